@@ -6,6 +6,10 @@ IPlugConvoEngine::IPlugConvoEngine(const InstanceInfo& info)
 {
   GetParam(kParamDry)->InitDouble("Dry", 0., 0., 1., 0.001);
   GetParam(kParamWet)->InitDouble("Wet", 1., 0., 1., 0.001);
+
+#if IPLUG_DSP
+  mParamSnapshot.Init(*this);
+#endif
 }
 
 #if IPLUG_DSP
@@ -14,26 +18,29 @@ void IPlugConvoEngine::ProcessBlock(sample** inputs, sample** outputs, int nFram
   sample* inputL = inputs[0];
   sample* outputL = outputs[0];
   
+  mParamSnapshot.Update(*this);
+
   mEngine.Add(inputs, nFrames, 1);
 
   int nAvailableSamples = std::min(mEngine.Avail(nFrames), nFrames);
 
-  const sample dryGain = GetParam(kParamDry)->Value();
-  const sample wetGain = GetParam(kParamWet)->Value();
-
   // If not enough samples are available yet, then only output the dry signal
-  for (auto i = 0; i < nFrames - nAvailableSamples; ++i)
+  auto s = 0;
+  for (; s < nFrames - nAvailableSamples; ++s)
   {
+    const sample dryGain = mParamSnapshot.RampValue(kParamDry, s, nFrames);
     *outputL++ = dryGain * *inputL++;
   }
 
   // Output samples from the convolution engine
   if (nAvailableSamples > 0)
   {
-    // Apply the dry/wet mix
+    // Apply the dry/wet mix, ramping from the previous block's values to avoid zipper noise
     WDL_FFT_REAL* pWetSignal = mEngine.Get()[0];
-    for (auto i = 0; i < nAvailableSamples; ++i)
+    for (; s < nFrames; ++s)
     {
+      const sample dryGain = mParamSnapshot.RampValue(kParamDry, s, nFrames);
+      const sample wetGain = mParamSnapshot.RampValue(kParamWet, s, nFrames);
       *outputL++ = dryGain * *inputL++ + wetGain * *pWetSignal++;
     }
 
@@ -44,9 +51,10 @@ void IPlugConvoEngine::ProcessBlock(sample** inputs, sample** outputs, int nFram
 
 void IPlugConvoEngine::OnReset()
 {
-  if (GetSampleRate() != mSampleRate)
+  if (GetSampleRate() != mSampleRate || GetBlockSize() != mBlockSize)
   {
     mSampleRate = GetSampleRate();
+    mBlockSize = GetBlockSize();
 
     static constexpr int irLength = sizeof(mIR) / sizeof(mIR[0]);
     static constexpr double irSampleRate = 44100.;
@@ -67,10 +75,14 @@ void IPlugConvoEngine::OnReset()
     }
     
     // Tie the impulse response to the convolution engine.
-    mEngine.SetImpulse(&mImpulse);
+    mEngine.SetImpulse(&mImpulse, mBlockSize);
     
     SetLatency(mEngine.GetLatency());
   }
+  else
+  {
+    mEngine.Reset();
+  }
 }
 
 template <class I, class O>
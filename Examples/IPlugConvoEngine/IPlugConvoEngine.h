@@ -1,6 +1,7 @@
 #pragma once
 
 #include "IPlug_include_in_plug_hdr.h"
+#include "IPlugParamSnapshot.h"
 
 
 #ifdef SAMPLE_TYPE_FLOAT
@@ -9,7 +10,7 @@
   #define WDL_FFT_REALSIZE 8
 #endif
 
-#include "convoengine.h"
+#include "ThreadedConvolutionEngine.h"
 
 #if defined USE_WDL_RESAMPLER
   #include "resample.h"
@@ -49,8 +50,7 @@ private:
   static const float mIR[512];
 
   WDL_ImpulseBuffer mImpulse;
-//  WDL_ConvolutionEngine_Div mEngine; // < low latency version
-  WDL_ConvolutionEngine mEngine;
+  ThreadedConvolutionEngine mEngine; // < low latency, long impulse tails are convolved on a worker thread
   
   static constexpr int mBlockLength = 64;
 
@@ -61,5 +61,7 @@ private:
   #endif
 
   double mSampleRate = 0.0;
+  int mBlockSize = 0;
+  IParamSnapshot mParamSnapshot;
 #endif
 };
@@ -0,0 +1,128 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Times the audio thread's work per block for ThreadedConvolutionEngine and WDL_ConvolutionEngine_Div, and counts deadline misses
+ * A stereo white noise impulse response is convolved with blocks fed in real time at 48 kHz, as a host would, and the first second is skipped.
+ * Usage: IPlugConvoEngine-benchmark [impulse response seconds] [seconds per run]
+ * Returns 1 if the threaded engine missed a deadline
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+// WDL_FFT_REALSIZE is set for every source file, by the makefile
+#include "ThreadedConvolutionEngine.h"
+
+using namespace iplug;
+
+static constexpr double kSampleRate = 48000.;
+static constexpr int kNumChannels = 2;
+
+template <class Engine>
+static void Run(const char* name, Engine& engine, int blockSize, int nFrames)
+{
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<double> noise(-1., 1.);
+  std::vector<WDL_FFT_REAL> inputs[kNumChannels];
+  WDL_FFT_REAL* ptrs[kNumChannels];
+
+  for (auto ch = 0; ch < kNumChannels; ch++)
+  {
+    inputs[ch].resize(blockSize);
+    ptrs[ch] = inputs[ch].data();
+  }
+
+  const auto blockDuration = std::chrono::duration<double>(blockSize / kSampleRate);
+  auto due = std::chrono::steady_clock::now();
+  double sum = 0., worst = 0.;
+  int nTimed = 0;
+
+  for (auto pos = 0; pos < nFrames; pos += blockSize)
+  {
+    for (auto ch = 0; ch < kNumChannels; ch++)
+    {
+      for (auto& s : inputs[ch])
+        s = noise(rng);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    engine.Add(ptrs, blockSize, kNumChannels);
+    engine.Advance(engine.Avail(blockSize));
+
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    if (pos >= kSampleRate)
+    {
+      sum += us;
+      worst = std::max(worst, us);
+      nTimed++;
+    }
+
+    due += std::chrono::duration_cast<std::chrono::steady_clock::duration>(blockDuration);
+    std::this_thread::sleep_until(due);
+  }
+
+  printf("%-8s block %4d: mean %8.1f us, worst %8.1f us (budget %6.0f us)\n", name, blockSize, nTimed ? sum / nTimed : 0., worst, blockDuration.count() * 1e6);
+}
+
+int main(int argc, char* argv[])
+{
+  const double irSeconds = argc > 1 ? atof(argv[1]) : 10.;
+  const double runSeconds = argc > 2 ? atof(argv[2]) : 6.;
+  const int irLength = static_cast<int>(irSeconds * kSampleRate);
+  const int nFrames = static_cast<int>(runSeconds * kSampleRate);
+
+  if (irLength <= 0 || runSeconds <= 1.)
+  {
+    fprintf(stderr, "usage: %s [impulse response seconds] [seconds per run, more than 1]\n", argv[0]);
+    return 1;
+  }
+
+  WDL_ImpulseBuffer impulse;
+  impulse.SetNumChannels(kNumChannels);
+  impulse.SetLength(irLength);
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> noise(-1., 1.);
+
+  for (auto ch = 0; ch < kNumChannels; ch++)
+  {
+    for (auto i = 0; i < irLength; i++)
+      impulse.impulses[ch].Get()[i] = noise(rng);
+  }
+
+  printf("%.1f s stereo impulse response at %.0f Hz, %u hardware threads\n", irSeconds, kSampleRate, std::thread::hardware_concurrency());
+
+  int nMisses = 0;
+
+  for (auto blockSize : {64, 256, 1024})
+  {
+    WDL_ConvolutionEngine_Div div;
+    div.SetImpulse(&impulse, 0, blockSize);
+    Run("Div", div, blockSize, nFrames);
+
+    ThreadedConvolutionEngine threaded;
+    threaded.SetImpulse(&impulse, blockSize);
+    Run("Threaded", threaded, blockSize, nFrames);
+
+    printf("%-8s block %4d: %d deadline misses in %d stages\n", "", blockSize, threaded.GetNumDeadlineMisses(), threaded.NStages());
+    nMisses += threaded.GetNumDeadlineMisses();
+  }
+
+  return nMisses ? 1 : 0;
+}
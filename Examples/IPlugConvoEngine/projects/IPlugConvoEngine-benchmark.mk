@@ -0,0 +1,32 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Examples/IPlugConvoEngine/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+# the impulse response length, and the length of each run, in seconds
+BENCH_IR_SECONDS ?= 10
+BENCH_SECONDS ?= 6
+
+TARGET = ../build-linux/IPlugConvoEngine-benchmark
+
+# only WDL's convolution engine is needed, not the plug-in sources in SRC
+BENCH_SRC = $(WDL_PATH)/convoengine.cpp \
+	$(PROJECT_ROOT)/IPlugConvoEngine_benchmark.cpp
+
+FFT_OBJ = ../build-linux/fft.o
+
+CFLAGS += -DWDL_FFT_REALSIZE=8 $(EXTRA_CFLAGS)
+
+$(FFT_OBJ): $(WDL_PATH)/fft.c
+	mkdir -p $(dir $@)
+	$(CC) -O3 -DWDL_FFT_REALSIZE=8 -c -o $@ $<
+
+$(TARGET): $(BENCH_SRC) $(FFT_OBJ)
+	$(CXX) $(CFLAGS) -o $@ $(BENCH_SRC) $(FFT_OBJ) $(LDFLAGS)
+
+# builds and runs the benchmark, which fails if the threaded engine misses a deadline
+bench: $(TARGET)
+	$(TARGET) $(BENCH_IR_SECONDS) $(BENCH_SECONDS)
+
+.PHONY: bench
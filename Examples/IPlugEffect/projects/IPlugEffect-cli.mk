@@ -0,0 +1,14 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Examples/IPlugEffect/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+TARGET = ../build-cli/IPlugEffect
+
+SRC += $(CLI_SRC) $(PROJECT_ROOT)/IPlugEffect.cpp
+CFLAGS += $(CLI_CFLAGS) $(EXTRA_CFLAGS)
+
+$(TARGET): $(SRC)
+	mkdir -p $(dir $@)
+	$(CXX) $(CFLAGS) -o $@ $(SRC) $(LDFLAGS)
@@ -45,6 +45,7 @@ public:
   , mNameLabel(label)
   {
     AttachIControl(this, label);
+    SetWantsDirtyPolling();
 
     SetColor(kBG, COLOR_WHITE);
 
@@ -0,0 +1,178 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IMinMaxDecimator
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "IPlugPlatform.h"
+#include "IPlugUtilities.h"
+
+BEGIN_IPLUG_NAMESPACE
+BEGIN_IGRAPHICS_NAMESPACE
+
+/** Reduces a window of samples to the minimum and maximum of each pixel column, so that plotting it costs in proportion to the plot's width rather than the window's length.
+ * Unlike skipping samples, this keeps every peak visible. The columns are updated as data arrives, either a whole window at a time with SetWindow(),
+ * or a sample at a time into a rolling window with Push(), so drawing only walks the columns. */
+class IMinMaxDecimator
+{
+public:
+  /** Constructs an IMinMaxDecimator
+   * @param nSamples The number of samples in the window
+   * @param nColumns The number of columns to reduce it to */
+  IMinMaxDecimator(int nSamples = 1, int nColumns = 1)
+  {
+    Resize(nSamples, nColumns);
+  }
+
+  /** Set the window length and the number of columns to reduce it to, and clear the columns
+   * @param nSamples The number of samples in the window
+   * @param nColumns The number of columns, e.g. the plot's width in pixels. Clamped to nSamples */
+  void Resize(int nSamples, int nColumns)
+  {
+    mNSamples = std::max(1, nSamples);
+    mNColumns = Clip(nColumns, 1, mNSamples);
+    mMin.assign(mNColumns, 0.f);
+    mMax.assign(mNColumns, 0.f);
+    Clear();
+  }
+
+  /** Clear the columns */
+  void Clear()
+  {
+    mCount = 0;
+    mLast = mNColumns - 1;
+    mNFilled = 0;
+  }
+
+  /** @return The number of samples in the window */
+  int NSamples() const { return mNSamples; }
+
+  /** @return The number of columns the window is reduced to */
+  int NColumns() const { return mNColumns; }
+
+  /** @return \c true if columns hold more than one sample each */
+  bool IsDecimating() const { return mNSamples > mNColumns; }
+
+  /** Replace the columns with a whole window of samples
+   * @param pSamples NSamples() samples, oldest first */
+  void SetWindow(const float* pSamples)
+  {
+    int s = 0;
+
+    for (auto col = 0; col < mNColumns; col++)
+    {
+      const int end = ColumnStart(col + 1);
+      float lo = pSamples[s];
+      float hi = lo;
+
+      for (s++; s < end; s++)
+      {
+        lo = std::min(lo, pSamples[s]);
+        hi = std::max(hi, pSamples[s]);
+      }
+
+      mMin[col] = lo;
+      mMax[col] = hi;
+    }
+
+    mCount = mNSamples;
+    mLast = mNColumns - 1;
+    mNFilled = mNColumns;
+  }
+
+  /** Append a sample to a rolling window, dropping the oldest column once a column's worth of samples has arrived
+   * @param value The sample */
+  void Push(float value)
+  {
+    if (mCount == 0 || ColumnOf(mCount) != ColumnOf(mCount - 1))
+    {
+      if (++mLast == mNColumns)
+        mLast = 0;
+
+      mMin[mLast] = mMax[mLast] = value;
+      mNFilled = std::min(mNFilled + 1, mNColumns);
+    }
+    else
+    {
+      mMin[mLast] = std::min(mMin[mLast], value);
+      mMax[mLast] = std::max(mMax[mLast], value);
+    }
+
+    mCount++;
+  }
+
+  /** Call a function for each point of a line through the columns' extremes, oldest first, e.g. to build a path.
+   * Each column gives two points, its minimum and maximum, ordered to continue from the previous point, or one if they are equal.
+   * Columns that have not been filled yet are skipped, so a rolling window grows in from the end
+   * @param func Called with (position, value), where position runs from 0 for the first column to 1 for the last */
+  template <typename F>
+  void ForEachPoint(F&& func) const
+  {
+    const float posPerColumn = mNColumns > 1 ? 1.f / static_cast<float>(mNColumns - 1) : 0.f;
+    int idx = mLast - mNFilled + 1;
+
+    if (idx < 0)
+      idx += mNColumns;
+
+    float prev = 0.f;
+
+    for (auto i = mNColumns - mNFilled; i < mNColumns; i++)
+    {
+      const float pos = static_cast<float>(i) * posPerColumn;
+      const float lo = mMin[idx];
+      const float hi = mMax[idx];
+
+      if (lo == hi)
+      {
+        func(pos, lo);
+        prev = lo;
+      }
+      else if (i == mNColumns - mNFilled || std::fabs(prev - lo) <= std::fabs(prev - hi))
+      {
+        func(pos, lo);
+        func(pos, hi);
+        prev = hi;
+      }
+      else
+      {
+        func(pos, hi);
+        func(pos, lo);
+        prev = lo;
+      }
+
+      if (++idx == mNColumns)
+        idx = 0;
+    }
+  }
+
+private:
+  int ColumnStart(int col) const { return static_cast<int>(static_cast<int64_t>(col) * mNSamples / mNColumns); }
+  int64_t ColumnOf(int64_t sample) const { return sample * mNColumns / mNSamples; }
+
+  std::vector<float> mMin;
+  std::vector<float> mMax;
+  int64_t mCount = 0; // samples seen since Clear()
+  int mNSamples = 1;
+  int mNColumns = 1;
+  int mLast = 0; // the column that the latest sample went into
+  int mNFilled = 0;
+};
+
+END_IGRAPHICS_NAMESPACE
+END_IPLUG_NAMESPACE
@@ -342,7 +342,7 @@ public:
     double vy0 = y + (h - (*mPoints.begin())->y / 100.0 * h);
     g.PathMoveTo(vx0, vy0);
     pathLinePoints();
-    g.PathStroke(IPattern::IPattern(mColor), 2.0f);
+    g.PathStroke(IPattern(mColor), 2.0f);
 
 
     //Wypełnienie pod wykresem
@@ -18,11 +18,13 @@
 
 #include "IControl.h"
 #include "ISender.h"
+#include "IMinMaxDecimator.h"
 
 BEGIN_IPLUG_NAMESPACE
 BEGIN_IGRAPHICS_NAMESPACE
 
-/** A control to display a rolling graphics of historical values */
+/** A control to display a rolling graphics of historical values
+ * When the buffer is longer than the plot in pixels, each pixel column is drawn as the minimum and maximum of its values, which are reduced as the values arrive (see IMinMaxDecimator) */
 class IVDisplayControl : public IControl
                        , public IVectorBase
 {
@@ -73,36 +75,61 @@ public:
     float h = mPlotBounds.H();
     
     const int sz = static_cast<int>(mBuffer.size());
+    const bool horizontal = mDirection == EDirection::Horizontal;
+    const int nColumns = static_cast<int>(std::ceil((horizontal ? w : h) * g.GetTotalScale()));
 
-    auto getPlotPos = [&](int pos, float axis, float extrem) {
-      float v = mBuffer[(mReadPos+pos) % sz];
+    if (std::min(nColumns, sz) != mDecimator.NColumns() || sz != mDecimator.NSamples())
+    {
+      mDecimator.Resize(sz, nColumns);
+
+      if (mDecimator.IsDecimating())
+      {
+        for (int i = mReadPos; i < sz; i++)
+          mDecimator.Push(mBuffer[i]);
+
+        for (int i = 0; i < mReadPos; i++)
+          mDecimator.Push(mBuffer[i]);
+      }
+    }
+
+    auto getPlotPos = [&](float v, float axis, float extrem) {
       v = (v - mLoValue) / (mHiValue - mLoValue);
       return axis + extrem - (v * extrem);
     };
-    
-    if(mDirection == EDirection::Horizontal)
-    {
-      g.PathMoveTo(x, getPlotPos(0, y, h));
-      
-      for (int i = 0; i < sz; i++)
-      {
-        float vx = x + ((float)i/(sz-1)) * w;
-        float vy = getPlotPos(i, y, h);
+
+    auto addPoint = [&](float pos, float v, bool first) {
+      const float vx = horizontal ? x + pos * w : getPlotPos(v, x, w);
+      const float vy = horizontal ? getPlotPos(v, y, h) : y + pos * h;
+
+      if (first)
+        g.PathMoveTo(vx, vy);
+      else
         g.PathLineTo(vx, vy);
-      }
+    };
+
+    if (mDecimator.IsDecimating())
+    {
+      bool first = true;
+
+      mDecimator.ForEachPoint([&](float pos, float v) {
+        addPoint(pos, v, first);
+        first = false;
+      });
     }
     else
     {
-      g.PathMoveTo(getPlotPos(0, x, w), y);
-      
+      // oldest first, from the read position round to the start of the buffer
+      int idx = mReadPos;
+
       for (int i = 0; i < sz; i++)
       {
-        float vx = getPlotPos(i, x, w);
-        float vy = y + ((float)i/(sz-1)) * h;
-        g.PathLineTo(vx, vy);
+        addPoint((float) i / (sz - 1), mBuffer[idx], i == 0);
+
+        if (++idx == sz)
+          idx = 0;
       }
     }
-        
+
     g.PathStroke(IPattern::CreateLinearGradient(mPlotBounds, mDirection, {{COLOR_TRANSPARENT, 0.f}, {GetColor(kX1), 1.f}}), mStrokeThickness, IStrokeOptions(), &mBlend);
   }
   
@@ -110,7 +137,13 @@ public:
   {
     auto Update = [&](float v) {
       mBuffer[mReadPos] = v;
-      mReadPos = (mReadPos+1) % mBuffer.size();
+
+      if (++mReadPos == static_cast<int>(mBuffer.size()))
+        mReadPos = 0;
+
+      if (mDecimator.IsDecimating())
+        mDecimator.Push(v);
+
       SetDirty(false);
     };
 
@@ -127,6 +160,7 @@ public:
   
 private:
   std::vector<float> mBuffer;
+  IMinMaxDecimator mDecimator;
   float mLoValue = 0.f;
   float mHiValue = 1.f;
   int mReadPos = 0;
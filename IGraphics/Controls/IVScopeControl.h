@@ -19,11 +19,13 @@
 #include "IControl.h"
 #include "ISender.h"
 #include "IPlugStructs.h"
+#include "IMinMaxDecimator.h"
 
 BEGIN_IPLUG_NAMESPACE
 BEGIN_IGRAPHICS_NAMESPACE
 
 /** Vectorial multi-channel capable oscilloscope control
+ * When MAXBUF is larger than the plot's width in pixels, each pixel column is drawn as the minimum and maximum of its samples, which are reduced as the data arrives (see IMinMaxDecimator)
  * @ingroup IControls */
 template <int MAXNC = 1, int MAXBUF = 128>
 class IVScopeControl : public IControl
@@ -61,6 +63,41 @@ public:
 
     float xPerData = r.W() / (float) MAXBUF;
 
+    const int nColumns = std::min(static_cast<int>(std::ceil(r.W() * g.GetTotalScale())), MAXBUF);
+
+    if (nColumns != mDecimators[0].NColumns())
+    {
+      for (auto& decimator : mDecimators)
+        decimator.Resize(MAXBUF, nColumns);
+
+      UpdateDecimators();
+    }
+
+    if (mDecimators[0].IsDecimating())
+    {
+      const float w = xPerData * (float) (MAXBUF - 1);
+
+      for (int c = 0; c < mBuf.nChans; c++)
+      {
+        bool first = true;
+
+        mDecimators[c].ForEachPoint([&](float pos, float v) {
+          const float y = r.MH() - Clip(v * maxY, -maxY, maxY);
+
+          if (first)
+            g.PathMoveTo(r.L + pos * w, y);
+          else
+            g.PathLineTo(r.L + pos * w, y);
+
+          first = false;
+        });
+
+        g.PathStroke(GetColor(kFG), mTrackSize, IStrokeOptions(), &mBlend);
+      }
+
+      return;
+    }
+
     for (int c = 0; c < mBuf.nChans; c++)
     {
       float xHi = 0.f;
@@ -95,12 +132,45 @@ public:
       int pos = 0;
       pos = stream.Get(&mBuf, pos);
 
+      UpdateDecimators();
       SetDirty(false);
     }
+    else if (!IsDisabled() && msgTag == IRingBufferSender<>::kUpdateMessage && dataSize == sizeof(ISenderRingData))
+    {
+      // read the latest window straight from the sender's ring buffer
+      const ISenderRingData* pRing = static_cast<const ISenderRingData*>(pData);
+      const int nChans = std::min(pRing->nChans, MAXNC);
+      const int nFrames = std::min(MAXBUF, pRing->ringSize);
+
+      // read into scratch space, so that a window torn by the audio thread is never drawn
+      for (int c = 0; c < nChans; c++)
+        pRing->CopyLatest(c, mRingScratch[c].data(), nFrames);
+
+      if (pRing->IsIntact(nFrames))
+      {
+        for (int c = 0; c < nChans; c++)
+          std::copy_n(mRingScratch[c].begin(), nFrames, mBuf.vals[c].begin());
+
+        mBuf.nChans = nChans;
+        UpdateDecimators();
+        SetDirty(false);
+      }
+    }
   }
 
 private:
+  void UpdateDecimators()
+  {
+    if (!mDecimators[0].IsDecimating())
+      return;
+
+    for (int c = 0; c < mBuf.nChans; c++)
+      mDecimators[c].SetWindow(mBuf.vals[c].data());
+  }
+
   ISenderData<MAXNC, std::array<float, MAXBUF>> mBuf;
+  std::array<std::array<float, MAXBUF>, MAXNC> mRingScratch; // see OnMsgFromDelegate()
+  std::array<IMinMaxDecimator, MAXNC> mDecimators;
   float mPadding = 2.f;
 };
 
@@ -0,0 +1,109 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @ingroup Controls
+ * @copydoc IVSpectrumControl
+ */
+
+#include "IControl.h"
+#include "ISender.h"
+
+BEGIN_IPLUG_NAMESPACE
+BEGIN_IGRAPHICS_NAMESPACE
+
+/** Vectorial multi-channel capable spectrum analyser control, which displays the log-frequency magnitudes (in dB) sent by an ISpectrumSender
+ * @ingroup IControls */
+template <int MAXNC = 1, int NPOINTS = 128>
+class IVSpectrumControl : public IControl
+                        , public IVectorBase
+{
+public:
+  /** Constructs an IVSpectrumControl
+   * @param bounds The rectangular area that the control occupies
+   * @param label A CString to label the control
+   * @param style, /see IVStyle
+   * @param loDB The level in dB at the bottom of the control
+   * @param hiDB The level in dB at the top of the control */
+  IVSpectrumControl(const IRECT& bounds, const char* label = "", const IVStyle& style = DEFAULT_STYLE, float loDB = -90.f, float hiDB = 0.f)
+  : IControl(bounds)
+  , IVectorBase(style)
+  , mLoDB(loDB)
+  , mHiDB(hiDB)
+  {
+    AttachIControl(this, label);
+
+    for (auto& chan : mBuf.vals)
+      chan.fill(loDB);
+  }
+
+  void Draw(IGraphics& g) override
+  {
+    DrawBackground(g, mRECT);
+    DrawWidget(g);
+    DrawLabel(g);
+
+    if(mStyle.drawFrame)
+      g.DrawRect(GetColor(kFR), mWidgetBounds, &mBlend, mStyle.frameThickness);
+  }
+
+  void DrawWidget(IGraphics& g) override
+  {
+    IRECT r = mWidgetBounds.GetPadded(-mPadding);
+
+    const float xPerPoint = r.W() / (float) (NPOINTS - 1);
+
+    auto getY = [&](float dB) {
+      const float v = Clip((dB - mLoDB) / (mHiDB - mLoDB), 0.f, 1.f);
+      return r.B - (v * r.H());
+    };
+
+    for (int c = 0; c < mBuf.nChans; c++)
+    {
+      g.PathMoveTo(r.L, getY(mBuf.vals[c][0]));
+
+      for (int p = 1; p < NPOINTS; p++)
+        g.PathLineTo(r.L + ((float) p * xPerPoint), getY(mBuf.vals[c][p]));
+
+      g.PathStroke(GetColor(c == 0 ? kFG : kX1), mTrackSize, IStrokeOptions(), &mBlend);
+    }
+  }
+
+  void OnResize() override
+  {
+    SetTargetRECT(MakeRects(mRECT));
+    SetDirty(false);
+  }
+
+  void OnMsgFromDelegate(int msgTag, int dataSize, const void* pData) override
+  {
+    if (!IsDisabled() && msgTag == ISender<>::kUpdateMessage)
+    {
+      IByteStream stream(pData, dataSize);
+
+      int pos = 0;
+      pos = stream.Get(&mBuf, pos);
+
+      SetDirty(false);
+    }
+  }
+
+private:
+  ISenderData<MAXNC, std::array<float, NPOINTS>> mBuf;
+  float mLoDB;
+  float mHiDB;
+  float mPadding = 2.f;
+};
+
+END_IGRAPHICS_NAMESPACE
+END_IPLUG_NAMESPACE
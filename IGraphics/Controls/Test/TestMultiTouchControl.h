@@ -71,6 +71,7 @@ public:
   void OnMouseDown(float x, float y, const IMouseMod& mod) override
   {
     AddTouch(mod.touchID, x, y, mod.touchRadius);
+    SetDirty(false);
   }
 
   void OnMouseUp(float x, float y, const IMouseMod& mod) override
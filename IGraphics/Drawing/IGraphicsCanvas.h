@@ -59,6 +59,7 @@ public:
   bool BitmapExtSupported(const char* ext) override;
     
 protected:
+  // N.B. GetThreadSafeBitmapDecoder() is not implemented: images are created by the browser, on the UI thread, see IGraphics::GetThreadSafeBitmapDecoder()
   APIBitmap* LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext) override;
   APIBitmap* LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale) override;
   APIBitmap* CreateAPIBitmap(int width, int height, float scale, double drawScale, bool cacheable = false) override;
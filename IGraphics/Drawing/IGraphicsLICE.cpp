@@ -0,0 +1,1762 @@
+#include <cmath>
+#include <unordered_map>
+
+#include "IGraphicsLICE.h"
+
+#include "wdlutf8.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+#if defined OS_MAC
+  #include <CoreGraphics/CoreGraphics.h>
+#endif
+
+using namespace iplug;
+using namespace igraphics;
+
+#pragma mark - Pixel arithmetic
+
+// Pixels are premultiplied LICE_pixels, so the four channels can be treated alike, two at a time
+
+static inline uint32_t Div255(uint32_t x)
+{
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+/** Scale all four channels by f, where 256 is unity */
+static inline LICE_pixel ScalePixel(LICE_pixel p, uint32_t f)
+{
+  const uint32_t rb = (((p & 0x00FF00FF) * f) >> 8) & 0x00FF00FF;
+  const uint32_t ag = (((p >> 8) & 0x00FF00FF) * f) & 0xFF00FF00;
+  return rb | ag;
+}
+
+/** Interpolate all four channels from a to b, where f = 256 gives b */
+static inline LICE_pixel LerpPixel(LICE_pixel a, LICE_pixel b, uint32_t f)
+{
+  const uint32_t rb = ((((a & 0x00FF00FF) * (256 - f)) + ((b & 0x00FF00FF) * f)) >> 8) & 0x00FF00FF;
+  const uint32_t ag = ((((a >> 8) & 0x00FF00FF) * (256 - f)) + (((b >> 8) & 0x00FF00FF) * f)) & 0xFF00FF00;
+  return rb | ag;
+}
+
+static inline uint32_t Coverage256(uint32_t c)
+{
+  return c + (c >> 7);
+}
+
+static inline LICE_pixel SrcOverPixel(LICE_pixel s, LICE_pixel d)
+{
+  const uint32_t sa = LICE_GETA(s);
+
+  if (sa == 255)
+    return s;
+
+  return s + ScalePixel(d, 256 - Coverage256(sa));
+}
+
+/** Porter-Duff compositing of premultiplied pixels: result = src * Fa + dst * Fb */
+static inline LICE_pixel BlendPixel(LICE_pixel s, LICE_pixel d, EBlend method)
+{
+  const uint32_t sa = LICE_GETA(s);
+  const uint32_t da = LICE_GETA(d);
+  uint32_t fa = 255;
+  uint32_t fb = 255 - sa;
+
+  switch (method)
+  {
+    case EBlend::SrcOver:   fa = 255;       fb = 255 - sa;  break;
+    case EBlend::SrcIn:     fa = da;        fb = 0;         break;
+    case EBlend::SrcOut:    fa = 255 - da;  fb = 0;         break;
+    case EBlend::SrcAtop:   fa = da;        fb = 255 - sa;  break;
+    case EBlend::DstOver:   fa = 255 - da;  fb = 255;       break;
+    case EBlend::DstIn:     fa = 0;         fb = sa;        break;
+    case EBlend::DstOut:    fa = 0;         fb = 255 - sa;  break;
+    case EBlend::DstAtop:   fa = 255 - da;  fb = sa;        break;
+    case EBlend::Add:       fa = 255;       fb = 255;       break;
+    case EBlend::XOR:       fa = 255 - da;  fb = 255 - sa;  break;
+  }
+
+  LICE_pixel result = 0;
+
+  for (int shift = 0; shift < 32; shift += 8)
+  {
+    const uint32_t c = Div255(((s >> shift) & 0xFF) * fa + ((d >> shift) & 0xFF) * fb);
+    result |= std::min(c, 255U) << shift;
+  }
+
+  return result;
+}
+
+static inline LICE_pixel PremultipliedColor(const IColor& color, float weight)
+{
+  const uint32_t a = Clip(static_cast<int>(color.A * weight + 0.5f), 0, 255);
+  return LICE_RGBA(Div255(color.R * a), Div255(color.G * a), Div255(color.B * a), a);
+}
+
+static inline bool NearInteger(double x)
+{
+  return std::fabs(x - std::floor(x + 0.5)) < 1e-3;
+}
+
+#pragma mark - Rasterization
+
+// Coverage is accumulated as signed area per pixel: each edge adds its area contribution to the cell it crosses and the remainder to the next cell,
+// and a running sum along each row gives the winding coverage. Rows are stride = w + 2 wide, so edges on the right border can't overflow.
+
+static void AccumulateClippedLine(float* pAcc, int stride, int h, float x0, float y0, float x1, float y1)
+{
+  if (y0 == y1)
+    return;
+
+  float dir = 1.f;
+
+  if (y0 > y1)
+  {
+    dir = -1.f;
+    std::swap(x0, x1);
+    std::swap(y0, y1);
+  }
+
+  if (y1 <= 0.f || y0 >= static_cast<float>(h))
+    return;
+
+  const float dxdy = (x1 - x0) / (y1 - y0);
+  const float maxX = static_cast<float>(stride - 2);
+  float x = x0;
+
+  if (y0 < 0.f)
+  {
+    x -= y0 * dxdy;
+    y0 = 0.f;
+  }
+
+  y1 = std::min(y1, static_cast<float>(h));
+
+  const int yEnd = static_cast<int>(std::ceil(y1));
+
+  for (int y = static_cast<int>(y0); y < yEnd; y++)
+  {
+    float* pRow = pAcc + (y * stride);
+    const float dy = std::min(static_cast<float>(y + 1), y1) - std::max(static_cast<float>(y), y0);
+    const float xNext = x + dxdy * dy;
+    const float d = dy * dir;
+    const float xa = Clip(std::min(x, xNext), 0.f, maxX);
+    const float xb = Clip(std::max(x, xNext), 0.f, maxX);
+    const float xaFloor = std::floor(xa);
+    const int xai = static_cast<int>(xaFloor);
+    const float xbCeil = std::ceil(xb);
+    const int xbi = static_cast<int>(xbCeil);
+
+    if (xbi <= xai + 1)
+    {
+      // within a single cell
+      const float xmf = 0.5f * (xa + xb) - xaFloor;
+      pRow[xai] += d - d * xmf;
+      pRow[xai + 1] += d * xmf;
+    }
+    else
+    {
+      const float s = 1.f / (xb - xa);
+      const float xaf = xa - xaFloor;
+      const float a0 = 0.5f * s * (1.f - xaf) * (1.f - xaf);
+      const float xbf = xb - xbCeil + 1.f;
+      const float am = 0.5f * s * xbf * xbf;
+
+      pRow[xai] += d * a0;
+
+      if (xbi == xai + 2)
+      {
+        pRow[xai + 1] += d * (1.f - a0 - am);
+      }
+      else
+      {
+        const float a1 = s * (1.5f - xaf);
+        pRow[xai + 1] += d * (a1 - a0);
+
+        for (int xi = xai + 2; xi < xbi - 1; xi++)
+          pRow[xi] += d * s;
+
+        const float a2 = a1 + (xbi - xai - 3) * s;
+        pRow[xbi - 1] += d * (1.f - a2 - am);
+      }
+
+      pRow[xbi] += d * am;
+    }
+
+    x = xNext;
+  }
+}
+
+/** Accumulate a line into a buffer w pixels wide. Parts of the line left or right of the buffer become vertical lines on its border,
+ * which still contribute their winding to the pixels on their right */
+static void AccumulateLine(float* pAcc, int stride, int h, float x0, float y0, float x1, float y1)
+{
+  // a NaN or infinite coordinate would index outside the buffer
+  if (!(std::isfinite(x0) && std::isfinite(y0) && std::isfinite(x1) && std::isfinite(y1)))
+    return;
+
+  const float w = static_cast<float>(stride - 2);
+  float t[2];
+  int nt = 0;
+
+  if ((x0 < 0.f) != (x1 < 0.f))
+    t[nt++] = -x0 / (x1 - x0);
+
+  if ((x0 > w) != (x1 > w))
+    t[nt++] = (w - x0) / (x1 - x0);
+
+  if (nt == 2 && t[0] > t[1])
+    std::swap(t[0], t[1]);
+
+  float px = x0;
+  float py = y0;
+
+  for (int i = 0; i <= nt; i++)
+  {
+    const float qx = i < nt ? x0 + (x1 - x0) * t[i] : x1;
+    const float qy = i < nt ? y0 + (y1 - y0) * t[i] : y1;
+    AccumulateClippedLine(pAcc, stride, h, Clip(px, 0.f, w), py, Clip(qx, 0.f, w), qy);
+    px = qx;
+    py = qy;
+  }
+}
+
+#pragma mark - Private Classes and Structs
+
+class IGraphicsLICE::Bitmap : public APIBitmap
+{
+public:
+  Bitmap(LICE_IBitmap* pBitmap, float scale, float drawScale)
+  {
+    SetBitmap(pBitmap, pBitmap->getWidth(), pBitmap->getHeight(), scale, drawScale);
+  }
+
+  Bitmap(const char* path, double sourceScale)
+  {
+    int w = 0, h = 0, n = 0;
+    unsigned char* pRGBA = stbi_load(path, &w, &h, &n, 4);
+
+    assert(pRGBA && "Unable to load file at path");
+
+    SetPixels(pRGBA, w, h, sourceScale);
+  }
+
+  Bitmap(const void* pData, int size, double sourceScale)
+  {
+    int w = 0, h = 0, n = 0;
+    unsigned char* pRGBA = stbi_load_from_memory(static_cast<const stbi_uc*>(pData), size, &w, &h, &n, 4);
+
+    assert(pRGBA && "Unable to decode image data");
+
+    SetPixels(pRGBA, w, h, sourceScale);
+  }
+
+  ~Bitmap()
+  {
+    delete GetBitmap();
+  }
+
+private:
+  /** Takes ownership of the straight alpha RGBA data from stb_image, and stores it premultiplied */
+  void SetPixels(unsigned char* pRGBA, int w, int h, double sourceScale)
+  {
+    if (!pRGBA)
+      w = h = 0;
+
+    LICE_MemBitmap* pBitmap = new LICE_MemBitmap(w, h);
+    LICE_pixel* pBits = pBitmap->getBits();
+    const int span = pBitmap->getRowSpan();
+
+    for (int y = 0; y < h; y++)
+    {
+      const unsigned char* pSrc = pRGBA + (y * w * 4);
+
+      for (int x = 0; x < w; x++, pSrc += 4)
+      {
+        const uint32_t a = pSrc[3];
+        pBits[y * span + x] = LICE_RGBA(Div255(pSrc[0] * a), Div255(pSrc[1] * a), Div255(pSrc[2] * a), a);
+      }
+    }
+
+    if (pRGBA)
+      stbi_image_free(pRGBA);
+
+    SetBitmap(pBitmap, w, h, static_cast<float>(sourceScale), 1.f);
+  }
+};
+
+struct IGraphicsLICE::Font
+{
+  struct Glyph
+  {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+    std::vector<uint8_t> mMask;
+  };
+
+  Font(IFontDataPtr&& data)
+  : mData(std::move(data))
+  {
+    const int offset = stbtt_GetFontOffsetForIndex(mData->Get(), mData->GetFaceIdx());
+    mValid = offset >= 0 && stbtt_InitFont(&mInfo, mData->Get(), offset);
+
+    if (mValid)
+      stbtt_GetFontVMetrics(&mInfo, &mAscent, &mDescent, &mLineGap);
+  }
+
+  /** @return The scale from font units to pixels for a given text size */
+  float Scale(float size) const
+  {
+    return stbtt_ScaleForPixelHeight(&mInfo, size);
+  }
+
+  /** @return The width of a string in font units */
+  double MeasureWidth(const char* str) const
+  {
+    double width = 0.0;
+    int prev = 0;
+
+    while (*str)
+    {
+      int codepoint;
+      str += wdl_utf8_parsechar(str, &codepoint);
+
+      if (prev)
+        width += stbtt_GetCodepointKernAdvance(&mInfo, prev, codepoint);
+
+      int advance, lsb;
+      stbtt_GetCodepointHMetrics(&mInfo, codepoint, &advance, &lsb);
+      width += advance;
+      prev = codepoint;
+    }
+
+    return width;
+  }
+
+  /** Get a rendered glyph, cached by codepoint, size and quarter pixel horizontal offset
+   * @return The glyph, valid until the next call */
+  const Glyph& GetGlyph(int codepoint, float scale, int subpixel)
+  {
+    const uint64_t scaleKey = static_cast<uint64_t>(scale * static_cast<float>(1 << 24)) & 0xFFFFFFFF;
+    const uint64_t key = (scaleKey << 32) | (static_cast<uint64_t>(subpixel) << 24) | (codepoint & 0xFFFFFF);
+
+    auto it = mGlyphs.find(key);
+
+    if (it != mGlyphs.end())
+      return it->second;
+
+    if (mGlyphs.size() >= kMaxCachedGlyphs)
+      mGlyphs.clear();
+
+    Glyph& glyph = mGlyphs[key];
+    const float shift = subpixel * 0.25f;
+    int x0, y0, x1, y1;
+
+    stbtt_GetCodepointBitmapBoxSubpixel(&mInfo, codepoint, scale, scale, shift, 0.f, &x0, &y0, &x1, &y1);
+
+    glyph.x = x0;
+    glyph.y = y0;
+    glyph.w = std::max(0, x1 - x0);
+    glyph.h = std::max(0, y1 - y0);
+    glyph.mMask.resize(glyph.w * glyph.h);
+
+    if (glyph.w && glyph.h)
+      stbtt_MakeCodepointBitmapSubpixel(&mInfo, glyph.mMask.data(), glyph.w, glyph.h, glyph.w, scale, scale, shift, 0.f, codepoint);
+
+    return glyph;
+  }
+
+  static constexpr size_t kMaxCachedGlyphs = 4096;
+
+  IFontDataPtr mData;
+  stbtt_fontinfo mInfo;
+  int mAscent = 0;
+  int mDescent = 0;
+  int mLineGap = 0;
+  bool mValid = false;
+  std::unordered_map<uint64_t, Glyph> mGlyphs;
+};
+
+/** The source colours of a fill: a solid colour, a gradient or a bitmap, already weighted and premultiplied */
+struct IGraphicsLICE::Paint
+{
+  /** Generate the source pixels of a span of device pixels */
+  void Shade(int x, int y, int n, LICE_pixel* pOut) const
+  {
+    if (mBitmap)
+      ShadeBitmap(x, y, n, pOut);
+    else
+      ShadeGradient(x, y, n, pOut);
+  }
+
+  bool IsSolid() const { return !mBitmap && mType == EPatternType::Solid; }
+
+  EPatternType mType = EPatternType::Solid;
+  EPatternExtend mExtend = EPatternExtend::Pad;
+  EBlend mMethod = EBlend::SrcOver;
+  LICE_pixel mColor = 0;
+  LICE_pixel mLUT[256];
+  IMatrix mInverse; // device pixels to pattern space, or to bitmap pixels
+
+  LICE_IBitmap* mBitmap = nullptr;
+  uint32_t mAlpha = 256;
+  bool mIntegral = false;
+  int mOffsetX = 0;
+  int mOffsetY = 0;
+
+private:
+  void ShadeGradient(int x, int y, int n, LICE_pixel* pOut) const
+  {
+    double px, py;
+    mInverse.TransformPoint(px, py, x + 0.5, y + 0.5);
+
+    for (int i = 0; i < n; i++, px += mInverse.mXX, py += mInverse.mYX)
+    {
+      double t = 0.0;
+
+      switch (mType)
+      {
+        case EPatternType::Linear:  t = py;                                     break;
+        case EPatternType::Radial:  t = std::sqrt(px * px + py * py);           break;
+        case EPatternType::Sweep:
+          t = std::atan2(py, px) / (2.0 * PI);
+          if (t < 0.0) t += 1.0;
+          break;
+        default:
+          break;
+      }
+
+      switch (mExtend)
+      {
+        case EPatternExtend::None:
+          if (t < 0.0 || t > 1.0)
+          {
+            pOut[i] = 0;
+            continue;
+          }
+          break;
+        case EPatternExtend::Pad:       t = Clip(t, 0.0, 1.0);                                   break;
+        case EPatternExtend::Repeat:    t -= std::floor(t);                                      break;
+        case EPatternExtend::Reflect:   t = std::fabs(std::fmod(t, 2.0)); if (t > 1.0) t = 2.0 - t;  break;
+      }
+
+      pOut[i] = mLUT[static_cast<int>(t * 255.0 + 0.5)];
+    }
+  }
+
+  void ShadeBitmap(int x, int y, int n, LICE_pixel* pOut) const
+  {
+    const LICE_pixel* pBits = mBitmap->getBits();
+    const int w = mBitmap->getWidth();
+    const int h = mBitmap->getHeight();
+    const int span = mBitmap->getRowSpan();
+
+    if (mIntegral)
+    {
+      const int sy = Clip(y + mOffsetY, 0, h - 1);
+      const LICE_pixel* pRow = pBits + (sy * span);
+
+      for (int i = 0; i < n; i++)
+      {
+        const LICE_pixel p = pRow[Clip(x + i + mOffsetX, 0, w - 1)];
+        pOut[i] = mAlpha < 256 ? ScalePixel(p, mAlpha) : p;
+      }
+
+      return;
+    }
+
+    // bilinear, sampling at pixel centres
+    double u, v;
+    mInverse.TransformPoint(u, v, x + 0.5, y + 0.5);
+    u -= 0.5;
+    v -= 0.5;
+
+    for (int i = 0; i < n; i++, u += mInverse.mXX, v += mInverse.mYX)
+    {
+      const double uc = Clip(u, 0.0, static_cast<double>(w - 1));
+      const double vc = Clip(v, 0.0, static_cast<double>(h - 1));
+      const int iu = static_cast<int>(uc);
+      const int iv = static_cast<int>(vc);
+      const uint32_t fu = static_cast<uint32_t>((uc - iu) * 256.0);
+      const uint32_t fv = static_cast<uint32_t>((vc - iv) * 256.0);
+      const int iu1 = std::min(iu + 1, w - 1);
+      const LICE_pixel* pRow0 = pBits + (iv * span);
+      const LICE_pixel* pRow1 = pBits + (std::min(iv + 1, h - 1) * span);
+
+      const LICE_pixel p = LerpPixel(LerpPixel(pRow0[iu], pRow0[iu1], fu), LerpPixel(pRow1[iu], pRow1[iu1], fu), fv);
+      pOut[i] = mAlpha < 256 ? ScalePixel(p, mAlpha) : p;
+    }
+  }
+};
+
+// Fonts
+StaticStorage<IGraphicsLICE::Font> IGraphicsLICE::sFontCache;
+
+#pragma mark - Polygons
+
+void IGraphicsLICE::Polygons::MoveTo(float x, float y)
+{
+  mSubPaths.push_back({static_cast<int>(mPoints.size()), 1, false});
+  mPoints.push_back({x, y});
+}
+
+void IGraphicsLICE::Polygons::LineTo(float x, float y)
+{
+  if (mSubPaths.empty())
+  {
+    MoveTo(x, y);
+    return;
+  }
+
+  if (mSubPaths.back().closed)
+  {
+    // after a close the current point is the start of the closed subpath
+    const PathPoint start = mPoints[mSubPaths.back().start];
+    MoveTo(start.x, start.y);
+  }
+
+  const PathPoint& last = mPoints.back();
+
+  if (last.x == x && last.y == y)
+    return;
+
+  mPoints.push_back({x, y});
+  mSubPaths.back().count++;
+}
+
+void IGraphicsLICE::Polygons::Close()
+{
+  if (!mSubPaths.empty())
+    mSubPaths.back().closed = true;
+}
+
+#pragma mark -
+
+IGraphicsLICE::IGraphicsLICE(IGEditorDelegate& dlg, int w, int h, int fps, float scale)
+: IGraphics(dlg, w, h, fps, scale)
+{
+  DBGMSG("IGraphics LICE @ %i FPS\n", fps);
+
+  StaticStorage<Font>::Accessor storage(sFontCache);
+  storage.Retain();
+}
+
+IGraphicsLICE::~IGraphicsLICE()
+{
+  StaticStorage<Font>::Accessor storage(sFontCache);
+  storage.Release();
+}
+
+bool IGraphicsLICE::BitmapExtSupported(const char* ext)
+{
+  char extLower[32];
+  ToLower(extLower, ext);
+  return (strstr(extLower, "png") != nullptr) || (strstr(extLower, "jpg") != nullptr) || (strstr(extLower, "jpeg") != nullptr);
+}
+
+APIBitmap* IGraphicsLICE::LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext)
+{
+#ifdef OS_WIN
+  if (location == EResourceLocation::kWinBinary)
+  {
+    int size = 0;
+    const void* pData = LoadWinResource(fileNameOrResID, ext, size, GetWinModuleHandle());
+    return new Bitmap(pData, size, scale);
+  }
+  else
+#endif
+  return new Bitmap(fileNameOrResID, scale);
+}
+
+APIBitmap* IGraphicsLICE::LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale)
+{
+  return new Bitmap(pData, dataSize, scale);
+}
+
+IBitmapDecodeFunc IGraphicsLICE::GetThreadSafeBitmapDecoder() const
+{
+  return ThreadSafeBitmapDecoder();
+}
+
+IBitmapDecodeFunc IGraphicsLICE::ThreadSafeBitmapDecoder()
+{
+  // the bitmap decoders only touch the data they are given
+  return [](const void* pData, int dataSize, int scale) -> APIBitmap* {
+    return new Bitmap(pData, dataSize, scale);
+  };
+}
+
+APIBitmap* IGraphicsLICE::CreateAPIBitmap(int width, int height, float scale, double drawScale, bool cacheable)
+{
+  LICE_MemBitmap* pBitmap = new LICE_MemBitmap(width, height);
+  LICE_Clear(pBitmap, 0);
+
+  return new Bitmap(pBitmap, scale, static_cast<float>(drawScale));
+}
+
+void IGraphicsLICE::OnViewInitialized(void* pContext)
+{
+  DrawResize();
+}
+
+void IGraphicsLICE::OnViewDestroyed()
+{
+  RemoveAllControls();
+
+  mDrawBitmap = nullptr;
+  mFrameBitmap = nullptr;
+}
+
+void IGraphicsLICE::DrawResize()
+{
+  auto w = static_cast<int>(std::ceil(static_cast<float>(WindowWidth()) * GetScreenScale()));
+  auto h = static_cast<int>(std::ceil(static_cast<float>(WindowHeight()) * GetScreenScale()));
+
+  if (!mFrameBitmap)
+    mFrameBitmap = std::make_unique<LICE_MemBitmap>(w, h);
+  else
+    mFrameBitmap->resize(w, h);
+
+  LICE_Clear(mFrameBitmap.get(), 0);
+  UpdateLayer();
+}
+
+void IGraphicsLICE::UpdateLayer()
+{
+  mDrawBitmap = mLayers.empty() ? mFrameBitmap.get() : mLayers.top()->GetAPIBitmap()->GetBitmap();
+}
+
+void IGraphicsLICE::BeginFrame()
+{
+  mPresentRects.Clear();
+
+  IGraphics::BeginFrame();
+}
+
+void IGraphicsLICE::CompleteRegion(const IRECT& bounds)
+{
+  if (mLayers.empty())
+    mPresentRects.Add(bounds);
+}
+
+void IGraphicsLICE::EndFrame()
+{
+  if (!mFrameBitmap)
+    return;
+
+#if defined OS_MAC || defined OS_WIN
+  const float scale = GetBackingPixelScale();
+  const int frameWidth = mFrameBitmap->getWidth();
+  const int frameHeight = mFrameBitmap->getHeight();
+
+  // only the regions drawn in this frame are copied to the window
+  mPresentRects.Optimize();
+
+  auto forEachPresentRect = [&](auto func) {
+    for (auto i = 0; i < mPresentRects.Size(); i++)
+    {
+      const IRECT& r = mPresentRects.Get(i);
+      const int x1 = Clip(static_cast<int>(std::floor(r.L * scale)), 0, frameWidth);
+      const int y1 = Clip(static_cast<int>(std::floor(r.T * scale)), 0, frameHeight);
+      const int x2 = Clip(static_cast<int>(std::ceil(r.R * scale)), 0, frameWidth);
+      const int y2 = Clip(static_cast<int>(std::ceil(r.B * scale)), 0, frameHeight);
+
+      if (x2 > x1 && y2 > y1)
+        func(x1, y1, x2 - x1, y2 - y1);
+    }
+  };
+#endif
+
+#if defined OS_MAC
+  CGContextRef pCGContext = (CGContextRef) GetPlatformContext();
+  CGColorSpaceRef pColorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef pBitmapContext = CGBitmapContextCreate(mFrameBitmap->getBits(), frameWidth, frameHeight, 8, mFrameBitmap->getRowSpan() * sizeof(LICE_pixel), pColorSpace, kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little);
+  CGImageRef pImage = CGBitmapContextCreateImage(pBitmapContext);
+
+  CGContextSaveGState(pCGContext);
+  CGContextScaleCTM(pCGContext, 1.0 / GetScreenScale(), 1.0 / GetScreenScale());
+
+  forEachPresentRect([&](int x, int y, int w, int h) {
+    CGImageRef pRegion = CGImageCreateWithImageInRect(pImage, CGRectMake(x, y, w, h));
+    // the view is flipped, so flip the image back
+    CGContextSaveGState(pCGContext);
+    CGContextTranslateCTM(pCGContext, x, y + h);
+    CGContextScaleCTM(pCGContext, 1.0, -1.0);
+    CGContextDrawImage(pCGContext, CGRectMake(0, 0, w, h), pRegion);
+    CGContextRestoreGState(pCGContext);
+    CGImageRelease(pRegion);
+  });
+
+  CGContextRestoreGState(pCGContext);
+  CGImageRelease(pImage);
+  CGContextRelease(pBitmapContext);
+  CGColorSpaceRelease(pColorSpace);
+#elif defined OS_WIN
+  BITMAPINFO bmpInfo;
+  ZeroMemory(&bmpInfo, sizeof(BITMAPINFO));
+  bmpInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bmpInfo.bmiHeader.biWidth = mFrameBitmap->getRowSpan();
+  bmpInfo.bmiHeader.biHeight = -frameHeight; // negative means top-down bitmap
+  bmpInfo.bmiHeader.biPlanes = 1;
+  bmpInfo.bmiHeader.biBitCount = 32;
+  bmpInfo.bmiHeader.biCompression = BI_RGB;
+
+  HWND hWnd = (HWND) GetWindow();
+  PAINTSTRUCT ps;
+  HDC hdc = BeginPaint(hWnd, &ps);
+
+  forEachPresentRect([&](int x, int y, int w, int h) {
+    StretchDIBits(hdc, x, y, w, h, x, y, w, h, mFrameBitmap->getBits(), &bmpInfo, DIB_RGB_COLORS, SRCCOPY);
+  });
+
+  EndPaint(hWnd, &ps);
+#elif defined OS_LINUX
+  // headless, the frame stays in mFrameBitmap, see GetFramePixels()
+#else
+  #error NOT IMPLEMENTED
+#endif
+}
+
+bool IGraphicsLICE::GetFramePixels(WDL_TypedBuf<uint32_t>& pixels, int& width, int& height)
+{
+  if (!mFrameBitmap)
+    return false;
+
+  width = mFrameBitmap->getWidth();
+  height = mFrameBitmap->getHeight();
+  pixels.Resize(width * height);
+
+  const LICE_pixel* pBits = mFrameBitmap->getBits();
+  const int span = mFrameBitmap->getRowSpan();
+
+  for (int y = 0; y < height; y++)
+    memcpy(pixels.Get() + (y * width), pBits + (y * span), width * sizeof(LICE_pixel));
+
+  return true;
+}
+
+#pragma mark - Transform and clip
+
+void IGraphicsLICE::PathTransformSetMatrix(const IMatrix& m)
+{
+  double xTranslate = 0.0;
+  double yTranslate = 0.0;
+
+  if (!mLayers.empty())
+  {
+    IRECT bounds = mLayers.top()->Bounds();
+
+    xTranslate = -bounds.L;
+    yTranslate = -bounds.T;
+  }
+
+  const float scale = GetBackingPixelScale();
+  mClipMatrix = IMatrix().Scale(scale, scale).Translate(static_cast<float>(xTranslate), static_cast<float>(yTranslate));
+  mMatrix = mClipMatrix;
+  mMatrix.Transform(m);
+}
+
+void IGraphicsLICE::SetClipRegion(const IRECT& r)
+{
+  double l = r.L, t = r.T, rr = r.R, b = r.B;
+  mClipMatrix.TransformPoint(l, t);
+  mClipMatrix.TransformPoint(rr, b);
+
+  const int w = mDrawBitmap ? mDrawBitmap->getWidth() : 0;
+  const int h = mDrawBitmap ? mDrawBitmap->getHeight() : 0;
+
+  // regions are pixel aligned, so rounding only removes numerical error
+  mClipL = Clip(static_cast<int>(std::floor(std::min(l, rr) + 0.5)), 0, w);
+  mClipT = Clip(static_cast<int>(std::floor(std::min(t, b) + 0.5)), 0, h);
+  mClipR = Clip(static_cast<int>(std::floor(std::max(l, rr) + 0.5)), 0, w);
+  mClipB = Clip(static_cast<int>(std::floor(std::max(t, b) + 0.5)), 0, h);
+}
+
+void IGraphicsLICE::DevicePoint(float x, float y, float& dx, float& dy) const
+{
+  double tx, ty;
+  mMatrix.TransformPoint(tx, ty, x, y);
+  dx = static_cast<float>(tx);
+  dy = static_cast<float>(ty);
+}
+
+float IGraphicsLICE::DeviceScale() const
+{
+  return static_cast<float>(std::sqrt(std::fabs(mMatrix.mXX * mMatrix.mYY - mMatrix.mXY * mMatrix.mYX)));
+}
+
+#pragma mark - Paths
+
+void IGraphicsLICE::PathClear()
+{
+  mPath.Clear();
+}
+
+void IGraphicsLICE::PathClose()
+{
+  mPath.Close();
+}
+
+void IGraphicsLICE::PathMoveTo(float x, float y)
+{
+  float dx, dy;
+  DevicePoint(x, y, dx, dy);
+  mPath.MoveTo(dx, dy);
+}
+
+void IGraphicsLICE::PathLineTo(float x, float y)
+{
+  float dx, dy;
+  DevicePoint(x, y, dx, dy);
+  mPath.LineTo(dx, dy);
+}
+
+void IGraphicsLICE::PathArc(float cx, float cy, float r, float a1, float a2, EWinding winding)
+{
+  float sweep = (a2 - a1);
+  const bool circle = sweep >= 360.f || sweep <= -360.f;
+
+  if (circle)
+  {
+    sweep = 360.f;
+  }
+  else if (winding == EWinding::CW)
+  {
+    while (sweep < 0)
+      sweep += 360.f;
+  }
+  else
+  {
+    while (sweep > 0)
+      sweep -= 360.f;
+  }
+
+  // enough segments to keep within a fifth of a pixel of the true arc
+  const float radius = r * DeviceScale();
+  const float step = radius > 0.2f ? 2.f * std::acos(1.f - 0.2f / radius) : static_cast<float>(PI * 0.5);
+  const int nSegments = Clip(static_cast<int>(std::ceil(std::fabs(DegToRad(sweep)) / step)), 1, 1024);
+  const float start = static_cast<float>(DegToRad(a1 - 90.f));
+  const float delta = static_cast<float>(DegToRad(sweep)) / nSegments;
+
+  for (int i = 0; i <= nSegments; i++)
+  {
+    if (circle && i == nSegments)
+      break;
+
+    float dx, dy;
+    const float angle = start + delta * i;
+    DevicePoint(cx + r * std::cos(angle), cy + r * std::sin(angle), dx, dy);
+
+    if (i == 0 && (circle || mPath.Empty() || mPath.mSubPaths.back().closed))
+      mPath.MoveTo(dx, dy);
+    else
+      mPath.LineTo(dx, dy);
+  }
+
+  if (circle)
+    mPath.Close();
+}
+
+void IGraphicsLICE::PathCubicBezierTo(float c1x, float c1y, float c2x, float c2y, float x2, float y2)
+{
+  PathPoint p[4];
+
+  if (mPath.Empty())
+    PathMoveTo(c1x, c1y);
+
+  p[0] = mPath.mPoints.back();
+  DevicePoint(c1x, c1y, p[1].x, p[1].y);
+  DevicePoint(c2x, c2y, p[2].x, p[2].y);
+  DevicePoint(x2, y2, p[3].x, p[3].y);
+
+  // the segment count bounds the distance from the curve to a fifth of a pixel, from the maximum second difference of the control points
+  const float ddx = std::max(std::fabs(p[0].x - 2.f * p[1].x + p[2].x), std::fabs(p[1].x - 2.f * p[2].x + p[3].x));
+  const float ddy = std::max(std::fabs(p[0].y - 2.f * p[1].y + p[2].y), std::fabs(p[1].y - 2.f * p[2].y + p[3].y));
+  const int nSegments = Clip(static_cast<int>(std::ceil(std::sqrt(0.75f * std::sqrt(ddx * ddx + ddy * ddy) / 0.2f))), 1, 256);
+
+  for (int i = 1; i <= nSegments; i++)
+  {
+    const float t = static_cast<float>(i) / nSegments;
+    const float mt = 1.f - t;
+    const float w0 = mt * mt * mt;
+    const float w1 = 3.f * mt * mt * t;
+    const float w2 = 3.f * mt * t * t;
+    const float w3 = t * t * t;
+    mPath.LineTo(w0 * p[0].x + w1 * p[1].x + w2 * p[2].x + w3 * p[3].x, w0 * p[0].y + w1 * p[1].y + w2 * p[2].y + w3 * p[3].y);
+  }
+}
+
+void IGraphicsLICE::PathQuadraticBezierTo(float cx, float cy, float x2, float y2)
+{
+  PathPoint p[3];
+
+  if (mPath.Empty())
+    PathMoveTo(cx, cy);
+
+  p[0] = mPath.mPoints.back();
+  DevicePoint(cx, cy, p[1].x, p[1].y);
+  DevicePoint(x2, y2, p[2].x, p[2].y);
+
+  const float ddx = p[0].x - 2.f * p[1].x + p[2].x;
+  const float ddy = p[0].y - 2.f * p[1].y + p[2].y;
+  const int nSegments = Clip(static_cast<int>(std::ceil(std::sqrt(0.25f * std::sqrt(ddx * ddx + ddy * ddy) / 0.2f))), 1, 256);
+
+  for (int i = 1; i <= nSegments; i++)
+  {
+    const float t = static_cast<float>(i) / nSegments;
+    const float mt = 1.f - t;
+    mPath.LineTo(mt * mt * p[0].x + 2.f * mt * t * p[1].x + t * t * p[2].x, mt * mt * p[0].y + 2.f * mt * t * p[1].y + t * t * p[2].y);
+  }
+}
+
+void IGraphicsLICE::PathStroke(const IPattern& pattern, float thickness, const IStrokeOptions& options, const IBlend* pBlend)
+{
+  Paint paint;
+  SetPaint(paint, pattern, pBlend, mMatrix);
+  StrokePolygons(mPath, thickness * DeviceScale(), options, mStroke);
+  FillPolygons(mStroke, false, paint);
+
+  if (!options.mPreserve)
+    mPath.Clear();
+}
+
+void IGraphicsLICE::PathFill(const IPattern& pattern, const IFillOptions& options, const IBlend* pBlend)
+{
+  Paint paint;
+  SetPaint(paint, pattern, pBlend, mMatrix);
+  FillPolygons(mPath, options.mFillRule != EFillRule::Winding, paint);
+
+  if (!options.mPreserve)
+    mPath.Clear();
+}
+
+#pragma mark - Stroking
+
+// Strokes are converted to a union of polygons - a quad per segment plus the joins and caps - all with the same orientation,
+// so that filling them with the non-zero rule covers each pixel once
+
+void IGraphicsLICE::StrokePolygons(const Polygons& path, float width, const IStrokeOptions& options, Polygons& outline) const
+{
+  const float halfWidth = width * 0.5f;
+
+  outline.Clear();
+
+  if (halfWidth <= 0.f)
+    return;
+
+  const Polygons* pSource = &path;
+  Polygons dashed;
+
+  if (options.mDash.GetCount())
+  {
+    // N.B. support odd counts by reading the array twice
+    const float scale = DeviceScale();
+    const int dashCount = options.mDash.GetCount();
+    const int dashMax = dashCount & 1 ? dashCount * 2 : dashCount;
+    float dashArray[16];
+    float total = 0.f;
+
+    for (int i = 0; i < dashMax; i++)
+    {
+      dashArray[i] = std::max(0.f, options.mDash.GetArray()[i % dashCount] * scale);
+      total += dashArray[i];
+    }
+
+    if (total > 0.f)
+    {
+      DashPolygons(path, dashArray, dashMax, options.mDash.GetOffset() * scale, dashed);
+      pSource = &dashed;
+    }
+  }
+
+  std::vector<PathPoint> points;
+
+  auto distance = [](const PathPoint& a, const PathPoint& b) {
+    return std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+  };
+
+  for (const SubPath& subPath : pSource->mSubPaths)
+  {
+    const PathPoint* pPoints = &pSource->mPoints[subPath.start];
+
+    // drop degenerate segments
+    points.clear();
+
+    for (int i = 0; i < subPath.count; i++)
+    {
+      if (points.empty() || distance(points.back(), pPoints[i]) > 1e-4f)
+        points.push_back(pPoints[i]);
+    }
+
+    if (subPath.closed && points.size() > 1 && distance(points.back(), points.front()) <= 1e-4f)
+      points.pop_back();
+
+    const int n = static_cast<int>(points.size());
+
+    if (n == 1)
+    {
+      // a zero length subpath still gets a round or square dot
+      if (options.mCapOption != ELineCap::Butt)
+      {
+        AddStrokeCap(outline, points[0], 1.f, 0.f, halfWidth, options.mCapOption);
+        AddStrokeCap(outline, points[0], -1.f, 0.f, halfWidth, options.mCapOption);
+      }
+
+      continue;
+    }
+
+    const bool closed = subPath.closed && n > 2;
+    const int nSegments = closed ? n : n - 1;
+
+    for (int i = 0; i < nSegments; i++)
+    {
+      const PathPoint& a = points[i];
+      const PathPoint& b = points[(i + 1) % n];
+      const float length = distance(a, b);
+      const float nx = -(b.y - a.y) / length * halfWidth;
+      const float ny = (b.x - a.x) / length * halfWidth;
+
+      const PathPoint quad[4] = {{a.x + nx, a.y + ny}, {b.x + nx, b.y + ny}, {b.x - nx, b.y - ny}, {a.x - nx, a.y - ny}};
+      AddStrokePolygon(outline, quad, 4);
+    }
+
+    for (int i = closed ? 0 : 1; i < (closed ? n : n - 1); i++)
+      AddStrokeJoin(outline, points[(i + n - 1) % n], points[i], points[(i + 1) % n], halfWidth, options);
+
+    if (!closed)
+    {
+      const float startLength = distance(points[0], points[1]);
+      const float endLength = distance(points[n - 2], points[n - 1]);
+
+      AddStrokeCap(outline, points[0], (points[0].x - points[1].x) / startLength, (points[0].y - points[1].y) / startLength, halfWidth, options.mCapOption);
+      AddStrokeCap(outline, points[n - 1], (points[n - 1].x - points[n - 2].x) / endLength, (points[n - 1].y - points[n - 2].y) / endLength, halfWidth, options.mCapOption);
+    }
+  }
+}
+
+void IGraphicsLICE::DashPolygons(const Polygons& path, const float* pDashes, int nDashes, float offset, Polygons& dashed)
+{
+  float total = 0.f;
+
+  for (int i = 0; i < nDashes; i++)
+    total += pDashes[i];
+
+  dashed.Clear();
+
+  for (const SubPath& subPath : path.mSubPaths)
+  {
+    const PathPoint* pPoints = &path.mPoints[subPath.start];
+
+    // find the dash the subpath starts in
+    float phase = std::fmod(offset, total);
+    int idx = 0;
+
+    if (phase < 0.f)
+      phase += total;
+
+    while (phase >= pDashes[idx])
+    {
+      phase -= pDashes[idx];
+      idx = (idx + 1) % nDashes;
+    }
+
+    float remaining = pDashes[idx] - phase;
+    bool on = !(idx & 1);
+
+    if (on)
+      dashed.MoveTo(pPoints[0].x, pPoints[0].y);
+
+    const int nSegments = subPath.closed ? subPath.count : subPath.count - 1;
+
+    for (int i = 0; i < nSegments; i++)
+    {
+      const PathPoint& a = pPoints[i];
+      const PathPoint& b = pPoints[(i + 1) % subPath.count];
+      const float length = std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+      float pos = 0.f;
+
+      while (length - pos > remaining)
+      {
+        pos += remaining;
+
+        const float x = a.x + (b.x - a.x) * pos / length;
+        const float y = a.y + (b.y - a.y) * pos / length;
+
+        if (on)
+          dashed.LineTo(x, y);
+        else
+          dashed.MoveTo(x, y);
+
+        on = !on;
+        idx = (idx + 1) % nDashes;
+        remaining = pDashes[idx];
+      }
+
+      remaining -= length - pos;
+
+      if (on)
+        dashed.LineTo(b.x, b.y);
+    }
+  }
+}
+
+void IGraphicsLICE::AddStrokeJoin(Polygons& outline, const PathPoint& p0, const PathPoint& p1, const PathPoint& p2, float halfWidth, const IStrokeOptions& options)
+{
+  float d0x = p1.x - p0.x, d0y = p1.y - p0.y;
+  float d1x = p2.x - p1.x, d1y = p2.y - p1.y;
+  const float l0 = std::sqrt(d0x * d0x + d0y * d0y);
+  const float l1 = std::sqrt(d1x * d1x + d1y * d1y);
+  d0x /= l0; d0y /= l0;
+  d1x /= l1; d1y /= l1;
+
+  const float cross = d0x * d1y - d0y * d1x;
+  const float dot = d0x * d1x + d0y * d1y;
+
+  if (std::fabs(cross) < 1e-6f && dot > 0.f)
+    return;
+
+  if (options.mJoinOption == ELineJoin::Round)
+  {
+    AddStrokeCircle(outline, p1, halfWidth);
+    return;
+  }
+
+  // the gap to fill is on the outside of the turn
+  const float side = cross > 0.f ? -halfWidth : halfWidth;
+  const PathPoint a = {p1.x - d0y * side, p1.y + d0x * side};
+  const PathPoint b = {p1.x - d1y * side, p1.y + d1x * side};
+
+  if (options.mJoinOption == ELineJoin::Miter)
+  {
+    const float cosHalfTurn = std::sqrt(std::max(0.f, (1.f + dot) * 0.5f));
+
+    if (cosHalfTurn > 1e-6f && 1.f / cosHalfTurn <= options.mMiterLimit)
+    {
+      // the miter bisects the two offsets, use the unit directions rather than a - p1 and b - p1, which cancel out for very thin strokes
+      const float mx = (d0y + d1y) * (cross > 0.f ? 1.f : -1.f);
+      const float my = (d0x + d1x) * (cross > 0.f ? -1.f : 1.f);
+      const float ml = std::sqrt(mx * mx + my * my);
+      const float miterLength = halfWidth / cosHalfTurn;
+
+      const PathPoint miter[4] = {p1, a, {p1.x + mx / ml * miterLength, p1.y + my / ml * miterLength}, b};
+      AddStrokePolygon(outline, miter, 4);
+      return;
+    }
+  }
+
+  const PathPoint bevel[3] = {p1, a, b};
+  AddStrokePolygon(outline, bevel, 3);
+}
+
+void IGraphicsLICE::AddStrokeCap(Polygons& outline, const PathPoint& end, float dx, float dy, float halfWidth, ELineCap cap)
+{
+  const float nx = -dy * halfWidth;
+  const float ny = dx * halfWidth;
+
+  switch (cap)
+  {
+    case ELineCap::Butt:
+      break;
+    case ELineCap::Round:
+      AddStrokeCircle(outline, end, halfWidth);
+      break;
+    case ELineCap::Square:
+    {
+      const float ex = dx * halfWidth;
+      const float ey = dy * halfWidth;
+      const PathPoint square[4] = {{end.x + nx, end.y + ny}, {end.x + nx + ex, end.y + ny + ey}, {end.x - nx + ex, end.y - ny + ey}, {end.x - nx, end.y - ny}};
+      AddStrokePolygon(outline, square, 4);
+      break;
+    }
+  }
+}
+
+void IGraphicsLICE::AddStrokeCircle(Polygons& outline, const PathPoint& centre, float radius)
+{
+  const float step = radius > 0.2f ? 2.f * std::acos(1.f - 0.2f / radius) : static_cast<float>(PI * 0.25);
+  const int nSegments = Clip(static_cast<int>(std::ceil(2.0 * PI / step)), 8, 256);
+  PathPoint points[256];
+
+  for (int i = 0; i < nSegments; i++)
+  {
+    const double angle = 2.0 * PI * i / nSegments;
+    points[i] = {centre.x + radius * static_cast<float>(std::cos(angle)), centre.y + radius * static_cast<float>(std::sin(angle))};
+  }
+
+  AddStrokePolygon(outline, points, nSegments);
+}
+
+void IGraphicsLICE::AddStrokePolygon(Polygons& outline, const PathPoint* pPoints, int nPoints)
+{
+  float area = 0.f;
+
+  for (int i = 0; i < nPoints; i++)
+  {
+    const PathPoint& a = pPoints[i];
+    const PathPoint& b = pPoints[(i + 1) % nPoints];
+    area += a.x * b.y - b.x * a.y;
+  }
+
+  if (std::fabs(area) < 1e-9f)
+    return;
+
+  if (area > 0.f)
+  {
+    outline.MoveTo(pPoints[0].x, pPoints[0].y);
+
+    for (int i = 1; i < nPoints; i++)
+      outline.LineTo(pPoints[i].x, pPoints[i].y);
+  }
+  else
+  {
+    outline.MoveTo(pPoints[nPoints - 1].x, pPoints[nPoints - 1].y);
+
+    for (int i = nPoints - 2; i >= 0; i--)
+      outline.LineTo(pPoints[i].x, pPoints[i].y);
+  }
+
+  outline.Close();
+}
+
+#pragma mark - Filling
+
+void IGraphicsLICE::SetPaint(Paint& paint, const IPattern& pattern, const IBlend* pBlend, const IMatrix& matrix)
+{
+  const float weight = BlendWeight(pBlend);
+
+  paint.mMethod = pBlend ? pBlend->mMethod : EBlend::SrcOver;
+  paint.mExtend = pattern.mExtend;
+
+  if (pattern.mType == EPatternType::Solid || pattern.NStops() < 2)
+  {
+    paint.mType = EPatternType::Solid;
+    paint.mColor = PremultipliedColor(pattern.GetStop(0).mColor, weight);
+    return;
+  }
+
+  paint.mType = pattern.mType;
+
+  // device pixels to user space, then to pattern space
+  IMatrix inverse = matrix;
+  inverse.Invert();
+  paint.mInverse = pattern.mTransform;
+  paint.mInverse.Transform(inverse);
+
+  // colours are interpolated unpremultiplied, then premultiplied into the table
+  const int nStops = pattern.NStops();
+  const float lastOffset = pattern.GetStop(nStops - 1).mOffset;
+  int stop = 0;
+
+  for (int i = 0; i < 256; i++)
+  {
+    const float t = i / 255.f;
+
+    while (stop < nStops - 1 && t > pattern.GetStop(stop + 1).mOffset)
+      stop++;
+
+    const IColorStop& s0 = pattern.GetStop(stop);
+    const IColorStop& s1 = pattern.GetStop(std::min(stop + 1, nStops - 1));
+    const float range = s1.mOffset - s0.mOffset;
+    const float f = range > 0.f ? Clip((t - s0.mOffset) / range, 0.f, 1.f) : (t >= s1.mOffset ? 1.f : 0.f);
+
+    auto lerp = [f](int a, int b) { return static_cast<int>(a + (b - a) * f + 0.5f); };
+    const IColor color(lerp(s0.mColor.A, s1.mColor.A), lerp(s0.mColor.R, s1.mColor.R), lerp(s0.mColor.G, s1.mColor.G), lerp(s0.mColor.B, s1.mColor.B));
+
+    // sweeps end at the last stop, as for the skia backend
+    const bool transparent = pattern.mType == EPatternType::Sweep && t > lastOffset;
+
+    paint.mLUT[i] = transparent ? 0 : PremultipliedColor(color, weight);
+  }
+}
+
+void IGraphicsLICE::FillPolygons(const Polygons& polygons, bool evenOdd, const Paint& paint)
+{
+  if (!mDrawBitmap || polygons.Empty() || mClipL >= mClipR || mClipT >= mClipB)
+    return;
+
+  if (FillAlignedRect(polygons, paint))
+    return;
+
+  float minX = polygons.mPoints[0].x, maxX = minX;
+  float minY = polygons.mPoints[0].y, maxY = minY;
+
+  for (const PathPoint& p : polygons.mPoints)
+  {
+    minX = std::min(minX, p.x);
+    maxX = std::max(maxX, p.x);
+    minY = std::min(minY, p.y);
+    maxY = std::max(maxY, p.y);
+  }
+
+  const int x1 = std::max(mClipL, static_cast<int>(std::floor(minX)));
+  const int x2 = std::min(mClipR, static_cast<int>(std::ceil(maxX)));
+  const int y1 = std::max(mClipT, static_cast<int>(std::floor(minY)));
+  const int y2 = std::min(mClipB, static_cast<int>(std::ceil(maxY)));
+
+  if (x1 >= x2 || y1 >= y2)
+    return;
+
+  const int w = x2 - x1;
+  const int h = y2 - y1;
+  const int stride = w + 2;
+
+  // N.B. the buffer is left zeroed as rows are read, so it is only ever cleared when it grows
+  if (mAccumulation.size() < static_cast<size_t>(stride * h))
+    mAccumulation.resize(stride * h, 0.f);
+
+  if (mCoverage.size() < static_cast<size_t>(w))
+    mCoverage.resize(w);
+
+  float* pAcc = mAccumulation.data();
+
+  for (const SubPath& subPath : polygons.mSubPaths)
+  {
+    const PathPoint* pPoints = &polygons.mPoints[subPath.start];
+
+    if (subPath.count < 3)
+      continue;
+
+    for (int i = 0; i < subPath.count; i++)
+    {
+      const PathPoint& a = pPoints[i];
+      const PathPoint& b = pPoints[(i + 1) % subPath.count];
+      AccumulateLine(pAcc, stride, h, a.x - x1, a.y - y1, b.x - x1, b.y - y1);
+    }
+  }
+
+  for (int y = 0; y < h; y++)
+  {
+    float* pRow = pAcc + (y * stride);
+    float sum = 0.f;
+    int first = -1;
+    int last = -1;
+
+    for (int x = 0; x < w; x++)
+    {
+      sum += pRow[x];
+      pRow[x] = 0.f;
+
+      float coverage = std::fabs(sum);
+
+      if (evenOdd)
+      {
+        coverage = std::fmod(coverage, 2.f);
+        coverage = coverage > 1.f ? 2.f - coverage : coverage;
+      }
+      else
+      {
+        coverage = std::min(coverage, 1.f);
+      }
+
+      const uint8_t c = static_cast<uint8_t>(coverage * 255.f + 0.5f);
+      mCoverage[x] = c;
+
+      if (c)
+      {
+        if (first < 0)
+          first = x;
+        last = x;
+      }
+    }
+
+    pRow[w] = 0.f;
+    pRow[w + 1] = 0.f;
+
+    if (first >= 0)
+      CompositeSpan(x1 + first, y1 + y, last - first + 1, mCoverage.data() + first, paint);
+  }
+}
+
+bool IGraphicsLICE::FillAlignedRect(const Polygons& polygons, const Paint& paint)
+{
+  // pixel aligned rectangles are common (backgrounds, panels, layers) and need no coverage calculation
+  if (polygons.mSubPaths.size() != 1 || polygons.mSubPaths[0].count != 4)
+    return false;
+
+  const PathPoint* p = polygons.mPoints.data();
+
+  for (int i = 0; i < 4; i++)
+  {
+    const PathPoint& a = p[i];
+    const PathPoint& b = p[(i + 1) % 4];
+
+    if (!NearInteger(a.x) || !NearInteger(a.y) || (a.x != b.x && a.y != b.y))
+      return false;
+  }
+
+  const int x1 = std::max(mClipL, static_cast<int>(std::floor(std::min(p[0].x, p[2].x) + 0.5f)));
+  const int x2 = std::min(mClipR, static_cast<int>(std::floor(std::max(p[0].x, p[2].x) + 0.5f)));
+  const int y1 = std::max(mClipT, static_cast<int>(std::floor(std::min(p[0].y, p[2].y) + 0.5f)));
+  const int y2 = std::min(mClipB, static_cast<int>(std::floor(std::max(p[0].y, p[2].y) + 0.5f)));
+
+  if (x1 >= x2 || y1 >= y2)
+    return true;
+
+  if (paint.IsSolid() && paint.mMethod == EBlend::SrcOver && LICE_GETA(paint.mColor) == 255)
+  {
+    LICE_FillRect(mDrawBitmap, x1, y1, x2 - x1, y2 - y1, paint.mColor, 1.f, LICE_BLIT_MODE_COPY);
+    return true;
+  }
+
+  for (int y = y1; y < y2; y++)
+    CompositeSpan(x1, y, x2 - x1, nullptr, paint);
+
+  return true;
+}
+
+void IGraphicsLICE::CompositeSpan(int x, int y, int n, const uint8_t* pCoverage, const Paint& paint)
+{
+  LICE_pixel* pDst = mDrawBitmap->getBits() + (y * mDrawBitmap->getRowSpan()) + x;
+  const LICE_pixel* pSrc = nullptr;
+  const bool solid = paint.IsSolid();
+
+  if (!solid)
+  {
+    if (mSpan.size() < static_cast<size_t>(n))
+      mSpan.resize(n);
+
+    paint.Shade(x, y, n, mSpan.data());
+    pSrc = mSpan.data();
+  }
+
+  if (paint.mMethod == EBlend::SrcOver)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      LICE_pixel s = solid ? paint.mColor : pSrc[i];
+
+      if (pCoverage && pCoverage[i] < 255)
+        s = ScalePixel(s, Coverage256(pCoverage[i]));
+
+      if (s)
+        pDst[i] = SrcOverPixel(s, pDst[i]);
+    }
+  }
+  else
+  {
+    for (int i = 0; i < n; i++)
+    {
+      const uint32_t c = pCoverage ? pCoverage[i] : 255;
+
+      if (!c)
+        continue;
+
+      const LICE_pixel result = BlendPixel(solid ? paint.mColor : pSrc[i], pDst[i], paint.mMethod);
+      pDst[i] = c == 255 ? result : LerpPixel(pDst[i], result, Coverage256(c));
+    }
+  }
+}
+
+#pragma mark - Bitmaps
+
+void IGraphicsLICE::DrawBitmap(const IBitmap& bitmap, const IRECT& dest, int srcX, int srcY, const IBlend* pBlend)
+{
+  LICE_IBitmap* pBitmap = bitmap.GetAPIBitmap()->GetBitmap();
+
+  if (!pBitmap->getWidth() || !pBitmap->getHeight())
+    return;
+
+  const double scale1 = 1.0 / (bitmap.GetScale() * bitmap.GetDrawScale());
+
+  // the area of dest covered by the image, which is positioned so that the source point lands on the top left of dest
+  const float imageL = dest.L - srcX;
+  const float imageT = dest.T - srcY;
+  const IRECT imageBounds(imageL, imageT, imageL + static_cast<float>(pBitmap->getWidth() * scale1), imageT + static_cast<float>(pBitmap->getHeight() * scale1));
+  const IRECT area = dest.Intersect(imageBounds);
+
+  if (area.Empty())
+    return;
+
+  Paint paint;
+  paint.mMethod = pBlend ? pBlend->mMethod : EBlend::SrcOver;
+  paint.mBitmap = pBitmap;
+  paint.mAlpha = Clip(static_cast<int>(BlendWeight(pBlend) * 256.f + 0.5f), 0, 256);
+  paint.mInverse = mMatrix;
+  paint.mInverse.Transform(IMatrix(scale1, 0.0, 0.0, scale1, imageL, imageT));
+  paint.mInverse.Invert();
+
+  const IMatrix& m = paint.mInverse;
+
+  if (std::fabs(m.mXX - 1.0) < 1e-6 && std::fabs(m.mYY - 1.0) < 1e-6 && std::fabs(m.mXY) < 1e-6 && std::fabs(m.mYX) < 1e-6 && NearInteger(m.mTX) && NearInteger(m.mTY))
+  {
+    paint.mIntegral = true;
+    paint.mOffsetX = static_cast<int>(std::floor(m.mTX + 0.5));
+    paint.mOffsetY = static_cast<int>(std::floor(m.mTY + 0.5));
+  }
+
+  Polygons polygon;
+  const float corners[4][2] = {{area.L, area.T}, {area.R, area.T}, {area.R, area.B}, {area.L, area.B}};
+
+  for (int i = 0; i < 4; i++)
+  {
+    float dx, dy;
+    DevicePoint(corners[i][0], corners[i][1], dx, dy);
+
+    if (i == 0)
+      polygon.MoveTo(dx, dy);
+    else
+      polygon.LineTo(dx, dy);
+  }
+
+  polygon.Close();
+  FillPolygons(polygon, false, paint);
+}
+
+IColor IGraphicsLICE::GetPoint(int x, int y)
+{
+  if (!mDrawBitmap || x < 0 || y < 0 || x >= mDrawBitmap->getWidth() || y >= mDrawBitmap->getHeight())
+    return COLOR_TRANSPARENT;
+
+  const LICE_pixel p = mDrawBitmap->getBits()[y * mDrawBitmap->getRowSpan() + x];
+  const int a = LICE_GETA(p);
+
+  if (!a)
+    return COLOR_TRANSPARENT;
+
+  auto unpremultiply = [a](int c) { return std::min(255, (c * 255 + a / 2) / a); };
+
+  return IColor(a, unpremultiply(LICE_GETR(p)), unpremultiply(LICE_GETG(p)), unpremultiply(LICE_GETB(p)));
+}
+
+void IGraphicsLICE::GetLayerBitmapData(const ILayerPtr& layer, RawBitmapData& data)
+{
+  LICE_IBitmap* pBitmap = layer->GetAPIBitmap()->GetBitmap();
+  const int width = pBitmap->getWidth();
+  const int height = pBitmap->getHeight();
+  const int rowBytes = width * sizeof(LICE_pixel);
+  const int size = height * rowBytes;
+
+  data.Resize(size);
+
+  if (data.GetSize() >= size)
+  {
+    for (int y = 0; y < height; y++)
+      memcpy(data.Get() + (y * rowBytes), pBitmap->getBits() + (y * pBitmap->getRowSpan()), rowBytes);
+  }
+}
+
+void IGraphicsLICE::ApplyShadowMask(ILayerPtr& layer, RawBitmapData& mask, const IShadow& shadow)
+{
+  LICE_IBitmap* pBitmap = layer->GetAPIBitmap()->GetBitmap();
+  const int width = pBitmap->getWidth();
+  const int height = pBitmap->getHeight();
+  const int span = pBitmap->getRowSpan();
+  const double scale = layer->GetAPIBitmap()->GetDrawScale() * layer->GetAPIBitmap()->GetScale();
+
+  if (!width || !height || mask.GetSize() < width * height * static_cast<int>(sizeof(LICE_pixel)))
+    return;
+
+  const int rowBytes = mask.GetSize() / height;
+  const int xOffset = static_cast<int>(std::floor(shadow.mXOffset * scale + 0.5));
+  const int yOffset = static_cast<int>(std::floor(shadow.mYOffset * scale + 0.5));
+
+  // the shadow pattern is in the layer's pixel space
+  const IRECT& bounds = layer->Bounds();
+  IBlend blend(EBlend::Default, shadow.mOpacity);
+  Paint paint;
+  SetPaint(paint, shadow.mPattern, &blend, IMatrix().Scale(static_cast<float>(scale), static_cast<float>(scale)).Translate(-bounds.L, -bounds.T));
+
+  if (mSpan.size() < static_cast<size_t>(width))
+    mSpan.resize(width);
+
+  for (int y = 0; y < height; y++)
+  {
+    LICE_pixel* pRow = pBitmap->getBits() + (y * span);
+    const int maskY = y - yOffset;
+
+    if (paint.IsSolid())
+      std::fill(mSpan.begin(), mSpan.begin() + width, paint.mColor);
+    else
+      paint.Shade(0, y, width, mSpan.data());
+
+    for (int x = 0; x < width; x++)
+    {
+      const int maskX = x - xOffset;
+      uint32_t alpha = 0;
+
+      if (maskX >= 0 && maskX < width && maskY >= 0 && maskY < height)
+        alpha = mask.Get()[maskY * rowBytes + maskX * sizeof(LICE_pixel) + AlphaChannel()];
+
+      const LICE_pixel shadowPixel = ScalePixel(mSpan[x], Coverage256(alpha));
+      pRow[x] = shadow.mDrawForeground ? SrcOverPixel(pRow[x], shadowPixel) : shadowPixel;
+    }
+  }
+}
+
+#pragma mark - Text
+
+bool IGraphicsLICE::LoadAPIFont(const char* fontID, const PlatformFontPtr& font)
+{
+  StaticStorage<Font>::Accessor storage(sFontCache);
+  Font* cached = storage.Find(fontID);
+
+  if (cached)
+    return true;
+
+  IFontDataPtr data = font->GetFontData();
+
+  if (data->IsValid())
+  {
+    std::unique_ptr<Font> pFont(new Font(std::move(data)));
+
+    if (pFont->mValid)
+    {
+      const size_t bytes = pFont->mData->GetSize();
+      storage.Add(pFont.release(), fontID, 1., bytes);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void IGraphicsLICE::PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double& y, Font& font) const
+{
+  const double scale = font.Scale(text.mSize);
+  const double textWidth = font.MeasureWidth(str) * scale;
+  const double textHeight = text.mSize;
+  const double ascender = -font.mAscent * scale;
+  const double descender = -font.mDescent * scale;
+
+  switch (text.mAlign)
+  {
+    case EAlign::Near:     x = r.L;                          break;
+    case EAlign::Center:   x = r.MW() - (textWidth / 2.0);   break;
+    case EAlign::Far:      x = r.R - textWidth;              break;
+  }
+
+  switch (text.mVAlign)
+  {
+    case EVAlign::Top:      y = r.T - ascender;                            break;
+    case EVAlign::Middle:   y = r.MH() - descender + (textHeight / 2.0);   break;
+    case EVAlign::Bottom:   y = r.B - descender;                           break;
+  }
+
+  r = IRECT((float) x, (float) (y + ascender), (float) (x + textWidth), (float) (y + ascender + textHeight));
+}
+
+float IGraphicsLICE::DoMeasureText(const IText& text, const char* str, IRECT& bounds) const
+{
+  StaticStorage<Font>::Accessor storage(sFontCache);
+  Font* pFont = storage.Find(text.mFont);
+
+  assert(pFont && "No font found - did you forget to load it?");
+
+  IRECT r = bounds;
+  double x, y;
+  PrepareAndMeasureText(text, str, bounds, x, y, *pFont);
+  DoMeasureTextRotation(text, r, bounds);
+  return bounds.W();
+}
+
+void IGraphicsLICE::DoDrawText(const IText& text, const char* str, const IRECT& bounds, const IBlend* pBlend)
+{
+  StaticStorage<Font>::Accessor storage(sFontCache);
+  Font* pFont = storage.Find(text.mFont);
+
+  assert(pFont && "No font found - did you forget to load it?");
+
+  IRECT measured = bounds;
+  double x, y;
+
+  PrepareAndMeasureText(text, str, measured, x, y, *pFont);
+  PathTransformSave();
+  DoTextRotation(text, bounds, measured);
+
+  Paint paint;
+  SetPaint(paint, IPattern(text.mFGColor), pBlend, mMatrix);
+
+  const float scale = pFont->Scale(text.mSize);
+  const bool axisAligned = std::fabs(mMatrix.mXY) < 1e-6 && std::fabs(mMatrix.mYX) < 1e-6 && std::fabs(mMatrix.mXX - mMatrix.mYY) < 1e-6 && mMatrix.mXX > 0.0;
+  int prev = 0;
+
+  if (axisAligned && mDrawBitmap)
+  {
+    // glyph masks rendered at the device size, on the pixel grid vertically and to a quarter pixel horizontally
+    const float glyphScale = static_cast<float>(scale * mMatrix.mXX);
+    const int baseline = static_cast<int>(std::floor(mMatrix.mYY * y + mMatrix.mTY + 0.5));
+    double penX = mMatrix.mXX * x + mMatrix.mTX;
+
+    while (*str)
+    {
+      int codepoint;
+      str += wdl_utf8_parsechar(str, &codepoint);
+
+      if (prev)
+        penX += glyphScale * stbtt_GetCodepointKernAdvance(&pFont->mInfo, prev, codepoint);
+
+      const int penXi = static_cast<int>(std::floor(penX));
+      const int subpixel = std::min(3, static_cast<int>((penX - penXi) * 4.0));
+      const Font::Glyph& glyph = pFont->GetGlyph(codepoint, glyphScale, subpixel);
+      const int gx = penXi + glyph.x;
+      const int gy = baseline + glyph.y;
+      const int x1 = std::max(mClipL, gx);
+      const int x2 = std::min(mClipR, gx + glyph.w);
+
+      if (x1 < x2)
+      {
+        for (int row = std::max(mClipT, gy); row < std::min(mClipB, gy + glyph.h); row++)
+          CompositeSpan(x1, row, x2 - x1, glyph.mMask.data() + ((row - gy) * glyph.w) + (x1 - gx), paint);
+      }
+
+      int advance, lsb;
+      stbtt_GetCodepointHMetrics(&pFont->mInfo, codepoint, &advance, &lsb);
+      penX += advance * glyphScale;
+      prev = codepoint;
+    }
+  }
+  else
+  {
+    // rotated or skewed text is filled from the glyph outlines
+    Polygons savedPath;
+    std::swap(savedPath, mPath);
+    mPath.Clear();
+
+    double penX = x;
+
+    while (*str)
+    {
+      int codepoint;
+      str += wdl_utf8_parsechar(str, &codepoint);
+
+      if (prev)
+        penX += scale * stbtt_GetCodepointKernAdvance(&pFont->mInfo, prev, codepoint);
+
+      stbtt_vertex* pVertices = nullptr;
+      const int nVertices = stbtt_GetCodepointShape(&pFont->mInfo, codepoint, &pVertices);
+
+      auto gx = [&](float vx) { return static_cast<float>(penX + vx * scale); };
+      auto gy = [&](float vy) { return static_cast<float>(y - vy * scale); };
+
+      for (int i = 0; i < nVertices; i++)
+      {
+        const stbtt_vertex& v = pVertices[i];
+
+        switch (v.type)
+        {
+          case STBTT_vmove:   PathMoveTo(gx(v.x), gy(v.y));                                                         break;
+          case STBTT_vline:   PathLineTo(gx(v.x), gy(v.y));                                                         break;
+          case STBTT_vcurve:  PathQuadraticBezierTo(gx(v.cx), gy(v.cy), gx(v.x), gy(v.y));                          break;
+        }
+      }
+
+      stbtt_FreeShape(&pFont->mInfo, pVertices);
+
+      int advance, lsb;
+      stbtt_GetCodepointHMetrics(&pFont->mInfo, codepoint, &advance, &lsb);
+      penX += advance * scale;
+      prev = codepoint;
+    }
+
+    FillPolygons(mPath, false, paint);
+    std::swap(savedPath, mPath);
+  }
+
+  PathTransformRestore();
+}
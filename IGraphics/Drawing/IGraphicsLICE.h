@@ -0,0 +1,167 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "IPlugPlatform.h"
+#include "IGraphics.h"
+
+#include "lice/lice.h"
+
+BEGIN_IPLUG_NAMESPACE
+BEGIN_IGRAPHICS_NAMESPACE
+
+/** IGraphics draw class using LICE bitmaps and a scanline software rasterizer. It needs no GPU and has a small footprint,
+ * so it suits low-end machines and headless rendering. Paths are flattened to polygons and anti-aliased with exact area coverage,
+ * bitmaps and layers are LICE_MemBitmaps holding premultiplied pixels, and fonts are rasterized with stb_truetype.
+ * At the end of each frame only the regions that were redrawn are copied to the window.
+ * NOTE: WDL/lice/lice.cpp must be compiled into the project.
+ *   @ingroup DrawClasses */
+class IGraphicsLICE : public IGraphics
+{
+private:
+  class Bitmap;
+  struct Font;
+  struct Paint;
+public:
+  IGraphicsLICE(IGEditorDelegate& dlg, int w, int h, int fps, float scale);
+  ~IGraphicsLICE();
+
+  const char* GetDrawingAPIStr() override { return "LICE"; }
+
+  void BeginFrame() override;
+  void EndFrame() override;
+  void OnViewInitialized(void* pContext) override;
+  void OnViewDestroyed() override;
+  void DrawResize() override;
+
+  void DrawBitmap(const IBitmap& bitmap, const IRECT& dest, int srcX, int srcY, const IBlend* pBlend) override;
+
+  void PathClear() override;
+  void PathClose() override;
+  void PathArc(float cx, float cy, float r, float a1, float a2, EWinding winding) override;
+  void PathMoveTo(float x, float y) override;
+  void PathLineTo(float x, float y) override;
+  void PathCubicBezierTo(float c1x, float c1y, float c2x, float c2y, float x2, float y2) override;
+  void PathQuadraticBezierTo(float cx, float cy, float x2, float y2) override;
+  void PathStroke(const IPattern& pattern, float thickness, const IStrokeOptions& options, const IBlend* pBlend) override;
+  void PathFill(const IPattern& pattern, const IFillOptions& options, const IBlend* pBlend) override;
+
+  IColor GetPoint(int x, int y) override;
+  void* GetDrawContext() override { return (void*) mDrawBitmap; }
+
+  bool BitmapExtSupported(const char* ext) override;
+  int AlphaChannel() const override { return LICE_PIXEL_A; }
+  bool FlippedBitmap() const override { return false; }
+
+  APIBitmap* CreateAPIBitmap(int width, int height, float scale, double drawScale, bool cacheable = false) override;
+
+  /** @return IBitmapDecodeFunc The decoder returned by GetThreadSafeBitmapDecoder(), see IGraphics::ThreadSafeBitmapDecoder() */
+  static IBitmapDecodeFunc ThreadSafeBitmapDecoder();
+
+  void GetLayerBitmapData(const ILayerPtr& layer, RawBitmapData& data) override;
+  void ApplyShadowMask(ILayerPtr& layer, RawBitmapData& mask, const IShadow& shadow) override;
+
+  void UpdateLayer() override;
+
+  /** Copy the most recently drawn frame out of the backing bitmap
+   * @param pixels Receives width * height pixels, top row first, as premultiplied LICE_pixels
+   * @param width Receives the width of the frame in pixels, which includes the screen scale
+   * @param height Receives the height of the frame in pixels
+   * @return \c true on success, \c false if there is no backing bitmap yet */
+  bool GetFramePixels(WDL_TypedBuf<uint32_t>& pixels, int& width, int& height);
+
+protected:
+  float DoMeasureText(const IText& text, const char* str, IRECT& bounds) const override;
+  void DoDrawText(const IText& text, const char* str, const IRECT& bounds, const IBlend* pBlend) override;
+
+  bool LoadAPIFont(const char* fontID, const PlatformFontPtr& font) override;
+
+  APIBitmap* LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext) override;
+  APIBitmap* LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale) override;
+  IBitmapDecodeFunc GetThreadSafeBitmapDecoder() const override;
+
+private:
+  /** A point in device space (backing pixels of the current draw bitmap) */
+  struct PathPoint
+  {
+    float x;
+    float y;
+  };
+
+  /** A run of points in a polygon list, which is closed when filled */
+  struct SubPath
+  {
+    int start;
+    int count;
+    bool closed;
+  };
+
+  /** Flattened device space polygons, as built by the Path... methods or by stroking */
+  struct Polygons
+  {
+    void Clear() { mPoints.clear(); mSubPaths.clear(); }
+    bool Empty() const { return mSubPaths.empty(); }
+    void MoveTo(float x, float y);
+    void LineTo(float x, float y);
+    void Close();
+
+    std::vector<PathPoint> mPoints;
+    std::vector<SubPath> mSubPaths;
+  };
+
+  void PrepareAndMeasureText(const IText& text, const char* str, IRECT& r, double& x, double& y, Font& font) const;
+
+  void PathTransformSetMatrix(const IMatrix& m) override;
+  void SetClipRegion(const IRECT& r) override;
+  void CompleteRegion(const IRECT& bounds) override;
+
+  void DevicePoint(float x, float y, float& dx, float& dy) const;
+  float DeviceScale() const;
+
+  void StrokePolygons(const Polygons& path, float width, const IStrokeOptions& options, Polygons& outline) const;
+  static void DashPolygons(const Polygons& path, const float* pDashes, int nDashes, float offset, Polygons& dashed);
+  static void AddStrokeJoin(Polygons& outline, const PathPoint& p0, const PathPoint& p1, const PathPoint& p2, float halfWidth, const IStrokeOptions& options);
+  static void AddStrokeCap(Polygons& outline, const PathPoint& end, float dx, float dy, float halfWidth, ELineCap cap);
+  static void AddStrokeCircle(Polygons& outline, const PathPoint& centre, float radius);
+  static void AddStrokePolygon(Polygons& outline, const PathPoint* pPoints, int nPoints);
+
+  void FillPolygons(const Polygons& polygons, bool evenOdd, const Paint& paint);
+  bool FillAlignedRect(const Polygons& polygons, const Paint& paint);
+  void CompositeSpan(int x, int y, int n, const uint8_t* pCoverage, const Paint& paint);
+
+  static void SetPaint(Paint& paint, const IPattern& pattern, const IBlend* pBlend, const IMatrix& matrix);
+
+  std::unique_ptr<LICE_MemBitmap> mFrameBitmap;
+  LICE_IBitmap* mDrawBitmap = nullptr;
+
+  IMatrix mMatrix;
+  IMatrix mClipMatrix;
+  int mClipL = 0;
+  int mClipT = 0;
+  int mClipR = 0;
+  int mClipB = 0;
+
+  Polygons mPath;
+  Polygons mStroke;
+
+  std::vector<float> mAccumulation;
+  std::vector<uint8_t> mCoverage;
+  std::vector<LICE_pixel> mSpan;
+  IRECTList mPresentRects;
+
+  static StaticStorage<Font> sFontCache;
+};
+
+END_IGRAPHICS_NAMESPACE
+END_IPLUG_NAMESPACE
@@ -756,7 +756,8 @@ bool IGraphicsNanoVG::LoadAPIFont(const char* fontID, const PlatformFontPtr& fon
 
   if (data->IsValid() && nvgCreateFontFaceMem(mVG, fontID, data->Get(), data->GetSize(), data->GetFaceIdx(), 0) != -1)
   {
-    storage.Add(data.release(), fontID);
+    const size_t bytes = data->GetSize();
+    storage.Add(data.release(), fontID, 1., bytes);
     return true;
   }
 
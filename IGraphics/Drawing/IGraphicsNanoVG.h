@@ -124,6 +124,7 @@ public:
   void DeleteFBO(NVGframebuffer* pBuffer);
   
 protected:
+  // N.B. GetThreadSafeBitmapDecoder() is not implemented: textures are created with the NanoVG context, on the UI thread, see IGraphics::GetThreadSafeBitmapDecoder()
   APIBitmap* LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext) override;
   APIBitmap* LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale) override;
   APIBitmap* CreateAPIBitmap(int width, int height, float scale, double drawScale, bool cacheable = false) override;
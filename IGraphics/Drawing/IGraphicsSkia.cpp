@@ -94,6 +94,7 @@ IGraphicsSkia::Bitmap::Bitmap(const void* pData, int size, double sourceScale)
 IGraphicsSkia::Bitmap::Bitmap(sk_sp<SkImage> image, double sourceScale)
 {
   mDrawable.mImage = image;
+  mDrawable.mIsSurface = false;
   SetBitmap(&mDrawable, mDrawable.mImage->width(), mDrawable.mImage->height(), sourceScale, 1.f);
 }
 
@@ -306,6 +307,24 @@ APIBitmap* IGraphicsSkia::LoadAPIBitmap(const char* name, const void* pData, int
   return new Bitmap(pData, dataSize, scale);
 }
 
+IBitmapDecodeFunc IGraphicsSkia::GetThreadSafeBitmapDecoder() const
+{
+  return ThreadSafeBitmapDecoder();
+}
+
+IBitmapDecodeFunc IGraphicsSkia::ThreadSafeBitmapDecoder()
+{
+  return [](const void* pData, int dataSize, int scale) -> APIBitmap* {
+    sk_sp<SkImage> image = SkImage::MakeFromEncoded(SkData::MakeWithCopy(pData, dataSize));
+
+    // decode now, on the calling thread, rather than lazily on the first draw
+    if (image)
+      image = image->makeRasterImage();
+
+    return image ? new Bitmap(image, scale) : nullptr;
+  };
+}
+
 void IGraphicsSkia::OnViewInitialized(void* pContext)
 {
 #if defined IGRAPHICS_GL
@@ -432,6 +451,19 @@ void IGraphicsSkia::BeginFrame()
   IGraphics::BeginFrame();
 }
 
+bool IGraphicsSkia::GetFramePixels(WDL_TypedBuf<uint32_t>& pixels, int& width, int& height)
+{
+  if (!mSurface)
+    return false;
+
+  width = mSurface->width();
+  height = mSurface->height();
+  pixels.Resize(width * height);
+
+  SkImageInfo info = SkImageInfo::MakeN32Premul(width, height);
+  return mSurface->readPixels(info, pixels.Get(), sizeof(uint32_t) * width, 0, 0);
+}
+
 void IGraphicsSkia::DrawImGui(SkSurface* surface)
 {
   #if defined IGRAPHICS_IMGUI
@@ -523,6 +555,8 @@ void IGraphicsSkia::EndFrame()
     StretchDIBits(hdc, 0, 0, w, h, 0, 0, w, h, bmpInfo->bmiColors, bmpInfo, DIB_RGB_COLORS, SRCCOPY);
     ReleaseDC(hWnd, hdc);
     EndPaint(hWnd, &ps);
+  #elif defined OS_LINUX
+    // headless, the frame stays in mSurface, see GetFramePixels()
   #else
     #error NOT IMPLEMENTED
   #endif
@@ -636,7 +670,8 @@ bool IGraphicsSkia::LoadAPIFont(const char* fontID, const PlatformFontPtr& font)
     
     if (typeface)
     {
-      storage.Add(new Font(std::move(data), typeface), fontID);
+      const size_t bytes = data->GetSize();
+      storage.Add(new Font(std::move(data), typeface), fontID, 1., bytes);
       return true;
     }
   }
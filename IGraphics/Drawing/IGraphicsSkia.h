@@ -118,10 +118,20 @@ public:
 
   APIBitmap* CreateAPIBitmap(int width, int height, float scale, double drawScale, bool cacheable = false) override;
 
+  /** @return IBitmapDecodeFunc The decoder returned by GetThreadSafeBitmapDecoder(), see IGraphics::ThreadSafeBitmapDecoder() */
+  static IBitmapDecodeFunc ThreadSafeBitmapDecoder();
+
   void GetLayerBitmapData(const ILayerPtr& layer, RawBitmapData& data) override;
   void ApplyShadowMask(ILayerPtr& layer, RawBitmapData& mask, const IShadow& shadow) override;
 
   void UpdateLayer() override;
+
+  /** Copy the most recently drawn frame out of the backing surface
+   * @param pixels Receives width * height pixels, top row first, in Skia's native 32-bit premultiplied format (kN32_SkColorType)
+   * @param width Receives the width of the frame in pixels, which includes the screen scale
+   * @param height Receives the height of the frame in pixels
+   * @return \c true on success, \c false if there is no surface yet */
+  bool GetFramePixels(WDL_TypedBuf<uint32_t>& pixels, int& width, int& height);
     
 protected:
     
@@ -132,6 +142,7 @@ protected:
 
   APIBitmap* LoadAPIBitmap(const char* fileNameOrResID, int scale, EResourceLocation location, const char* ext) override;
   APIBitmap* LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale) override;
+  IBitmapDecodeFunc GetThreadSafeBitmapDecoder() const override;
 private:
   void DrawImGui(SkSurface* surface);
   
@@ -76,7 +76,11 @@ public:
   void operator=(const IControl&) = delete;
   
   /** Destructor. Clean up any resources that your control owns. */
-  virtual ~IControl() {}
+  virtual ~IControl()
+  {
+    if (mTracked)
+      mGraphics->UntrackControl(this);
+  }
 
   /** Implement this method to respond to a mouse down event on this control. 
    * @param x The X coordinate of the mouse event
@@ -308,7 +312,7 @@ public:
 
   /** Set the rectangular draw area for this control, within the graphics context
    * @param bounds The control's bounds */
-  void SetRECT(const IRECT& bounds) { mRECT = bounds; mMouseIsOver = false; OnResize(); }
+  void SetRECT(const IRECT& bounds) { mRECT = bounds; mMouseIsOver = false; InvalidateHitTestGrid(); OnResize(); }
   
   /** Get the rectangular mouse tracking target area, within the graphics context for this control
    * @return The control's target bounds within the graphics context */
@@ -316,11 +320,11 @@ public:
 
   /** Set the rectangular mouse tracking target area, within the graphics context for this control
    * @param bounds The control's new target bounds within the graphics context */
-  void SetTargetRECT(const IRECT& bounds) { mTargetRECT = bounds; mMouseIsOver = false; }
+  void SetTargetRECT(const IRECT& bounds) { mTargetRECT = bounds; mMouseIsOver = false; InvalidateHitTestGrid(); }
   
   /** Set BOTH the draw rect and the target area, within the graphics context for this control
    * @param bounds The control's new draw and target bounds within the graphics context */
-  void SetTargetAndDrawRECTs(const IRECT& bounds) { mRECT = mTargetRECT = bounds; mMouseIsOver = false; OnResize(); }
+  void SetTargetAndDrawRECTs(const IRECT& bounds) { mRECT = mTargetRECT = bounds; mMouseIsOver = false; InvalidateHitTestGrid(); OnResize(); }
 
   /** Set the position of the control, preserving the width and height. This may need to be overriden if you maintain custom positioning data in your control
    * @param x the new x coordinate of the top left corner of the control
@@ -398,7 +402,9 @@ public:
   /* Called at each display refresh by the IGraphics draw loop, triggers the control's AnimationFunc if it is set */
   void Animate();
 
-  /** Called at each display refresh by the IGraphics draw loop, after IControl::Animate(), to determine if the control is marked as dirty. 
+  /** Called at each display refresh by the IGraphics draw loop, after IControl::Animate(), to determine if the control is marked as dirty.
+   * NOTE: IGraphics only calls this on controls that have been marked dirty since they were last drawn, are animating, or want dirty polling, see SetWantsDirtyPolling().
+   * An override that returns true without SetDirty() having been called must either call SetDirty(false) when its state changes, or SetWantsDirtyPolling()
    * @return \c true if the control is marked dirty. */
   virtual bool IsDirty();
 
@@ -423,6 +429,26 @@ public:
   
   /** @return /c true if this control supports multiple touches */
   bool GetWantsMultiTouch() const { return mWantsMultiTouch; }
+
+  /** Specify whether IGraphics should call IsDirty() on this control at every display tick. This is needed by controls that override IsDirty() to redraw without calling SetDirty() or SetAnimation() */
+  void SetWantsDirtyPolling(bool enable = true) { mWantsDirtyPolling = enable; Track(); }
+
+  /** @return /c true if IGraphics calls IsDirty() on this control at every display tick */
+  bool GetWantsDirtyPolling() const { return mWantsDirtyPolling; }
+
+  /** Specify whether this control paints every pixel of its RECT opaquely, so that IGraphics can skip drawing the controls behind it when it covers a dirty region.
+   * It is ignored while the control is disabled, or its blend is not EBlend::Default with a weight of 1 */
+  void SetOpaque(bool opaque = true) { mOpaque = opaque; }
+
+  /** @return /c true if this control paints every pixel of its RECT opaquely */
+  bool GetOpaque() const { return mOpaque; }
+
+  /** Specify whether IGraphics should draw this control into a cached layer, and draw the layer when the control is not dirty but overlaps a dirty region, e.g. under an animating control.
+   * The layer is redrawn when the control is dirty, resized or rescaled. Only suitable for controls whose drawing does not depend on what is behind them */
+  void SetUseLayerCache(bool enable = true) { mUseLayerCache = enable; if (!enable) mLayerCache = nullptr; }
+
+  /** @return /c true if IGraphics draws this control into a cached layer */
+  bool GetUseLayerCache() const { return mUseLayerCache; }
   
   /** Add a IGestureFunc that should be triggered in response to a certain type of gesture
    * @param type The type of gesture to recognize on this control
@@ -448,6 +474,9 @@ public:
     OnInit();
     OnResize();
     OnRescale();
+
+    if (mDirty || mAnimationFunc || mWantsDirtyPolling)
+      Track();
   }
   
   /** @return A pointer to the IGraphics context that owns this control */ 
@@ -476,12 +505,12 @@ public:
   
   /** Set the animation function
    * @param func A std::function conforming to IAnimationFunction */
-  void SetAnimation(IAnimationFunction func) { mAnimationFunc = func;}
+  void SetAnimation(IAnimationFunction func) { mAnimationFunc = func; Track(); }
   
   /** Set the animation function and starts it
    * @param func A std::function conforming to IAnimationFunction
    * @param duration Duration in milliseconds for the animation  */
-  void SetAnimation(IAnimationFunction func, int duration) { mAnimationFunc = func; StartAnimation(duration); }
+  void SetAnimation(IAnimationFunction func, int duration) { mAnimationFunc = func; StartAnimation(duration); Track(); }
 
   /** Get the control's animation function, if it exists */
   IAnimationFunction GetAnimationFunction() { return mAnimationFunc; }
@@ -532,7 +561,6 @@ protected:
   IText mText;
   IBlend mBlend;
   int mTextEntryLength = DEFAULT_TEXT_ENTRY_LEN;
-  bool mDirty = true;
   bool mHide = false;
   bool mDisabled = false;
   bool mDisablePrompt = true;
@@ -554,6 +582,7 @@ protected:
   {
     assert(nVals > 0);
     mVals.resize(nVals);
+    InvalidateParamControlMap();
   }
 
 #if defined VST3_API || defined VST3C_API
@@ -565,6 +594,10 @@ protected:
 #endif
   
 private:
+  void InvalidateHitTestGrid() { if (mGraphics) mGraphics->InvalidateHitTestGrid(); }
+  void InvalidateParamControlMap() { if (mGraphics) mGraphics->InvalidateParamControlMap(); }
+  void Track() { if (mGraphics && !mTracked) mGraphics->TrackControl(this); }
+
   IGEditorDelegate* mDelegate = nullptr;
   IGraphics* mGraphics = nullptr;
   IActionFunction mActionFunc = nullptr;
@@ -575,6 +608,16 @@ private:
   std::vector<ParamTuple> mVals { {kNoParameter, 0.} };
   std::unordered_map<EGestureType, IGestureFunc> mGestureFuncs;
   EGestureType mLastGesture = EGestureType::Unknown;
+  bool mDirty = true; // set by SetDirty(), which also tracks the control, so that IGraphics polls it
+  bool mWantsDirtyPolling = false;
+  bool mTracked = false; // in IGraphics::mTrackedControls
+  bool mOpaque = false;
+  bool mUseLayerCache = false;
+  bool mLayerCacheValid = false; // cleared by IGraphics::IsDirty() when the control is dirty
+  ILayerPtr mLayerCache;
+  std::unique_ptr<ShadowMaskCache> mShadowMaskCache;
+
+  friend class IGraphics;
 };
 
 #pragma mark - Base Controls
@@ -600,6 +643,10 @@ public:
   /** Call in the constructor of your IBControl to link the IBitmapBase and IControl
    * @param pControl Ptr to the control */
   void AttachIControl(IControl* pControl) { mControl = pControl; }
+
+  /** Replace the bitmap, e.g. when one loaded with IGraphics::LoadBitmapAsync() is ready. An invalid bitmap draws nothing, so it can be a placeholder until then
+   * @param bitmap The new bitmap */
+  void SetBitmap(const IBitmap& bitmap) { mBitmap = bitmap; }
   
   /** Draw a frame of a multi-frame bitmap based on the IControl value
    * @param g The IGraphics context */
@@ -1779,6 +1826,7 @@ public:
   , mDrawFrame(drawFrame)
   {
     mIgnoreMouse = true;
+    SetOpaque(PatternIsOpaque(mPattern));
   }
   
   IPanelControl(const IRECT& bounds, const IPattern& pattern, bool drawFrame = false)
@@ -1787,6 +1835,7 @@ public:
   , mDrawFrame(drawFrame)
   {
     mIgnoreMouse = true;
+    SetOpaque(PatternIsOpaque(mPattern));
   }
 
   void Draw(IGraphics& g) override
@@ -1801,12 +1850,27 @@ public:
   void SetPattern(const IPattern& pattern)
   {
     mPattern = pattern;
+    SetOpaque(PatternIsOpaque(mPattern));
     SetDirty(false);
   }
   
   IPattern GetPattern() const { return mPattern; }
   
 private:
+  static bool PatternIsOpaque(const IPattern& pattern)
+  {
+    if (!pattern.NStops() || (pattern.mType != EPatternType::Solid && pattern.mExtend == EPatternExtend::None))
+      return false;
+
+    for (auto i = 0; i < pattern.NStops(); i++)
+    {
+      if (pattern.GetStop(i).mColor.A < 255)
+        return false;
+    }
+
+    return true;
+  }
+
   IPattern mPattern;
   bool mDrawFrame;
 };
@@ -8,6 +8,16 @@
  ==============================================================================
 */
 
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define IGRAPHICS_BLUR_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define IGRAPHICS_BLUR_NEON
+#endif
+
 #include "IGraphics.h"
 
 #define NANOSVG_IMPLEMENTATION
@@ -40,8 +50,88 @@ using VST3_API_BASE = iplug::IPlugVST3Controller;
 using namespace iplug;
 using namespace igraphics;
 
-static StaticStorage<APIBitmap> sBitmapCache;
-static StaticStorage<SVGHolder> sSVGCache;
+static StaticStorage<APIBitmap> sBitmapCache(DEFAULT_BITMAP_CACHE_BUDGET);
+static StaticStorage<SVGHolder> sSVGCache(DEFAULT_SVG_CACHE_BUDGET);
+
+/** Read a whole file, on any thread */
+static void ReadResourceFile(const char* path, WDL_TypedBuf<uint8_t>& result)
+{
+  FILE* fd = fopen(path, "rb");
+  if (!fd)
+    return;
+  
+  // First we determine the file size
+  if (fseek(fd, 0, SEEK_END))
+  {
+    fclose(fd);
+    return;
+  }
+  long size = ftell(fd);
+
+  // Now reset to the start of the file so we can actually read it.
+  if (fseek(fd, 0, SEEK_SET))
+  {
+    fclose(fd);
+    return;
+  }
+
+  result.Resize((int)size);
+  size_t bytesRead = fread(result.Get(), 1, (size_t)size, fd);
+  if (bytesRead != (size_t)size)
+  {
+    fclose(fd);
+    result.Resize(0, true);
+    return;
+  }
+  fclose(fd);
+}
+
+/** The state of a bitmap or SVG that is being loaded on the worker pool */
+struct IGraphics::AsyncLoad
+{
+  WDL_String mName;
+  bool mIsSVG = false;
+  int mTargetScale = 0;
+  int mSourceScale = 0;
+  int mDataSize = 0;
+  std::unique_ptr<APIBitmap> mBitmap;
+  std::unique_ptr<SVGHolder> mSVG;
+  std::atomic<bool> mFinished{false};
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+
+  // completions requested with LoadBitmapAsync()/LoadSVGAsync(), called from ProcessAsyncLoads()
+  struct BitmapRequest
+  {
+    IBitmapLoadedFunc func;
+    int nStates;
+    bool framesAreHorizontal;
+  };
+
+  std::vector<BitmapRequest> mBitmapRequests;
+  std::vector<ISVGLoadedFunc> mSVGRequests;
+  WDL_String mUnits;
+  float mDPI = 72.f;
+
+  void Finish()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mFinished = true;
+    }
+
+    mCondition.notify_all();
+  }
+
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this]() { return mFinished.load(); });
+  }
+};
+
+static std::mutex sSharedPreloadsMutex;
+std::vector<std::shared_ptr<IGraphics::AsyncLoad>> IGraphics::sSharedPreloads;
 
 IGraphics::IGraphics(IGEditorDelegate& dlg, int w, int h, int fps, float scale)
 : mWidth(w)
@@ -71,9 +161,17 @@ IGraphics::~IGraphics()
   RemoveAllControls();
     
   StaticStorage<APIBitmap>::Accessor bitmapStorage(sBitmapCache);
+  for (auto pBitmap : mBitmapReferences)
+    bitmapStorage.RemoveReference(pBitmap);
   bitmapStorage.Release();
   StaticStorage<SVGHolder>::Accessor svgStorage(sSVGCache);
+  for (auto pHolder : mSVGReferences)
+    svgStorage.RemoveReference(pHolder);
   svgStorage.Release();
+
+  // loads in progress own their results, so they can finish without this object
+  if (mWorkerPool)
+    WorkerPool::ReleaseShared();
 }
 
 void IGraphics::SetScreenScale(float scale)
@@ -127,6 +225,8 @@ void IGraphics::RemoveControlWithTag(int ctrlTag)
 {
   mControls.DeletePtr(GetControlWithTag(ctrlTag));
   mCtrlTags.erase(ctrlTag);
+  InvalidateHitTestGrid();
+  InvalidateParamControlMap();
   SetAllControlsDirty();
 }
 
@@ -155,6 +255,8 @@ void IGraphics::RemoveControls(int fromIdx)
     mControls.Delete(idx--, true);
   }
   
+  InvalidateHitTestGrid();
+  InvalidateParamControlMap();
   SetAllControlsDirty();
 }
 
@@ -182,6 +284,8 @@ void IGraphics::RemoveControl(IControl* pControl)
   
   mControls.DeletePtr(pControl, true);
   
+  InvalidateHitTestGrid();
+  InvalidateParamControlMap();
   SetAllControlsDirty();
 }
 
@@ -203,6 +307,8 @@ void IGraphics::RemoveAllControls()
   
   mCtrlTags.clear();
   mControls.Empty(true);
+  InvalidateHitTestGrid();
+  InvalidateParamControlMap();
 }
 
 void IGraphics::SetControlPosition(int idx, float x, float y)
@@ -279,6 +385,8 @@ void IGraphics::AttachBackground(const char* fileName)
   IControl* pBG = new IBitmapControl(0, 0, LoadBitmap(fileName, 1, false), kNoParameter, EBlend::Default);
   pBG->SetDelegate(*GetDelegate());
   mControls.Insert(0, pBG);
+  InvalidateHitTestGrid();
+  InvalidateParamControlMap();
 }
 
 void IGraphics::AttachSVGBackground(const char* fileName)
@@ -309,6 +417,8 @@ IControl* IGraphics::AttachControl(IControl* pControl, int ctrlTag, const char*
   pControl->SetDelegate(*GetDelegate());
   pControl->SetGroup(group);
   mControls.Add(pControl);
+  InvalidateHitTestGrid();
+  InvalidateParamControlMap();
     
   pControl->OnAttached();
   return pControl;
@@ -469,16 +579,126 @@ void IGraphics::DisableControl(int paramIdx, bool disable)
 
 void IGraphics::ForControlWithParam(int paramIdx, std::function<void(IControl* pControl)> func)
 {
-  for (auto c = 0; c < NControls(); c++)
+  if (paramIdx < 0)
   {
-    IControl* pControl = GetControl(c);
+    // unlinked values aren't in the map
+    for (auto c = 0; c < NControls(); c++)
+    {
+      IControl* pControl = GetControl(c);
+
+      if (pControl->LinkedToParam(paramIdx) > kNoValIdx)
+      {
+        func(pControl);
+        // Could be more than one, don't break until we check them all.
+      }
+    }
+
+    return;
+  }
 
-    if (pControl->LinkedToParam(paramIdx) > kNoValIdx)
+  IControl* pPrevControl = nullptr;
+
+  ForControlValueWithParam(paramIdx, [&pPrevControl, &func](IControl* pControl, int valIdx) {
+    // a control's links are adjacent, call func once per control
+    if (pControl != pPrevControl)
     {
+      pPrevControl = pControl;
       func(pControl);
-      // Could be more than one, don't break until we check them all.
     }
+  });
+}
+
+void IGraphics::ForControlValueWithParam(int paramIdx, std::function<void(IControl* pControl, int valIdx)> func)
+{
+  if (paramIdx < 0)
+    return;
+
+  if (!mParamControlMapValid)
+  {
+    if (mParamControlMapDepth > 0)
+    {
+      // the map is being iterated further up the stack so it can't be rebuilt, scan all controls instead
+      for (auto c = 0; c < NControls(); c++)
+      {
+        IControl* pControl = GetControl(c);
+
+        for (auto v = 0; v < pControl->NVals(); v++)
+        {
+          if (pControl->GetParamIdx(v) == paramIdx)
+            func(pControl, v);
+        }
+      }
+
+      return;
+    }
+
+    RebuildParamControlMap();
+  }
+
+  if (paramIdx >= static_cast<int>(mParamControlStarts.size()) - 1)
+    return;
+
+  mParamControlMapDepth++;
+
+  const int end = mParamControlStarts[paramIdx + 1];
+
+  for (auto i = mParamControlStarts[paramIdx]; i < end; i++)
+  {
+    const ParamControlLink link = mParamControlLinks[i];
+
+    // if func changed the controls, check that the link still holds
+    if (!mParamControlMapValid)
+    {
+      if (GetControlIdx(link.pControl) < 0 || link.valIdx >= link.pControl->NVals() || link.pControl->GetParamIdx(link.valIdx) != paramIdx)
+        continue;
+    }
+
+    func(link.pControl, link.valIdx);
+  }
+
+  mParamControlMapDepth--;
+}
+
+void IGraphics::RebuildParamControlMap()
+{
+  int maxParamIdx = -1;
+
+  for (auto c = 0; c < NControls(); c++)
+  {
+    IControl* pControl = GetControl(c);
+
+    for (auto v = 0; v < pControl->NVals(); v++)
+      maxParamIdx = std::max(maxParamIdx, pControl->GetParamIdx(v));
   }
+
+  mParamControlStarts.assign(maxParamIdx + 2, 0);
+
+  auto forEachLink = [this](auto func) {
+    for (auto c = 0; c < NControls(); c++)
+    {
+      IControl* pControl = GetControl(c);
+
+      for (auto v = 0; v < pControl->NVals(); v++)
+      {
+        const int paramIdx = pControl->GetParamIdx(v);
+
+        if (paramIdx > kNoParameter)
+          func(paramIdx, pControl, v);
+      }
+    }
+  };
+
+  forEachLink([this](int paramIdx, IControl*, int) { mParamControlStarts[paramIdx + 1]++; });
+
+  for (auto p = 0; p <= maxParamIdx; p++)
+    mParamControlStarts[p + 1] += mParamControlStarts[p];
+
+  mParamControlLinks.resize(mParamControlStarts.back());
+  std::vector<int> fillPos(mParamControlStarts.begin(), mParamControlStarts.end() - 1);
+
+  forEachLink([this, &fillPos](int paramIdx, IControl* pControl, int valIdx) { mParamControlLinks[fillPos[paramIdx]++] = {pControl, valIdx}; });
+
+  mParamControlMapValid = true;
 }
 
 void IGraphics::ForControlInGroup(const char* group, std::function<void(IControl* pControl)> func)
@@ -505,7 +725,11 @@ void IGraphics::ForStandardControlsFunc(std::function<void(IControl* pControl)>
 void IGraphics::ForAllControlsFunc(std::function<void(IControl* pControl)> func)
 {
   ForStandardControlsFunc(func);
-  
+  ForSpecialControlsFunc(func);
+}
+
+void IGraphics::ForSpecialControlsFunc(std::function<void(IControl* pControl)> func)
+{
   if (mPerfDisplay)
     func(mPerfDisplay.get());
   
@@ -551,7 +775,24 @@ void IGraphics::SetAllControlsDirty()
 
 void IGraphics::SetAllControlsClean()
 {
-  ForAllControls(&IControl::SetClean);
+  for (auto pControl : mTrackedControls)
+  {
+    if (pControl)
+      pControl->SetClean();
+  }
+}
+
+void IGraphics::TrackControl(IControl* pControl)
+{
+  pControl->mTracked = true;
+  mTrackedControls.push_back(pControl);
+}
+
+void IGraphics::UntrackControl(IControl* pControl)
+{
+  // N.B. cleared rather than erased, since a control can be deleted while IsDirty() walks the list
+  std::replace(mTrackedControls.begin(), mTrackedControls.end(), pControl, static_cast<IControl*>(nullptr));
+  pControl->mTracked = false;
 }
 
 void IGraphics::AssignParamNameToolTips()
@@ -565,23 +806,28 @@ void IGraphics::AssignParamNameToolTips()
   ForStandardControlsFunc(func);
 }
 
-void IGraphics::UpdatePeers(IControl* pCaller, int callerValIdx) // TODO: this could be really slow
+void IGraphics::UpdatePeers(IControl* pCaller, int callerValIdx)
 {
   double value = pCaller->GetValue(callerValIdx);
   int paramIdx = pCaller->GetParamIdx(callerValIdx);
-    
-  auto func = [pCaller, paramIdx, value](IControl* pControl)
+  IControl* pPrevControl = nullptr;
+
+  auto func = [pCaller, value, &pPrevControl](IControl* pControl, int valIdx)
   {
-    int valIdx = pControl->LinkedToParam(paramIdx);
+    // only the first value of a control linked to the parameter is updated
+    if (pControl == pPrevControl)
+      return;
+
+    pPrevControl = pControl;
 
     // Not actually called from the delegate, but we don't want to push the updates back to the delegate
-    if ((valIdx > kNoValIdx) && (pControl != pCaller))
+    if (pControl != pCaller)
     {
       pControl->SetValueFromDelegate(value, valIdx);
     }
   };
     
-  ForStandardControlsFunc(func);
+  ForControlValueWithParam(paramIdx, func);
 }
 
 void IGraphics::PromptUserInput(IControl& control, const IRECT& bounds, int valIdx)
@@ -656,6 +902,10 @@ void IGraphics::DrawText(const IText& text, const char* str, float x, float y, c
 
 void IGraphics::DrawBitmap(const IBitmap& bitmap, const IRECT& bounds, int bmpState, const IBlend* pBlend)
 {
+  // e.g. a placeholder for a bitmap that is still loading
+  if (!bitmap.IsValid())
+    return;
+
   int srcX = 0;
   int srcY = 0;
 
@@ -678,7 +928,7 @@ void IGraphics::DrawBitmap(const IBitmap& bitmap, const IRECT& bounds, int bmpSt
 
 void IGraphics::DrawBitmapedText(const IBitmap& bitmap, const IRECT& bounds, IText& text, IBlend* pBlend, const char* str, bool vCenter, bool multiline, int charWidth, int charHeight, int charOffset)
 {
-  if (CStringHasContents(str))
+  if (bitmap.IsValid() && CStringHasContents(str))
   {
     int stringLength = (int) strlen(str);
 
@@ -781,23 +1031,55 @@ void IGraphics::PathRadialLine(float cx, float cy, float angle, float rMin, floa
 
 bool IGraphics::IsDirty(IRECTList& rects)
 {
+  ProcessAsyncLoads();
+
   if (mDisplayTickFunc)
     mDisplayTickFunc();
 
-  ForAllControlsFunc([](IControl* pControl) { pControl->Animate(); } );
+  int visits = 0;
+
+  // N.B. indices rather than iterators, since animations can mark other controls dirty
+  for (size_t i = 0; i < mTrackedControls.size(); i++)
+  {
+    IControl* pControl = mTrackedControls[i];
+
+    if (pControl && pControl->GetAnimationFunction())
+    {
+      pControl->Animate();
+      visits++;
+    }
+  }
 
   bool dirty = false;
-    
-  auto func = [&dirty, &rects](IControl* pControl) {
+  size_t nKept = 0;
+
+  for (size_t i = 0; i < mTrackedControls.size(); i++)
+  {
+    IControl* pControl = mTrackedControls[i];
+
+    if (!pControl)
+      continue;
+
+    visits++;
+
     if (pControl->IsDirty())
     {
       // N.B padding outlines for single line outlines
       rects.Add(pControl->GetRECT().GetPadded(0.75));
+      pControl->mLayerCacheValid = false;
       dirty = true;
+      mTrackedControls[nKept++] = pControl;
     }
-  };
-    
-  ForAllControlsFunc(func);
+    else if (pControl->GetAnimationFunction() || pControl->GetWantsDirtyPolling())
+      mTrackedControls[nKept++] = pControl;
+    else
+      pControl->mTracked = false;
+  }
+
+  mTrackedControls.resize(nKept);
+  mDirtyTrackingStats.mTicks++;
+  mDirtyTrackingStats.mVisits += visits;
+  mDirtyTrackingStats.mLastTickVisits = visits;
 
 #ifdef USE_IDLE_CALLS
   if (dirty)
@@ -848,7 +1130,29 @@ void IGraphics::DrawControl(IControl* pControl, const IRECT& bounds, float scale
       return;
     
     PrepareRegion(clipBounds);
-    pControl->Draw(*this);
+
+    if (pControl->GetUseLayerCache())
+    {
+      // N.B. the whole control is drawn, so that the layer can be reused for any region
+      if (!pControl->mLayerCacheValid || !CheckLayer(pControl->mLayerCache))
+      {
+        StartLayer(pControl, controlBounds);
+        pControl->Draw(*this);
+        pControl->mLayerCache = EndLayer();
+        pControl->mLayerCacheValid = true;
+        mDrawStats.mControlDraws++;
+      }
+      else
+        mDrawStats.mLayerCacheHits++;
+
+      DrawLayer(pControl->mLayerCache);
+    }
+    else
+    {
+      pControl->Draw(*this);
+      mDrawStats.mControlDraws++;
+    }
+
 #ifdef AAX_API
     pControl->DrawPTHighlight(*this);
 #endif
@@ -867,7 +1171,31 @@ void IGraphics::DrawControl(IControl* pControl, const IRECT& bounds, float scale
 
 void IGraphics::Draw(const IRECT& bounds, float scale)
 {
-  ForAllControlsFunc([this, bounds, scale](IControl* pControl) { DrawControl(pControl, bounds, scale); });
+  // the controls behind the front-most opaque control that covers the region would be painted over
+  auto firstIdx = NControls() - 1;
+
+  while (firstIdx > 0)
+  {
+    IControl* pControl = GetControl(firstIdx);
+    const IBlend blend = pControl->GetBlend();
+
+    // a disabled control, or one drawn with a blend weight below 1 (SetDisabled() sets GRAYED_ALPHA), shows what is behind it
+    const bool occludes = pControl->GetOpaque() && !pControl->IsHidden() && !pControl->IsDisabled() && blend.mMethod == EBlend::Default && blend.mWeight >= 1.f;
+
+    if (occludes && pControl->GetRECT().Contains(bounds))
+      break;
+
+    firstIdx--;
+  }
+
+  firstIdx = std::max(firstIdx, 0);
+  mDrawStats.mRegions++;
+  mDrawStats.mOccludedControls += firstIdx;
+
+  for (auto c = firstIdx; c < NControls(); c++)
+    DrawControl(GetControl(c), bounds, scale);
+
+  ForSpecialControlsFunc([this, bounds, scale](IControl* pControl) { DrawControl(pControl, bounds, scale); });
 
 #ifndef NDEBUG
   if (mShowAreaDrawn)
@@ -899,7 +1227,7 @@ void IGraphics::Draw(IRECTList& rects)
   else
   {
     rects.PixelAlign(scale);
-    rects.Optimize();
+    rects.Optimize(mMaxOverdraw);
 
     for (auto i = 0; i < rects.Size(); i++)
       Draw(rects.Get(i), scale);
@@ -1313,38 +1641,69 @@ int IGraphics::GetMouseControlIdx(float x, float y, bool mouseOver)
 {
   if (!mouseOver || mEnableMouseOver)
   {
-    // Search from front to back
-    for (auto c = NControls() - 1; c >= (mouseOver ? 1 : 0); --c)
+    const int minIdx = mouseOver ? 1 : 0;
+
+    if (mEnableHitTestGrid)
     {
-      IControl* pControl = GetControl(c);
+      if (!mHitTestGridValid)
+        RebuildHitTestGrid();
 
-#ifndef NDEBUG
-      if(!mLiveEdit)
+      const int* pCandidates;
+      const int nCandidates = mHitTestGrid.GetItems(x, y, pCandidates);
+
+      // Search from front to back, candidates are in control order
+      for (auto i = nCandidates - 1; i >= 0 && pCandidates[i] >= minIdx; --i)
       {
-#endif
-        if (!pControl->IsHidden() && !pControl->GetIgnoreMouse())
-        {
-          if ((!pControl->IsDisabled() || (mouseOver ? pControl->GetMouseOverWhenDisabled() : pControl->GetMouseEventsWhenDisabled())))
-          {
-            if (pControl->IsHit(x, y))
-            {
-              return c;
-            }
-          }
-        }
-#ifndef NDEBUG
+        if (IsControlHit(pCandidates[i], x, y, mouseOver))
+          return pCandidates[i];
       }
-      else if (pControl->GetRECT().Contains(x, y))
-      {
+
+      return -1;
+    }
+
+    // Search from front to back
+    for (auto c = NControls() - 1; c >= minIdx; --c)
+    {
+      if (IsControlHit(c, x, y, mouseOver))
         return c;
-      }
-#endif
     }
   }
   
   return -1;
 }
 
+bool IGraphics::IsControlHit(int idx, float x, float y, bool mouseOver)
+{
+  IControl* pControl = GetControl(idx);
+
+#ifndef NDEBUG
+  if (mLiveEdit)
+    return pControl->GetRECT().Contains(x, y);
+#endif
+
+  if (pControl->IsHidden() || pControl->GetIgnoreMouse())
+    return false;
+
+  if (pControl->IsDisabled() && !(mouseOver ? pControl->GetMouseOverWhenDisabled() : pControl->GetMouseEventsWhenDisabled()))
+    return false;
+
+  return pControl->IsHit(x, y);
+}
+
+void IGraphics::RebuildHitTestGrid()
+{
+  std::vector<IRECT> bounds(NControls());
+
+  for (auto c = 0; c < NControls(); c++)
+  {
+    IControl* pControl = GetControl(c);
+    bounds[c] = pControl->GetRECT().Union(pControl->GetTargetRECT());
+  }
+
+  mHitTestGrid.Build(bounds);
+  mHitTestGridValid = true;
+}
+
 IControl* IGraphics::GetMouseControl(float x, float y, bool capture, bool mouseOver, ITouchID touchID)
 {
   IControl* pControl = nullptr;
@@ -1512,6 +1871,9 @@ void IGraphics::OnDragResize(float x, float y)
 
 IBitmap IGraphics::GetScaledBitmap(IBitmap& src)
 {
+  if (!src.IsValid())
+    return src;
+
   //TODO: bug with # frames!
 //  return LoadBitmap(src.GetResourceName().Get(), src.N(), src.GetFramesAreHorizontal(), (GetRoundedScreenScale() == 1 && GetDrawScale() > 1.) ? 2 : 0 /* ??? */);
   return LoadBitmap(src.GetResourceName().Get(), src.N(), src.GetFramesAreHorizontal(), GetRoundedScreenScale());
@@ -1550,6 +1912,8 @@ void IGraphics::EnableLiveEdit(bool enable)
 #ifdef IGRAPHICS_SKIA
 ISVG IGraphics::LoadSVG(const char* fileName, const char* units, float dpi)
 {
+  FinishAsyncLoad(fileName, true, 0);
+
   StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
   SVGHolder* pHolder = storage.Find(fileName);
   
@@ -1566,6 +1930,7 @@ ISVG IGraphics::LoadSVG(const char* fileName, const char* units, float dpi)
     }
   }
   
+  ReferenceSVG(pHolder);
   return ISVG(pHolder->mSVGDom);
 }
 
@@ -1576,42 +1941,54 @@ ISVG IGraphics::LoadSVG(const char* name, const void* pData, int dataSize, const
 
   if (!pHolder)
   {
-    sk_sp<SkSVGDOM> svgDOM;
-    SkDOM xmlDom;
+    pHolder = CreateSVGHolder(pData, dataSize, units, dpi);
 
-    SkMemoryStream svgStream(pData, dataSize);
-    svgDOM = SkSVGDOM::MakeFromStream(svgStream);
-    
-    if (!svgDOM)
+    if (!pHolder)
       return ISVG(nullptr); // return invalid SVG
 
-    // If an SVG doesn't have a container size, SKIA doesn't seem to have access to any meaningful size info.
-    // So use NanoSVG to get the size.
-    if (svgDOM->containerSize().width() == 0)
-    {
-      NSVGimage* pImage = nullptr;
+    storage.Add(pHolder, name, 1., dataSize);
+  }
 
-      WDL_String svgStr;
-      svgStr.Set((const char*)pData, dataSize);
-      pImage = nsvgParse(svgStr.Get(), units, dpi);
-      
-      assert(pImage);
+  ReferenceSVG(pHolder);
+  return ISVG(pHolder->mSVGDom);
+}
 
-      svgDOM->setContainerSize(SkSize::Make(pImage->width, pImage->height));
+SVGHolder* IGraphics::CreateSVGHolder(const void* pData, int dataSize, const char* units, float dpi)
+{
+  sk_sp<SkSVGDOM> svgDOM;
+  SkDOM xmlDom;
 
-      nsvgDelete(pImage);
-    }
+  SkMemoryStream svgStream(pData, dataSize);
+  svgDOM = SkSVGDOM::MakeFromStream(svgStream);
+  
+  if (!svgDOM)
+    return nullptr;
+
+  // If an SVG doesn't have a container size, SKIA doesn't seem to have access to any meaningful size info.
+  // So use NanoSVG to get the size.
+  if (svgDOM->containerSize().width() == 0)
+  {
+    NSVGimage* pImage = nullptr;
+
+    WDL_String svgStr;
+    svgStr.Set((const char*)pData, dataSize);
+    pImage = nsvgParse(svgStr.Get(), units, dpi);
+    
+    assert(pImage);
 
-    pHolder = new SVGHolder(svgDOM);
-    storage.Add(pHolder, name);
+    svgDOM->setContainerSize(SkSize::Make(pImage->width, pImage->height));
+
+    nsvgDelete(pImage);
   }
 
-  return ISVG(pHolder->mSVGDom);
+  return new SVGHolder(svgDOM);
 }
 
 #else
 ISVG IGraphics::LoadSVG(const char* fileName, const char* units, float dpi)
 {
+  FinishAsyncLoad(fileName, true, 0);
+
   StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
   SVGHolder* pHolder = storage.Find(fileName);
 
@@ -1628,6 +2005,7 @@ ISVG IGraphics::LoadSVG(const char* fileName, const char* units, float dpi)
     }
   }
 
+  ReferenceSVG(pHolder);
   return ISVG(pHolder->mImage);
 }
 
@@ -1638,23 +2016,32 @@ ISVG IGraphics::LoadSVG(const char* name, const void* pData, int dataSize, const
 
   if (!pHolder)
   {
-    NSVGimage* pImage = nullptr;
-
-    // Because we're taking a const void* pData, but NanoSVG takes a void*, 
-    WDL_String svgStr;
-    svgStr.Set((const char*)pData, dataSize);
-    pImage = nsvgParse(svgStr.Get(), units, dpi);
+    pHolder = CreateSVGHolder(pData, dataSize, units, dpi);
 
-    if (!pImage)
+    if (!pHolder)
       return ISVG(nullptr);
-    
-    pHolder = new SVGHolder(pImage);
 
-    storage.Add(pHolder, name);
+    storage.Add(pHolder, name, 1., dataSize);
   }
 
+  ReferenceSVG(pHolder);
   return ISVG(pHolder->mImage);
 }
+
+SVGHolder* IGraphics::CreateSVGHolder(const void* pData, int dataSize, const char* units, float dpi)
+{
+  NSVGimage* pImage = nullptr;
+
+  // Because we're taking a const void* pData, but NanoSVG takes a void*, 
+  WDL_String svgStr;
+  svgStr.Set((const char*)pData, dataSize);
+  pImage = nsvgParse(svgStr.Get(), units, dpi);
+
+  if (!pImage)
+    return nullptr;
+  
+  return new SVGHolder(pImage);
+}
 #endif
 
 WDL_TypedBuf<uint8_t> IGraphics::LoadResource(const char* fileNameOrResID, const char* fileType)
@@ -1677,36 +2064,7 @@ WDL_TypedBuf<uint8_t> IGraphics::LoadResource(const char* fileNameOrResID, const
   }
 #endif
   if (resourceFound == EResourceLocation::kAbsolutePath)
-  {
-    FILE* fd = fopen(path.Get(), "rb");
-    if (!fd)
-      return result;
-    
-    // First we determine the file size
-    if (fseek(fd, 0, SEEK_END))
-    {
-      fclose(fd);
-      return result;
-    }
-    long size = ftell(fd);
-
-    // Now reset to the start of the file so we can actually read it.
-    if (fseek(fd, 0, SEEK_SET))
-    {
-      fclose(fd);
-      return result;
-    }
-
-    result.Resize((int)size);
-    size_t bytesRead = fread(result.Get(), 1, (size_t)size, fd);
-    if (bytesRead != (size_t)size)
-    {
-      fclose(fd);
-      result.Resize(0, true);
-      return result;
-    }
-    fclose(fd);
-  }
+    ReadResourceFile(path.Get(), result);
 
   return result;
 }
@@ -1716,6 +2074,8 @@ IBitmap IGraphics::LoadBitmap(const char* name, int nStates, bool framesAreHoriz
   if (targetScale == 0)
     targetScale = GetRoundedScreenScale();
 
+  FinishAsyncLoad(name, false, targetScale);
+
   StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
   APIBitmap* pAPIBitmap = storage.Find(name, targetScale);
 
@@ -1770,6 +2130,7 @@ IBitmap IGraphics::LoadBitmap(const char* name, int nStates, bool framesAreHoriz
     }
   }
 
+  ReferenceBitmap(pAPIBitmap);
   return IBitmap(pAPIBitmap, nStates, framesAreHorizontal, name);
 }
 
@@ -1821,19 +2182,459 @@ IBitmap IGraphics::LoadBitmap(const char *name, const void *pData, int dataSize,
     }
   }
 
+  ReferenceBitmap(pAPIBitmap);
   return IBitmap(pAPIBitmap, nStates, framesAreHorizontal, name);
 }
 
 void IGraphics::ReleaseBitmap(const IBitmap &bitmap)
 {
+  APIBitmap* pBitmap = bitmap.GetAPIBitmap();
   StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
-  storage.Remove(bitmap.GetAPIBitmap());
-}
+
+  if (mBitmapReferences.erase(pBitmap))
+    storage.RemoveReference(pBitmap);
+
+  // other instances may still be drawing the bitmap, in which case it is deleted when the last of them releases it or closes
+  storage.RemoveWhenUnreferenced(pBitmap);
+}
 
 void IGraphics::RetainBitmap(const IBitmap& bitmap, const char* cacheName)
 {
+  APIBitmap* pBitmap = bitmap.GetAPIBitmap();
+  const size_t bytes = static_cast<size_t>(pBitmap->GetWidth()) * pBitmap->GetHeight() * 4;
+
   StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
-  storage.Add(bitmap.GetAPIBitmap(), cacheName, bitmap.GetScale());
+  storage.Add(pBitmap, cacheName, bitmap.GetScale(), bytes);
+  ReferenceBitmap(pBitmap);
+}
+
+void IGraphics::ReferenceBitmap(const APIBitmap* pBitmap)
+{
+  if (pBitmap && mBitmapReferences.insert(pBitmap).second)
+  {
+    StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
+    storage.AddReference(pBitmap);
+  }
+}
+
+void IGraphics::ReferenceSVG(const SVGHolder* pHolder)
+{
+  if (pHolder && mSVGReferences.insert(pHolder).second)
+  {
+    StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
+    storage.AddReference(pHolder);
+  }
+}
+
+void IGraphics::SetBitmapCacheBudget(size_t bytes)
+{
+  StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
+  storage.SetBudget(bytes);
+}
+
+void IGraphics::SetSVGCacheBudget(size_t bytes)
+{
+  StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
+  storage.SetBudget(bytes);
+}
+
+StaticStorageStats IGraphics::GetBitmapCacheStats()
+{
+  StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
+  return storage.GetStats();
+}
+
+StaticStorageStats IGraphics::GetSVGCacheStats()
+{
+  StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
+  return storage.GetStats();
+}
+
+DirtyTrackingStats IGraphics::GetDirtyTrackingStats() const
+{
+  DirtyTrackingStats stats = mDirtyTrackingStats;
+  stats.mTrackedControls = static_cast<int>(std::count_if(mTrackedControls.begin(), mTrackedControls.end(), [](IControl* pControl) { return pControl != nullptr; }));
+  return stats;
+}
+
+void IGraphics::PreloadBitmaps(const std::initializer_list<const char*>& names, int targetScale)
+{
+  for (auto name : names)
+    StartAsyncLoad(name, false, targetScale, nullptr, 0.f, false);
+}
+
+void IGraphics::LoadBitmapAsync(const char* name, IBitmapLoadedFunc func, int nStates, bool framesAreHorizontal, int targetScale)
+{
+  std::shared_ptr<AsyncLoad> load = StartAsyncLoad(name, false, targetScale, nullptr, 0.f, true);
+  load->mBitmapRequests.push_back({func, nStates, framesAreHorizontal});
+}
+
+void IGraphics::LoadBitmapAsync(const char* name, IControl* pControl, int nStates, bool framesAreHorizontal)
+{
+  LoadBitmapAsync(name, [this, pControl](const IBitmap& bitmap) {
+    // the control may have been removed while the bitmap was loading
+    if (GetControlIdx(pControl) < 0)
+      return;
+
+    IBitmapBase* pBitmapBase = dynamic_cast<IBitmapBase*>(pControl);
+
+    if (pBitmapBase)
+      pBitmapBase->SetBitmap(bitmap);
+
+    pControl->SetDirty(false);
+  }, nStates, framesAreHorizontal);
+}
+
+void IGraphics::PreloadSVGs(const std::initializer_list<const char*>& names, const char* units, float dpi)
+{
+  for (auto name : names)
+    StartAsyncLoad(name, true, 0, units, dpi, false);
+}
+
+void IGraphics::LoadSVGAsync(const char* name, ISVGLoadedFunc func, const char* units, float dpi)
+{
+  std::shared_ptr<AsyncLoad> load = StartAsyncLoad(name, true, 0, units, dpi, true);
+  load->mSVGRequests.push_back(func);
+}
+
+std::shared_ptr<IGraphics::AsyncLoad> IGraphics::StartAsyncLoad(const char* name, bool isSVG, int targetScale, const char* units, float dpi, bool forRequest)
+{
+  if (!isSVG && targetScale == 0)
+    targetScale = GetRoundedScreenScale();
+
+  for (auto& load : mAsyncLoads)
+  {
+    if (load->mIsSVG == isSVG && load->mTargetScale == targetScale && !strcmp(load->mName.Get(), name))
+      return load;
+  }
+
+  auto load = std::make_shared<AsyncLoad>();
+  load->mName.Set(name);
+  load->mIsSVG = isSVG;
+  load->mTargetScale = targetScale;
+  load->mUnits.Set(units ? units : "px");
+  load->mDPI = dpi;
+
+  // Started before the UI opened, so wait for it rather than load it again
+  if (std::shared_ptr<AsyncLoad> sharedPreload = FindSharedPreload(name, isSVG, targetScale))
+  {
+    if (!forRequest)
+      return nullptr;
+
+    if (!mWorkerPool)
+      mWorkerPool = WorkerPool::RetainShared();
+
+    // N.B. the pool is first-in, first-out and the preload was queued first, so it is running or done by the time this waits for it
+    mWorkerPool->Enqueue([load, sharedPreload]() {
+      sharedPreload->Wait();
+      load->Finish();
+    });
+
+    mAsyncLoads.push_back(load);
+    return load;
+  }
+
+  IBitmapDecodeFunc decoder;
+  WDL_String path;
+  const char* ext = "svg";
+  EResourceLocation location = EResourceLocation::kNotFound;
+  bool cached = false;
+
+  if (isSVG)
+  {
+    StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
+    cached = storage.Find(name) != nullptr;
+
+    if (!cached)
+      location = LocateResource(name, ext, path, GetBundleID(), GetWinModuleHandle(), GetSharedResourcesSubPath());
+  }
+  else
+  {
+    ext = name + strlen(name) - 1;
+    while (ext >= name && *ext != '.') --ext;
+    ++ext;
+
+    decoder = GetThreadSafeBitmapDecoder();
+
+    StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
+    cached = storage.Find(name, targetScale) != nullptr;
+
+    if (!cached && decoder && BitmapExtSupported(ext))
+    {
+      location = SearchImageResource(name, ext, path, targetScale, load->mSourceScale);
+
+      // If another scale is cached, LoadBitmap() only needs to scale it
+      if (location != EResourceLocation::kNotFound && load->mSourceScale != targetScale)
+        cached = storage.Find(name, load->mSourceScale) != nullptr;
+    }
+  }
+
+  const void* pResData = nullptr;
+  int resSize = 0;
+
+#ifdef OS_WIN
+  if (!cached && location == EResourceLocation::kWinBinary)
+    pResData = LoadWinResource(path.Get(), ext, resSize, GetWinModuleHandle());
+#endif
+
+  if (cached || (location != EResourceLocation::kAbsolutePath && !pResData))
+  {
+    if (!forRequest)
+      return nullptr;
+
+    // Nothing to do off the UI thread, so the request is completed by the next ProcessAsyncLoads()
+    load->Finish();
+    mAsyncLoads.push_back(load);
+    return load;
+  }
+
+  if (!mWorkerPool)
+    mWorkerPool = WorkerPool::RetainShared();
+
+  mWorkerPool->Enqueue([load, decoder, path, pResData, resSize]() {
+    RunAsyncLoad(*load, decoder, path, pResData, resSize);
+    load->Finish();
+  });
+
+  mAsyncLoads.push_back(load);
+  return load;
+}
+
+void IGraphics::RunAsyncLoad(AsyncLoad& load, const IBitmapDecodeFunc& decoder, const WDL_String& path, const void* pResData, int resSize)
+{
+  WDL_TypedBuf<uint8_t> fileData;
+  const void* pData = pResData;
+  int dataSize = resSize;
+
+  if (!pData)
+  {
+    ReadResourceFile(path.Get(), fileData);
+    pData = fileData.Get();
+    dataSize = fileData.GetSize();
+  }
+
+  if (dataSize > 0)
+  {
+    if (load.mIsSVG)
+      load.mSVG.reset(CreateSVGHolder(pData, dataSize, load.mUnits.Get(), load.mDPI));
+    else
+      load.mBitmap.reset(decoder(pData, dataSize, load.mSourceScale));
+  }
+
+  load.mDataSize = dataSize;
+}
+
+std::shared_ptr<IGraphics::AsyncLoad> IGraphics::FindSharedPreload(const char* name, bool isSVG, int targetScale)
+{
+  std::lock_guard<std::mutex> lock(sSharedPreloadsMutex);
+
+  for (auto& load : sSharedPreloads)
+  {
+    if (load->mIsSVG == isSVG && load->mTargetScale == targetScale && !strcmp(load->mName.Get(), name))
+      return load;
+  }
+
+  return nullptr;
+}
+
+void IGraphics::StartSharedPreloads(const std::initializer_list<const char*>& bitmaps, const std::initializer_list<const char*>& svgs, int targetScale,
+                                    IBitmapDecodeFunc decoder, const char* bundleID, void* pWinModuleHandle, const char* sharedResourcesSubPath)
+{
+  // N.B. the caches are retained so that the preloaded resources outlive any UI that is opened and closed before the plug-in is deleted
+  {
+    StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
+    storage.Retain();
+  }
+
+  {
+    StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
+    storage.Retain();
+  }
+
+  WorkerPool* pPool = WorkerPool::RetainShared();
+
+  auto start = [&](const char* name, bool isSVG) {
+    auto load = std::make_shared<AsyncLoad>();
+    load->mName.Set(name);
+    load->mIsSVG = isSVG;
+    load->mTargetScale = isSVG ? 0 : targetScale;
+    load->mUnits.Set("px");
+
+    WDL_String path;
+    const char* ext = "svg";
+    EResourceLocation location = EResourceLocation::kNotFound;
+
+    if (isSVG)
+    {
+      StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
+
+      if (storage.Find(name))
+        return;
+
+      location = LocateResource(name, ext, path, bundleID, pWinModuleHandle, sharedResourcesSubPath);
+    }
+    else
+    {
+      ext = name + strlen(name) - 1;
+      while (ext >= name && *ext != '.') --ext;
+      ++ext;
+
+      StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
+
+      if (storage.Find(name, targetScale))
+        return;
+
+      location = SearchImageResource(name, ext, path, targetScale, load->mSourceScale, bundleID, pWinModuleHandle, sharedResourcesSubPath);
+
+      // If another scale is cached, LoadBitmap() only needs to scale it
+      if (location != EResourceLocation::kNotFound && load->mSourceScale != targetScale && storage.Find(name, load->mSourceScale))
+        return;
+    }
+
+    const void* pResData = nullptr;
+    int resSize = 0;
+
+#ifdef OS_WIN
+    if (location == EResourceLocation::kWinBinary)
+      pResData = LoadWinResource(path.Get(), ext, resSize, pWinModuleHandle);
+#endif
+
+    if (location != EResourceLocation::kAbsolutePath && !pResData)
+      return;
+
+    if (FindSharedPreload(name, isSVG, load->mTargetScale))
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(sSharedPreloadsMutex);
+      sSharedPreloads.push_back(load);
+    }
+
+    pPool->Enqueue([load, decoder, path, pResData, resSize]() {
+      RunAsyncLoad(*load, decoder, path, pResData, resSize);
+
+      // the result is cached before the load is finished, so whatever waits for it then finds it in the cache
+      CacheAsyncLoad(*load);
+
+      {
+        std::lock_guard<std::mutex> lock(sSharedPreloadsMutex);
+        sSharedPreloads.erase(std::find(sSharedPreloads.begin(), sSharedPreloads.end(), load));
+      }
+
+      load->Finish();
+    });
+  };
+
+  if (decoder)
+  {
+    for (auto name : bitmaps)
+      start(name, false);
+  }
+
+  for (auto name : svgs)
+    start(name, true);
+}
+
+void IGraphics::ReleaseSharedPreloads()
+{
+  std::vector<std::shared_ptr<AsyncLoad>> loads;
+
+  {
+    std::lock_guard<std::mutex> lock(sSharedPreloadsMutex);
+    loads = sSharedPreloads;
+  }
+
+  for (auto& load : loads)
+    load->Wait();
+
+  WorkerPool::ReleaseShared();
+
+  StaticStorage<APIBitmap>::Accessor bitmapStorage(sBitmapCache);
+  bitmapStorage.Release();
+  StaticStorage<SVGHolder>::Accessor svgStorage(sSVGCache);
+  svgStorage.Release();
+}
+
+void IGraphics::FinishAsyncLoad(const char* name, bool isSVG, int targetScale)
+{
+  for (auto it = mAsyncLoads.begin(); it != mAsyncLoads.end(); ++it)
+  {
+    AsyncLoad& load = **it;
+
+    if (load.mIsSVG == isSVG && load.mTargetScale == targetScale && !strcmp(load.mName.Get(), name))
+    {
+      load.Wait();
+      CacheAsyncLoad(load);
+
+      if (load.mBitmapRequests.empty() && load.mSVGRequests.empty())
+        mAsyncLoads.erase(it);
+
+      return;
+    }
+  }
+
+  // A load started before the UI opened caches its result before it finishes
+  if (std::shared_ptr<AsyncLoad> sharedPreload = FindSharedPreload(name, isSVG, targetScale))
+    sharedPreload->Wait();
+}
+
+void IGraphics::CacheAsyncLoad(AsyncLoad& load)
+{
+  // N.B. results are cached unreferenced: whatever loads them from the cache references them
+  if (load.mBitmap)
+  {
+    StaticStorage<APIBitmap>::Accessor storage(sBitmapCache);
+
+    // It may have been loaded synchronously in the meantime
+    if (!storage.Find(load.mName.Get(), load.mSourceScale))
+    {
+      const size_t bytes = static_cast<size_t>(load.mBitmap->GetWidth()) * load.mBitmap->GetHeight() * 4;
+      storage.Add(load.mBitmap.release(), load.mName.Get(), load.mSourceScale, bytes);
+    }
+
+    load.mBitmap = nullptr;
+  }
+
+  if (load.mSVG)
+  {
+    StaticStorage<SVGHolder>::Accessor storage(sSVGCache);
+
+    if (!storage.Find(load.mName.Get()))
+      storage.Add(load.mSVG.release(), load.mName.Get(), 1., load.mDataSize);
+
+    load.mSVG = nullptr;
+  }
+}
+
+void IGraphics::ProcessAsyncLoads()
+{
+  if (mAsyncLoads.empty())
+    return;
+
+  // Completion functions may start more loads, so take the finished ones out first
+  std::vector<std::shared_ptr<AsyncLoad>> finished;
+
+  for (auto it = mAsyncLoads.begin(); it != mAsyncLoads.end();)
+  {
+    if ((*it)->mFinished)
+    {
+      finished.push_back(std::move(*it));
+      it = mAsyncLoads.erase(it);
+    }
+    else
+      ++it;
+  }
+
+  for (auto& load : finished)
+  {
+    CacheAsyncLoad(*load);
+
+    for (auto& request : load->mBitmapRequests)
+      request.func(LoadBitmap(load->mName.Get(), request.nStates, request.framesAreHorizontal, load->mTargetScale));
+
+    for (auto& func : load->mSVGRequests)
+      func(LoadSVG(load->mName.Get(), load->mUnits.Get(), load->mDPI));
+  }
 }
 
 IBitmap IGraphics::ScaleBitmap(const IBitmap& inBitmap, const char* name, int scale)
@@ -1869,6 +2670,12 @@ inline void IGraphics::SearchNextScale(int& sourceScale, int targetScale)
 }
 
 EResourceLocation IGraphics::SearchImageResource(const char* name, const char* type, WDL_String& result, int targetScale, int& sourceScale)
+{
+  return SearchImageResource(name, type, result, targetScale, sourceScale, GetBundleID(), GetWinModuleHandle(), GetSharedResourcesSubPath());
+}
+
+EResourceLocation IGraphics::SearchImageResource(const char* name, const char* type, WDL_String& result, int targetScale, int& sourceScale,
+                                                 const char* bundleID, void* pWinModuleHandle, const char* sharedResourcesSubPath)
 {
   // Search target scale, then descending
   for (sourceScale = targetScale ; sourceScale > 0; SearchNextScale(sourceScale, targetScale))
@@ -1882,7 +2689,7 @@ EResourceLocation IGraphics::SearchImageResource(const char* name, const char* t
       fullName.SetFormatted((int) (strlen(name) + strlen("@2x")), "%s@%dx%s", baseName.Get(), sourceScale, ext.Get());
     }
 
-    EResourceLocation found = LocateResource(fullName.Get(), type, result, GetBundleID(), GetWinModuleHandle(), GetSharedResourcesSubPath());
+    EResourceLocation found = LocateResource(fullName.Get(), type, result, bundleID, pWinModuleHandle, sharedResourcesSubPath);
 
     if (found > EResourceLocation::kNotFound)
       return found;
@@ -2069,105 +2876,236 @@ void IGraphics::DrawRotatedLayer(const ILayerPtr& layer, double angle)
   PathTransformRestore();
 }
 
-void IGraphics::ApplyLayerDropShadow(ILayerPtr& layer, const IShadow& shadow)
+// Box blur the columns [x0, x1) of a plane of 8-bit values, treating values outside the plane as 0. zeros must hold x1 zeros.
+// The radius must be at most 127, so that the column sums fit in 16 bits. Each output is the rounded mean of the box, within 1,
+// from a 16-bit fixed point multiply, so that the loops over x vectorise, 16 columns at a time
+static void BoxBlurColumns(const uint8_t* in, uint8_t* out, uint16_t* sums, const uint8_t* zeros, int stride, int height, int x0, int x1, int radius)
 {
-  auto GaussianBlurSwap = [](uint8_t* out, uint8_t* in, uint8_t* kernel, int width, int height,
-                             int outStride, int inStride, int kernelSize, uint32_t norm)
+  if (!radius)
   {
-    int repeats = 0;
-    int fullKernelSize = kernelSize * 2 + 1;
-    uint32_t last = 0;
+    for (int y = 0; y < height; y++)
+      memcpy(out + y * stride + x0, in + y * stride + x0, x1 - x0);
+
+    return;
+  }
 
-    auto RepeatCheck = [&](int idx)
+  const int boxWidth = 2 * radius + 1;
+  const uint16_t rounding = static_cast<uint16_t>((boxWidth + 1) / 2);
+  const uint16_t mul = static_cast<uint16_t>(std::lround(65536.0 / boxWidth));
+
+  std::fill(sums + x0, sums + x1, 0);
+
+  for (int y = 0; y < std::min(radius, height); y++)
+  {
+    const uint8_t* pIn = in + y * stride;
+
+    for (int x = x0; x < x1; x++)
+      sums[x] += pIn[x];
+  }
+
+  for (int y = 0; y < height; y++)
+  {
+    const uint8_t* pAdd = y + radius < height ? in + (y + radius) * stride : zeros;
+    const uint8_t* pSub = y >= radius ? in + (y - radius) * stride : zeros;
+    uint8_t* pOut = out + y * stride;
+    int x = x0;
+
+#if defined IGRAPHICS_BLUR_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vRounding = _mm_set1_epi16(static_cast<short>(rounding));
+    const __m128i vMul = _mm_set1_epi16(static_cast<short>(mul));
+
+    for (; x + 16 <= x1; x += 16)
     {
-      repeats = last == in[idx * 4] ? std::min(repeats + 1, fullKernelSize) : 1;
-      last = in[idx * 4];
-        
-      return repeats == fullKernelSize;
+      const __m128i add = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pAdd + x));
+      const __m128i sub = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSub + x));
+      const __m128i lo = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x)), _mm_unpacklo_epi8(add, zero));
+      const __m128i hi = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + x + 8)), _mm_unpackhi_epi8(add, zero));
+      const __m128i outLo = _mm_mulhi_epu16(_mm_add_epi16(lo, vRounding), vMul);
+      const __m128i outHi = _mm_mulhi_epu16(_mm_add_epi16(hi, vRounding), vMul);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + x), _mm_packus_epi16(outLo, outHi));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + x), _mm_sub_epi16(lo, _mm_unpacklo_epi8(sub, zero)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + x + 8), _mm_sub_epi16(hi, _mm_unpackhi_epi8(sub, zero)));
+    }
+#elif defined IGRAPHICS_BLUR_NEON
+    const uint16x8_t vRounding = vdupq_n_u16(rounding);
+    const uint16x4_t vMul = vdup_n_u16(mul);
+
+    auto scale = [&](uint16x8_t sum) {
+      const uint16x8_t r = vaddq_u16(sum, vRounding);
+      return vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(r), vMul), 16), vshrn_n_u32(vmull_u16(vget_high_u16(r), vMul), 16));
     };
-      
-    for (int i = 0; i < height; i++, in += inStride)
+
+    for (; x + 16 <= x1; x += 16)
     {
-      for (int j = 0; j < kernelSize - 1; j++)
-      {
-        uint32_t accum = in[j * 4] * kernel[0];
-        for (int k = 1; k < j + 1; k++)
-          accum += kernel[k] * in[(j - k) * 4];
-        for (int k = 1; k < kernelSize; k++)
-          accum += kernel[k] * in[(j + k) * 4];
-        out[j * outStride + (i * 4)] = static_cast<uint8_t>(std::min(static_cast<uint32_t>(255), accum / norm));
-      }
-      for (int j = 0; j < kernelSize * 2 - 2; j++)
-        RepeatCheck(j);
-      for (int j = kernelSize - 1; j < (width - kernelSize) + 1; j++)
-      {
-        if (RepeatCheck(j + kernelSize - 1))
-        {
-            out[j * outStride + (i * 4)] = static_cast<uint8_t>(last);
-            continue;
-        }
-          
-        uint32_t accum = in[j * 4] * kernel[0];
-        for (int k = 1; k < kernelSize; k++)
-          accum += kernel[k] * (in[(j - k) * 4] + in[(j + k) * 4]);
-        out[j * outStride + (i * 4)] = static_cast<uint8_t>(std::min(static_cast<uint32_t>(255), accum / norm));
-      }
-      for (int j = (width - kernelSize) + 1; j < width; j++)
-      {
-        uint32_t accum = in[j * 4] * kernel[0];
-        for (int k = 1; k < kernelSize; k++)
-          accum += kernel[k] * in[(j - k) * 4];
-        for (int k = 1; k < width - j; k++)
-          accum += kernel[k] * in[(j + k) * 4];
-        out[j * outStride + (i * 4)] = static_cast<uint8_t>(std::min(static_cast<uint32_t>(255), accum / norm));
-      }
+      const uint8x16_t add = vld1q_u8(pAdd + x);
+      const uint8x16_t sub = vld1q_u8(pSub + x);
+      const uint16x8_t lo = vaddw_u8(vld1q_u16(sums + x), vget_low_u8(add));
+      const uint16x8_t hi = vaddw_u8(vld1q_u16(sums + x + 8), vget_high_u8(add));
+
+      vst1q_u8(pOut + x, vcombine_u8(vqmovn_u16(scale(lo)), vqmovn_u16(scale(hi))));
+      vst1q_u16(sums + x, vsubw_u8(lo, vget_low_u8(sub)));
+      vst1q_u16(sums + x + 8, vsubw_u8(hi, vget_high_u8(sub)));
     }
-  };
-  
-  RawBitmapData temp1;
-  RawBitmapData temp2;
-  RawBitmapData kernel;
-    
+#endif
+
+    for (; x < x1; x++)
+    {
+      const uint16_t sum = sums[x] + pAdd[x];
+      pOut[x] = static_cast<uint8_t>(std::min(255u, (static_cast<uint32_t>(static_cast<uint16_t>(sum + rounding)) * mul) >> 16));
+      sums[x] = sum - pSub[x];
+    }
+  }
+}
+
+void IGraphics::ApplyLayerDropShadow(ILayerPtr& layer, const IShadow& shadow)
+{
   // Get bitmap in 32-bit form
-  GetLayerBitmapData(layer, temp1);
+  RawBitmapData& data = mShadowBitmapData;
+  GetLayerBitmapData(layer, data);
     
-  if (!temp1.GetSize())
-      return;
-  temp2.Resize(temp1.GetSize());
-    
-  // Form kernel (reference blurSize from zero (which will be no blur))
-  bool flipped = FlippedBitmap();
-  float scale = layer->GetAPIBitmap()->GetScale() * layer->GetAPIBitmap()->GetDrawScale();
-  float blurSize = std::max(1.f, (shadow.mBlurSize * scale) + 1.f);
-  float blurConst = 4.5f / (blurSize * blurSize);
-  int iSize = static_cast<int>(ceil(blurSize));
-  int width = layer->GetAPIBitmap()->GetWidth();
-  int height = layer->GetAPIBitmap()->GetHeight();
-  int stride1 = temp1.GetSize() / width;
-  int stride2 = flipped ? -temp1.GetSize() / height : temp1.GetSize() / height;
-  int stride3 = flipped ? -stride2 : stride2;
-
-  kernel.Resize(iSize);
-        
-  for (int i = 0; i < iSize; i++)
-    kernel.Get()[i] = static_cast<uint8_t>(std::round(255.f * std::expf(-(i * i) * blurConst)));
-  
-  // Kernel normalisation
-  int normFactor = kernel.Get()[0];
-    
-  for (int i = 1; i < iSize; i++)
-    normFactor += kernel.Get()[i] + kernel.Get()[i];
-  
-  // Do blur
-  uint8_t* asRows = temp1.Get() + AlphaChannel();
-  uint8_t* inRows = flipped ? asRows + stride3 * (height - 1) : asRows;
-  uint8_t* asCols = temp2.Get() + AlphaChannel();
-  
-  GaussianBlurSwap(asCols, inRows, kernel.Get(), width, height, stride1, stride2, iSize, normFactor);
-  GaussianBlurSwap(asRows, asCols, kernel.Get(), height, width, stride3, stride1, iSize, normFactor);
-  
+  if (!data.GetSize())
+    return;
+
+  // The blur approximates a gaussian with a standard deviation of a third of blurSize by three box blurs,
+  // so the cost per pixel doesn't depend on the size. The columns are blurred, then the rows, as columns of the transposed image
+  const bool flipped = FlippedBitmap();
+  const float scale = layer->GetAPIBitmap()->GetScale() * layer->GetAPIBitmap()->GetDrawScale();
+  const float blurSize = std::max(1.f, (shadow.mBlurSize * scale) + 1.f);
+  const int width = layer->GetAPIBitmap()->GetWidth();
+  const int height = layer->GetAPIBitmap()->GetHeight();
+  const int rowBytes = data.GetSize() / height;
+  const int alpha = AlphaChannel();
+  const size_t nPixels = static_cast<size_t>(width) * height;
+
+  mShadowPlanes.resize(nPixels * 3);
+  mShadowSums.resize(std::max(width, height));
+  mShadowZeros.resize(std::max(width, height));
+
+  uint8_t* pSource = mShadowPlanes.data();
+  uint8_t* pPlane1 = pSource + nPixels;
+  uint8_t* pPlane2 = pPlane1 + nPixels;
+  const uint8_t* pZeros = mShadowZeros.data();
+
+  for (int y = 0; y < height; y++)
+  {
+    const uint8_t* pRow = data.Get() + (flipped ? height - 1 - y : y) * rowBytes + alpha;
+
+    for (int x = 0; x < width; x++)
+      pSource[y * width + x] = pRow[x * 4];
+  }
+
+  ShadowMaskCache* pCache = nullptr;
+
+  if (layer->mControl)
+  {
+    if (!layer->mControl->mShadowMaskCache)
+      layer->mControl->mShadowMaskCache = std::make_unique<ShadowMaskCache>();
+
+    pCache = layer->mControl->mShadowMaskCache.get();
+  }
+
+  if (pCache && pCache->mWidth == width && pCache->mHeight == height && pCache->mBlurSize == blurSize
+      && !memcmp(pCache->mSource.data(), pSource, nPixels))
+  {
+    const uint8_t* pMask = pCache->mMask.data();
+
+    for (int y = 0; y < height; y++)
+    {
+      uint8_t* pRow = data.Get() + y * rowBytes + alpha;
+
+      for (int x = 0; x < width; x++)
+        pRow[x * 4] = pMask[y * width + x];
+    }
+
+    ApplyShadowMask(layer, data, shadow);
+    return;
+  }
+
+  // box widths for a standard deviation of sigma, the narrower ones first
+  const float sigma = blurSize / 3.f;
+  const int nBoxes = 3;
+  int lowerWidth = static_cast<int>(std::floor(std::sqrt(12.f * sigma * sigma / nBoxes + 1.f)));
+  lowerWidth -= (lowerWidth % 2) ? 0 : 1;
+  const float nLower = (12.f * sigma * sigma - nBoxes * lowerWidth * lowerWidth - 4.f * nBoxes * lowerWidth - 3.f * nBoxes) / (-4.f * lowerWidth - 4.f);
+  int radii[nBoxes];
+
+  for (int i = 0; i < nBoxes; i++)
+    radii[i] = std::min((i < std::round(nLower) ? lowerWidth : lowerWidth + 2) / 2, 127);
+
+  uint16_t* pSums = mShadowSums.data();
+
+  // source columns -> plane1 -> plane2 -> plane1
+  auto blurColumns = [&](int x0, int x1) {
+    BoxBlurColumns(pSource, pPlane1, pSums, pZeros, width, height, x0, x1, radii[0]);
+    BoxBlurColumns(pPlane1, pPlane2, pSums, pZeros, width, height, x0, x1, radii[1]);
+    BoxBlurColumns(pPlane2, pPlane1, pSums, pZeros, width, height, x0, x1, radii[2]);
+  };
+
+  // plane1 rows [y0, y1) -> transposed into plane2 -> source -> plane2 -> source, and transposed back into the layer data.
+  // The source plane is free by then, and each block of rows only reads and writes its own part of each plane
+  auto blurRows = [&](int y0, int y1) {
+    for (int x = 0; x < width; x++)
+    {
+      for (int y = y0; y < y1; y++)
+        pPlane2[x * height + y] = pPlane1[y * width + x];
+    }
+
+    BoxBlurColumns(pPlane2, pSource, pSums, pZeros, height, width, y0, y1, radii[0]);
+    BoxBlurColumns(pSource, pPlane2, pSums, pZeros, height, width, y0, y1, radii[1]);
+    BoxBlurColumns(pPlane2, pSource, pSums, pZeros, height, width, y0, y1, radii[2]);
+
+    for (int y = y0; y < y1; y++)
+    {
+      uint8_t* pRow = data.Get() + y * rowBytes + alpha;
+
+      for (int x = 0; x < width; x++)
+        pRow[x * 4] = pSource[x * height + y];
+    }
+  };
+
+  if (pCache)
+    pCache->mSource.assign(pSource, pSource + nPixels);
+
+  // blocks of 64 columns or rows, spread over the worker threads for large layers
+  const int blockSize = 64;
+  const int nColumnBlocks = (width + blockSize - 1) / blockSize;
+  const int nRowBlocks = (height + blockSize - 1) / blockSize;
+
+  if (nPixels >= 256 * 256)
+  {
+    if (!mWorkerPool)
+      mWorkerPool = WorkerPool::RetainShared();
+
+    mWorkerPool->ParallelFor(nColumnBlocks, [&](int block) { blurColumns(block * blockSize, std::min(width, (block + 1) * blockSize)); });
+    mWorkerPool->ParallelFor(nRowBlocks, [&](int block) { blurRows(block * blockSize, std::min(height, (block + 1) * blockSize)); });
+  }
+  else
+  {
+    blurColumns(0, width);
+    blurRows(0, height);
+  }
+
+  if (pCache)
+  {
+    pCache->mMask.resize(nPixels);
+
+    for (int y = 0; y < height; y++)
+    {
+      const uint8_t* pRow = data.Get() + y * rowBytes + alpha;
+
+      for (int x = 0; x < width; x++)
+        pCache->mMask[y * width + x] = pRow[x * 4];
+    }
+
+    pCache->mWidth = width;
+    pCache->mHeight = height;
+    pCache->mBlurSize = blurSize;
+  }
+
   // Apply alphas to the pattern and recombine/replace the image
-  ApplyShadowMask(layer, temp1, shadow);
+  ApplyShadowMask(layer, data, shadow);
 }
 
 bool IGraphics::LoadFont(const char* fontID, const char* fileNameOrResID)
@@ -2404,6 +3342,9 @@ void IGraphics::AttachImGui(std::function<void(IGraphics*)> drawFunc, std::funct
 
   void IGraphics::DrawRotatedBitmap(const IBitmap& bitmap, float destCtrX, float destCtrY, double angle, const IBlend* pBlend)
   {
+    if (!bitmap.IsValid())
+      return;
+
     float width = bitmap.W() / bitmap.GetDrawScale();
     float height = bitmap.H() / bitmap.GetDrawScale();
     
@@ -2771,6 +3712,9 @@ void IGraphics::AttachImGui(std::function<void(IGraphics*)> drawFunc, std::funct
   
   void IGraphics::DrawFittedBitmap(const IBitmap& bitmap, const IRECT& bounds, const IBlend* pBlend)
   {
+    if (!bitmap.IsValid())
+      return;
+
     PathTransformSave();
     PathTransformTranslate(bounds.L, bounds.T);
     IRECT newBounds(0., 0., static_cast<float>(bitmap.W()), static_cast<float>(bitmap.H()));
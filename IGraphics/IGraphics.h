@@ -31,7 +31,7 @@
  */
 
 #ifndef NO_IGRAPHICS
-#if defined(IGRAPHICS_NANOVG) + defined(IGRAPHICS_CANVAS) + defined(IGRAPHICS_SKIA) != 1
+#if defined(IGRAPHICS_NANOVG) + defined(IGRAPHICS_CANVAS) + defined(IGRAPHICS_SKIA) + defined(IGRAPHICS_LICE) != 1
 #error Either NO_IGRAPHICS or one and only one choice of graphics library must be defined!
 #endif
 #endif
@@ -43,6 +43,7 @@
 #include "IPlugConstants.h"
 #include "IPlugLogger.h"
 #include "IPlugPaths.h"
+#include "IPlugWorkerPool.h"
 
 #include "IGraphicsConstants.h"
 #include "IGraphicsStructs.h"
@@ -59,6 +60,7 @@
 #include <memory>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #ifdef FillRect
 #undef FillRect
@@ -389,6 +391,33 @@ public:
    * @param inBitmap The source bitmap to find a scaled version of
    * @return IBitmap The scaled bitmap */
   IBitmap GetScaledBitmap(IBitmap& inBitmap);
+
+  /** Set the memory budget of the bitmap cache, which is shared by all plug-in instances. Bitmaps that no open UI has loaded are
+   * kept for reuse until the cache is over budget, and are then deleted least recently used first
+   * @param bytes The budget in bytes, which is compared with the total width * height * 4 of the cached bitmaps */
+  static void SetBitmapCacheBudget(size_t bytes);
+
+  /** Set the memory budget of the SVG cache, which is shared by all plug-in instances, see SetBitmapCacheBudget()
+   * @param bytes The budget in bytes, which is compared with the total size of the SVG source data */
+  static void SetSVGCacheBudget(size_t bytes);
+
+  /** @return StaticStorageStats Counters for the bitmap cache, for diagnostics */
+  static StaticStorageStats GetBitmapCacheStats();
+
+  /** @return StaticStorageStats Counters for the SVG cache, for diagnostics */
+  static StaticStorageStats GetSVGCacheStats();
+
+  /** @return DirtyTrackingStats Counters for the controls visited by IsDirty(), for diagnostics */
+  DirtyTrackingStats GetDirtyTrackingStats() const;
+
+  /** Reset the counters returned by GetDirtyTrackingStats() */
+  void ResetDirtyTrackingStats() { mDirtyTrackingStats = DirtyTrackingStats(); }
+
+  /** @return DrawStats Counters for the controls drawn by Draw(), for diagnostics */
+  const DrawStats& GetDrawStats() const { return mDrawStats; }
+
+  /** Reset the counters returned by GetDrawStats() */
+  void ResetDrawStats() { mDrawStats = DrawStats(); }
   
   /** Checks a file extension and reports whether this drawing API supports loading that extension */
   virtual bool BitmapExtSupported(const char* ext) = 0;
@@ -968,6 +997,7 @@ public:
   void SetTranslation(float x, float y) { mXTranslation = x; mYTranslation = y; }
   
   /** Called repeatedly at frame rate by the platform class to check what the graphics context says is dirty.
+   * Only the controls that have been marked dirty since they were last drawn, are animating, or want dirty polling are visited, so an idle tick does no work per control
    * @param rects The rectangular regions which will be added to to mark what is dirty in the context
    * @return /c true if a control is dirty */
   bool IsDirty(IRECTList& rects);
@@ -1036,6 +1066,13 @@ public:
    * @param strict Set /c true to enable strict drawing mode */
   void SetStrictDrawing(bool strict);
 
+  /** Set how much extra area may be drawn to reduce the number of regions drawn in a frame, since each region visits every control, see IRECTList::Optimize()
+   * @param maxOverdraw The largest fraction of a drawn region that was not dirty, 0 to draw only dirty areas */
+  void SetMaxOverdraw(float maxOverdraw) { mMaxOverdraw = Clip(maxOverdraw, 0.f, 1.f); }
+
+  /** @return The largest fraction of a drawn region that was not dirty, see SetMaxOverdraw() */
+  float GetMaxOverdraw() const { return mMaxOverdraw; }
+
   /* Enables layout on resize. This means IGEditorDelegate:LayoutUI() will be called when the GUI is resized */
   void SetLayoutOnResize(bool layoutOnResize);
 
@@ -1230,6 +1267,10 @@ public:
   /** For all standard controls in the main control stack perform a function
    * @param func A std::function to perform on each control */
   void ForStandardControlsFunc(std::function<void(IControl* pControl)> func);
+
+  /** For all "special controls", that are drawn in front of the main control stack, perform a function
+   * @param func A std::function to perform on each control */
+  void ForSpecialControlsFunc(std::function<void(IControl* pControl)> func);
   
   /** For all standard controls in the main control stack that are linked to a specific parameter, call a method
    * @param method The method to call
@@ -1242,6 +1283,21 @@ public:
    * @param paramIdx The parameter index to match
    * @param func A std::function to perform on each control */
   void ForControlWithParam(int paramIdx, std::function<void(IControl* pControl)> func);
+
+  /** For all standard controls in the main control stack that are linked to a specific parameter, execute a function for each linked value.
+   * Uses a map from parameter index to controls, so the cost is proportional to the number of linked controls rather than the total number of controls
+   * @param paramIdx The parameter index to match
+   * @param func A std::function called with each control and the valIdx linked to the parameter */
+  void ForControlValueWithParam(int paramIdx, std::function<void(IControl* pControl, int valIdx)> func);
+
+  /** Called when controls are attached, removed or linked to different parameters, so that the parameter to control map is rebuilt before it is next used */
+  void InvalidateParamControlMap() { mParamControlMapValid = false; }
+
+  /** Used internally by IControl when it is marked dirty, starts animating or wants dirty polling, so that IsDirty() visits it until it is clean again */
+  void TrackControl(IControl* pControl);
+
+  /** Used internally by IControl's destructor, to stop IsDirty() visiting it */
+  void UntrackControl(IControl* pControl);
   
   /** For all standard controls in the main control stack that are linked to a group, execute a function
    * @param group CString specificying the goupd name
@@ -1414,7 +1470,7 @@ public:
   /** Calls SetDirty() on every control */
   void SetAllControlsDirty();
   
-  /** Calls SetClean() on every control */
+  /** Calls SetClean() on every control that IsDirty() has visited, since the others are already clean */
   void SetAllControlsClean();
     
   /** Reposition a control, redrawing the interface correctly
@@ -1450,6 +1506,15 @@ private:
    * @param touchID The ITouchID relating to the event (multi-touch only)
    * @return IControl* The hit control in the control stack */
   IControl* GetMouseControl(float x, float y, bool capture, bool mouseOver = false, ITouchID touchID = 0);
+
+  /** @return \c true if the control at idx should receive a mouse event at x and y */
+  bool IsControlHit(int idx, float x, float y, bool mouseOver);
+
+  /** Rebuild the hit test grid from the current control bounds */
+  void RebuildHitTestGrid();
+
+  /** Rebuild the map from parameter index to the controls linked to it */
+  void RebuildParamControlMap();
   
 #pragma mark - Event handling
 public:
@@ -1523,6 +1588,18 @@ public:
   /** @return \c true if the context can handle mouse overs */
   bool CanEnableMouseOver() const { return mEnableMouseOver; }
 
+  /** Find the control under the mouse via a uniform grid over the control bounds, rather than testing every control.
+   * Worthwhile for interfaces with many controls. Z-order is preserved. Requires that IControl::IsHit() only returns \c true
+   * for points within the control's draw or target rectangle
+   * @param enable Set \c true to use the grid */
+  void EnableHitTestGrid(bool enable) { mEnableHitTestGrid = enable; mHitTestGridValid = false; }
+
+  /** @return \c true if the hit test grid is enabled */
+  bool HitTestGridEnabled() const { return mEnableHitTestGrid; }
+
+  /** Called when controls are attached, removed or change bounds, so that the hit test grid is rebuilt before it is next used */
+  void InvalidateHitTestGrid() { mHitTestGridValid = false; }
+
   /** @return An integer representing the control index in IGraphics::mControls which the mouse is over, or -1 if it is not */
   inline int GetMouseOver() const { return mMouseOverIdx; }
 
@@ -1609,6 +1686,66 @@ public:
    * @return An ISVG representing the image */
   virtual ISVG LoadSVG(const char* name, const void* pData, int dataSize, const char* units = "px", float dpi = 72.f);
 
+  /** Start decoding bitmaps on worker threads, so that a later LoadBitmap() of each one only waits for its own decode, if it hasn't finished yet.
+   * Call it at the start of your layout function with the bitmaps the layout loads. Drawing APIs that can only create bitmaps on the UI thread
+   * (NanoVG and Canvas, see GetThreadSafeBitmapDecoder()) ignore it
+   * @param names CString file names or resource IDs
+   * @param targetScale Set \c to a number > 0 to explicity load e.g. an @2x.png */
+  void PreloadBitmaps(const std::initializer_list<const char*>& names, int targetScale = 0);
+
+  /** Load a bitmap without waiting for it to be decoded. \c func is called on the UI thread from the display timer once it is ready
+   * @param fileNameOrResID CString file name or resource ID
+   * @param func Called with the bitmap
+   * @param nStates The number of states/frames in a multi-frame stacked bitmap
+   * @param framesAreHorizontal Set \c true if the frames in a bitmap are stacked horizontally
+   * @param targetScale Set \c to a number > 0 to explicity load e.g. an @2x.png */
+  void LoadBitmapAsync(const char* fileNameOrResID, IBitmapLoadedFunc func, int nStates = 1, bool framesAreHorizontal = false, int targetScale = 0);
+
+  /** Load the bitmap of a bitmap control (an IControl that is also an IBitmapBase) without waiting for it to be decoded.
+   * Construct the control with an invalid IBitmap() placeholder and explicit bounds: it draws nothing until the bitmap is ready,
+   * then it is given the bitmap via IBitmapBase::SetBitmap() and marked dirty
+   * @param fileNameOrResID CString file name or resource ID
+   * @param pControl The control, which may be removed before the bitmap is ready
+   * @param nStates The number of states/frames in a multi-frame stacked bitmap
+   * @param framesAreHorizontal Set \c true if the frames in a bitmap are stacked horizontally */
+  void LoadBitmapAsync(const char* fileNameOrResID, IControl* pControl, int nStates = 1, bool framesAreHorizontal = false);
+
+  /** Start parsing SVGs on worker threads, so that a later LoadSVG() of each one only waits for its own parse, if it hasn't finished yet
+   * @param fileNamesOrResIDs CString absolute paths or resource IDs
+   * @param units \todo
+   * @param dpi The dots per inch of the SVG files */
+  void PreloadSVGs(const std::initializer_list<const char*>& fileNamesOrResIDs, const char* units = "px", float dpi = 72.f);
+
+  /** Load an SVG without waiting for it to be parsed. \c func is called on the UI thread from the display timer once it is ready
+   * @param fileNameOrResID A CString absolute path or resource ID
+   * @param func Called with the SVG, which is invalid if it couldn't be loaded
+   * @param units \todo
+   * @param dpi The dots per inch of the SVG file */
+  void LoadSVGAsync(const char* fileNameOrResID, ISVGLoadedFunc func, const char* units = "px", float dpi = 72.f);
+
+  /** Start decoding bitmaps and parsing SVGs on worker threads before any IGraphics exists, e.g. from the plug-in constructor, into the caches shared by the module.
+   * A later LoadBitmap() or LoadSVG() of each one, by any IGraphics, only waits for its own load, if it hasn't finished yet.
+   * Plug-ins call it through IGEditorDelegate::PreloadEditorResources(), which supplies the drawing API's decoder and the plug-in's resource location.
+   * Each call retains the caches and the worker pool, and must be balanced by a call to ReleaseSharedPreloads()
+   * @param bitmaps CString file names or resource IDs of bitmaps
+   * @param svgs CString file names or resource IDs of SVGs, parsed with the default units and dpi
+   * @param targetScale The screen scale to load bitmaps for, e.g. 2 to load an @2x.png
+   * @param decoder See ThreadSafeBitmapDecoder(). If it is \c nullptr, bitmaps are left to the UI thread
+   * @param bundleID The bundle ID used to locate resources on macOS and iOS
+   * @param pWinModuleHandle The module handle used to locate resources on Windows
+   * @param sharedResourcesSubPath The shared resources sub path used to locate resources on macOS */
+  static void StartSharedPreloads(const std::initializer_list<const char*>& bitmaps, const std::initializer_list<const char*>& svgs, int targetScale,
+                                  IBitmapDecodeFunc decoder, const char* bundleID, void* pWinModuleHandle, const char* sharedResourcesSubPath);
+
+  /** Wait for the loads started by StartSharedPreloads() and release the caches and worker pool it retained.
+   * The preloaded resources stay cached while any IGraphics is open */
+  static void ReleaseSharedPreloads();
+
+  /** The decoder that GetThreadSafeBitmapDecoder() returns, for use before the drawing API is instantiated, e.g. as IGRAPHICS_DRAW_CLASS::ThreadSafeBitmapDecoder().
+   * Drawing API classes that can decode off the UI thread hide this with their own
+   * @return \c nullptr, the drawing API must create bitmaps on the UI thread */
+  static IBitmapDecodeFunc ThreadSafeBitmapDecoder() { return nullptr; }
+
   /** Load a resource from the file system, the bundle, or a Windows resource, and returns its data
    * @param fileNameOrResID CString file name or resource ID
    * @param fileType Type of the file (e.g "png", "svg", "ttf")
@@ -1645,6 +1782,13 @@ protected:
    * @return APIBitmap* Drawing API bitmap abstraction */
   virtual APIBitmap* LoadAPIBitmap(const char* name, const void* pData, int dataSize, int scale) = 0;
 
+  /** Drawing API method used by PreloadBitmaps() and LoadBitmapAsync() to create bitmaps on worker threads.
+   * LICE and Skia implement it. NanoVG and Canvas don't, since they create textures and images with their context on the UI thread:
+   * for them PreloadBitmaps() does nothing and LoadBitmapAsync() loads the bitmap on the UI thread at the next display tick
+   * @return IBitmapDecodeFunc A function that creates an APIBitmap from encoded image data on any thread, without using this object,
+   * or \c nullptr if the drawing API must create bitmaps on the UI thread */
+  virtual IBitmapDecodeFunc GetThreadSafeBitmapDecoder() const { return nullptr; }
+
   /** Creates a new API bitmap, either in memory or as a GPU texture
    * @param width The desired width
    * @param height The desired height
@@ -1672,7 +1816,7 @@ protected:
   /** Utility used by SearchImageResource/SearchBitmapInCache
    * @param sourceScale \todo
    * @param targetScale \todo */
-  inline void SearchNextScale(int& sourceScale, int targetScale);
+  static inline void SearchNextScale(int& sourceScale, int targetScale);
 
   /** Search for a bitmap image resource matching the target scale 
    * @param fileName \todo
@@ -1683,6 +1827,10 @@ protected:
    * @return EResourceLocation \todo */
   EResourceLocation SearchImageResource(const char* fileName, const char* type, WDL_String& result, int targetScale, int& sourceScale);
 
+  /** Search for a bitmap image resource matching the target scale, without an IGraphics, see StartSharedPreloads() */
+  static EResourceLocation SearchImageResource(const char* fileName, const char* type, WDL_String& result, int targetScale, int& sourceScale,
+                                               const char* bundleID, void* pWinModuleHandle, const char* sharedResourcesSubPath);
+
   /** Search the static storage cache for a bitmap image resource matching the target scale
    * @param fileName \todo
    * @param targetScale \todo
@@ -1730,9 +1878,59 @@ private:
     mMouseOver = nullptr;
     mMouseOverIdx = -1;
   }
+
+  /** Protect a cached bitmap from eviction for the lifetime of this IGraphics */
+  void ReferenceBitmap(const APIBitmap* pBitmap);
+
+  /** Protect a cached SVG from eviction for the lifetime of this IGraphics */
+  void ReferenceSVG(const SVGHolder* pHolder);
+
+  struct AsyncLoad;
+
+  static std::vector<std::shared_ptr<AsyncLoad>> sSharedPreloads; // loads started by StartSharedPreloads() that haven't finished, guarded by a mutex in IGraphics.cpp
+
+  /** Start loading a bitmap or SVG on the worker pool, or find a load of it that is already in progress
+   * @param forRequest If \c true, and there is nothing to load off the UI thread, return a finished load rather than \c nullptr
+   * @return The load, or \c nullptr if it is cached already, it can't be found, or (for bitmaps) the drawing API can't decode off the UI thread */
+  std::shared_ptr<AsyncLoad> StartAsyncLoad(const char* name, bool isSVG, int targetScale, const char* units, float dpi, bool forRequest);
+
+  /** Wait for a load started by PreloadBitmaps() or PreloadSVGs(), if there is one, and add its result to the cache */
+  void FinishAsyncLoad(const char* name, bool isSVG, int targetScale);
+
+  /** Add the result of a finished load to the cache */
+  static void CacheAsyncLoad(AsyncLoad& load);
+
+  /** Read and decode or parse a load's resource, on a worker thread, then mark it finished
+   * @param pResData The resource data, or \c nullptr to read it from path */
+  static void RunAsyncLoad(AsyncLoad& load, const IBitmapDecodeFunc& decoder, const WDL_String& path, const void* pResData, int resSize);
+
+  /** @return A load started by StartSharedPreloads() that hasn't finished yet, or \c nullptr */
+  static std::shared_ptr<AsyncLoad> FindSharedPreload(const char* name, bool isSVG, int targetScale);
+
+  /** Cache finished loads and call their completion functions, from the display timer */
+  void ProcessAsyncLoads();
+
+  /** Parse an SVG, on any thread
+   * @return The parsed SVG, or \c nullptr if the data is not a valid SVG */
+  static SVGHolder* CreateSVGHolder(const void* pData, int dataSize, const char* units, float dpi);
   
   WDL_PtrList<IControl> mControls;
+  std::vector<IControl*> mTrackedControls; // the controls that IsDirty() visits, nullptr for controls deleted since the last tick
+  DirtyTrackingStats mDirtyTrackingStats;
+  DrawStats mDrawStats;
   std::unordered_map<int, IControl*> mCtrlTags;
+  IRECTGrid mHitTestGrid; // indices of mControls by position, for GetMouseControlIdx()
+
+  struct ParamControlLink
+  {
+    IControl* pControl;
+    int valIdx;
+  };
+
+  // for each parameter, the controls linked to it in control order, stored flat: the links for paramIdx start at mParamControlStarts[paramIdx]
+  std::vector<int> mParamControlStarts;
+  std::vector<ParamControlLink> mParamControlLinks;
+  int mParamControlMapDepth = 0; // the number of ForControlValueWithParam() calls in progress
 
   // Order (front-to-back) ToolTip / PopUp / TextEntry / LiveEdit / Corner / PerfDisplay
   std::unique_ptr<ICornerResizerControl> mCornerResizer;
@@ -1773,7 +1971,11 @@ private:
   float mMaxScale;
   int mLastClickedParam = kNoParameter;
   bool mEnableMouseOver = false;
+  bool mEnableHitTestGrid = false;
+  bool mHitTestGridValid = false;
+  bool mParamControlMapValid = false;
   bool mStrict = false;
+  float mMaxOverdraw = 0.f;
   bool mEnableTooltips = false;
   bool mShowControlBounds = false;
   bool mShowAreaDrawn = false;
@@ -1784,6 +1986,16 @@ private:
   double mPrevTimestamp = 0.;
   IKeyHandlerFunc mKeyHandlerFunc = nullptr;
   IDisplayTickFunc mDisplayTickFunc = nullptr;
+  std::unordered_set<const APIBitmap*> mBitmapReferences; // the cached bitmaps this instance has handed out
+  std::unordered_set<const SVGHolder*> mSVGReferences;
+  std::vector<std::shared_ptr<AsyncLoad>> mAsyncLoads; // loads in progress, or finished and waiting for ProcessAsyncLoads()
+  WorkerPool* mWorkerPool = nullptr; // the shared pool, retained on first use
+
+  // scratch buffers for ApplyLayerDropShadow(), kept between calls
+  RawBitmapData mShadowBitmapData;
+  std::vector<uint8_t> mShadowPlanes;
+  std::vector<uint16_t> mShadowSums;
+  std::vector<uint8_t> mShadowZeros;
 
 protected:
   IGEditorDelegate* mDelegate;
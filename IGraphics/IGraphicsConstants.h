@@ -34,6 +34,8 @@ static constexpr float PARAM_EDIT_H = 16.f; // TODO: remove?
 #define MAX_NET_ERR_MSG_LEN 1024
 
 static constexpr int MAX_IMG_SCALE = 3;
+static constexpr size_t DEFAULT_BITMAP_CACHE_BUDGET = 256 * 1024 * 1024; // decoded bitmap bytes shared by all instances, see IGraphics::SetBitmapCacheBudget()
+static constexpr size_t DEFAULT_SVG_CACHE_BUDGET = 16 * 1024 * 1024;
 static constexpr int DEFAULT_TEXT_ENTRY_LEN = 7;
 static constexpr double DEFAULT_GEARING = 4.0;
 
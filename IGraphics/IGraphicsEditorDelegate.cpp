@@ -22,6 +22,8 @@ IGEditorDelegate::IGEditorDelegate(int nParams)
 
 IGEditorDelegate::~IGEditorDelegate()
 {
+  for (auto i = 0; i < mNSharedPreloads; i++)
+    IGraphics::ReleaseSharedPreloads();
 }
 
 void* IGEditorDelegate::OpenWindow(void* pParent)
@@ -102,22 +104,9 @@ void IGEditorDelegate::SendParameterValueFromDelegate(int paramIdx, double value
     if (!normalized)
       value = GetParam(paramIdx)->ToNormalized(value);
 
-    for (int c = 0; c < mGraphics->NControls(); c++)
-    {
-      IControl* pControl = mGraphics->GetControl(c);
-      
-      int nVals = pControl->NVals();
-      
-      for(int v = 0; v < nVals; v++)
-      {
-        if (pControl->GetParamIdx(v) == paramIdx)
-        {
-          pControl->SetValueFromDelegate(value, v);
-          // Could be more than one, don't break until we check them all.
-        }
-      }
-
-    }
+    mGraphics->ForControlValueWithParam(paramIdx, [value](IControl* pControl, int valIdx) {
+      pControl->SetValueFromDelegate(value, valIdx);
+    });
   }
   
   IEditorDelegate::SendParameterValueFromDelegate(paramIdx, value, normalized);
@@ -71,6 +71,15 @@ public:
       mLayoutFunc(pGraphics);
   }
   
+  /** Start loading the editor's bitmaps and SVGs on worker threads before it is opened, so that they are cached by the time the layout function loads them.
+   * Call it from the plug-in constructor, e.g. with the bitmaps and SVGs named in config.h. See IGraphics::StartSharedPreloads().
+   * It is defined in IGraphics_include_in_plug_src.h, which knows the plug-in's drawing API and where its resources are.
+   * The preloaded resources are kept until this delegate is deleted. With NanoVG and Canvas, only SVGs are preloaded
+   * @param bitmaps CString file names or resource IDs of bitmaps
+   * @param svgs CString file names or resource IDs of SVGs
+   * @param targetScale The screen scale to load bitmaps for, e.g. 2 to load an @2x.png for a high DPI display */
+  void PreloadEditorResources(const std::initializer_list<const char*>& bitmaps, const std::initializer_list<const char*>& svgs = {}, int targetScale = 1);
+
   /** Get a pointer to the IGraphics context */
   IGraphics* GetUI() { return mGraphics.get(); };
 
@@ -96,6 +105,7 @@ private:
   int mLastWidth = 0;
   int mLastHeight = 0;
   float mLastScale = 0.f;
+  int mNSharedPreloads = 0; // calls to PreloadEditorResources(), each balanced by IGraphics::ReleaseSharedPreloads() on destruction
   bool mClosing = false; // used to prevent re-entrancy on closing
 };
 
@@ -18,6 +18,9 @@
 #include <codecvt>
 #include <string>
 #include <memory>
+#include <list>
+#include <limits>
+#include <unordered_map>
 
 #include "mutex.h"
 #include "wdlstring.h"
@@ -59,6 +62,9 @@
   #include <emscripten.h>
   #include <emscripten/val.h>
   #define BITMAP_DATA_TYPE emscripten::val*
+#elif defined IGRAPHICS_LICE
+  #include "lice/lice.h"
+  #define BITMAP_DATA_TYPE LICE_IBitmap*
 #else // NO_IGRAPHICS
   #define BITMAP_DATA_TYPE void*;
 #endif
@@ -71,6 +77,8 @@
   #define FONT_DESCRIPTOR_TYPE HFONT
 #elif defined OS_WEB
   #define FONT_DESCRIPTOR_TYPE std::pair<WDL_String, WDL_String>*
+#elif defined OS_LINUX
+  #define FONT_DESCRIPTOR_TYPE void* // headless, fonts are only loaded from data
 #else 
   // NO_IGRAPHICS
 #endif
@@ -484,7 +492,50 @@ struct SVGHolder
 };
 #endif
 
-/** Used internally to store data statically, making sure memory is not wasted when there are multiple plug-in instances loaded */
+/** Counters describing the work done by IGraphics::IsDirty() at each display tick, for diagnostics */
+struct DirtyTrackingStats
+{
+  uint64_t mTicks = 0;      // IsDirty() calls
+  uint64_t mVisits = 0;     // IControl::Animate() and IControl::IsDirty() calls, over all ticks
+  int mLastTickVisits = 0;  // IControl::Animate() and IControl::IsDirty() calls during the last tick
+  int mTrackedControls = 0; // controls that the next tick will visit
+};
+
+/** The blurred alpha of a control's last drop-shadow layer, with the alpha it was blurred from, so that IGraphics::ApplyLayerDropShadow() can reuse it while the layer's contents are unchanged */
+struct ShadowMaskCache
+{
+  std::vector<uint8_t> mSource; // the layer's alpha, top row first
+  std::vector<uint8_t> mMask;   // the blurred alpha, top row first
+  int mWidth = 0;
+  int mHeight = 0;
+  float mBlurSize = 0.f;        // in pixels
+};
+
+/** Counters describing the work done by IGraphics::Draw() to draw controls, for diagnostics */
+struct DrawStats
+{
+  uint64_t mRegions = 0;          // regions drawn, after merging the dirty rectangles
+  uint64_t mControlDraws = 0;     // IControl::Draw() calls
+  uint64_t mLayerCacheHits = 0;   // controls drawn from their cached layer, see IControl::SetUseLayerCache()
+  uint64_t mOccludedControls = 0; // controls skipped because an opaque control covered the region, see IControl::SetOpaque()
+};
+
+/** Counters describing the contents and use of a StaticStorage, for diagnostics */
+struct StaticStorageStats
+{
+  uint64_t mHits = 0;       // Find() calls that returned an item
+  uint64_t mMisses = 0;     // Find() calls that returned nothing
+  uint64_t mEvictions = 0;  // items deleted to stay within the budget
+  size_t mBytes = 0;        // the total size of the stored items, as given to Add()
+  size_t mBudget = 0;       // the size above which unreferenced items are evicted
+  int mItems = 0;
+  int mReferencedItems = 0;
+};
+
+/** Used internally to store data statically, making sure memory is not wasted when there are multiple plug-in instances loaded.
+ * Items are found via a hash table. Each item may be given a size in bytes, and when the total exceeds the storage's budget,
+ * items that have no references are deleted, least recently used first. Items that are referenced are never evicted,
+ * so anything that is handed out as a raw pointer must be referenced for as long as it is used. */
 template <class T>
 class StaticStorage
 {
@@ -498,18 +549,26 @@ public:
     , mStorage(storage) 
     {}
     
-    T* Find(const char* str, double scale = 1.)               { return mStorage.Find(str, scale); }
-    void Add(T* pData, const char* str, double scale = 1.)    { return mStorage.Add(pData, str, scale); }
-    void Remove(T* pData)                                     { return mStorage.Remove(pData); }
-    void Clear()                                              { return mStorage.Clear(); }
-    void Retain()                                             { return mStorage.Retain(); }
-    void Release()                                            { return mStorage.Release(); }
+    T* Find(const char* str, double scale = 1.)                               { return mStorage.Find(str, scale); }
+    void Add(T* pData, const char* str, double scale = 1., size_t bytes = 0)  { return mStorage.Add(pData, str, scale, bytes); }
+    void Remove(T* pData)                                                     { return mStorage.Remove(pData); }
+    void RemoveWhenUnreferenced(T* pData)                                     { return mStorage.RemoveWhenUnreferenced(pData); }
+    void Clear()                                                              { return mStorage.Clear(); }
+    void Retain()                                                             { return mStorage.Retain(); }
+    void Release()                                                            { return mStorage.Release(); }
+    void AddReference(const T* pData)                                         { return mStorage.AddReference(pData); }
+    void RemoveReference(const T* pData)                                      { return mStorage.RemoveReference(pData); }
+    void SetBudget(size_t bytes)                                              { return mStorage.SetBudget(bytes); }
+    StaticStorageStats GetStats() const                                       { return mStorage.GetStats(); }
       
   private:
     StaticStorage& mStorage;
   };
   
-  StaticStorage() {}
+  /** @param budget The total size in bytes above which unreferenced items are evicted. By default nothing is evicted */
+  StaticStorage(size_t budget = std::numeric_limits<size_t>::max())
+  : mBudget(budget)
+  {}
     
   ~StaticStorage()
   {
@@ -520,102 +579,224 @@ public:
   StaticStorage& operator=(const StaticStorage&) = delete;
     
 private:
-  /** \todo */
   struct DataKey
   {
     // N.B. - hashID is not guaranteed to be unique
     size_t hashID;
     WDL_String name;
     double scale;
+    size_t bytes;
+    int refs;
+    bool removeWhenUnreferenced;
     std::unique_ptr<T> data;
   };
+
+  // Most recently used first
+  using DataList = std::list<DataKey>;
+  using DataIterator = typename DataList::iterator;
   
-  /** \todo 
-   * @param str \todo
-   * @return size_t \todo */
-  size_t Hash(const char* str)
+  /** Hash an identifier and scale, without allocating
+   * @param str The identifier
+   * @param scale The scale
+   * @return The hash */
+  static size_t Hash(const char* str, double scale)
   {
-    std::string string(str);
-    return std::hash<std::string>()(string);
+    // 64-bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    while (*str)
+    {
+      hash ^= static_cast<uint8_t>(*str++);
+      hash *= 0x100000001b3ULL;
+    }
+
+    return static_cast<size_t>(hash ^ std::hash<double>()(scale));
   }
 
-  /** \todo 
-   * @param str \todo
-   * @param scale \todo
-   * @return T* \todo */
+  /** Find an item, and mark it as the most recently used
+   * @param str The identifier of the item
+   * @param scale The scale of the item
+   * @return T* The item, or \c nullptr if it is not stored */
   T* Find(const char* str, double scale = 1.)
   {
-    WDL_String cacheName(str);
-    cacheName.AppendFormatted((int) strlen(str) + 6, "-%.1fx", scale);
-    
-    size_t hashID = Hash(cacheName.Get());
-    
-    int i, n = mDatas.GetSize();
-    for (i = 0; i < n; ++i)
+    auto range = mIndex.equal_range(Hash(str, scale));
+
+    for (auto it = range.first; it != range.second; ++it)
     {
-      DataKey* pKey = mDatas.Get(i);
+      DataIterator data = it->second;
 
       // Use the hash id for a quick search and then confirm with the scale and identifier to ensure uniqueness
-      if (pKey->hashID == hashID && scale == pKey->scale && !strcmp(str, pKey->name.Get()))
-        return pKey->data.get();
+      if (scale == data->scale && !strcmp(str, data->name.Get()))
+      {
+        mDatas.splice(mDatas.begin(), mDatas, data);
+        mStats.mHits++;
+        return data->data.get();
+      }
     }
+
+    mStats.mMisses++;
     return nullptr;
   }
 
-  /** \todo 
-   * @param pData \todo
-   * @param str \todo
-   * @param scale \todo scale where 2x = retina, omit if not needed */
-  void Add(T* pData, const char* str, double scale = 1.)
+  /** Take ownership of an item, first evicting unreferenced items if they are needed to make room for it
+   * @param pData The item
+   * @param str The identifier of the item
+   * @param scale scale where 2x = retina, omit if not needed
+   * @param bytes The memory used by the item, which counts towards the budget */
+  void Add(T* pData, const char* str, double scale = 1., size_t bytes = 0)
   {
-    DataKey* pKey = mDatas.Add(new DataKey);
+    Evict(bytes);
 
-    WDL_String cacheName(str);
-    cacheName.AppendFormatted((int) strlen(str) + 6, "-%.1fx", scale);
-    
-    pKey->hashID = Hash(cacheName.Get());
-    pKey->data = std::unique_ptr<T>(pData);
-    pKey->scale = scale;
-    pKey->name.Set(str);
+    const size_t hashID = Hash(str, scale);
+
+    mDatas.push_front(DataKey{hashID, WDL_String(str), scale, bytes, 0, false, std::unique_ptr<T>(pData)});
+    mIndex.emplace(hashID, mDatas.begin());
+    mItems.emplace(pData, mDatas.begin());
+    mStats.mBytes += bytes;
 
     //DBGMSG("adding %s to the static storage at %.1fx the original scale\n", str, scale);
   }
 
-  /** \todo @param pData \todo */
+  /** Delete an item, whether or not it is referenced
+   * @param pData The item */
   void Remove(T* pData)
   {
-    for (int i = 0; i < mDatas.GetSize(); ++i)
-    {
-      if (mDatas.Get(i)->data.get() == pData)
-      {
-        mDatas.Delete(i, true);
-        break;
-      }
-    }
+    auto it = mItems.find(pData);
+
+    if (it != mItems.end())
+      Erase(it->second);
   }
 
-  /** \todo  */
+  /** Delete an item once nothing references it, which may be immediately
+   * @param pData The item */
+  void RemoveWhenUnreferenced(T* pData)
+  {
+    auto it = mItems.find(pData);
+
+    if (it == mItems.end())
+      return;
+
+    if (it->second->refs > 0)
+      it->second->removeWhenUnreferenced = true;
+    else
+      Erase(it->second);
+  }
+
+  /** Delete all items */
   void Clear()
   {
-    mDatas.Empty(true);
+    mIndex.clear();
+    mItems.clear();
+    mDatas.clear();
+    mStats.mBytes = 0;
   };
 
-  /** \todo  */
+  /** Register a user of the storage, which keeps the items alive until the last user is released */
   void Retain()
   {
     mCount++;
   }
   
-  /** \todo  */
+  /** Unregister a user of the storage, deleting all items if it was the last one */
   void Release()
   {
     if (--mCount == 0)
       Clear();
   }
+
+  /** Protect an item from eviction
+   * @param pData The item, which may or may not be stored */
+  void AddReference(const T* pData)
+  {
+    auto it = mItems.find(pData);
+
+    if (it != mItems.end())
+    {
+      it->second->refs++;
+      it->second->removeWhenUnreferenced = false;
+    }
+  }
+
+  /** Remove a reference added with AddReference(). Once unreferenced an item is deleted if RemoveWhenUnreferenced() was called for it,
+   * otherwise it may be evicted if the storage is over budget
+   * @param pData The item, which may or may not be stored */
+  void RemoveReference(const T* pData)
+  {
+    auto it = mItems.find(pData);
+
+    if (it != mItems.end() && it->second->refs > 0 && --it->second->refs == 0)
+    {
+      if (it->second->removeWhenUnreferenced)
+        Erase(it->second);
+      else
+        Evict(0);
+    }
+  }
+
+  /** Set the total size above which unreferenced items are evicted
+   * @param bytes The budget in bytes */
+  void SetBudget(size_t bytes)
+  {
+    mBudget = bytes;
+    Evict(0);
+  }
+
+  /** @return StaticStorageStats Counters describing the contents and use of the storage */
+  StaticStorageStats GetStats() const
+  {
+    StaticStorageStats stats = mStats;
+    stats.mBudget = mBudget;
+    stats.mItems = static_cast<int>(mDatas.size());
+
+    for (const DataKey& key : mDatas)
+      stats.mReferencedItems += key.refs > 0;
+
+    return stats;
+  }
+
+  /** Evict unreferenced items, least recently used first, until the budget can accommodate another item
+   * @param bytes The size of the item to make room for */
+  void Evict(size_t bytes)
+  {
+    auto it = mDatas.end();
+
+    while (it != mDatas.begin() && mStats.mBytes + bytes > mBudget)
+    {
+      --it;
+
+      if (!it->refs)
+      {
+        it = Erase(it);
+        mStats.mEvictions++;
+      }
+    }
+  }
+
+  DataIterator Erase(DataIterator data)
+  {
+    auto range = mIndex.equal_range(data->hashID);
+
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second == data)
+      {
+        mIndex.erase(it);
+        break;
+      }
+    }
+
+    mItems.erase(data->data.get());
+    mStats.mBytes -= data->bytes;
+    return mDatas.erase(data);
+  }
     
   int mCount = 0;
+  size_t mBudget;
+  StaticStorageStats mStats;
   WDL_Mutex mMutex;
-  WDL_PtrList<DataKey> mDatas;
+  DataList mDatas;
+  std::unordered_multimap<size_t, DataIterator> mIndex;
+  std::unordered_map<const T*, DataIterator> mItems;
 };
 
 /** Encapsulate an xy point in one struct */
@@ -16,7 +16,9 @@
  * @{
  */
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 #include <chrono>
 #include <numeric>
 
@@ -35,6 +37,8 @@ class IGraphics;
 class IControl;
 class ILambdaControl;
 class IPopupMenu;
+class IBitmap;
+struct ISVG;
 struct IRECT;
 struct IVec2;
 struct IMouseInfo;
@@ -50,6 +54,9 @@ using IColorPickerHandlerFunc = std::function<void(const IColor& result)>;
 using IGestureFunc = std::function<void(IControl*, const IGestureInfo&)>;
 using IPopupFunction = std::function<void(IPopupMenu* pMenu)>;
 using IDisplayTickFunc = std::function<void()>;
+using IBitmapLoadedFunc = std::function<void(const IBitmap& bitmap)>;
+using ISVGLoadedFunc = std::function<void(const ISVG& svg)>;
+using IBitmapDecodeFunc = std::function<APIBitmap*(const void* pData, int dataSize, int scale)>;
 using ITouchID = uintptr_t;
 
 /** A click action function that does nothing */
@@ -464,7 +471,7 @@ struct IColor
     };
 
     IColor col;
-    h = std::fmodf(h, 1.0f);
+    h = std::fmod(h, 1.0f);
     if (h < 0.0f) h += 1.0f;
     s = Clip(s, 0.0f, 1.0f);
     l = Clip(l, 0.0f, 1.0f);
@@ -1892,8 +1899,22 @@ public:
     return true;
   }
   
-  /** Remove rects that are contained by other rects and intersections and merge any rects that can be merged */
-  void Optimize()
+  /** Remove rects that are contained by other rects and intersections and merge any rects that can be merged, see OptimizeSweep()
+   * @param maxOverdraw Above 0, neighbouring rects in the same row or column are also merged across the gaps between them,
+   * as long as the gaps are at most this fraction of the merged rect. This trades drawing area for fewer rects */
+  void Optimize(float maxOverdraw = 0.f)
+  {
+    if (Size() > 1)
+      OptimizeSweep();
+
+    if (maxOverdraw > 0.f)
+      MergeNeighbours(maxOverdraw);
+  }
+
+  /** Remove rects that are contained by other rects and intersections and merge any rects that can be merged, by comparing each pair of rects.
+   * This was the implementation of Optimize(), and is kept as a reference. It is quadratic in the number of rects,
+   * and can leave out parts of the area where several rects overlap the same rect */
+  void OptimizePairwise()
   {
     for (int i = 0; i < Size(); i++)
     {
@@ -1941,7 +1962,180 @@ public:
     }
   }
   
+  /** Replace the rects by non-overlapping rects that cover the same area, in O(n log n) for typical layouts such as rows of controls.
+   * The area is swept from top to bottom in bands between consecutive rect edges. In each band the horizontal extents of the rects are merged into spans,
+   * and a span that continues the one above it with the same extent extends its rect downwards. The result covers the same area as the rects it replaces,
+   * and so at least the area OptimizePairwise() covers (see Tests/IRECTListTest) */
+  void OptimizeSweep()
+  {
+    std::vector<IRECT> rects;
+    std::vector<float> edges;
+    rects.reserve(Size());
+    edges.reserve(Size() * 2);
+
+    for (auto i = 0; i < Size(); i++)
+    {
+      const IRECT& r = Get(i);
+
+      if (r.W() > 0.f && r.H() > 0.f)
+      {
+        rects.push_back(r);
+        edges.push_back(r.T);
+        edges.push_back(r.B);
+      }
+    }
+
+    std::sort(rects.begin(), rects.end(), [](const IRECT& a, const IRECT& b) { return a.T < b.T; });
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    Clear();
+
+    std::vector<IRECT> active; // the rects overlapping the current band
+    std::vector<IRECT> open; // the rects that may extend into the current band, by ascending L
+    std::vector<IRECT> nextOpen;
+    std::vector<std::pair<float, float>> spans;
+    size_t nextRect = 0;
+
+    for (size_t e = 0; e + 1 < edges.size(); e++)
+    {
+      const float top = edges[e];
+      const float bottom = edges[e + 1];
+
+      active.erase(std::remove_if(active.begin(), active.end(), [top](const IRECT& r) { return r.B <= top; }), active.end());
+
+      while (nextRect < rects.size() && rects[nextRect].T <= top)
+        active.push_back(rects[nextRect++]);
+
+      spans.clear();
+
+      for (const auto& r : active)
+        spans.emplace_back(r.L, r.R);
+
+      std::sort(spans.begin(), spans.end());
+
+      size_t nSpans = 0;
+
+      for (const auto& span : spans)
+      {
+        if (nSpans && span.first <= spans[nSpans - 1].second)
+          spans[nSpans - 1].second = std::max(spans[nSpans - 1].second, span.second);
+        else
+          spans[nSpans++] = span;
+      }
+
+      spans.resize(nSpans);
+      nextOpen.clear();
+      size_t o = 0;
+
+      for (const auto& span : spans)
+      {
+        while (o < open.size() && open[o].L < span.first)
+          Add(open[o++]);
+
+        if (o < open.size() && open[o].L == span.first && open[o].R == span.second)
+        {
+          nextOpen.push_back(open[o++]);
+          nextOpen.back().B = bottom;
+        }
+        else
+          nextOpen.push_back(IRECT(span.first, top, span.second, bottom));
+      }
+
+      while (o < open.size())
+        Add(open[o++]);
+
+      open.swap(nextOpen);
+    }
+
+    for (const auto& r : open)
+      Add(r);
+  }
+
 private:
+  /** Merge rects that share their top and bottom, or their left and right edges, and are next to each other in that row or column,
+   * if the gap between them would be at most maxOverdraw of the merged rect. The rects must not overlap.
+   * Other rects in the gap are absorbed by the merged rect, and a merge that would partly overlap another rect is not made, so the result doesn't overlap either
+   * @param maxOverdraw The largest fraction of a merged rect that is not covered by the rects it replaces */
+  void MergeNeighbours(float maxOverdraw)
+  {
+    struct Merged
+    {
+      IRECT r;
+      float covered;
+      bool absorbed;
+    };
+
+    std::vector<Merged> merged;
+    std::vector<size_t> inGap;
+    merged.reserve(Size());
+
+    for (auto i = 0; i < Size(); i++)
+      merged.push_back({Get(i), Get(i).Area(), false});
+
+    // unlike IRECT::Intersects(), rects that only share an edge don't overlap
+    auto overlaps = [](const IRECT& a, const IRECT& b) { return a.L < b.R && b.L < a.R && a.T < b.B && b.T < a.B; };
+
+    auto mergeRuns = [&merged, &inGap, &overlaps, maxOverdraw](auto inRun, auto before) {
+      std::sort(merged.begin(), merged.end(), [before](const Merged& a, const Merged& b) { return before(a.r, b.r); });
+      size_t n = 0;
+
+      for (size_t i = 0; i < merged.size(); i++)
+      {
+        if (merged[i].absorbed)
+          continue;
+
+        if (n && inRun(merged[n - 1].r, merged[i].r))
+        {
+          const IRECT u = merged[n - 1].r.Union(merged[i].r);
+          float covered = merged[n - 1].covered + merged[i].covered;
+          bool blocked = false;
+          inGap.clear();
+
+          for (size_t j = 0; j < merged.size() && !blocked; j++)
+          {
+            if (j == n - 1 || j == i || (j >= n && j < i) || merged[j].absorbed || !overlaps(u, merged[j].r))
+              continue;
+
+            if (u.Contains(merged[j].r))
+            {
+              inGap.push_back(j);
+              covered += merged[j].covered;
+            }
+            else
+              blocked = true;
+          }
+
+          if (!blocked && covered >= (1.f - maxOverdraw) * u.Area())
+          {
+            for (auto j : inGap)
+              merged[j].absorbed = true;
+
+            merged[n - 1] = {u, covered, false};
+            continue;
+          }
+        }
+
+        merged[n++] = merged[i];
+      }
+
+      merged.resize(n);
+      merged.erase(std::remove_if(merged.begin(), merged.end(), [](const Merged& m) { return m.absorbed; }), merged.end());
+    };
+
+    auto sameRow = [](const IRECT& a, const IRECT& b) { return a.T == b.T && a.B == b.B; };
+    auto rowOrder = [](const IRECT& a, const IRECT& b) { return a.T != b.T ? a.T < b.T : a.B != b.B ? a.B < b.B : a.L < b.L; };
+    auto sameColumn = [](const IRECT& a, const IRECT& b) { return a.L == b.L && a.R == b.R; };
+    auto columnOrder = [](const IRECT& a, const IRECT& b) { return a.L != b.L ? a.L < b.L : a.R != b.R ? a.R < b.R : a.T < b.T; };
+
+    mergeRuns(sameRow, rowOrder);
+    mergeRuns(sameColumn, columnOrder);
+
+    Clear();
+
+    for (const auto& m : merged)
+      Add(m.r);
+  }
+
   /** \todo 
    * @param r \todo
    * @param i \todo
@@ -1992,6 +2186,106 @@ private:
   WDL_TypedBuf<IRECT> mRects;
 };
 
+/** A uniform grid over a set of rectangles, used to find the rectangles that may contain a point without testing them all.
+ * Each cell lists, in ascending order, the indices of the rectangles that overlap it (including their right and bottom edges) */
+class IRECTGrid
+{
+public:
+  IRECTGrid()
+  {}
+
+  IRECTGrid(const IRECTGrid&) = delete;
+  IRECTGrid& operator=(const IRECTGrid&) = delete;
+
+  /** Build the grid. Empty rectangles are not indexed
+   * @param rects The rectangles to index, the index of each rectangle in this vector is what the grid returns
+   * @param maxCellsPerAxis The maximum number of rows and columns */
+  void Build(const std::vector<IRECT>& rects, int maxCellsPerAxis = 64)
+  {
+    mBounds = IRECT();
+    int nRects = 0;
+
+    for (const auto& r : rects)
+    {
+      if (!r.Empty())
+      {
+        mBounds = mBounds.Union(r);
+        nRects++;
+      }
+    }
+
+    // aim for a handful of rectangles per cell
+    mNAxisCells = Clip(static_cast<int>(std::ceil(std::sqrt(nRects / 4.0))), 1, std::max(maxCellsPerAxis, 1));
+    mCellW = std::max(mBounds.W() / (float) mNAxisCells, 1e-3f);
+    mCellH = std::max(mBounds.H() / (float) mNAxisCells, 1e-3f);
+
+    const int nCells = mNAxisCells * mNAxisCells;
+    mCellStarts.assign(nCells + 1, 0);
+
+    ForEachCell(rects, [&](int cell, int) { mCellStarts[cell + 1]++; });
+
+    for (auto cell = 0; cell < nCells; cell++)
+      mCellStarts[cell + 1] += mCellStarts[cell];
+
+    mItems.resize(mCellStarts[nCells]);
+    std::vector<int> fillPos(mCellStarts.begin(), mCellStarts.end() - 1);
+
+    ForEachCell(rects, [&](int cell, int rectIdx) { mItems[fillPos[cell]++] = rectIdx; });
+  }
+
+  /** Get the indices of the rectangles that may contain a point
+   * @param x point X
+   * @param y point Y
+   * @param pItems Set to the indices, in ascending order
+   * @return The number of indices */
+  int GetItems(float x, float y, const int*& pItems) const
+  {
+    pItems = nullptr;
+
+    if (mCellStarts.empty() || !mBounds.ContainsEdge(x, y))
+      return 0;
+
+    const int cell = CellRow(y) * mNAxisCells + CellCol(x);
+    pItems = mItems.data() + mCellStarts[cell];
+    return mCellStarts[cell + 1] - mCellStarts[cell];
+  }
+
+  /** @return The area covered by the grid, the union of all the indexed rectangles */
+  const IRECT& GetBounds() const { return mBounds; }
+
+private:
+  int CellCol(float x) const { return Clip(static_cast<int>((x - mBounds.L) / mCellW), 0, mNAxisCells - 1); }
+  int CellRow(float y) const { return Clip(static_cast<int>((y - mBounds.T) / mCellH), 0, mNAxisCells - 1); }
+
+  template <typename F>
+  void ForEachCell(const std::vector<IRECT>& rects, F func) const
+  {
+    for (auto i = 0; i < static_cast<int>(rects.size()); i++)
+    {
+      const IRECT& r = rects[i];
+
+      if (r.Empty())
+        continue;
+
+      const int col0 = CellCol(r.L), col1 = CellCol(r.R);
+      const int row0 = CellRow(r.T), row1 = CellRow(r.B);
+
+      for (auto row = row0; row <= row1; row++)
+      {
+        for (auto col = col0; col <= col1; col++)
+          func(row * mNAxisCells + col, i);
+      }
+    }
+  }
+
+  IRECT mBounds;
+  int mNAxisCells = 0;
+  float mCellW = 1.f;
+  float mCellH = 1.f;
+  std::vector<int> mCellStarts;
+  std::vector<int> mItems;
+};
+
 /** Used to store transformation matrices */
 struct IMatrix
 {
@@ -70,10 +70,29 @@
     gGraphics = new IGraphicsWeb(dlg, w, h, fps, scale);
     return gGraphics;
   }
+  #elif defined OS_LINUX
+  IGraphics* MakeGraphics(IGEditorDelegate& dlg, int w, int h, int fps = 0, float scale = 1.)
+  {
+    return new IGraphicsLinux(dlg, w, h, fps, scale);
+  }
   #else
     #error "No OS defined!"
   #endif
 
+  void IGEditorDelegate::PreloadEditorResources(const std::initializer_list<const char*>& bitmaps, const std::initializer_list<const char*>& svgs, int targetScale)
+  {
+  #if defined OS_WIN
+    IGraphics::StartSharedPreloads(bitmaps, svgs, targetScale, IGRAPHICS_DRAW_CLASS::ThreadSafeBitmapDecoder(), "", gHINSTANCE, nullptr);
+  #elif defined OS_MAC
+    IGraphics::StartSharedPreloads(bitmaps, svgs, targetScale, IGRAPHICS_DRAW_CLASS::ThreadSafeBitmapDecoder(), BUNDLE_ID, nullptr, SHARED_RESOURCES_SUBPATH);
+  #elif defined OS_IOS
+    IGraphics::StartSharedPreloads(bitmaps, svgs, targetScale, IGRAPHICS_DRAW_CLASS::ThreadSafeBitmapDecoder(), BUNDLE_ID, nullptr, nullptr);
+  #else
+    IGraphics::StartSharedPreloads(bitmaps, svgs, targetScale, IGRAPHICS_DRAW_CLASS::ThreadSafeBitmapDecoder(), "", nullptr, nullptr);
+  #endif
+    mNSharedPreloads++;
+  }
+
   END_IGRAPHICS_NAMESPACE
   END_IPLUG_NAMESPACE
 
@@ -56,6 +56,12 @@
     #if defined IGRAPHICS_GL || defined IGRAPHICS_METAL
       #error When using IGRAPHICS_CANVAS, don't define IGRAPHICS_METAL or IGRAPHICS_GL*
     #endif
+  #elif defined IGRAPHICS_LICE
+    #include "IGraphicsLICE.h"
+    #define IGRAPHICS_DRAW_CLASS_TYPE IGraphicsLICE
+    #if defined IGRAPHICS_GL || defined IGRAPHICS_METAL
+      #error When using IGRAPHICS_LICE, don't define IGRAPHICS_METAL or IGRAPHICS_GL*
+    #endif
   #else
     #error NO IGRAPHICS_MODE defined
   #endif
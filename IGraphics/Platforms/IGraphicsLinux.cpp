@@ -8,4 +8,205 @@
  ==============================================================================
 */
 
-/\todo
+#include <cstdio>
+#include <memory>
+
+#include "IGraphicsLinux.h"
+#include "IPlugPaths.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+#pragma mark - Private Classes and Structs
+
+class IGraphicsLinux::FileFont : public PlatformFont
+{
+public:
+  FileFont(const char* fontPath)
+  : PlatformFont(false), mPath(fontPath)
+  {}
+
+  IFontDataPtr GetFontData() override;
+
+private:
+  WDL_String mPath;
+};
+
+IFontDataPtr IGraphicsLinux::FileFont::GetFontData()
+{
+  IFontDataPtr fontData(new IFontData());
+  FILE* fp = fopen(mPath.Get(), "rb");
+
+  if (!fp)
+    return fontData;
+
+  fseek(fp, 0, SEEK_END);
+  fontData = std::make_unique<IFontData>((int) ftell(fp));
+
+  if (!fontData->GetSize())
+  {
+    fclose(fp);
+    return fontData;
+  }
+
+  fseek(fp, 0, SEEK_SET);
+  size_t readSize = fread(fontData->Get(), 1, fontData->GetSize(), fp);
+  fclose(fp);
+
+  if (readSize && readSize == static_cast<size_t>(fontData->GetSize()))
+    fontData->SetFaceIdx(0);
+
+  return fontData;
+}
+
+class IGraphicsLinux::MemoryFont : public PlatformFont
+{
+public:
+  MemoryFont(const void* pData, int dataSize)
+  : PlatformFont(false)
+  {
+    mData.Set((const uint8_t*) pData, dataSize);
+  }
+
+  IFontDataPtr GetFontData() override
+  {
+    return IFontDataPtr(new IFontData(mData.Get(), mData.GetSize(), 0));
+  }
+
+private:
+  WDL_TypedBuf<uint8_t> mData;
+};
+
+#pragma mark -
+
+IGraphicsLinux::IGraphicsLinux(IGEditorDelegate& dlg, int w, int h, int fps, float scale)
+: IGRAPHICS_DRAW_CLASS(dlg, w, h, fps, scale)
+{
+}
+
+IGraphicsLinux::~IGraphicsLinux()
+{
+  CloseWindow();
+}
+
+void* IGraphicsLinux::OpenWindow(void* pParent)
+{
+  if (mWindowOpen)
+    return nullptr;
+
+  mWindowOpen = true;
+
+  OnViewInitialized(nullptr /* not used */);
+
+  SetScreenScale(GetScreenScale());
+
+  GetDelegate()->LayoutUI(this);
+  GetDelegate()->OnUIOpen();
+
+  return nullptr;
+}
+
+void IGraphicsLinux::CloseWindow()
+{
+  if (mWindowOpen)
+  {
+    OnViewDestroyed();
+    mWindowOpen = false;
+  }
+}
+
+bool IGraphicsLinux::RenderFrame()
+{
+  IRECTList rects;
+
+  if (!mWindowOpen)
+    return false;
+
+  if (IsDirty(rects))
+  {
+    SetAllControlsClean();
+    Draw(rects);
+    return true;
+  }
+
+  return false;
+}
+
+void IGraphicsLinux::RenderFullFrame()
+{
+  SetAllControlsDirty();
+  RenderFrame();
+}
+
+EMsgBoxResult IGraphicsLinux::ShowMessageBox(const char* str, const char* caption, EMsgBoxType type, IMsgBoxCompletionHanderFunc completionHandler)
+{
+  ReleaseMouseCapture();
+
+  DBGMSG("IGraphicsLinux::ShowMessageBox %s: %s\n", caption ? caption : "", str ? str : "");
+
+  // nobody can answer, so take the choice that doesn't proceed
+  EMsgBoxResult result = kNoResult;
+
+  switch (type)
+  {
+    case kMB_OK: result = kOK; break;
+    case kMB_YESNO: result = kNO; break;
+    case kMB_OKCANCEL:
+    case kMB_YESNOCANCEL:
+    case kMB_RETRYCANCEL: result = kCANCEL; break;
+    default:
+      break;
+  }
+
+  if (completionHandler)
+    completionHandler(result);
+
+  return result;
+}
+
+void IGraphicsLinux::PromptForFile(WDL_String& fileName, WDL_String& path, EFileAction action, const char* ext)
+{
+  fileName.Set("");
+}
+
+void IGraphicsLinux::PromptForDirectory(WDL_String& path)
+{
+  path.Set("");
+}
+
+IPopupMenu* IGraphicsLinux::CreatePlatformPopupMenu(IPopupMenu& menu, const IRECT& bounds, bool& isAsync)
+{
+  return nullptr;
+}
+
+PlatformFontPtr IGraphicsLinux::LoadPlatformFont(const char* fontID, const char* fileNameOrResID)
+{
+  WDL_String fullPath;
+  const EResourceLocation fontLocation = LocateResource(fileNameOrResID, "ttf", fullPath, GetBundleID(), nullptr, GetSharedResourcesSubPath());
+
+  if (fontLocation == kNotFound)
+    return nullptr;
+
+  return PlatformFontPtr(new FileFont(fullPath.Get()));
+}
+
+PlatformFontPtr IGraphicsLinux::LoadPlatformFont(const char* fontID, const char* fontName, ETextStyle style)
+{
+  // there is no font service to look up system fonts by name, load them from a file or from memory instead
+  return nullptr;
+}
+
+PlatformFontPtr IGraphicsLinux::LoadPlatformFont(const char* fontID, void* pData, int dataSize)
+{
+  return PlatformFontPtr(new MemoryFont(pData, dataSize));
+}
+
+#ifndef NO_IGRAPHICS
+#if defined IGRAPHICS_SKIA
+  #include "IGraphicsSkia.cpp"
+#elif defined IGRAPHICS_LICE
+  #include "IGraphicsLICE.cpp"
+#else
+  #error
+#endif
+#endif
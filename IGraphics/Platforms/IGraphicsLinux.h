@@ -12,47 +12,70 @@
 
 #include "IGraphics_select.h"
 
+#if !(defined IGRAPHICS_SKIA && defined IGRAPHICS_CPU) && !defined IGRAPHICS_LICE
+  #error IGraphicsLinux is a headless target, which requires IGRAPHICS_LICE, or IGRAPHICS_SKIA and IGRAPHICS_CPU
+#endif
+
 BEGIN_IPLUG_NAMESPACE
 BEGIN_IGRAPHICS_NAMESPACE
 
-/** IGraphics platform class for linux
-*   @ingroup PlatformClasses
-*/
+/** IGraphics platform class for linux. This is a headless target: there is no window or event loop, frames are drawn into an in-memory software surface (a Skia raster surface or a LICE bitmap).
+ * The host calls OpenWindow() once, injects mouse and key events via the IGraphics::OnMouseDown() etc. methods, and calls RenderFrame() for each frame,
+ * e.g. for offline rendering of a UI, screenshot tests or benchmarking drawing code on a machine without a display.
+ * Dialogs don't block: message boxes are declined, and file, directory and colour prompts are cancelled
+ * @ingroup PlatformClasses */
 class IGraphicsLinux final : public IGRAPHICS_DRAW_CLASS
 {
+  class FileFont;
+  class MemoryFont;
 public:
   IGraphicsLinux(IGEditorDelegate& dlg, int w, int h, int fps, float scale);
-  virtual ~IGraphicsLinux);
+  ~IGraphicsLinux();
 
-  void* OpenWindow(void* pWindow) override;
-  void CloseWindow() override;
-  bool WindowIsOpen() override;
-  void PlatformResize(bool parentHasResized) override;
+  const char* GetPlatformAPIStr() override { return "Linux (headless)"; }
 
-  void HideMouseCursor() override;
-  void ShowMouseCursor() override;
+  void HideMouseCursor(bool hide, bool lock) override { mCursorHidden = hide; }
+  void MoveMouseCursor(float x, float y) override { mMouseX = x; mMouseY = y; }
+  void GetMouseLocation(float& x, float&y) const override { x = mMouseX; y = mMouseY; }
 
+  void ForceEndUserEdit() override {}
+  void* OpenWindow(void* pParent) override;
+  void CloseWindow() override;
+  void* GetWindow() override { return nullptr; }
+  bool WindowIsOpen() override { return mWindowOpen; }
+  bool GetTextFromClipboard(WDL_String& str) override { str.Set(mClipboardText.Get()); return true; }
+  bool SetTextInClipboard(const char* str) override { mClipboardText.Set(str); return true; }
+  void UpdateTooltips() override {}
   EMsgBoxResult ShowMessageBox(const char* str, const char* caption, EMsgBoxType type, IMsgBoxCompletionHanderFunc completionHandler) override;
-  void ForceEndUserEdit() override;
-
-  const char* GetPlatformAPIStr() override;
-
-  void UpdateTooltips() override;
 
-  bool RevealPathInExplorerOrFinder(WDL_String& path, bool select) override;
-  void PromptForFile(WDL_String& fileName, WDL_String& path, EFileAction action,  const char* ext, IColorPickerHandlerFunc func) override;
-  bool PromptForColor(IColor& color, const char* str) override;
+  void PromptForFile(WDL_String& fileName, WDL_String& path, EFileAction action, const char* ext) override;
+  void PromptForDirectory(WDL_String& path) override;
+  bool PromptForColor(IColor& color, const char* str, IColorPickerHandlerFunc func) override { return false; }
+  bool OpenURL(const char* url, const char* msgWindowTitle, const char* confirmMsg, const char* errMsgOnFailure) override { return false; }
 
-  bool OpenURL(const char* url, const char* msgWindowTitle, const char* confirmMsg, const char* errMsgOnFailure) override;
+  //IGraphicsLinux
+  /** Animate the controls and, if any are dirty, draw them into the surface. This is what a platform's display timer does on the other targets
+   * @return \c true if anything was drawn */
+  bool RenderFrame();
 
-  static int GetUserOSVersion();
-  bool GetTextFromClipboard(WDL_String& str) override;
-  bool SetTextInClipboard(const char* str) override { return false; } // TODO
+  /** Draw every control into the surface, regardless of whether it is dirty */
+  void RenderFullFrame();
 
 protected:
-  IPopupMenu* CreatePlatformPopupMenu(const IPopupMenu& menu, IRECT& bounds) override;
-  void CreatePlatformTextEntry(int paramIdx, const IText& text, const IRECT& bounds, int length, const char* str) override;
-}
+  IPopupMenu* CreatePlatformPopupMenu(IPopupMenu& menu, const IRECT& bounds, bool& isAsync) override;
+  void CreatePlatformTextEntry(int paramIdx, const IText& text, const IRECT& bounds, int length, const char* str) override {}
+
+private:
+  PlatformFontPtr LoadPlatformFont(const char* fontID, const char* fileNameOrResID) override;
+  PlatformFontPtr LoadPlatformFont(const char* fontID, const char* fontName, ETextStyle style) override;
+  PlatformFontPtr LoadPlatformFont(const char* fontID, void* pData, int dataSize) override;
+  void CachePlatformFont(const char* fontID, const PlatformFontPtr& font) override {}
+
+  WDL_String mClipboardText;
+  float mMouseX = 0.f;
+  float mMouseY = 0.f;
+  bool mWindowOpen = false;
+};
 
 END_IGRAPHICS_NAMESPACE
 END_IPLUG_NAMESPACE
@@ -629,6 +629,8 @@ void IGraphicsMac::CreatePlatformImGui()
 #if defined IGRAPHICS_IMGUI
   #if defined IGRAPHICS_SKIA && IGRAPHICS_CPU
     #define USE_IGRAPHICS_IMGUIVIEW 1
+  #elif defined IGRAPHICS_LICE
+    #define USE_IGRAPHICS_IMGUIVIEW 1
   #elif defined IGRAPHICS_NANOVG && IGRAPHICS_METAL
     #define USE_IGRAPHICS_IMGUIVIEW 1
 #else
@@ -652,6 +654,8 @@ void IGraphicsMac::CreatePlatformImGui()
   #include "IGraphicsNanoVG.cpp"
 #elif defined IGRAPHICS_SKIA
   #include "IGraphicsSkia.cpp"
+#elif defined IGRAPHICS_LICE
+  #include "IGraphicsLICE.cpp"
 #else
   #error Either NO_IGRAPHICS or one and only one choice of graphics library must be defined!
 #endif
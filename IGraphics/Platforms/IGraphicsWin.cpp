@@ -2239,6 +2239,8 @@ void IGraphicsWin::VBlankNotify()
 #endif
   #include "nanovg.c"
   #include "glad.c"
+#elif defined IGRAPHICS_LICE
+  #include "IGraphicsLICE.cpp"
 #else
   #error
 #endif
@@ -257,6 +257,8 @@ void IPlugAAX::RenderAudio(AAX_SIPlugRenderInfo* pRenderInfo, const TParamValPai
 {
   TRACE
 
+  ProcessPendingParamState();
+
   // Get bypass parameter value
   bool bypass;
   mBypassParameter->GetValueAsBool(&bypass);
@@ -503,10 +505,14 @@ AAX_Result IPlugAAX::SetChunk(AAX_CTypeID chunkID, const AAX_SPlugInChunk* pChun
     //IByteChunk::GetIPlugVerFromChunk(chunk, pos); // TODO: IPlugVer should be in chunk!
     pos = UnserializeState(chunk, pos);
     
+    // with lock-free state restore, the restored values may only be staged for the audio thread
+    std::vector<double> pendingValues(NParams());
+    const bool pending = GetPendingParamState(pendingValues.data());
+    
     for (int i = 0; i< NParams(); i++)
-      SetParameterNormalizedValue(mParamIDs.Get(i)->Get(), GetParam(i)->GetNormalized());
+      SetParameterNormalizedValue(mParamIDs.Get(i)->Get(), pending ? GetParam(i)->ToNormalized(pendingValues[i]) : GetParam(i)->GetNormalized());
     
-    OnRestoreState();
+    CallOnRestoreState();
     mNumPlugInChanges++; // necessary in order to cause CompareActiveChunk() to get called again and turn off the compare light 
     
     return AAX_SUCCESS;
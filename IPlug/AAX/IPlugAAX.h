@@ -122,7 +122,7 @@ private:
   AAX_CParameter<bool>* mBypassParameter = nullptr;
   AAX_ITransport* mTransport = nullptr;
   WDL_PtrList<WDL_String> mParamIDs;
-  IMidiQueue mMidiOutputQueue;
+  IMidiQueue mMidiOutputQueue {DEFAULT_BLOCK_SIZE, IMidiQueue::EOverflowPolicy::DropOldest};
   int mMaxNChansForMainInputBus = 0;
   WDL_String mTrackName;
 };
@@ -156,6 +156,8 @@ void IPlugAPP::AppProcess(double** inputs, double** outputs, int nFrames)
 
   //Do not handle Sysex messages here - SendSysexMsgFromUI overridden
 
+  ProcessPendingParamState();
+
   ENTER_PARAMS_MUTEX
   ProcessBuffers(0.0, GetBlockSize());
   LEAVE_PARAMS_MUTEX
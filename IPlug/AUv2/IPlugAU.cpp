@@ -1502,7 +1502,7 @@ OSStatus IPlugAU::SetState(CFPropertyListRef pPropList)
     return kAudioUnitErr_InvalidPropertyValue;
   }
 
-  OnRestoreState();
+  CallOnRestoreState();
   return noErr;
 }
 
@@ -1732,6 +1732,8 @@ OSStatus IPlugAU::RenderProc(void* pPlug, AudioUnitRenderActionFlags* pFlags, co
       _this->SetChannelConnections(ERoute::kOutput, nConnected, totalNumChans - nConnected, false); // this will disconnect the channels that are on the unconnected buses
     }
 
+    _this->ProcessPendingParamState();
+
     if (_this->GetBypassed())
     {
       _this->PassThroughBuffers((AudioSampleType) 0, nFrames);
@@ -1816,6 +1818,8 @@ IPlugAU::IPlugAU(const InstanceInfo& info, const Config& config)
 {
   Trace(TRACELOC, "%s", config.pluginName);
 
+  SetProcessingActive(false);
+
   memset(&mHostCallbacks, 0, sizeof(HostCallbackInfo));
   memset(&mMidiCallback, 0, sizeof(AUMIDIOutputCallbackStruct));
 
@@ -2265,6 +2269,7 @@ OSStatus IPlugAU::DoInitialize(IPlugAU* _this)
   }
 
   _this->mActive = true;
+  _this->SetProcessingActive(true);
   _this->OnParamReset(kReset);
   _this->OnActivate(true);
   
@@ -2276,6 +2281,7 @@ OSStatus IPlugAU::DoUninitialize(IPlugAU* _this)
 {
   _this->mActive = false;
   _this->OnActivate(false);
+  _this->SetProcessingActive(false);
   return noErr;
 }
 
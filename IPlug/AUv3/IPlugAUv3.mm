@@ -121,6 +121,7 @@ bool IPlugAUv3::SendSysEx(const ISysEx& msg)
 void IPlugAUv3::ProcessWithEvents(AudioTimeStamp const* pTimestamp, uint32_t frameCount, AURenderEvent const* pEvents, ITimeInfo& timeInfo)
 {
   SetTimeInfo(timeInfo);
+  ProcessPendingParamState();
   
   IMidiMsg midiMsg;
   while (mMidiMsgsFromEditor.Pop(midiMsg))
@@ -0,0 +1,72 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#include "IPlugCLI.h"
+
+using namespace iplug;
+
+IPlugCLI::IPlugCLI(const InstanceInfo& info, const Config& config)
+: IPlugAPIBase(config, kAPICLI)
+, IPlugProcessor(config, kAPICLI)
+{
+  Trace(TRACELOC, "%s%s", config.pluginName, config.channelIOStr);
+
+  SetBlockSize(DEFAULT_BLOCK_SIZE);
+
+  // No timer is created, there is no user interface to update and the host never waits on the main thread
+}
+
+void IPlugCLI::CLIPrepare(double sampleRate, int blockSize, int nInputs, int nOutputs, double tempo)
+{
+  SetSampleRate(sampleRate);
+  SetBlockSize(blockSize);
+  SetRenderingOffline(true);
+
+  SetChannelConnections(ERoute::kInput, 0, MaxNChannels(ERoute::kInput), false);
+  SetChannelConnections(ERoute::kInput, 0, nInputs, true);
+  SetChannelConnections(ERoute::kOutput, 0, MaxNChannels(ERoute::kOutput), false);
+  SetChannelConnections(ERoute::kOutput, 0, nOutputs, true);
+
+  mTimeInfo = ITimeInfo();
+  mTimeInfo.mTempo = tempo;
+  mTimeInfo.mTransportIsRunning = true;
+
+  OnParamReset(kReset);
+  OnReset();
+  OnActivate(true);
+}
+
+void IPlugCLI::CLIProcess(sample** inputs, sample** outputs, int nFrames, const IParamChange* pChanges, int nChanges, double samplePos)
+{
+  mTimeInfo.mSamplePos = samplePos;
+  mTimeInfo.mPPQPos = samplePos / GetSampleRate() * mTimeInfo.mTempo / 60.;
+
+  AttachBuffers(ERoute::kInput, 0, NChannelsConnected(ERoute::kInput), inputs, nFrames);
+  AttachBuffers(ERoute::kOutput, 0, NChannelsConnected(ERoute::kOutput), outputs, nFrames);
+
+  ProcessPendingParamState();
+
+  mParamChanges.Clear();
+
+  ENTER_PARAMS_MUTEX
+  for (int i = 0; i < nChanges; i++)
+  {
+    const IParamChange& change = pChanges[i];
+
+    if (mSampleAccurateAutomation)
+      mParamChanges.Add(change);
+
+    GetParam(change.mParamIdx)->Set(change.mValue);
+    OnParamChange(change.mParamIdx, kHost, change.mOffset);
+  }
+
+  ProcessBuffers((sample) 0., nFrames);
+  LEAVE_PARAMS_MUTEX
+}
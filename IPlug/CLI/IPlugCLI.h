@@ -0,0 +1,73 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#ifndef _IPLUGAPI_
+#define _IPLUGAPI_
+
+/**
+ * @file
+ * @copydoc IPlugCLI
+ */
+
+#include "IPlugPlatform.h"
+#include "IPlugAPIBase.h"
+#include "IPlugProcessor.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Used to pass various instance info to the API class */
+struct InstanceInfo
+{};
+
+/** Command-line API base class for an IPlug plug-in. There is no audio device or window, the plug-in is driven by IPlugCLIHost,
+ * which renders audio files through it offline, as fast as it can. Built with IPLUG_EDITOR, the user interface can be opened on the headless linux IGraphics target,
+ * see Tests/IGraphicsStressTest
+ * @ingroup APIClasses */
+class IPlugCLI : public IPlugAPIBase
+               , public IPlugProcessor
+{
+public:
+  IPlugCLI(const InstanceInfo& info, const Config& config);
+
+  //IPlugAPIBase
+  void BeginInformHostOfParamChange(int idx) override {};
+  void InformHostOfParamChange(int idx, double normalizedValue) override {};
+  void EndInformHostOfParamChange(int idx) override {};
+  void InformHostOfPresetChange() override {};
+  void SendParameterValueFromAPI(int paramIdx, double value, bool normalized) override {}; // there is no user interface to update
+
+  //IPlugProcessor
+  bool SendMidiMsg(const IMidiMsg& msg) override { return false; }
+  bool SendSysEx(const ISysEx& msg) override { return false; }
+
+  //IPlugCLI
+  /** Called by the host before rendering, to set the sample rate, the maximum block size and the connected channels, switch to offline rendering, and reset the plug-in
+   * @param sampleRate The sample rate of the render
+   * @param blockSize The maximum number of frames per call to CLIProcess()
+   * @param nInputs The number of input channels to connect
+   * @param nOutputs The number of output channels to connect
+   * @param tempo The tempo reported to the plug-in, the transport runs from the start of the render */
+  void CLIPrepare(double sampleRate, int blockSize, int nInputs, int nOutputs, double tempo = DEFAULT_TEMPO);
+
+  /** Called by the host to process a block. Parameter changes are applied in order before ProcessBlock(), as host automation
+   * @param inputs The connected input channels
+   * @param outputs The connected output channels
+   * @param nFrames The number of frames in this block, no more than the block size passed to CLIPrepare()
+   * @param pChanges Parameter changes for this block, sorted by offset, with non-normalized values
+   * @param nChanges The number of parameter changes
+   * @param samplePos The position of the first frame of the block in the render */
+  void CLIProcess(sample** inputs, sample** outputs, int nFrames, const IParamChange* pChanges, int nChanges, double samplePos);
+};
+
+IPlugCLI* MakePlug(const InstanceInfo& info);
+
+END_IPLUG_NAMESPACE
+
+#endif
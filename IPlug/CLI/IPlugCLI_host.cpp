@@ -0,0 +1,842 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+#include "lineparse.h"
+
+#include "IPlugCLI_host.h"
+#include "IPlugUtilities.h"
+
+#include "config.h"
+
+using namespace iplug;
+
+namespace
+{
+  bool HasRawExtension(const char* path)
+  {
+    const size_t len = strlen(path);
+    return len >= 4 && !stricmp(path + len - 4, ".raw");
+  }
+
+  uint32_t ReadLE(const uint8_t* pBytes, int nBytes)
+  {
+    uint32_t value = 0;
+
+    for (int i = 0; i < nBytes; i++)
+      value |= static_cast<uint32_t>(pBytes[i]) << (8 * i);
+
+    return value;
+  }
+
+  void WriteLE(uint8_t*& pBytes, uint32_t value, int nBytes)
+  {
+    for (int i = 0; i < nBytes; i++)
+      *pBytes++ = static_cast<uint8_t>(value >> (8 * i));
+  }
+
+  const int kWAVFormatPCM = 1;
+  const int kWAVFormatFloat = 3;
+  const int kWAVFormatExtensible = 0xFFFE;
+
+  // limits for the command-line options, so that the values always fit the ints and WAV header fields they end up in
+  const int kMaxBlockSize = 65536;
+  const int kMaxChannels = 64;
+  const double kMaxSampleRate = 1536000.;
+  const double kMaxSeconds = 86400.;
+  const double kMaxTempo = 1000.;
+}
+
+#pragma mark - AudioFileReader
+
+IPlugCLIHost::AudioFileReader::~AudioFileReader()
+{
+  if (mFile)
+    fclose(mFile);
+}
+
+bool IPlugCLIHost::AudioFileReader::Open(const char* path, int rawChannels, double rawSampleRate, WDL_String& error)
+{
+  mFile = fopen(path, "rb");
+
+  if (!mFile)
+  {
+    error.SetFormatted(1024, "Couldn't open %s", path);
+    return false;
+  }
+
+  if (HasRawExtension(path))
+  {
+    fseek(mFile, 0, SEEK_END);
+    const int64_t size = ftell(mFile);
+    rewind(mFile);
+
+    mNChannels = rawChannels;
+    mSampleRate = rawSampleRate;
+    mBytesPerSample = 4;
+    mFloat = true;
+    mNFrames = size / (mNChannels * mBytesPerSample);
+    return true;
+  }
+
+  uint8_t header[12];
+
+  if (fread(header, 1, 12, mFile) != 12 || memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4))
+  {
+    error.SetFormatted(1024, "%s is not a WAV file, raw files should end in .raw", path);
+    return false;
+  }
+
+  bool gotFormat = false;
+  int blockAlign = 0;
+
+  while (true)
+  {
+    uint8_t chunkHeader[8];
+
+    if (fread(chunkHeader, 1, 8, mFile) != 8)
+    {
+      error.SetFormatted(1024, "%s has no audio data", path);
+      return false;
+    }
+
+    const uint32_t chunkSize = ReadLE(chunkHeader + 4, 4);
+
+    if (!memcmp(chunkHeader, "fmt ", 4))
+    {
+      uint8_t fmt[40] = {};
+
+      if (chunkSize < 16 || fread(fmt, 1, std::min<uint32_t>(chunkSize, 40), mFile) != std::min<uint32_t>(chunkSize, 40))
+      {
+        error.SetFormatted(1024, "%s has a bad format chunk", path);
+        return false;
+      }
+
+      int format = ReadLE(fmt, 2);
+
+      if (format == kWAVFormatExtensible && chunkSize >= 26)
+        format = ReadLE(fmt + 24, 2); // the first two bytes of the sub format GUID
+
+      mNChannels = ReadLE(fmt + 2, 2);
+      mSampleRate = ReadLE(fmt + 4, 4);
+      blockAlign = ReadLE(fmt + 12, 2);
+      const int bitDepth = ReadLE(fmt + 14, 2);
+      mBytesPerSample = (bitDepth + 7) / 8;
+      mFloat = format == kWAVFormatFloat;
+
+      const bool supported = (format == kWAVFormatPCM && mBytesPerSample >= 1 && mBytesPerSample <= 4)
+                          || (format == kWAVFormatFloat && (mBytesPerSample == 4 || mBytesPerSample == 8));
+
+      if (!supported || mNChannels < 1 || blockAlign != mNChannels * mBytesPerSample)
+      {
+        error.SetFormatted(1024, "%s has an unsupported format (%i, %i bit), use integer PCM or floating point", path, format, bitDepth);
+        return false;
+      }
+
+      if (chunkSize > 40)
+        fseek(mFile, chunkSize - 40, SEEK_CUR);
+
+      if (chunkSize & 1)
+        fseek(mFile, 1, SEEK_CUR);
+
+      gotFormat = true;
+    }
+    else if (!memcmp(chunkHeader, "data", 4))
+    {
+      if (!gotFormat)
+      {
+        error.SetFormatted(1024, "%s has no format chunk before its audio data", path);
+        return false;
+      }
+
+      mNFrames = chunkSize / blockAlign;
+      return true;
+    }
+    else
+    {
+      fseek(mFile, chunkSize + (chunkSize & 1), SEEK_CUR);
+    }
+  }
+}
+
+int IPlugCLIHost::AudioFileReader::Read(sample** ppData, int nFrames)
+{
+  const int nRead = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(nFrames, mNFrames - mNFramesRead)));
+  const int frameBytes = mNChannels * mBytesPerSample;
+
+  mBuffer.resize(static_cast<size_t>(nRead) * frameBytes);
+
+  const int nGot = nRead ? static_cast<int>(fread(mBuffer.data(), frameBytes, nRead, mFile)) : 0;
+  const uint8_t* pBytes = mBuffer.data();
+
+  for (int s = 0; s < nGot; s++)
+  {
+    for (int c = 0; c < mNChannels; c++, pBytes += mBytesPerSample)
+    {
+      double value;
+
+      if (mFloat && mBytesPerSample == 4)
+      {
+        float f;
+        memcpy(&f, pBytes, 4);
+        value = f;
+      }
+      else if (mFloat)
+      {
+        memcpy(&value, pBytes, 8);
+      }
+      else if (mBytesPerSample == 1)
+      {
+        value = (static_cast<int>(pBytes[0]) - 128) / 128.;
+      }
+      else
+      {
+        // shift into the top bits of an int32, so that the sign is extended
+        const int shift = 32 - 8 * mBytesPerSample;
+        value = static_cast<int32_t>(ReadLE(pBytes, mBytesPerSample) << shift) / 2147483648.;
+      }
+
+      ppData[c][s] = static_cast<sample>(value);
+    }
+  }
+
+  for (int c = 0; c < mNChannels; c++)
+    std::fill(ppData[c] + nGot, ppData[c] + nFrames, static_cast<sample>(0));
+
+  mNFramesRead += nGot;
+
+  return nGot;
+}
+
+#pragma mark - AudioFileWriter
+
+bool IPlugCLIHost::AudioFileWriter::Open(const char* path, int nChannels, double sampleRate, int bitDepth, WDL_String& error)
+{
+  mRaw = HasRawExtension(path);
+
+  if (!mRaw && bitDepth != 16 && bitDepth != 24 && bitDepth != 32)
+  {
+    error.SetFormatted(1024, "Unsupported bit depth %i, use 16, 24 or 32", bitDepth);
+    return false;
+  }
+
+  mFile = fopen(path, "wb");
+
+  if (!mFile)
+  {
+    error.SetFormatted(1024, "Couldn't open %s for writing", path);
+    return false;
+  }
+
+  mNChannels = nChannels;
+  mSampleRate = static_cast<int>(std::lround(sampleRate));
+  mBitDepth = mRaw ? 32 : bitDepth;
+  mNFramesWritten = 0;
+  mFailed = false;
+
+  if (!mRaw)
+    WriteHeader(); // rewritten with the sizes by Close()
+
+  return true;
+}
+
+void IPlugCLIHost::AudioFileWriter::WriteHeader()
+{
+  const bool isFloat = mBitDepth == 32;
+  const int bytesPerSample = mBitDepth / 8;
+  const uint32_t dataSize = static_cast<uint32_t>(mNFramesWritten * mNChannels * bytesPerSample);
+  const uint32_t headerSize = isFloat ? 56 : 44; // floating point files have a fact chunk
+
+  uint8_t header[56];
+  uint8_t* pBytes = header;
+
+  memcpy(pBytes, "RIFF", 4); pBytes += 4;
+  WriteLE(pBytes, headerSize - 8 + dataSize + (dataSize & 1), 4);
+  memcpy(pBytes, "WAVEfmt ", 8); pBytes += 8;
+  WriteLE(pBytes, 16, 4);
+  WriteLE(pBytes, isFloat ? kWAVFormatFloat : kWAVFormatPCM, 2);
+  WriteLE(pBytes, mNChannels, 2);
+  WriteLE(pBytes, mSampleRate, 4);
+  WriteLE(pBytes, mSampleRate * mNChannels * bytesPerSample, 4);
+  WriteLE(pBytes, mNChannels * bytesPerSample, 2);
+  WriteLE(pBytes, mBitDepth, 2);
+
+  if (isFloat)
+  {
+    memcpy(pBytes, "fact", 4); pBytes += 4;
+    WriteLE(pBytes, 4, 4);
+    WriteLE(pBytes, static_cast<uint32_t>(mNFramesWritten), 4);
+  }
+
+  memcpy(pBytes, "data", 4); pBytes += 4;
+  WriteLE(pBytes, dataSize, 4);
+
+  fseek(mFile, 0, SEEK_SET);
+
+  if (fwrite(header, 1, headerSize, mFile) != headerSize)
+    mFailed = true;
+}
+
+bool IPlugCLIHost::AudioFileWriter::Write(sample** ppData, int offset, int nFrames)
+{
+  if (!mFile)
+    return false;
+
+  const int bytesPerSample = mBitDepth / 8;
+  mBuffer.resize(static_cast<size_t>(nFrames) * mNChannels * bytesPerSample);
+  uint8_t* pBytes = mBuffer.data();
+
+  for (int s = offset; s < offset + nFrames; s++)
+  {
+    for (int c = 0; c < mNChannels; c++)
+    {
+      if (mBitDepth == 32)
+      {
+        const float f = static_cast<float>(ppData[c][s]);
+
+        if (mRaw)
+          memcpy(pBytes, &f, 4), pBytes += 4;
+        else
+        {
+          uint32_t bits;
+          memcpy(&bits, &f, 4);
+          WriteLE(pBytes, bits, 4);
+        }
+      }
+      else
+      {
+        const double fullScale = mBitDepth == 16 ? 32767. : 8388607.;
+        const double value = Clip(static_cast<double>(ppData[c][s]), -1., 1.) * fullScale;
+        WriteLE(pBytes, static_cast<uint32_t>(static_cast<int32_t>(std::lround(value))), bytesPerSample);
+      }
+    }
+  }
+
+  if (fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size())
+    mFailed = true;
+
+  mNFramesWritten += nFrames;
+
+  return !mFailed;
+}
+
+bool IPlugCLIHost::AudioFileWriter::Close()
+{
+  if (!mFile)
+    return !mFailed;
+
+  if (!mRaw)
+  {
+    const int64_t dataSize = mNFramesWritten * mNChannels * (mBitDepth / 8);
+
+    if (dataSize & 1)
+    {
+      const uint8_t pad = 0;
+      fwrite(&pad, 1, 1, mFile);
+    }
+
+    if (dataSize > 0xFFFFFFFFll - 56)
+      mFailed = true; // too large for a WAV file
+
+    WriteHeader();
+  }
+
+  if (fclose(mFile))
+    mFailed = true;
+
+  mFile = nullptr;
+
+  return !mFailed;
+}
+
+#pragma mark - IPlugCLIHost
+
+void IPlugCLIHost::PrintUsage(FILE* pFile, const char* programName)
+{
+  fprintf(pFile,
+    "%s - renders audio files through %s offline\n"
+    "\n"
+    "usage: %s [options] [input] output\n"
+    "\n"
+    "Files ending in .raw are interleaved 32 bit floats, anything else is WAV. If there is no input, --length sets the duration.\n"
+    "\n"
+    "options:\n"
+    "  -p, --preset FILE        load a preset, either a .fxp file or a raw state chunk\n"
+    "  -a, --automation FILE    apply parameter automation, one \"seconds parameter value\" point per line\n"
+    "  -b, --block-size N       the maximum number of frames per block, up to %i (default %i)\n"
+    "  -r, --sample-rate HZ     the sample rate of raw input, or of the render if there is no input, up to %.0f (default %g)\n"
+    "  -c, --channels N         the number of channels in raw input, up to %i (default 2)\n"
+    "  -d, --bit-depth N        16 or 24 for integer PCM, or 32 for floating point WAV output (default 32)\n"
+    "  -l, --length SECONDS     the duration to render if there is no input\n"
+    "  -t, --tail SECONDS       extra time to render after the input ends\n"
+    "      --tempo BPM          the tempo reported to the plug-in (default %g)\n"
+    "      --no-latency-compensation\n"
+    "                           keep the plug-in's latency at the start of the output, rather than removing it\n"
+    "      --timing FILE        write the time taken by each block to a CSV file\n"
+    "      --list-params        print the plug-in's parameters and exit\n"
+    "  -q, --quiet              don't print the timing report\n"
+    "  -h, --help               print this message and exit\n",
+    programName, PLUG_NAME, programName, kMaxBlockSize, DEFAULT_BLOCK_SIZE, kMaxSampleRate, DEFAULT_SAMPLE_RATE, kMaxChannels, DEFAULT_TEMPO);
+}
+
+bool IPlugCLIHost::ParseArgs(int argc, char* argv[], Options& options, WDL_String& error)
+{
+  std::vector<const char*> paths;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    auto is = [arg](const char* shortName, const char* longName) {
+      return (shortName && !strcmp(arg, shortName)) || !strcmp(arg, longName);
+    };
+
+    // options that take a value
+    const char* value = nullptr;
+    auto getValue = [&]() {
+      if (i + 1 >= argc)
+      {
+        error.SetFormatted(1024, "%s needs a value", arg);
+        return false;
+      }
+
+      value = argv[++i];
+      return true;
+    };
+
+    auto getNumber = [&](double& number, double min, double max, bool integer = false) {
+      if (!getValue())
+        return false;
+
+      char* pEnd = nullptr;
+      number = strtod(value, &pEnd);
+
+      if (pEnd == value || *pEnd || !(number >= min && number <= max) || (integer && number != std::floor(number)))
+      {
+        error.SetFormatted(1024, "Bad value for %s: %s", arg, value);
+        return false;
+      }
+
+      return true;
+    };
+
+    double number = 0.;
+
+    if (is("-h", "--help"))
+      options.mHelp = true;
+    else if (is("-q", "--quiet"))
+      options.mQuiet = true;
+    else if (is(nullptr, "--list-params"))
+      options.mListParams = true;
+    else if (is(nullptr, "--no-latency-compensation"))
+      options.mCompensateLatency = false;
+    else if (is("-p", "--preset"))
+    {
+      if (!getValue()) return false;
+      options.mPresetPath.Set(value);
+    }
+    else if (is("-a", "--automation"))
+    {
+      if (!getValue()) return false;
+      options.mAutomationPath.Set(value);
+    }
+    else if (is(nullptr, "--timing"))
+    {
+      if (!getValue()) return false;
+      options.mTimingPath.Set(value);
+    }
+    else if (is("-b", "--block-size"))
+    {
+      if (!getNumber(number, 1., kMaxBlockSize, true)) return false;
+      options.mBlockSize = static_cast<int>(number);
+    }
+    else if (is("-r", "--sample-rate"))
+    {
+      if (!getNumber(number, 1., kMaxSampleRate)) return false;
+      options.mSampleRate = number;
+    }
+    else if (is("-c", "--channels"))
+    {
+      if (!getNumber(number, 1., kMaxChannels, true)) return false;
+      options.mRawChannels = static_cast<int>(number);
+    }
+    else if (is("-d", "--bit-depth"))
+    {
+      if (!getNumber(number, 16., 32., true) || (number != 16. && number != 24. && number != 32.))
+      {
+        error.SetFormatted(1024, "Bad value for %s: %s, use 16, 24 or 32", arg, value);
+        return false;
+      }
+
+      options.mBitDepth = static_cast<int>(number);
+    }
+    else if (is("-l", "--length"))
+    {
+      if (!getNumber(number, 0., kMaxSeconds)) return false;
+      options.mLength = number;
+    }
+    else if (is("-t", "--tail"))
+    {
+      if (!getNumber(number, 0., kMaxSeconds)) return false;
+      options.mTail = number;
+    }
+    else if (is(nullptr, "--tempo"))
+    {
+      if (!getNumber(number, 1., kMaxTempo)) return false;
+      options.mTempo = number;
+    }
+    else if (arg[0] == '-' && arg[1])
+    {
+      error.SetFormatted(1024, "Unknown option %s", arg);
+      return false;
+    }
+    else
+      paths.push_back(arg);
+  }
+
+  if (options.mHelp || options.mListParams)
+    return true;
+
+  if (paths.size() == 2)
+  {
+    options.mInputPath.Set(paths[0]);
+    options.mOutputPath.Set(paths[1]);
+  }
+  else if (paths.size() == 1)
+  {
+    options.mOutputPath.Set(paths[0]);
+
+    if (options.mLength <= 0.)
+    {
+      error.Set("Without an input file, --length is needed");
+      return false;
+    }
+  }
+  else
+  {
+    error.Set(paths.empty() ? "No output file" : "Too many files");
+    return false;
+  }
+
+  return true;
+}
+
+int IPlugCLIHost::FindParam(const char* nameOrIdx) const
+{
+  char* pEnd = nullptr;
+  const long idx = strtol(nameOrIdx, &pEnd, 10);
+
+  if (pEnd != nameOrIdx && !*pEnd)
+    return (idx >= 0 && idx < mIPlug->NParams()) ? static_cast<int>(idx) : kNoParameter;
+
+  for (int i = 0; i < mIPlug->NParams(); i++)
+  {
+    if (!strcmp(mIPlug->GetParam(i)->GetName(), nameOrIdx))
+      return i;
+  }
+
+  return kNoParameter;
+}
+
+void IPlugCLIHost::ListParams() const
+{
+  printf("%-6s %-24s %12s %12s %12s  %s\n", "index", "name", "min", "max", "default", "label");
+
+  for (int i = 0; i < mIPlug->NParams(); i++)
+  {
+    const IParam* pParam = mIPlug->GetParam(i);
+    printf("%-6i %-24s %12g %12g %12g  %s\n", i, pParam->GetName(), pParam->GetMin(), pParam->GetMax(), pParam->GetDefault(), pParam->GetLabel());
+  }
+}
+
+bool IPlugCLIHost::LoadPreset(const char* path, WDL_String& error)
+{
+  FILE* pFile = fopen(path, "rb");
+
+  if (!pFile)
+  {
+    error.SetFormatted(1024, "Couldn't open preset %s", path);
+    return false;
+  }
+
+  fseek(pFile, 0, SEEK_END);
+  const long size = ftell(pFile);
+  rewind(pFile);
+
+  IByteChunk chunk;
+  chunk.Resize(static_cast<int>(size));
+  const bool read = size > 0 && fread(chunk.GetData(), size, 1, pFile) == 1;
+  fclose(pFile);
+
+  if (!read)
+  {
+    error.SetFormatted(1024, "Couldn't read preset %s", path);
+    return false;
+  }
+
+  if (size >= 4 && !memcmp(chunk.GetData(), "CcnK", 4))
+  {
+    if (!mIPlug->LoadPresetFromFXP(path))
+    {
+      error.SetFormatted(1024, "%s is not a preset for %s", path, PLUG_NAME);
+      return false;
+    }
+  }
+  else if (mIPlug->UnserializeState(chunk, 0) < 0)
+  {
+    error.SetFormatted(1024, "Couldn't restore the state in %s", path);
+    return false;
+  }
+
+  return true;
+}
+
+bool IPlugCLIHost::LoadAutomation(const char* path, double sampleRate, WDL_String& error)
+{
+  FILE* pFile = fopen(path, "r");
+
+  if (!pFile)
+  {
+    error.SetFormatted(1024, "Couldn't open automation %s", path);
+    return false;
+  }
+
+  char line[4096];
+  int lineNumber = 0;
+  LineParser lp;
+
+  // LineParser::gettoken_float() doesn't accept signs or exponents
+  auto getNumber = [&lp](int token, double& number) {
+    const char* str = lp.gettoken_str(token);
+    char* pEnd = nullptr;
+    number = strtod(str, &pEnd);
+    return pEnd != str && !*pEnd;
+  };
+
+  while (fgets(line, sizeof(line), pFile))
+  {
+    lineNumber++;
+    line[strcspn(line, "\r\n")] = '\0';
+
+    if (lp.parse(line) < 0 || !lp.getnumtokens())
+      continue;
+
+    double time = 0., value = 0.;
+    const bool numbersOK = lp.getnumtokens() == 3 && getNumber(0, time) && getNumber(2, value);
+
+    if (!numbersOK || time < 0.)
+    {
+      error.SetFormatted(1024, "%s:%i: expected \"seconds parameter value\"", path, lineNumber);
+      fclose(pFile);
+      return false;
+    }
+
+    const int paramIdx = FindParam(lp.gettoken_str(1));
+
+    if (paramIdx == kNoParameter)
+    {
+      error.SetFormatted(1024, "%s:%i: no parameter %s", path, lineNumber, lp.gettoken_str(1));
+      fclose(pFile);
+      return false;
+    }
+
+    mAutomation.push_back({static_cast<int64_t>(std::llround(time * sampleRate)), paramIdx, value});
+  }
+
+  fclose(pFile);
+
+  std::stable_sort(mAutomation.begin(), mAutomation.end(), [](const AutomationPoint& a, const AutomationPoint& b) {
+    return a.mFrame < b.mFrame;
+  });
+
+  return true;
+}
+
+void IPlugCLIHost::ReportTiming(const Options& options, int nInputs, int nOutputs, int64_t nRenderFrames, const std::vector<double>& blockTimes) const
+{
+  if (!options.mTimingPath.GetLength() && options.mQuiet)
+    return;
+
+  const int blockSize = options.mBlockSize;
+
+  if (options.mTimingPath.GetLength())
+  {
+    FILE* pFile = fopen(options.mTimingPath.Get(), "w");
+
+    if (pFile)
+    {
+      fprintf(pFile, "block,frames,microseconds\n");
+
+      for (size_t i = 0; i < blockTimes.size(); i++)
+      {
+        const int64_t frames = std::min<int64_t>(blockSize, nRenderFrames - static_cast<int64_t>(i) * blockSize);
+        fprintf(pFile, "%i,%lli,%.3f\n", static_cast<int>(i), static_cast<long long>(frames), blockTimes[i]);
+      }
+
+      fclose(pFile);
+    }
+    else
+      fprintf(stderr, "Couldn't write timing to %s\n", options.mTimingPath.Get());
+  }
+
+  if (options.mQuiet || blockTimes.empty())
+    return;
+
+  std::vector<double> sorted(blockTimes);
+  std::sort(sorted.begin(), sorted.end());
+
+  const double sampleRate = mIPlug->GetSampleRate();
+  const double total = std::accumulate(sorted.begin(), sorted.end(), 0.);
+  const double mean = total / sorted.size();
+  const double budget = 1e6 * blockSize / sampleRate;
+  const double seconds = nRenderFrames / sampleRate;
+  auto percentile = [&sorted](double p) { return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))]; };
+
+  printf("%s: rendered %.3f s (%lli frames, %i in, %i out) at %g Hz in %i blocks of %i\n",
+         PLUG_NAME, seconds, static_cast<long long>(nRenderFrames), nInputs, nOutputs, sampleRate, static_cast<int>(sorted.size()), blockSize);
+  printf("process time %.3f ms, %.1fx real time\n", total / 1000., total > 0. ? seconds * 1e6 / total : 0.);
+  printf("per block (us): mean %.2f, median %.2f, p95 %.2f, p99 %.2f, max %.2f, real time budget %.2f (mean load %.2f%%)\n",
+         mean, percentile(0.5), percentile(0.95), percentile(0.99), sorted.back(), budget, 100. * mean / budget);
+}
+
+int IPlugCLIHost::Run(const Options& options)
+{
+  mIPlug = std::unique_ptr<IPlugCLI>(MakePlug(InstanceInfo()));
+
+  if (options.mListParams)
+  {
+    ListParams();
+    return 0;
+  }
+
+  WDL_String error;
+  AudioFileReader reader;
+  const bool hasInput = options.mInputPath.GetLength() > 0;
+
+  if (hasInput && !reader.Open(options.mInputPath.Get(), options.mRawChannels, options.mSampleRate, error))
+  {
+    fprintf(stderr, "%s\n", error.Get());
+    return 1;
+  }
+
+  const double sampleRate = hasInput ? reader.GetSampleRate() : options.mSampleRate;
+  const int blockSize = options.mBlockSize;
+
+  // connect all of the file's channels, if there is an I/O config for them, and the outputs of that config
+  const int nFileChannels = hasInput ? reader.NChannels() : 0;
+  const int nInputs = std::min(nFileChannels, mIPlug->MaxNChannels(ERoute::kInput));
+  int nOutputs = mIPlug->MaxNChannels(ERoute::kOutput);
+
+  for (int i = 0; i < mIPlug->NIOConfigs(); i++)
+  {
+    const IOConfig* pConfig = mIPlug->GetIOConfig(i);
+
+    if (pConfig->GetTotalNChannels(ERoute::kInput) == nFileChannels && pConfig->GetTotalNChannels(ERoute::kOutput) > 0)
+    {
+      nOutputs = std::min(nOutputs, pConfig->GetTotalNChannels(ERoute::kOutput));
+      break;
+    }
+  }
+
+  if (nInputs < nFileChannels)
+    fprintf(stderr, "%s has %i inputs, only the first %i channels of %s are processed\n", PLUG_NAME, nInputs, nInputs, options.mInputPath.Get());
+
+  if (nOutputs < 1)
+  {
+    fprintf(stderr, "%s has no outputs\n", PLUG_NAME);
+    return 1;
+  }
+
+  mIPlug->CLIPrepare(sampleRate, blockSize, nInputs, nOutputs, options.mTempo);
+
+  if (options.mPresetPath.GetLength() && !LoadPreset(options.mPresetPath.Get(), error))
+  {
+    fprintf(stderr, "%s\n", error.Get());
+    return 1;
+  }
+
+  if (options.mAutomationPath.GetLength() && !LoadAutomation(options.mAutomationPath.Get(), sampleRate, error))
+  {
+    fprintf(stderr, "%s\n", error.Get());
+    return 1;
+  }
+
+  AudioFileWriter writer;
+
+  if (!writer.Open(options.mOutputPath.Get(), nOutputs, sampleRate, options.mBitDepth, error))
+  {
+    fprintf(stderr, "%s\n", error.Get());
+    return 1;
+  }
+
+  // the latency is only known after the preset is loaded, the first latency frames are rendered but not written
+  const int64_t latency = options.mCompensateLatency ? mIPlug->GetLatency() : 0;
+  const int64_t nFrames = (hasInput ? reader.NFrames() : std::llround(options.mLength * sampleRate)) + std::llround(options.mTail * sampleRate);
+  const int64_t nRenderFrames = nFrames + latency;
+
+  std::vector<sample> inputData(static_cast<size_t>(std::max(nFileChannels, 1)) * blockSize, 0.);
+  std::vector<sample> outputData(static_cast<size_t>(nOutputs) * blockSize, 0.);
+  std::vector<sample*> inputs, outputs;
+
+  for (int c = 0; c < std::max(nFileChannels, 1); c++)
+    inputs.push_back(inputData.data() + c * blockSize);
+
+  for (int c = 0; c < nOutputs; c++)
+    outputs.push_back(outputData.data() + c * blockSize);
+
+  std::vector<IParamChange> changes;
+  changes.reserve(mAutomation.size());
+  std::vector<double> blockTimes;
+  blockTimes.reserve(static_cast<size_t>(nRenderFrames / blockSize + 1));
+  size_t nextPoint = 0;
+
+  for (int64_t pos = 0; pos < nRenderFrames; pos += blockSize)
+  {
+    const int n = static_cast<int>(std::min<int64_t>(blockSize, nRenderFrames - pos));
+
+    if (hasInput)
+      reader.Read(inputs.data(), n);
+
+    changes.clear();
+
+    for (; nextPoint < mAutomation.size() && mAutomation[nextPoint].mFrame < pos + n; nextPoint++)
+    {
+      const AutomationPoint& point = mAutomation[nextPoint];
+      const IParam* pParam = mIPlug->GetParam(point.mParamIdx);
+      changes.push_back(IParamChange(point.mParamIdx, static_cast<int>(std::max<int64_t>(0, point.mFrame - pos)), pParam->ToNormalized(point.mValue), point.mValue));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    mIPlug->CLIProcess(inputs.data(), outputs.data(), n, changes.data(), static_cast<int>(changes.size()), static_cast<double>(pos));
+    const auto end = std::chrono::steady_clock::now();
+
+    blockTimes.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+    const int skip = static_cast<int>(Clip<int64_t>(latency - pos, 0, n));
+
+    if (skip < n && !writer.Write(outputs.data(), skip, n - skip))
+      break;
+  }
+
+  if (!writer.Close())
+  {
+    fprintf(stderr, "Couldn't write %s\n", options.mOutputPath.Get());
+    return 1;
+  }
+
+  ReportTiming(options, nInputs, nOutputs, nRenderFrames, blockTimes);
+
+  return 0;
+}
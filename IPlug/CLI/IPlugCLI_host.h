@@ -0,0 +1,201 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+
+ IPlug plug-in -> offline command-line render host
+
+ Notes:
+
+ The plug-in class is linked into the executable, as for the standalone app. Audio is streamed from the input file through
+ ProcessBlock() a block at a time, with GetRenderingOffline() returning true, as fast as the plug-in can process it.
+ The time taken by each block is measured and summarised when the render is done. Run the executable with --help for the options.
+
+ Files ending in .raw are headerless interleaved 32 bit floats in the machine's byte order, anything else is read and written as WAV.
+ WAV input can be 8, 16, 24 or 32 bit integer PCM, or 32 or 64 bit floating point.
+
+ An automation file has one point per line: the time in seconds, the parameter's index or name, and its non-normalized value.
+ Names containing spaces must be quoted, and lines starting with # are ignored, e.g.
+
+   # seconds  parameter  value
+   0.0        Gain       100
+   1.5        "Gain"     25
+   2.0        0          50
+
+ Points are applied at the start of the block that contains them, with their offset in that block, like host automation.
+ If the plug-in calls SetSampleAccurateAutomation(), every point is also available to ProcessBlock() via GetParamChanges().
+
+ A preset can be either a VST2 format .fxp file, as written by IPluginBase::SavePresetAsFXP(), or a raw state chunk,
+ as written by IPluginBase::SerializeState().
+
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "wdlstring.h"
+
+#include "IPlugPlatform.h"
+#include "IPlugConstants.h"
+#include "IPlugStructs.h"
+
+#include "IPlugCLI.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A class that renders audio files through an IPlug plug-in offline, and reports the time taken by each block */
+class IPlugCLIHost
+{
+public:
+
+  /** The settings for a render, parsed from the command line */
+  struct Options
+  {
+    WDL_String mInputPath;
+    WDL_String mOutputPath;
+    WDL_String mPresetPath;
+    WDL_String mAutomationPath;
+    WDL_String mTimingPath;
+    double mSampleRate = DEFAULT_SAMPLE_RATE; // used for raw input, or if there is no input
+    int mRawChannels = 2;
+    int mBlockSize = DEFAULT_BLOCK_SIZE;
+    int mBitDepth = 32; // 16 or 24 bit PCM, or 32 bit floating point
+    double mLength = 0.; // seconds to render if there is no input
+    double mTail = 0.; // seconds to render after the input ends
+    double mTempo = DEFAULT_TEMPO;
+    bool mCompensateLatency = true;
+    bool mListParams = false;
+    bool mQuiet = false;
+    bool mHelp = false;
+  };
+
+  /** Reads a WAV or raw audio file a block at a time */
+  class AudioFileReader
+  {
+  public:
+    AudioFileReader() = default;
+    AudioFileReader(const AudioFileReader&) = delete;
+    AudioFileReader& operator=(const AudioFileReader&) = delete;
+    ~AudioFileReader();
+
+    /** Open a file for reading
+     * @param path The file to read. Files ending in .raw are read as interleaved 32 bit floats
+     * @param rawChannels The number of channels in a raw file
+     * @param rawSampleRate The sample rate of a raw file
+     * @param error Set to a description of the problem on failure
+     * @return \c true on success */
+    bool Open(const char* path, int rawChannels, double rawSampleRate, WDL_String& error);
+
+    /** Read the next frames, zero filling any that are beyond the end of the file
+     * @param ppData NChannels() buffers of at least nFrames samples
+     * @param nFrames The number of frames to read
+     * @return The number of frames that were read from the file */
+    int Read(sample** ppData, int nFrames);
+
+    int NChannels() const { return mNChannels; }
+    double GetSampleRate() const { return mSampleRate; }
+    int64_t NFrames() const { return mNFrames; }
+
+  private:
+    FILE* mFile = nullptr;
+    int mNChannels = 0;
+    double mSampleRate = 0.;
+    int64_t mNFrames = 0;
+    int64_t mNFramesRead = 0;
+    int mBytesPerSample = 4;
+    bool mFloat = true;
+    std::vector<uint8_t> mBuffer;
+  };
+
+  /** Writes a WAV or raw audio file a block at a time */
+  class AudioFileWriter
+  {
+  public:
+    AudioFileWriter() = default;
+    AudioFileWriter(const AudioFileWriter&) = delete;
+    AudioFileWriter& operator=(const AudioFileWriter&) = delete;
+    ~AudioFileWriter() { Close(); }
+
+    /** Open a file for writing, replacing any existing file
+     * @param path The file to write. Files ending in .raw are written as interleaved 32 bit floats
+     * @param nChannels The number of channels
+     * @param sampleRate The sample rate
+     * @param bitDepth 16 or 24 for integer PCM, 32 for floating point. Ignored for raw files
+     * @param error Set to a description of the problem on failure
+     * @return \c true on success */
+    bool Open(const char* path, int nChannels, double sampleRate, int bitDepth, WDL_String& error);
+
+    /** Append frames to the file. Integer PCM is clipped to full scale
+     * @param ppData NChannels() buffers
+     * @param offset The first frame to write from each buffer
+     * @param nFrames The number of frames to write
+     * @return \c true on success */
+    bool Write(sample** ppData, int offset, int nFrames);
+
+    /** Complete the WAV header and close the file
+     * @return \c true on success */
+    bool Close();
+
+  private:
+    void WriteHeader();
+
+    FILE* mFile = nullptr;
+    bool mRaw = false;
+    bool mFailed = false;
+    int mNChannels = 0;
+    int mSampleRate = 0;
+    int mBitDepth = 32;
+    int64_t mNFramesWritten = 0;
+    std::vector<uint8_t> mBuffer;
+  };
+
+  /** Parse the command line
+   * @param argc The number of arguments, including the program name
+   * @param argv The arguments
+   * @param options The options to fill in
+   * @param error Set to a description of the problem on failure
+   * @return \c true on success */
+  static bool ParseArgs(int argc, char* argv[], Options& options, WDL_String& error);
+
+  /** Print the command line usage
+   * @param pFile Where to print it
+   * @param programName The name of the executable */
+  static void PrintUsage(FILE* pFile, const char* programName);
+
+  /** Create the plug-in and run the render described by options
+   * @return The process exit code, 0 on success */
+  int Run(const Options& options);
+
+private:
+  /** An automation point, at a frame from the start of the render */
+  struct AutomationPoint
+  {
+    int64_t mFrame;
+    int mParamIdx;
+    double mValue;
+  };
+
+  bool LoadPreset(const char* path, WDL_String& error);
+  bool LoadAutomation(const char* path, double sampleRate, WDL_String& error);
+  int FindParam(const char* nameOrIdx) const;
+  void ListParams() const;
+  void ReportTiming(const Options& options, int nInputs, int nOutputs, int64_t nRenderFrames, const std::vector<double>& blockTimes) const;
+
+  std::unique_ptr<IPlugCLI> mIPlug;
+  std::vector<AutomationPoint> mAutomation; // sorted by frame, points at the same frame keep the order of the file
+};
+
+END_IPLUG_NAMESPACE
@@ -0,0 +1,37 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#include <cstdio>
+
+#include "IPlugCLI_host.h"
+
+using namespace iplug;
+
+int main(int argc, char* argv[])
+{
+  IPlugCLIHost::Options options;
+  WDL_String error;
+
+  if (!IPlugCLIHost::ParseArgs(argc, argv, options, error))
+  {
+    fprintf(stderr, "%s\n\n", error.Get());
+    IPlugCLIHost::PrintUsage(stderr, argv[0]);
+    return 1;
+  }
+
+  if (options.mHelp)
+  {
+    IPlugCLIHost::PrintUsage(stdout, argv[0]);
+    return 0;
+  }
+
+  IPlugCLIHost host;
+  return host.Run(options);
+}
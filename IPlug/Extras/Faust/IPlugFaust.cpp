@@ -45,7 +45,7 @@ void IPlugFaust::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
 
     if (mOverSampler)
       mOverSampler->ProcessBlock(inputs, outputs, nFrames, 2, 2 /* TODO: flexible channel count */,
-        [&](sample** inputs, sample** outputs, int nFrames) //TODO:: badness capture = allocated
+        [this](sample** inputs, sample** outputs, int nFrames)
         {
           mDSP->compute(nFrames, inputs, outputs);
         });
@@ -89,6 +89,12 @@ public:
       mOverSampler->SetOverSampling(OverSampler<sample>::RateToFactor(rate));
   }
 
+  /** @return The latency added by oversampling, in samples, for the plug-in to report with SetLatency() */
+  int GetOverSamplingLatency() const
+  {
+    return mOverSampler ? mOverSampler->GetLatency() : 0;
+  }
+
   // Unique methods
   void SetSampleRate(double sampleRate)
   {
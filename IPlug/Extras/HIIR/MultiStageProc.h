@@ -0,0 +1,82 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/*
+MultiStageProc.h
+
+The all-pass stages of StageProcFPU, applied to SIMD lanes (see
+SIMDLanes.h). The recursion unrolls the stages at compile time, so that the
+filter state stays in registers.
+
+Template parameters:
+  - REMAINING: Number of remaining coefficients to process, >= 0
+  - L: Lanes type
+*/
+
+#pragma once
+
+namespace hiir
+{
+
+template <int REMAINING, class L>
+class StageProcMulti
+{
+public:
+  typedef typename L::V V;
+
+  static inline void process_sample_pos (const int nbr_coefs, V &spl_0, V &spl_1, const V coef [], V x [], V y [])
+  {
+    const int cnt = nbr_coefs - REMAINING;
+
+    const V temp_0 = L::add (L::mul (L::sub (spl_0, y [cnt + 0]), coef [cnt + 0]), x [cnt + 0]);
+    const V temp_1 = L::add (L::mul (L::sub (spl_1, y [cnt + 1]), coef [cnt + 1]), x [cnt + 1]);
+
+    x [cnt + 0] = spl_0;
+    x [cnt + 1] = spl_1;
+
+    y [cnt + 0] = temp_0;
+    y [cnt + 1] = temp_1;
+
+    spl_0 = temp_0;
+    spl_1 = temp_1;
+
+    StageProcMulti <REMAINING - 2, L>::process_sample_pos (nbr_coefs, spl_0, spl_1, coef, x, y);
+  }
+};
+
+template <class L>
+class StageProcMulti <1, L>
+{
+public:
+  typedef typename L::V V;
+
+  static inline void process_sample_pos (const int nbr_coefs, V &spl_0, V &/*spl_1*/, const V coef [], V x [], V y [])
+  {
+    const int last = nbr_coefs - 1;
+    const V temp = L::add (L::mul (L::sub (spl_0, y [last]), coef [last]), x [last]);
+    x [last] = spl_0;
+    y [last] = temp;
+    spl_0 = temp;
+  }
+};
+
+template <class L>
+class StageProcMulti <0, L>
+{
+public:
+  typedef typename L::V V;
+
+  static inline void process_sample_pos (const int /*nbr_coefs*/, V &/*spl_0*/, V &/*spl_1*/, const V /*coef*/ [], V /*x*/ [], V /*y*/ [])
+  {
+    // Nothing (stops recursion)
+  }
+};
+
+} // namespace hiir
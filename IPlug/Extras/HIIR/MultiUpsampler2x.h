@@ -0,0 +1,246 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/*
+MultiUpsampler2x.h
+
+Upsamples by a factor 2 several channels at once, processing one channel per
+SIMD lane (see SIMDLanes.h). The arithmetic in each lane is the same as in
+Upsampler2xFPU, so the output is bit-exact with one Upsampler2xFPU per
+channel.
+
+Channels are processed in groups as wide as the target allows (e.g. 8 float
+channels with AVX). Leftover channels go to narrower groups, down to the FPU
+for the last one, unless they fill more than half of a group.
+
+Template parameters:
+- NC: number of coefficients, > 0
+- T: float or double
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <cassert>
+
+#include "SIMDLanes.h"
+#include "MultiStageProc.h"
+
+namespace hiir
+{
+
+template <int NC, typename T>
+class Upsampler2xMulti
+{
+public:
+
+  enum { NBR_COEFS = NC };
+
+  /*
+  Name: ctor
+  Input parameters:
+    - nbr_chn: Maximum number of channels to process, > 0. All memory is
+    allocated here.
+  */
+  explicit Upsampler2xMulti (int nbr_chn);
+
+  /*
+  Name: set_coefs
+  Description:
+    Sets filter coefficients, for all channels. Generate them with the
+    PolyphaseIir2Designer class.
+  */
+  void set_coefs (const double coef_arr [NBR_COEFS]);
+
+  /*
+  Name: process_block
+  Description:
+    Upsamples (x2) a block of samples for channels 0 to nbr_chn - 1. The
+    state of the other channels is left untouched.
+  Input parameters:
+    - in_ptr_arr: Input arrays, one per channel, containing nbr_spl samples.
+    - nbr_chn: Number of channels to process, <= the number passed to the
+    constructor
+    - nbr_spl: Number of input samples to process, > 0
+  Output parameters:
+    - out_ptr_arr: Output arrays, one per channel, capacity: nbr_spl * 2
+    samples. They must not overlap the input arrays.
+  */
+  void process_block (T * const out_ptr_arr [], const T * const in_ptr_arr [], int nbr_chn, long nbr_spl);
+
+  /*
+  Name: process_block
+  Description:
+    Upsamples (x2) a block of samples for a single channel.
+  */
+  void process_block (int chn, T out_ptr [], const T in_ptr [], long nbr_spl);
+
+  /*
+  Name: process_sample
+  Description:
+    Upsamples (x2) one sample of a single channel.
+  */
+  void process_sample (int chn, T &out_0, T &out_1, T input);
+
+  /*
+  Name: clear_buffers
+  Description:
+    Clears filter memory for all channels, as if they processed silence since
+    an infinite amount of time.
+  */
+  void clear_buffers ();
+
+  int get_nbr_chn () const { return _nbr_chn; }
+
+private:
+  template <class L>
+  void process_groups (T * const out_ptr_arr [], const T * const in_ptr_arr [], int chn, int nbr_chn, long nbr_spl);
+
+  // ptr_arr [0] is the buffer of channel chn
+  template <class L>
+  void process_lanes (T * const out_ptr_arr [], const T * const in_ptr_arr [], int chn, int nbr_lanes, long nbr_spl);
+
+  std::array<T, NBR_COEFS> _coef;
+  std::vector<T> _x; // [coef * _nbr_chn + chn]
+  std::vector<T> _y;
+  int _nbr_chn;
+
+private:
+  Upsampler2xMulti (const Upsampler2xMulti &other);
+  Upsampler2xMulti& operator = (const Upsampler2xMulti &other);
+
+};  // class Upsampler2xMulti
+
+template <int NC, typename T>
+Upsampler2xMulti <NC, T>::Upsampler2xMulti (int nbr_chn)
+: _coef ()
+, _x (NBR_COEFS * nbr_chn)
+, _y (NBR_COEFS * nbr_chn)
+, _nbr_chn (nbr_chn)
+{
+  assert (nbr_chn > 0);
+
+  for (int i = 0; i < NBR_COEFS; ++i)
+  {
+    _coef [i] = 0;
+  }
+  clear_buffers ();
+}
+
+template <int NC, typename T>
+void Upsampler2xMulti <NC, T>::set_coefs (const double coef_arr [NBR_COEFS])
+{
+  assert (coef_arr != 0);
+
+  for (int i = 0; i < NBR_COEFS; ++i)
+  {
+    _coef [i] = static_cast <T> (coef_arr [i]);
+  }
+}
+
+template <int NC, typename T>
+void Upsampler2xMulti <NC, T>::process_block (T * const out_ptr_arr [], const T * const in_ptr_arr [], int nbr_chn, long nbr_spl)
+{
+  assert (nbr_chn <= _nbr_chn);
+  assert (nbr_spl > 0);
+
+  process_groups <LanesWide <T>> (out_ptr_arr, in_ptr_arr, 0, nbr_chn, nbr_spl);
+}
+
+template <int NC, typename T>
+void Upsampler2xMulti <NC, T>::process_block (int chn, T out_ptr [], const T in_ptr [], long nbr_spl)
+{
+  assert (chn >= 0 && chn < _nbr_chn);
+  assert (nbr_spl > 0);
+
+  T * const out_ptr_arr [1] = { out_ptr };
+  const T * const in_ptr_arr [1] = { in_ptr };
+  process_lanes <LanesFPU <T>> (out_ptr_arr, in_ptr_arr, chn, 1, nbr_spl);
+}
+
+template <int NC, typename T>
+void Upsampler2xMulti <NC, T>::process_sample (int chn, T &out_0, T &out_1, T input)
+{
+  T out [2];
+  process_block (chn, out, &input, 1);
+  out_0 = out [0];
+  out_1 = out [1];
+}
+
+template <int NC, typename T>
+void Upsampler2xMulti <NC, T>::clear_buffers ()
+{
+  std::fill (_x.begin (), _x.end (), T (0));
+  std::fill (_y.begin (), _y.end (), T (0));
+}
+
+template <int NC, typename T>
+template <class L>
+void Upsampler2xMulti <NC, T>::process_groups (T * const out_ptr_arr [], const T * const in_ptr_arr [], int chn, int nbr_chn, long nbr_spl)
+{
+  while (nbr_chn - chn >= L::NBR_LANES)
+  {
+    process_lanes <L> (out_ptr_arr + chn, in_ptr_arr + chn, chn, L::NBR_LANES, nbr_spl);
+    chn += L::NBR_LANES;
+  }
+
+  const int remaining = nbr_chn - chn;
+
+  if (remaining == 0)
+    return;
+
+  if (remaining * 2 > L::NBR_LANES)
+    process_lanes <L> (out_ptr_arr + chn, in_ptr_arr + chn, chn, remaining, nbr_spl);
+  else
+    process_groups <typename L::Half> (out_ptr_arr, in_ptr_arr, chn, nbr_chn, nbr_spl);
+}
+
+template <int NC, typename T>
+template <class L>
+void Upsampler2xMulti <NC, T>::process_lanes (T * const out_ptr_arr [], const T * const in_ptr_arr [], int chn, int nbr_lanes, long nbr_spl)
+{
+  typedef typename L::V V;
+
+  V coef [NBR_COEFS];
+  V x [NBR_COEFS];
+  V y [NBR_COEFS];
+
+  for (int i = 0; i < NBR_COEFS; ++i)
+  {
+    coef [i] = L::set1 (_coef [i]);
+    x [i] = L::load (&_x [i * _nbr_chn + chn], nbr_lanes);
+    y [i] = L::load (&_y [i * _nbr_chn + chn], nbr_lanes);
+  }
+
+  long pos = 0;
+  do
+  {
+    V spl [2];
+    spl [0] = L::gather (in_ptr_arr, 0, pos, nbr_lanes);
+    spl [1] = spl [0];
+
+    StageProcMulti <NBR_COEFS, L>::process_sample_pos (NBR_COEFS, spl [0], spl [1], coef, x, y);
+
+    L::scatter (out_ptr_arr, 0, pos * 2, spl [0], nbr_lanes);
+    L::scatter (out_ptr_arr, 0, pos * 2 + 1, spl [1], nbr_lanes);
+    ++ pos;
+  }
+  while (pos < nbr_spl);
+
+  for (int i = 0; i < NBR_COEFS; ++i)
+  {
+    L::store (&_x [i * _nbr_chn + chn], x [i], nbr_lanes);
+    L::store (&_y [i * _nbr_chn + chn], y [i], nbr_lanes);
+  }
+}
+
+} // namespace hiir
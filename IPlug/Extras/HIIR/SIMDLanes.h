@@ -0,0 +1,303 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/*
+SIMDLanes.h
+
+Thin wrappers around the SIMD instruction sets, used by the multi-channel
+resamplers to process one channel per vector lane.
+
+Each Lanes type provides:
+- V: the vector type, holding N samples of type T
+- Half: the Lanes type with half as many lanes (LanesFPU <T> has one lane,
+  and is its own Half)
+- set1, add, sub, mul: element-wise operations. There are no fused
+  multiply-adds, so each lane rounds exactly as the FPU code does.
+- load, store: load or store the first n lanes from/to a contiguous array.
+  The other lanes are loaded as zero, and are not stored.
+- gather, scatter: load or store the first n lanes from/to sample pos of n
+  channel buffers starting at ptr_arr [chn].
+
+The widest Lanes type available for the target is LanesWide <T>: AVX, SSE2,
+NEON, or the FPU as a fallback.
+*/
+
+#pragma once
+
+#if defined (__AVX__)
+  #include <immintrin.h>
+  #define HIIR_USE_AVX
+  #define HIIR_USE_SSE2
+#elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define HIIR_USE_SSE2
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  #include <arm_neon.h>
+  #define HIIR_USE_NEON
+#endif
+
+namespace hiir
+{
+
+template <typename T, int N, typename Lanes>
+class LanesBase
+{
+public:
+  enum { NBR_LANES = N };
+
+  template <typename V>
+  static inline V load (const T ptr [], int n)
+  {
+    if (n == N)
+      return Lanes::loadu (ptr);
+
+    T tmp [N] = {};
+    for (int i = 0; i < n; ++i)
+    {
+      tmp [i] = ptr [i];
+    }
+    return Lanes::loadu (tmp);
+  }
+
+  template <typename V>
+  static inline void store (T ptr [], V v, int n)
+  {
+    if (n == N)
+    {
+      Lanes::storeu (ptr, v);
+      return;
+    }
+
+    T tmp [N];
+    Lanes::storeu (tmp, v);
+    for (int i = 0; i < n; ++i)
+    {
+      ptr [i] = tmp [i];
+    }
+  }
+
+  template <typename V>
+  static inline V gather (const T * const ptr_arr [], int chn, long pos, int n)
+  {
+    T tmp [N] = {};
+    for (int i = 0; i < n; ++i)
+    {
+      tmp [i] = ptr_arr [chn + i] [pos];
+    }
+    return Lanes::loadu (tmp);
+  }
+
+  template <typename V>
+  static inline void scatter (T * const ptr_arr [], int chn, long pos, V v, int n)
+  {
+    T tmp [N];
+    Lanes::storeu (tmp, v);
+    for (int i = 0; i < n; ++i)
+    {
+      ptr_arr [chn + i] [pos] = tmp [i];
+    }
+  }
+};
+
+/* One lane, plain FPU arithmetic */
+template <typename T>
+class LanesFPU
+{
+public:
+  typedef T V;
+  typedef LanesFPU <T> Half;
+  enum { NBR_LANES = 1 };
+
+  static inline V set1 (T a) { return a; }
+  static inline V add (V a, V b) { return a + b; }
+  static inline V sub (V a, V b) { return a - b; }
+  static inline V mul (V a, V b) { return a * b; }
+  static inline V load (const T ptr [], int /*n*/) { return ptr [0]; }
+  static inline void store (T ptr [], V v, int /*n*/) { ptr [0] = v; }
+  static inline V gather (const T * const ptr_arr [], int chn, long pos, int /*n*/) { return ptr_arr [chn] [pos]; }
+  static inline void scatter (T * const ptr_arr [], int chn, long pos, V v, int /*n*/) { ptr_arr [chn] [pos] = v; }
+};
+
+#if defined (HIIR_USE_SSE2)
+
+class LanesSSE2Float : public LanesBase <float, 4, LanesSSE2Float>
+{
+public:
+  typedef __m128 V;
+  typedef LanesFPU <float> Half;
+
+  static inline V set1 (float a) { return _mm_set1_ps (a); }
+  static inline V add (V a, V b) { return _mm_add_ps (a, b); }
+  static inline V sub (V a, V b) { return _mm_sub_ps (a, b); }
+  static inline V mul (V a, V b) { return _mm_mul_ps (a, b); }
+  static inline V loadu (const float ptr []) { return _mm_loadu_ps (ptr); }
+  static inline void storeu (float ptr [], V v) { _mm_storeu_ps (ptr, v); }
+  static inline V load (const float ptr [], int n) { return LanesBase::load <V> (ptr, n); }
+  static inline void store (float ptr [], V v, int n) { LanesBase::store (ptr, v, n); }
+  static inline V gather (const float * const ptr_arr [], int chn, long pos, int n)
+  {
+    if (n == 4)
+      return _mm_setr_ps (ptr_arr [chn] [pos], ptr_arr [chn + 1] [pos], ptr_arr [chn + 2] [pos], ptr_arr [chn + 3] [pos]);
+    return LanesBase::gather <V> (ptr_arr, chn, pos, n);
+  }
+  static inline void scatter (float * const ptr_arr [], int chn, long pos, V v, int n) { LanesBase::scatter (ptr_arr, chn, pos, v, n); }
+};
+
+class LanesSSE2Double : public LanesBase <double, 2, LanesSSE2Double>
+{
+public:
+  typedef __m128d V;
+  typedef LanesFPU <double> Half;
+
+  static inline V set1 (double a) { return _mm_set1_pd (a); }
+  static inline V add (V a, V b) { return _mm_add_pd (a, b); }
+  static inline V sub (V a, V b) { return _mm_sub_pd (a, b); }
+  static inline V mul (V a, V b) { return _mm_mul_pd (a, b); }
+  static inline V loadu (const double ptr []) { return _mm_loadu_pd (ptr); }
+  static inline void storeu (double ptr [], V v) { _mm_storeu_pd (ptr, v); }
+  static inline V load (const double ptr [], int n) { return LanesBase::load <V> (ptr, n); }
+  static inline void store (double ptr [], V v, int n) { LanesBase::store (ptr, v, n); }
+  static inline V gather (const double * const ptr_arr [], int chn, long pos, int n)
+  {
+    if (n == 2)
+      return _mm_setr_pd (ptr_arr [chn] [pos], ptr_arr [chn + 1] [pos]);
+    return LanesBase::gather <V> (ptr_arr, chn, pos, n);
+  }
+  static inline void scatter (double * const ptr_arr [], int chn, long pos, V v, int n)
+  {
+    _mm_storel_pd (&ptr_arr [chn] [pos], v);
+    if (n == 2)
+      _mm_storeh_pd (&ptr_arr [chn + 1] [pos], v);
+  }
+};
+
+#endif // HIIR_USE_SSE2
+
+#if defined (HIIR_USE_AVX)
+
+class LanesAVXFloat : public LanesBase <float, 8, LanesAVXFloat>
+{
+public:
+  typedef __m256 V;
+  typedef LanesSSE2Float Half;
+
+  static inline V set1 (float a) { return _mm256_set1_ps (a); }
+  static inline V add (V a, V b) { return _mm256_add_ps (a, b); }
+  static inline V sub (V a, V b) { return _mm256_sub_ps (a, b); }
+  static inline V mul (V a, V b) { return _mm256_mul_ps (a, b); }
+  static inline V loadu (const float ptr []) { return _mm256_loadu_ps (ptr); }
+  static inline void storeu (float ptr [], V v) { _mm256_storeu_ps (ptr, v); }
+  static inline V load (const float ptr [], int n) { return LanesBase::load <V> (ptr, n); }
+  static inline void store (float ptr [], V v, int n) { LanesBase::store (ptr, v, n); }
+  static inline V gather (const float * const ptr_arr [], int chn, long pos, int n)
+  {
+    if (n == 8)
+    {
+      return _mm256_setr_ps (ptr_arr [chn] [pos], ptr_arr [chn + 1] [pos], ptr_arr [chn + 2] [pos], ptr_arr [chn + 3] [pos],
+                             ptr_arr [chn + 4] [pos], ptr_arr [chn + 5] [pos], ptr_arr [chn + 6] [pos], ptr_arr [chn + 7] [pos]);
+    }
+    return LanesBase::gather <V> (ptr_arr, chn, pos, n);
+  }
+  static inline void scatter (float * const ptr_arr [], int chn, long pos, V v, int n) { LanesBase::scatter (ptr_arr, chn, pos, v, n); }
+};
+
+class LanesAVXDouble : public LanesBase <double, 4, LanesAVXDouble>
+{
+public:
+  typedef __m256d V;
+  typedef LanesSSE2Double Half;
+
+  static inline V set1 (double a) { return _mm256_set1_pd (a); }
+  static inline V add (V a, V b) { return _mm256_add_pd (a, b); }
+  static inline V sub (V a, V b) { return _mm256_sub_pd (a, b); }
+  static inline V mul (V a, V b) { return _mm256_mul_pd (a, b); }
+  static inline V loadu (const double ptr []) { return _mm256_loadu_pd (ptr); }
+  static inline void storeu (double ptr [], V v) { _mm256_storeu_pd (ptr, v); }
+  static inline V load (const double ptr [], int n) { return LanesBase::load <V> (ptr, n); }
+  static inline void store (double ptr [], V v, int n) { LanesBase::store (ptr, v, n); }
+  static inline V gather (const double * const ptr_arr [], int chn, long pos, int n)
+  {
+    if (n == 4)
+      return _mm256_setr_pd (ptr_arr [chn] [pos], ptr_arr [chn + 1] [pos], ptr_arr [chn + 2] [pos], ptr_arr [chn + 3] [pos]);
+    return LanesBase::gather <V> (ptr_arr, chn, pos, n);
+  }
+  static inline void scatter (double * const ptr_arr [], int chn, long pos, V v, int n) { LanesBase::scatter (ptr_arr, chn, pos, v, n); }
+};
+
+#endif // HIIR_USE_AVX
+
+#if defined (HIIR_USE_NEON)
+
+class LanesNEONFloat : public LanesBase <float, 4, LanesNEONFloat>
+{
+public:
+  typedef float32x4_t V;
+  typedef LanesFPU <float> Half;
+
+  static inline V set1 (float a) { return vdupq_n_f32 (a); }
+  static inline V add (V a, V b) { return vaddq_f32 (a, b); }
+  static inline V sub (V a, V b) { return vsubq_f32 (a, b); }
+  static inline V mul (V a, V b) { return vmulq_f32 (a, b); }
+  static inline V loadu (const float ptr []) { return vld1q_f32 (ptr); }
+  static inline void storeu (float ptr [], V v) { vst1q_f32 (ptr, v); }
+  static inline V load (const float ptr [], int n) { return LanesBase::load <V> (ptr, n); }
+  static inline void store (float ptr [], V v, int n) { LanesBase::store (ptr, v, n); }
+  static inline V gather (const float * const ptr_arr [], int chn, long pos, int n) { return LanesBase::gather <V> (ptr_arr, chn, pos, n); }
+  static inline void scatter (float * const ptr_arr [], int chn, long pos, V v, int n) { LanesBase::scatter (ptr_arr, chn, pos, v, n); }
+};
+
+#if defined (__aarch64__) || defined (_M_ARM64)
+
+class LanesNEONDouble : public LanesBase <double, 2, LanesNEONDouble>
+{
+public:
+  typedef float64x2_t V;
+  typedef LanesFPU <double> Half;
+
+  static inline V set1 (double a) { return vdupq_n_f64 (a); }
+  static inline V add (V a, V b) { return vaddq_f64 (a, b); }
+  static inline V sub (V a, V b) { return vsubq_f64 (a, b); }
+  static inline V mul (V a, V b) { return vmulq_f64 (a, b); }
+  static inline V loadu (const double ptr []) { return vld1q_f64 (ptr); }
+  static inline void storeu (double ptr [], V v) { vst1q_f64 (ptr, v); }
+  static inline V load (const double ptr [], int n) { return LanesBase::load <V> (ptr, n); }
+  static inline void store (double ptr [], V v, int n) { LanesBase::store (ptr, v, n); }
+  static inline V gather (const double * const ptr_arr [], int chn, long pos, int n) { return LanesBase::gather <V> (ptr_arr, chn, pos, n); }
+  static inline void scatter (double * const ptr_arr [], int chn, long pos, V v, int n) { LanesBase::scatter (ptr_arr, chn, pos, v, n); }
+};
+
+#endif // aarch64
+
+#endif // HIIR_USE_NEON
+
+/* The widest lanes available for T on this target */
+template <typename T>
+struct LanesWideSelect
+{
+  typedef LanesFPU <T> Type;
+};
+
+#if defined (HIIR_USE_AVX)
+template <> struct LanesWideSelect <float> { typedef LanesAVXFloat Type; };
+template <> struct LanesWideSelect <double> { typedef LanesAVXDouble Type; };
+#elif defined (HIIR_USE_SSE2)
+template <> struct LanesWideSelect <float> { typedef LanesSSE2Float Type; };
+template <> struct LanesWideSelect <double> { typedef LanesSSE2Double Type; };
+#elif defined (HIIR_USE_NEON)
+template <> struct LanesWideSelect <float> { typedef LanesNEONFloat Type; };
+#if defined (__aarch64__) || defined (_M_ARM64)
+template <> struct LanesWideSelect <double> { typedef LanesNEONDouble Type; };
+#endif
+#endif
+
+template <typename T>
+using LanesWide = typename LanesWideSelect <T>::Type;
+
+} // namespace hiir
@@ -15,8 +15,8 @@
 #include <functional>
 #include <cmath>
 
-#include "HIIR/FPUUpsampler2x.h"
-#include "HIIR/FPUDownsampler2x.h"
+#include "HIIR/MultiUpsampler2x.h"
+#include "HIIR/MultiDownsampler2x.h"
 
 #include "heapbuf.h"
 #include "ptrlist.h"
@@ -47,6 +47,14 @@ public:
   : mBlockProcessing(blockProcessing)
   , mNInChannels(nInChannels)
   , mNOutChannels(nOutChannels)
+  , mUpsampler2x(nInChannels)
+  , mUpsampler4x(nInChannels)
+  , mUpsampler8x(nInChannels)
+  , mUpsampler16x(nInChannels)
+  , mDownsampler2x(nOutChannels)
+  , mDownsampler4x(nOutChannels)
+  , mDownsampler8x(nOutChannels)
+  , mDownsampler16x(nOutChannels)
   {
     
     static constexpr double coeffs2x[12] = { 0.036681502163648017, 0.13654762463195794, 0.27463175937945444, 0.42313861743656711, 0.56109869787919531, 0.67754004997416184, 0.76974183386322703, 0.83988962484963892, 0.89226081800387902, 0.9315419599631839, 0.96209454837808417, 0.98781637073289585 };
@@ -54,34 +62,29 @@ public:
     static constexpr double coeffs8x[3] = {0.055748680811302048, 0.24305119574153072, 0.64669913119268196 };
     static constexpr double coeffs16x[2] = {0.10717745346023573, 0.53091435354504557 };
 
+    mUpsampler2x.set_coefs(coeffs2x);
+    mUpsampler4x.set_coefs(coeffs4x);
+    mUpsampler8x.set_coefs(coeffs8x);
+    mUpsampler16x.set_coefs(coeffs16x);
+
+    mDownsampler2x.set_coefs(coeffs2x);
+    mDownsampler4x.set_coefs(coeffs4x);
+    mDownsampler8x.set_coefs(coeffs8x);
+    mDownsampler16x.set_coefs(coeffs16x);
+
+    mStageDelays[0] = StageGroupDelay(coeffs2x, 12);
+    mStageDelays[1] = StageGroupDelay(coeffs4x, 4);
+    mStageDelays[2] = StageGroupDelay(coeffs8x, 3);
+    mStageDelays[3] = StageGroupDelay(coeffs16x, 2);
+
     for (auto c = 0; c < mNInChannels; c++)
     {
-      mUpsampler2x.Add(new Upsampler2xFPU<12, T>());
-      mUpsampler4x.Add(new Upsampler2xFPU<4, T>());
-      mUpsampler8x.Add(new Upsampler2xFPU<3, T>());
-      mUpsampler16x.Add(new Upsampler2xFPU<2, T>());
-      
-      mUpsampler2x.Get(c)->set_coefs(coeffs2x);
-      mUpsampler4x.Get(c)->set_coefs(coeffs4x);
-      mUpsampler8x.Get(c)->set_coefs(coeffs8x);
-      mUpsampler16x.Get(c)->set_coefs(coeffs16x);
-      
       // ptr location doesn't matter at this stage
       mNextInputPtrs.Add(mUp2x.Get());
     }
     
     for (auto c = 0; c < mNOutChannels; c++)
     {
-      mDownsampler2x.Add(new Downsampler2xFPU<12, T>());
-      mDownsampler4x.Add(new Downsampler2xFPU<4, T>());
-      mDownsampler8x.Add(new Downsampler2xFPU<3, T>());
-      mDownsampler16x.Add(new Downsampler2xFPU<2, T>());
-      
-      mDownsampler2x.Get(c)->set_coefs(coeffs2x);
-      mDownsampler4x.Get(c)->set_coefs(coeffs4x);
-      mDownsampler8x.Get(c)->set_coefs(coeffs8x);
-      mDownsampler16x.Get(c)->set_coefs(coeffs16x);
-      
       // ptr location doesn't matter at this stage
       mNextOutputPtrs.Add(mDown2x.Get());
     }
@@ -91,18 +94,6 @@ public:
     Reset();
   }
   
-  ~OverSampler()
-  {
-    mUpsampler2x.Empty(true);
-    mDownsampler2x.Empty(true);
-    mUpsampler4x.Empty(true);
-    mDownsampler4x.Empty(true);
-    mUpsampler8x.Empty(true);
-    mDownsampler8x.Empty(true);
-    mUpsampler16x.Empty(true);
-    mDownsampler16x.Empty(true);
-  }
-
   OverSampler(const OverSampler&) = delete;
   OverSampler& operator=(const OverSampler&) = delete;
     
@@ -140,13 +131,18 @@ public:
     mDown4BufferPtrs.Empty();
     mDown2BufferPtrs.Empty();
     
+    mUpsampler2x.clear_buffers();
+    mUpsampler4x.clear_buffers();
+    mUpsampler8x.clear_buffers();
+    mUpsampler16x.clear_buffers();
+
+    mDownsampler2x.clear_buffers();
+    mDownsampler4x.clear_buffers();
+    mDownsampler8x.clear_buffers();
+    mDownsampler16x.clear_buffers();
+
     for (auto c = 0; c < mNInChannels; c++)
     {
-      mUpsampler2x.Get(c)->clear_buffers();
-      mUpsampler4x.Get(c)->clear_buffers();
-      mUpsampler8x.Get(c)->clear_buffers();
-      mUpsampler16x.Get(c)->clear_buffers();
-      
       mUp2BufferPtrs.Add(mUp2x.Get() + c * 2 * blockSize);
       mUp4BufferPtrs.Add(mUp4x.Get() + (c * 4 * blockSize));
       mUp8BufferPtrs.Add(mUp8x.Get() + (c * 8 * blockSize));
@@ -155,11 +151,6 @@ public:
     
     for (auto c = 0; c < mNOutChannels; c++)
     {
-      mDownsampler2x.Get(c)->clear_buffers();
-      mDownsampler4x.Get(c)->clear_buffers();
-      mDownsampler8x.Get(c)->clear_buffers();
-      mDownsampler16x.Get(c)->clear_buffers();
-      
       mDown2BufferPtrs.Add(mDown2x.Get() + c * 2 * blockSize);
       mDown4BufferPtrs.Add(mDown4x.Get() + (c * 4 * blockSize));
       mDown8BufferPtrs.Add(mDown8x.Get() + (c * 8 * blockSize));
@@ -173,8 +164,10 @@ public:
    * @param nFrames The block size for this block: number of samples per channel.
    * @param nInChans The number of input channels to process. Must be less or equal to the number of channels passed to the constructor
    * @param nOutChans The number of output channels to process. Must be less or equal to the number of channels passed to the constructor
-   * @param func The function that processes the audio sample at the higher sampling rate. NOTE: std::function can call malloc if you pass in captures */
-  void ProcessBlock(T** inputs, T** outputs, int nFrames, int nInChans, int nOutChans, BlockProcessFunc func)
+   * @param func The function that processes the audio sample at the higher sampling rate, called as func(T** inputs, T** outputs, int nFrames).
+   * Pass a lambda rather than a BlockProcessFunc: it is called directly, so it can be inlined and its captures are never copied to the heap */
+  template <typename BlockFunc>
+  void ProcessBlock(T** inputs, T** outputs, int nFrames, int nInChans, int nOutChans, BlockFunc&& func)
   {
     assert(nInChans <= mNInChannels);
     assert(nOutChans <= mNOutChannels);
@@ -205,19 +198,18 @@ public:
       mPrevRate = mRate;
     }
 
-    for(auto c = 0; c < nInChans; c++) {
-      if (mRate >= 2) {
-        mUpsampler2x.Get(c)->process_block(mUp2BufferPtrs.Get(c), inputs[c], nFrames);
-      }
-      if (mRate >= 4) {
-        mUpsampler4x.Get(c)->process_block(mUp4BufferPtrs.Get(c), mUp2BufferPtrs.Get(c), nFrames * 2);
-      }
-      if (mRate >= 8) {
-        mUpsampler8x.Get(c)->process_block(mUp8BufferPtrs.Get(c), mUp4BufferPtrs.Get(c), nFrames * 4);
-      }
-      if (mRate == 16) {
-        mUpsampler16x.Get(c)->process_block(mUp16BufferPtrs.Get(c), mUp8BufferPtrs.Get(c), nFrames * 8);
-      }
+    // each stage processes all the channels at once, in SIMD lanes
+    if (mRate >= 2) {
+      mUpsampler2x.process_block(mUp2BufferPtrs.GetList(), inputs, nInChans, nFrames);
+    }
+    if (mRate >= 4) {
+      mUpsampler4x.process_block(mUp4BufferPtrs.GetList(), mUp2BufferPtrs.GetList(), nInChans, nFrames * 2);
+    }
+    if (mRate >= 8) {
+      mUpsampler8x.process_block(mUp8BufferPtrs.GetList(), mUp4BufferPtrs.GetList(), nInChans, nFrames * 4);
+    }
+    if (mRate == 16) {
+      mUpsampler16x.process_block(mUp16BufferPtrs.GetList(), mUp8BufferPtrs.GetList(), nInChans, nFrames * 8);
     }
     
     if (mRate == 1) {
@@ -232,82 +224,81 @@ public:
       }
     }
     
-    for(auto c = 0; c < nOutChans; c++) {
-      if (mRate == 16) {
-        mDownsampler16x.Get(c)->process_block(mDown8BufferPtrs.Get(c), mDown16BufferPtrs.Get(c), nFrames * 8);
-      }
-      if (mRate >= 8) {
-        mDownsampler8x.Get(c)->process_block(mDown4BufferPtrs.Get(c), mDown8BufferPtrs.Get(c), nFrames * 4);
-      }
-      if (mRate >= 4) {
-        mDownsampler4x.Get(c)->process_block(mDown2BufferPtrs.Get(c), mDown4BufferPtrs.Get(c), nFrames * 2);
-      }
-      if (mRate >= 2) {
-        mDownsampler2x.Get(c)->process_block(outputs[c], mDown2BufferPtrs.Get(c), nFrames);
-      }
+    if (mRate == 16) {
+      mDownsampler16x.process_block(mDown8BufferPtrs.GetList(), mDown16BufferPtrs.GetList(), nOutChans, nFrames * 8);
+    }
+    if (mRate >= 8) {
+      mDownsampler8x.process_block(mDown4BufferPtrs.GetList(), mDown8BufferPtrs.GetList(), nOutChans, nFrames * 4);
+    }
+    if (mRate >= 4) {
+      mDownsampler4x.process_block(mDown2BufferPtrs.GetList(), mDown4BufferPtrs.GetList(), nOutChans, nFrames * 2);
+    }
+    if (mRate >= 2) {
+      mDownsampler2x.process_block(outputs, mDown2BufferPtrs.GetList(), nOutChans, nFrames);
     }
   }
   
   /** Over sample an input sample with a per-sample function (up-sample input -> process with function -> down-sample)
    * @param input The audio sample to input
-   * @param std::function<double(double)> The function that processes the audio sample at the higher sampling rate. NOTE: std::function can call malloc if you pass in captures
+   * @param func The function that processes the audio sample at the higher sampling rate, called as T func(T input). Like ProcessBlock(), it is called directly
    * @return The audio sample output */
-  T Process(T input, std::function<T(T)> func)
+  template <typename SampleFunc>
+  T Process(T input, SampleFunc&& func)
   {
     T output;
 
     if(mRate == 16)
     {
-      mUpsampler2x.Get(0)->process_sample(mUp2x.Get()[0], mUp2x.Get()[1], input);
-      mUpsampler4x.Get(0)->process_block(mUp4x.Get(), mUp2x.Get(), 2);
-      mUpsampler8x.Get(0)->process_block(mUp8x.Get(), mUp4x.Get(), 4);
-      mUpsampler16x.Get(0)->process_block(mUp16x.Get(), mUp8x.Get(), 8);
+      mUpsampler2x.process_sample(0, mUp2x.Get()[0], mUp2x.Get()[1], input);
+      mUpsampler4x.process_block(0, mUp4x.Get(), mUp2x.Get(), 2);
+      mUpsampler8x.process_block(0, mUp8x.Get(), mUp4x.Get(), 4);
+      mUpsampler16x.process_block(0, mUp16x.Get(), mUp8x.Get(), 8);
 
       for (auto i = 0; i < 16; i++)
       {
         mDown16x.Get()[i] = func(mUp16x.Get()[i]);
       }
 
-      mDownsampler16x.Get(0)->process_block(mDown8x.Get(), mDown16x.Get(), 8);
-      mDownsampler8x.Get(0)->process_block(mDown4x.Get(), mDown8x.Get(), 4);
-      mDownsampler4x.Get(0)->process_block(mDown2x.Get(), mDown4x.Get(), 2);
-      output = mDownsampler2x.Get(0)->process_sample(mDown2x.Get());
+      mDownsampler16x.process_block(0, mDown8x.Get(), mDown16x.Get(), 8);
+      mDownsampler8x.process_block(0, mDown4x.Get(), mDown8x.Get(), 4);
+      mDownsampler4x.process_block(0, mDown2x.Get(), mDown4x.Get(), 2);
+      output = mDownsampler2x.process_sample(0, mDown2x.Get());
     }
     else if (mRate == 8)
     {
-      mUpsampler2x.Get(0)->process_sample(mUp2x.Get()[0], mUp2x.Get()[1], input);
-      mUpsampler4x.Get(0)->process_block(mUp4x.Get(), mUp2x.Get(), 2);
-      mUpsampler8x.Get(0)->process_block(mUp8x.Get(), mUp4x.Get(), 4);
+      mUpsampler2x.process_sample(0, mUp2x.Get()[0], mUp2x.Get()[1], input);
+      mUpsampler4x.process_block(0, mUp4x.Get(), mUp2x.Get(), 2);
+      mUpsampler8x.process_block(0, mUp8x.Get(), mUp4x.Get(), 4);
 
       for (auto i = 0; i < 8; i++)
       {
         mDown8x.Get()[i] = func(mUp8x.Get()[i]);
       }
 
-      mDownsampler8x.Get(0)->process_block(mDown4x.Get(), mDown8x.Get(), 4);
-      mDownsampler4x.Get(0)->process_block(mDown2x.Get(), mDown4x.Get(), 2);
-      output = mDownsampler2x.Get(0)->process_sample(mDown2x.Get());
+      mDownsampler8x.process_block(0, mDown4x.Get(), mDown8x.Get(), 4);
+      mDownsampler4x.process_block(0, mDown2x.Get(), mDown4x.Get(), 2);
+      output = mDownsampler2x.process_sample(0, mDown2x.Get());
     }
     else if (mRate == 4)
     {
-      mUpsampler2x.Get(0)->process_sample(mUp2x.Get()[0], mUp2x.Get()[1], input);
-      mUpsampler4x.Get(0)->process_block(mUp4x.Get(), mUp2x.Get(), 2);
+      mUpsampler2x.process_sample(0, mUp2x.Get()[0], mUp2x.Get()[1], input);
+      mUpsampler4x.process_block(0, mUp4x.Get(), mUp2x.Get(), 2);
 
       for (auto i = 0; i < 4; i++)
       {
         mDown4x.Get()[i] = func(mUp4x.Get()[i]);
       }
 
-      mDownsampler4x.Get(0)->process_block(mDown2x.Get(), mDown4x.Get(), 2);
-      output = mDownsampler2x.Get(0)->process_sample(mDown2x.Get());
+      mDownsampler4x.process_block(0, mDown2x.Get(), mDown4x.Get(), 2);
+      output = mDownsampler2x.process_sample(0, mDown2x.Get());
     }
     else if (mRate == 2)
     {
-      mUpsampler2x.Get(0)->process_sample(mUp2x.Get()[0], mUp2x.Get()[1], input);
+      mUpsampler2x.process_sample(0, mUp2x.Get()[0], mUp2x.Get()[1], input);
 
       mDown2x.Get()[0] = func(mUp2x.Get()[0]);
       mDown2x.Get()[1] = func(mUp2x.Get()[1]);
-      output = mDownsampler2x.Get(0)->process_sample(mDown2x.Get());
+      output = mDownsampler2x.process_sample(0, mDown2x.Get());
     }
     else
     {
@@ -318,9 +309,10 @@ public:
   }
 
   /** Over-sample an per-sample synthesis function
-   * @param genFunc The function that generates the audio sample
+   * @param genFunc The function that generates the audio sample, called as T genFunc(). Like ProcessBlock(), it is called directly
    * @return The audio sample output */
-  T ProcessGen(std::function<T()> genFunc)
+  template <typename GenFunc>
+  T ProcessGen(GenFunc&& genFunc)
   {
     auto ProcessDown16x = [&](T input)
     {
@@ -331,10 +323,10 @@ public:
 
       if(mWritePos == 0)
       {
-        mDownsampler16x.Get(0)->process_block(mDown8x.Get(), mDown16x.Get(), 8);
-        mDownsampler8x.Get(0)->process_block(mDown4x.Get(), mDown8x.Get(), 4);
-        mDownsampler4x.Get(0)->process_block(mDown2x.Get(), mDown4x.Get(), 2);
-        mDownSamplerOutput = mDownsampler2x.Get(0)->process_sample(mDown2x.Get());
+        mDownsampler16x.process_block(0, mDown8x.Get(), mDown16x.Get(), 8);
+        mDownsampler8x.process_block(0, mDown4x.Get(), mDown8x.Get(), 4);
+        mDownsampler4x.process_block(0, mDown2x.Get(), mDown4x.Get(), 2);
+        mDownSamplerOutput = mDownsampler2x.process_sample(0, mDown2x.Get());
       }
     };
 
@@ -347,9 +339,9 @@ public:
 
       if(mWritePos == 0)
       {
-        mDownsampler8x.Get(0)->process_block(mDown4x.Get(), mDown8x.Get(), 4);
-        mDownsampler4x.Get(0)->process_block(mDown2x.Get(), mDown4x.Get(), 2);
-        mDownSamplerOutput = mDownsampler2x.Get(0)->process_sample(mDown2x.Get());
+        mDownsampler8x.process_block(0, mDown4x.Get(), mDown8x.Get(), 4);
+        mDownsampler4x.process_block(0, mDown2x.Get(), mDown4x.Get(), 2);
+        mDownSamplerOutput = mDownsampler2x.process_sample(0, mDown2x.Get());
       }
     };
 
@@ -362,8 +354,8 @@ public:
 
       if(mWritePos == 0)
       {
-        mDownsampler4x.Get(0)->process_block(mDown2x.Get(), mDown4x.Get(), 2);
-        mDownSamplerOutput = mDownsampler2x.Get(0)->process_sample(mDown2x.Get());
+        mDownsampler4x.process_block(0, mDown2x.Get(), mDown4x.Get(), 2);
+        mDownSamplerOutput = mDownsampler2x.process_sample(0, mDown2x.Get());
       }
     };
 
@@ -375,7 +367,7 @@ public:
 
       if(mWritePos == 0)
       {
-        mDownSamplerOutput = mDownsampler2x.Get(0)->process_sample(mDown2x.Get());
+        mDownSamplerOutput = mDownsampler2x.process_sample(0, mDown2x.Get());
       }
     };
 
@@ -430,7 +422,41 @@ public:
     return mRate;
   }
 
+  /** The up and down-sampling filters are minimum phase IIRs, so their delay depends on frequency. This is the delay at low frequencies, which rises towards the top of the passband
+   * @return The delay of the signal through the oversampler at the current rate, in samples at the base sample rate */
+  double GetGroupDelay() const
+  {
+    double delay = 0.;
+
+    // stage i is an up-sampler and a down-sampler running at 2^(i+1) times the base rate.
+    // The down-sampler's output is aligned with the later of each pair of input samples, which takes one sample off
+    for (auto i = 0, stageRate = 2; stageRate <= mRate; i++, stageRate *= 2)
+      delay += (2. * mStageDelays[i] - 1.) / stageRate;
+
+    return delay;
+  }
+
+  /** Call this after SetOverSampling(), and report the result to the host with IPlugProcessor::SetLatency()
+   * @return GetGroupDelay() rounded to whole samples */
+  int GetLatency() const
+  {
+    return static_cast<int>(std::round(GetGroupDelay()));
+  }
+
 private:
+  /** The low frequency group delay of one polyphase half-band filter, in samples at its higher rate.
+   * The coefficients alternate between two chains of first order all-passes in z^-2, each with a delay of 2(1-a)/(1+a) at DC, and the second chain is one sample later.
+   * At DC both chains have zero phase, so the delay of their sum is the mean of their delays */
+  static double StageGroupDelay(const double* pCoeffs, int nCoeffs)
+  {
+    double pathDelays[2] = {0., 1.};
+
+    for (auto i = 0; i < nCoeffs; i++)
+      pathDelays[i & 1] += 2. * (1. - pCoeffs[i]) / (1. + pCoeffs[i]);
+
+    return 0.5 * (pathDelays[0] + pathDelays[1]);
+  }
+
   EFactor mFactor = kNone;
   int mPrevRate = 0;
   int mRate = 1;
@@ -439,6 +465,7 @@ private:
   bool mBlockProcessing; // false
   int mNInChannels; // 1
   int mNOutChannels;
+  double mStageDelays[4] = {}; // low frequency group delay of each stage, in samples at its higher rate
   
   // the actual data
   WDL_TypedBuf<T> mUp16x;
@@ -469,16 +496,16 @@ private:
   WDL_PtrList<T>* mInPtrLoopSrc = nullptr;
   WDL_PtrList<T>* mOutPtrLoopSrc = nullptr;
   
-  //Ptrs to oversamplers for each channel
-  WDL_PtrList<Upsampler2xFPU<12, T>> mUpsampler2x; // for 1x to 2x SR
-  WDL_PtrList<Upsampler2xFPU<4, T>> mUpsampler4x;  // for 2x to 4x SR
-  WDL_PtrList<Upsampler2xFPU<3, T>> mUpsampler8x;  // for 4x to 8x SR
-  WDL_PtrList<Upsampler2xFPU<2, T>> mUpsampler16x; // for 8x to 16x SR
-
-  WDL_PtrList<Downsampler2xFPU<12, T>> mDownsampler2x; // decimator for 2x to 1x SR
-  WDL_PtrList<Downsampler2xFPU<4, T>> mDownsampler4x;  // decimator for 4x to 2x SR
-  WDL_PtrList<Downsampler2xFPU<3, T>> mDownsampler8x;  // decimator for 8x to 4x SR
-  WDL_PtrList<Downsampler2xFPU<2, T>> mDownsampler16x; // decimator for 16x to 8x SR
+  //Oversamplers for all channels, which process several channels at once in SIMD lanes
+  Upsampler2xMulti<12, T> mUpsampler2x; // for 1x to 2x SR
+  Upsampler2xMulti<4, T> mUpsampler4x;  // for 2x to 4x SR
+  Upsampler2xMulti<3, T> mUpsampler8x;  // for 4x to 8x SR
+  Upsampler2xMulti<2, T> mUpsampler16x; // for 8x to 16x SR
+
+  Downsampler2xMulti<12, T> mDownsampler2x; // decimator for 2x to 1x SR
+  Downsampler2xMulti<4, T> mDownsampler4x;  // decimator for 4x to 2x SR
+  Downsampler2xMulti<3, T> mDownsampler8x;  // decimator for 8x to 4x SR
+  Downsampler2xMulti<2, T> mDownsampler16x; // decimator for 16x to 8x SR
 };
 
 END_IPLUG_NAMESPACE
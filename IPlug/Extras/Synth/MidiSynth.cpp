@@ -474,11 +474,26 @@ void MidiSynth::SetSampleRateAndBlockSize(double sampleRate, int blockSize)
   Reset();
 
   mSampleRate = sampleRate;
-  mMidiQueue.Resize(blockSize);
+  mMaxHostBlockSize = blockSize;
+  mMidiQueue.Resize(std::max(blockSize, mMidiQueueCapacity));
   mVoiceAllocator.SetSampleRateAndBlockSize(sampleRate, blockSize);
 
   for(int v = 0; v < NVoices(); v++)
   {
     GetVoice(v)->SetSampleRateAndBlockSize(sampleRate, blockSize);
   }
+
+  StartRenderPool();
+}
+
+void MidiSynth::StartRenderPool()
+{
+  mVoiceAllocator.SetRenderPool(nullptr);
+  mRenderPool.Stop();
+
+  if(mNumRenderWorkers > 0 && mMaxHostBlockSize > 0)
+  {
+    mRenderPool.Start(mNumRenderWorkers, mMaxRenderChannels, mMaxHostBlockSize);
+    mVoiceAllocator.SetRenderPool(&mRenderPool);
+  }
 }
@@ -134,6 +134,25 @@ public:
     return mVoiceAllocator.GetNVoices();
   }
 
+  /** Render voices in parallel on a pool of worker threads. The audio thread renders voices too, and the worker outputs are summed into
+   * the output buffers at the end of each block, so results can differ from serial rendering by floating point rounding.
+   * Call this off the audio thread, e.g. in the plug-in constructor or OnReset(). The pool is (re)started in SetSampleRateAndBlockSize().
+   * NOTE: voices must not share mutable state with each other when rendered in parallel.
+   * @param nWorkers The number of worker threads in addition to the audio thread, or 0 for deterministic single-threaded rendering
+   * @param maxOutputChannels The maximum number of output channels to render in parallel, blocks with more channels are rendered serially */
+  void SetMultiThreaded(int nWorkers, int maxOutputChannels = 2)
+  {
+    mNumRenderWorkers = nWorkers;
+    mMaxRenderChannels = maxOutputChannels;
+    StartRenderPool();
+  }
+
+  /** @return The number of worker threads rendering voices, 0 if voices are rendered on the audio thread only */
+  int GetNumRenderWorkers() const
+  {
+    return mRenderPool.NWorkers();
+  }
+
   /** adds a SynthVoice to this MidiSynth, taking ownership of the object. */
   void AddVoice(SynthVoice* pVoice, uint8_t zone)
   {
@@ -145,6 +164,28 @@ public:
     mMidiQueue.Add(msg);
   }
 
+  /** Adds a list of MIDI messages that is already sorted by offset, such as a host's event list for a block, merging it with the queue in one pass
+   * @param pMsgs The messages
+   * @param nMsgs The number of messages */
+  void AddMidiMsgsToQueue(const IMidiMsg* pMsgs, int nMsgs)
+  {
+    mMidiQueue.AddSorted(pMsgs, nMsgs);
+  }
+
+  /** @return The number of MIDI messages dropped because the queue was full. The queue doesn't grow on the audio thread: if messages are dropped, raise its capacity with SetMidiQueueCapacity() */
+  int GetNumDroppedMidiMsgs() const
+  {
+    return mMidiQueue.GetNumDropped();
+  }
+
+  /** Sets the number of MIDI messages the queue can hold, which is otherwise based on the block size. Don't call this from the audio thread, since it allocates
+   * @param capacity The number of messages */
+  void SetMidiQueueCapacity(int capacity)
+  {
+    mMidiQueueCapacity = capacity;
+    mMidiQueue.Resize(std::max(mMaxHostBlockSize, capacity));
+  }
+
   /** Processes a block of audio samples
    * @param inputs Pointer to input Arrays
    * @param outputs Pointer to output Arrays
@@ -191,11 +232,13 @@ private:
   VoiceInputEvent MidiMessageToEventMPE(const IMidiMsg& msg);
   VoiceInputEvent MidiMessageToEvent(const IMidiMsg& msg);
   void HandleRPN(IMidiMsg msg);
+  void StartRenderPool();
 
   // basic MIDI data
   VoiceAllocator mVoiceAllocator;
   uint16_t mUnisonVoices{1};
-  IMidiQueue mMidiQueue;
+  int mMidiQueueCapacity = 0;
+  IMidiQueue mMidiQueue {DEFAULT_BLOCK_SIZE, IMidiQueue::EOverflowPolicy::DropOldest}; // fixed capacity, so a flood of messages never allocates on the audio thread
   float mVelocityLUT[128];
   float mAfterTouchLUT[128];
   ChannelState mChannelStates[16]{};
@@ -204,6 +247,12 @@ private:
   double mSampleRate = DEFAULT_SAMPLE_RATE;
   bool mVoicesAreActive = false;
   int mNonMPEPitchBendRange = kDefaultPitchBendRange;
+
+  // multi-threaded voice rendering
+  VoiceRenderPool mRenderPool;
+  int mNumRenderWorkers = 0;
+  int mMaxRenderChannels = 2;
+  int mMaxHostBlockSize = 0;
   
   // the synth will startup in basic MIDI mode. When an MPE Zone setup message is received, MPE mode is entered.
   // To leave MPE mode, use RPNs to set all MPE zone channel counts to 0 as per the MPE spec.
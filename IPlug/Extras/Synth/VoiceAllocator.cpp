@@ -56,6 +56,7 @@ void VoiceAllocator::AddVoice(SynthVoice* pVoice, uint8_t zone)
   if(mVoicePtrs.size() + 1 < UCHAR_MAX)
   {
     mVoicePtrs.push_back(pVoice);
+    mBusyVoicePtrs.reserve(mVoicePtrs.size());
     ClearVoiceInputs(pVoice);
     pVoice->mKey = -1;
     pVoice->mZone = zone;
@@ -529,9 +530,26 @@ void VoiceAllocator::NoteOff(VoiceInputEvent e, int64_t sampleTime)
 
 void VoiceAllocator::ProcessVoices(sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIndex, int blockSize)
 {
+  if(mRenderPool && mRenderPool->CanProcess(nOutputs, startIndex, blockSize))
+  {
+    mBusyVoicePtrs.clear();
+
+    for(auto pVoice : mVoicePtrs)
+    {
+      if(pVoice->GetBusy())
+        mBusyVoicePtrs.push_back(pVoice);
+    }
+
+    // not worth waking the workers for a single voice
+    if(mBusyVoicePtrs.size() > 1)
+    {
+      if(mRenderPool->ProcessVoices(mBusyVoicePtrs.data(), static_cast<int>(mBusyVoicePtrs.size()), inputs, outputs, nInputs, nOutputs, startIndex, blockSize))
+        return;
+    }
+  }
+
   for(auto pVoice : mVoicePtrs)
   {
-    // TODO distribute voices across cores
     if(pVoice->GetBusy())
     {
       pVoice->ProcessSamplesAccumulating(inputs, outputs, nInputs, nOutputs, startIndex, blockSize);
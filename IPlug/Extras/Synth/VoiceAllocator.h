@@ -26,6 +26,7 @@
 #include "IPlugQueue.h"
 
 #include "SynthVoice.h"
+#include "VoiceRenderPool.h"
 
 BEGIN_IPLUG_NAMESPACE
 
@@ -137,6 +138,11 @@ public:
 
   void ProcessVoices(sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIndex, int blockSize);
 
+  /** Render busy voices in parallel using a VoiceRenderPool. We do not take ownership of the pool.
+   * Pass nullptr to render voices serially on the audio thread, which is deterministic.
+   * @param pPool Pointer to a started pool, or nullptr */
+  void SetRenderPool(VoiceRenderPool* pPool) { mRenderPool = pPool; }
+
   size_t GetNVoices() const {return mVoicePtrs.size();}
   SynthVoice* GetVoice(int voiceIndex) const {return mVoicePtrs[voiceIndex];}
   void SetPitchOffset(float offset) { mPitchOffset = offset; }
@@ -167,6 +173,8 @@ private:
   IPlugQueue<VoiceInputEvent> mInputQueue{1024};
 
   std::vector<SynthVoice*> mVoicePtrs;
+  std::vector<SynthVoice*> mBusyVoicePtrs; // scratch list of busy voices, reserved in AddVoice() so that ProcessVoices() doesn't allocate
+  VoiceRenderPool* mRenderPool = nullptr;
   std::vector<std::unique_ptr<VoiceControlRamps>> mVoiceGlides;
   std::vector<int> mHeldKeys; // The currently physically held keys on the keyboard
   std::vector<int> mSustainedNotes; // Any notes that are sustained, including those that are physically held
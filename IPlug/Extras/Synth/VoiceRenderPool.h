@@ -0,0 +1,381 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+ */
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc VoiceRenderPool
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <climits>
+#include <stdint.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define VOICERENDERPOOL_SSE
+#endif
+
+#include "IPlugConstants.h"
+#include "IPlugPlatform.h"
+
+#include "SynthVoice.h"
+
+#if defined OS_WIN
+#include <windows.h>
+#elif defined OS_MAC || defined OS_IOS || defined OS_LINUX
+#include <pthread.h>
+#endif
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A pool of pre-spawned worker threads that render subsets of the busy voices of a VoiceAllocator in parallel.
+ * The audio thread never blocks, locks or allocates: voices are handed out through a single atomic work word,
+ * each worker accumulates into its own private buffer, and the calling thread sums those buffers into the outputs
+ * once every voice of the block has been rendered. The calling thread also renders voices (straight into the outputs),
+ * so a block always completes even if no worker wakes up in time.
+ * Workers take on the priority of the audio thread, see CopyCallerPriority().
+ * NOTE: voices rendered via the pool must not share mutable state with each other. */
+class VoiceRenderPool final
+{
+public:
+  /** The maximum number of voices that can be distributed in one job (matches the VoiceAllocator limit) */
+  static constexpr int kMaxVoices = UCHAR_MAX;
+
+  VoiceRenderPool() = default;
+
+  ~VoiceRenderPool()
+  {
+    Stop();
+  }
+
+  VoiceRenderPool(const VoiceRenderPool&) = delete;
+  VoiceRenderPool& operator=(const VoiceRenderPool&) = delete;
+
+  /** Spawn the worker threads and allocate their accumulation buffers. Must not be called on the audio thread.
+   * @param nWorkers The number of additional threads to spawn (the audio thread renders too)
+   * @param maxChannels The maximum number of output channels the pool can render
+   * @param maxBlockSize The maximum number of sample frames in a host block */
+  void Start(int nWorkers, int maxChannels, int maxBlockSize)
+  {
+    Stop();
+
+    if (nWorkers < 1 || maxChannels < 1 || maxBlockSize < 1)
+      return;
+
+    mMaxChannels = maxChannels;
+    mMaxBlockSize = maxBlockSize;
+    mRunning.store(true);
+    mCallerPriorityCaptured = false;
+    mCallerPriorityGen.store(0);
+
+    for (auto i = 0; i < nWorkers; i++)
+    {
+      std::unique_ptr<Worker> pWorker(new Worker);
+      pWorker->mBuffer.resize(static_cast<size_t>(maxChannels) * maxBlockSize);
+      pWorker->mChannelPtrs.resize(maxChannels);
+
+      for (auto c = 0; c < maxChannels; c++)
+        pWorker->mChannelPtrs[c] = pWorker->mBuffer.data() + (static_cast<size_t>(c) * maxBlockSize);
+
+      mWorkers.push_back(std::move(pWorker));
+    }
+
+    for (auto& pWorker : mWorkers)
+    {
+      Worker* pW = pWorker.get();
+      pW->mThread = std::thread([this, pW]() { WorkerLoop(*pW); });
+    }
+  }
+
+  /** Stop and join all worker threads. Must not be called on the audio thread or while ProcessVoices() is running. */
+  void Stop()
+  {
+    mRunning.store(false);
+
+    for (auto& pWorker : mWorkers)
+    {
+      if (pWorker->mThread.joinable())
+        pWorker->mThread.join();
+    }
+
+    mWorkers.clear();
+  }
+
+  /** @return \c true if worker threads have been spawned */
+  bool IsRunning() const { return !mWorkers.empty(); }
+
+  /** @return The number of worker threads, not including the calling thread */
+  int NWorkers() const { return static_cast<int>(mWorkers.size()); }
+
+  /** @return \c true if a block with these dimensions can be rendered by the pool */
+  bool CanProcess(int nOutputs, int startIdx, int nFrames) const
+  {
+    return IsRunning() && nOutputs <= mMaxChannels && (startIdx + nFrames) <= mMaxBlockSize;
+  }
+
+  /** Render a set of voices, accumulating their output into outputs, exactly as SynthVoice::ProcessSamplesAccumulating() would.
+   * Called on the audio thread. Returns \c false without touching the outputs if the pool cannot handle the block,
+   * in which case the caller should render the voices serially.
+   * @param pVoices Array of pointers to the (busy) voices to render
+   * @param nVoices The number of voices in pVoices
+   * @param inputs Pointer to input channel arrays, shared read-only between all voices
+   * @param outputs Pointer to output channel arrays
+   * @param nInputs The number of input channels that contain valid data
+   * @param nOutputs The number of output channels that contain valid data
+   * @param startIdx The start index of the block of samples to process
+   * @param nFrames The number of samples to process in this block
+   * @return \c true if the voices were rendered */
+  bool ProcessVoices(SynthVoice* const* pVoices, int nVoices, sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIdx, int nFrames)
+  {
+    if (!CanProcess(nOutputs, startIdx, nFrames) || nVoices > kMaxVoices)
+      return false;
+
+    if (nVoices < 1)
+      return true;
+
+    if (!mCallerPriorityCaptured)
+      CaptureCallerPriority();
+
+    const uint32_t gen = mGeneration + 1;
+    mGeneration = gen;
+
+    // publish the job, all plain writes are released by the store to mWork below
+    mJobVoices = pVoices;
+    mJobInputs = inputs;
+    mJobNInputs = nInputs;
+    mJobNOutputs = nOutputs;
+    mJobStartIdx = startIdx;
+    mJobNFrames = nFrames;
+    mCompleted.store(0, std::memory_order_relaxed);
+    mWork.store(MakeWorkWord(gen, nVoices, 0), std::memory_order_release);
+
+    // render voices on this thread too, directly into the outputs
+    int voiceIdx;
+    while ((voiceIdx = ClaimVoice(gen)) >= 0)
+    {
+      pVoices[voiceIdx]->ProcessSamplesAccumulating(inputs, outputs, nInputs, nOutputs, startIdx, nFrames);
+      mCompleted.fetch_add(1, std::memory_order_release);
+    }
+
+    // every voice has been claimed, wait for the workers that are still rendering
+    while (mCompleted.load(std::memory_order_acquire) < nVoices)
+      Pause();
+
+    // sum the accumulation buffers of the workers that took part in this job
+    for (auto& pWorker : mWorkers)
+    {
+      if (pWorker->mGeneration.load(std::memory_order_relaxed) != gen)
+        continue;
+
+      for (auto c = 0; c < nOutputs; c++)
+      {
+        const sample* pIn = pWorker->mChannelPtrs[c];
+        sample* pOut = outputs[c];
+
+        for (auto s = startIdx; s < startIdx + nFrames; s++)
+          pOut[s] += pIn[s];
+      }
+    }
+
+    return true;
+  }
+
+private:
+  /** Spin this many times before yielding, and yield this many times before sleeping. A worker stays hot for a whole host block */
+  static constexpr int kSpinsBeforeYield = 4096;
+  static constexpr int kYieldsBeforeSleep = 4096;
+
+  struct Worker
+  {
+    std::thread mThread;
+    std::vector<sample> mBuffer;
+    std::vector<sample*> mChannelPtrs;
+    std::atomic<uint32_t> mGeneration{0};
+  };
+
+  // The work word packs the job generation (32 bits), the number of voices (16 bits) and the next voice to claim (16 bits)
+  // so that a worker that wakes late can never claim a voice from a job it did not observe being published.
+  static uint64_t MakeWorkWord(uint32_t gen, int nVoices, int next)
+  {
+    return (static_cast<uint64_t>(gen) << 32) | (static_cast<uint64_t>(nVoices & 0xFFFF) << 16) | static_cast<uint64_t>(next & 0xFFFF);
+  }
+
+  /** @return The index of the next voice to render in job gen, or -1 if there is none left */
+  int ClaimVoice(uint32_t gen)
+  {
+    uint64_t work = mWork.load(std::memory_order_acquire);
+
+    while (true)
+    {
+      const uint32_t workGen = static_cast<uint32_t>(work >> 32);
+      const int nVoices = static_cast<int>((work >> 16) & 0xFFFF);
+      const int next = static_cast<int>(work & 0xFFFF);
+
+      if (workGen != gen || next >= nVoices)
+        return -1;
+
+      if (mWork.compare_exchange_weak(work, MakeWorkWord(gen, nVoices, next + 1), std::memory_order_acq_rel, std::memory_order_acquire))
+        return next;
+    }
+  }
+
+  /** Called on the audio thread by the first ProcessVoices() after Start(), to record its scheduling for the workers to copy. Doesn't block */
+  void CaptureCallerPriority()
+  {
+    mCallerPriorityCaptured = true;
+
+#if defined OS_WIN
+    const int priority = GetThreadPriority(GetCurrentThread());
+
+    if (priority == THREAD_PRIORITY_ERROR_RETURN)
+      return;
+
+    mCallerPriority.store(priority, std::memory_order_relaxed);
+#elif defined OS_LINUX
+    int policy = 0;
+    sched_param param {};
+
+    if (pthread_getschedparam(pthread_self(), &policy, &param))
+      return;
+
+    mCallerPolicy.store(policy, std::memory_order_relaxed);
+    mCallerPriority.store(param.sched_priority, std::memory_order_relaxed);
+#else
+    return;
+#endif
+
+    mCallerPriorityGen.fetch_add(1, std::memory_order_release);
+  }
+
+  /** Give the calling worker the scheduling of the audio thread, as captured by CaptureCallerPriority(). A realtime audio thread gets realtime workers,
+   * but a worker never runs above the thread that waits for it: an idle worker spins before it sleeps, so at a higher priority it could keep that thread off a core.
+   * On macOS and iOS, workers use QOS_CLASS_USER_INTERACTIVE, since only threads that join the host's audio workgroup get realtime scheduling there, and the pool doesn't.
+   * Workers are not pinned to cores: hosts place their own audio threads, and the scheduler can fit the workers around them better than a fixed affinity could. */
+  void CopyCallerPriority()
+  {
+#if defined OS_WIN
+    SetThreadPriority(GetCurrentThread(), mCallerPriority.load(std::memory_order_relaxed));
+#elif defined OS_LINUX
+    sched_param param {};
+    param.sched_priority = mCallerPriority.load(std::memory_order_relaxed);
+    pthread_setschedparam(pthread_self(), mCallerPolicy.load(std::memory_order_relaxed), &param);
+#endif
+  }
+
+  void WorkerLoop(Worker& worker)
+  {
+#if defined OS_MAC || defined OS_IOS
+    pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+#endif
+
+#ifdef VOICERENDERPOOL_SSE
+    // match the usual audio thread setup so that decaying voices don't hit denormals
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+#endif
+
+    uint32_t lastGen = static_cast<uint32_t>(mWork.load(std::memory_order_acquire) >> 32);
+    uint32_t lastPriorityGen = 0;
+    int idleCount = 0;
+
+    while (mRunning.load(std::memory_order_relaxed))
+    {
+      const uint32_t gen = static_cast<uint32_t>(mWork.load(std::memory_order_acquire) >> 32);
+
+      if (gen == lastGen)
+      {
+        if (idleCount < kSpinsBeforeYield)
+          Pause();
+        else if (idleCount < kSpinsBeforeYield + kYieldsBeforeSleep)
+          std::this_thread::yield();
+        else
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+        if (idleCount < kSpinsBeforeYield + kYieldsBeforeSleep)
+          idleCount++;
+
+        continue;
+      }
+
+      lastGen = gen;
+      idleCount = 0;
+
+      const uint32_t priorityGen = mCallerPriorityGen.load(std::memory_order_acquire);
+
+      if (priorityGen != lastPriorityGen)
+      {
+        lastPriorityGen = priorityGen;
+        CopyCallerPriority();
+      }
+
+      int voiceIdx = ClaimVoice(gen);
+
+      if (voiceIdx < 0)
+        continue;
+
+      // job parameters are stable until this worker's voices are complete
+      const int startIdx = mJobStartIdx;
+      const int nFrames = mJobNFrames;
+      const int nOutputs = mJobNOutputs;
+
+      for (auto c = 0; c < nOutputs; c++)
+      {
+        sample* pBuf = worker.mChannelPtrs[c];
+
+        for (auto s = startIdx; s < startIdx + nFrames; s++)
+          pBuf[s] = 0.;
+      }
+
+      worker.mGeneration.store(gen, std::memory_order_relaxed);
+
+      do
+      {
+        mJobVoices[voiceIdx]->ProcessSamplesAccumulating(mJobInputs, worker.mChannelPtrs.data(), mJobNInputs, nOutputs, startIdx, nFrames);
+        mCompleted.fetch_add(1, std::memory_order_release);
+      }
+      while ((voiceIdx = ClaimVoice(gen)) >= 0);
+    }
+  }
+
+  static inline void Pause()
+  {
+#ifdef VOICERENDERPOOL_SSE
+    _mm_pause();
+#endif
+  }
+
+  std::vector<std::unique_ptr<Worker>> mWorkers;
+  std::atomic<bool> mRunning{false};
+  std::atomic<uint64_t> mWork{0};
+  std::atomic<int> mCompleted{0};
+  uint32_t mGeneration = 0;
+
+  // the scheduling of the audio thread, see CaptureCallerPriority()
+  bool mCallerPriorityCaptured = false;
+  std::atomic<int> mCallerPolicy{0};
+  std::atomic<int> mCallerPriority{0};
+  std::atomic<uint32_t> mCallerPriorityGen{0};
+  int mMaxChannels = 0;
+  int mMaxBlockSize = 0;
+
+  SynthVoice* const* mJobVoices = nullptr;
+  sample** mJobInputs = nullptr;
+  int mJobNInputs = 0;
+  int mJobNOutputs = 0;
+  int mJobStartIdx = 0;
+  int mJobNFrames = 0;
+};
+
+END_IPLUG_NAMESPACE
@@ -0,0 +1,426 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc ThreadedConvolutionEngine
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "IPlugPlatform.h"
+
+// N.B. define WDL_FFT_REALSIZE before including this file, as for convoengine.h
+#include "convoengine.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A zero latency, non-uniform partitioned convolution engine for long impulse responses, with the same interface as WDL_ConvolutionEngine_Div.
+ * The head of the impulse response is convolved on the calling (audio) thread by a WDL_ConvolutionEngine_Div. The rest of it is split into tail stages,
+ * each with a block size four times that of the previous one (up to 16384 samples), that are convolved on a background thread.
+ * A stage with block size B starts 3 * B samples into the impulse response, so each of its blocks is due 2 * B samples after its input is complete.
+ * The worker always computes the pending block with the earliest deadline. If a block is late, the tail is left out of the output for those samples,
+ * and GetNumDeadlineMisses() is incremented, rather than the audio thread waiting for it.
+ * Add(), Avail(), Get() and Advance() don't lock; SetImpulse() and Reset() stop and restart the worker, so they must not be called while processing. */
+class ThreadedConvolutionEngine
+{
+public:
+  /** The block size of the largest tail stage, above which FFTs stop being worth it */
+  static constexpr int kMaxTailBlockSize = 16384;
+
+  ThreadedConvolutionEngine() = default;
+
+  ~ThreadedConvolutionEngine()
+  {
+    StopWorker();
+  }
+
+  ThreadedConvolutionEngine(const ThreadedConvolutionEngine&) = delete;
+  ThreadedConvolutionEngine& operator=(const ThreadedConvolutionEngine&) = delete;
+
+  /** Set the impulse response, and reset the engine. The impulse is copied to the stages, so it can be freed afterwards
+   * @param pImpulse The impulse response
+   * @param knownBlockSize The host's block size if known, or 0. The smallest tail block size is no smaller than this
+   * @param latencyAllowed Latency that the head may add, in samples, trading it for less work on the audio thread (see WDL_ConvolutionEngine_Div)
+   * @param tailBlockSize The block size of the first tail stage (a power of two), or 0 for the default of 2048 samples
+   * @return The latency in samples */
+  int SetImpulse(WDL_ImpulseBuffer* pImpulse, int knownBlockSize = 0, int latencyAllowed = 0, int tailBlockSize = 0)
+  {
+    StopWorker();
+
+    mStages.clear();
+
+    int blockSize = tailBlockSize > 0 ? tailBlockSize : 2048;
+    while (blockSize < knownBlockSize && blockSize < kMaxTailBlockSize)
+      blockSize *= 2;
+
+    const int impulseLength = pImpulse->GetLength();
+    int start = 3 * blockSize;
+
+    mHead.SetImpulse(pImpulse, 0, knownBlockSize, start, 0, latencyAllowed);
+
+    while (start < impulseLength)
+    {
+      const int nextBlockSize = std::min(blockSize * 4, kMaxTailBlockSize);
+      const int end = nextBlockSize > blockSize ? std::min(3 * nextBlockSize, impulseLength) : impulseLength;
+
+      mStages.push_back(std::make_unique<TailStage>());
+      TailStage& stage = *mStages.back();
+      stage.mBlockSize = blockSize;
+      stage.mStart = start;
+      stage.mEngine.SetImpulse(pImpulse, 2 * blockSize, start, end - start);
+
+      start = end;
+      blockSize = nextBlockSize;
+    }
+
+    Reset();
+
+    return GetLatency();
+  }
+
+  /** @return The latency in samples, which is the head's latency, so 0 unless SetImpulse() allowed some */
+  int GetLatency() { return mHead.GetLatency(); }
+
+  /** Clear any latent samples, and the deadline miss count */
+  void Reset()
+  {
+    StopWorker();
+
+    mHead.Reset();
+    mNumMixed = 0;
+    mReadPos.store(0);
+    mNumDeadlineMisses.store(0);
+
+    for (auto& pStage : mStages)
+      pStage->Reset();
+
+    StartWorker();
+  }
+
+  /** Add input samples. Doesn't allocate memory once the channel count and block size have been seen, or lock */
+  void Add(WDL_FFT_REAL** bufs, int len, int nch)
+  {
+    nch = std::min(nch, WDL_CONVO_MAX_PROC_NCH);
+
+    mHead.Add(bufs, len, nch);
+
+    if (mStages.empty())
+      return;
+
+    mProcNch.store(nch, std::memory_order_relaxed);
+
+    bool blockReady = false;
+
+    for (auto& pStage : mStages)
+      blockReady |= pStage->Write(bufs, len, nch);
+
+    if (blockReady)
+      mWake.notify_one();
+  }
+
+  /** Process the head, up to wantSamples, and mix in the tail that is ready
+   * @return The number of samples available to Get() */
+  int Avail(int wantSamples)
+  {
+    const int avail = mHead.Avail(wantSamples);
+
+    if (avail > mNumMixed && !mStages.empty())
+    {
+      WDL_FFT_REAL** pOutputs = mHead.Get();
+      const int nch = mProcNch.load(std::memory_order_relaxed);
+      const int64_t readPos = mReadPos.load(std::memory_order_relaxed) + mNumMixed;
+      const int len = avail - mNumMixed;
+      bool late = false;
+
+      for (auto& pStage : mStages)
+        late |= !pStage->MixInto(pOutputs, mNumMixed, readPos, len, nch);
+
+      if (late)
+        mNumDeadlineMisses.fetch_add(1, std::memory_order_relaxed);
+
+      mNumMixed = avail;
+    }
+
+    return avail;
+  }
+
+  /** @return The output buffers, one per channel, valid for the number of samples returned by Avail() */
+  WDL_FFT_REAL** Get() { return mHead.Get(); }
+
+  /** Remove samples from the front of the output buffers */
+  void Advance(int len)
+  {
+    mHead.Advance(len);
+    mNumMixed = std::max(0, mNumMixed - len);
+    mReadPos.fetch_add(len, std::memory_order_release);
+  }
+
+  /** @return The number of tail stages that run on the worker thread. 0 if the impulse response is short enough for the head to do everything */
+  int NStages() const { return static_cast<int>(mStages.size()); }
+
+  /** @return The number of times a tail block wasn't ready in time, since the last Reset() */
+  int GetNumDeadlineMisses() const { return mNumDeadlineMisses.load(std::memory_order_relaxed); }
+
+private:
+  /** A single-producer, single-consumer ring buffer per channel, indexed by absolute sample positions */
+  struct Ring
+  {
+    void Resize(int minSize)
+    {
+      int size = 1;
+      while (size < minSize)
+        size *= 2;
+
+      mMask = size - 1;
+
+      for (auto& buf : mBufs)
+        buf.assign(size, 0.);
+    }
+
+    void Clear(int64_t writePos)
+    {
+      for (auto& buf : mBufs)
+        std::fill(buf.begin(), buf.end(), WDL_FFT_REAL(0.));
+
+      mWritePos.store(writePos);
+    }
+
+    int Size() const { return mMask + 1; }
+
+    void Copy(int ch, int64_t pos, WDL_FFT_REAL* pDest, int len) const
+    {
+      const int offset = static_cast<int>(pos & mMask);
+      const int n = std::min(len, Size() - offset);
+      memcpy(pDest, mBufs[ch].data() + offset, n * sizeof(WDL_FFT_REAL));
+      memcpy(pDest + n, mBufs[ch].data(), (len - n) * sizeof(WDL_FFT_REAL));
+    }
+
+    void Store(int ch, int64_t pos, const WDL_FFT_REAL* pSrc, int len)
+    {
+      const int offset = static_cast<int>(pos & mMask);
+      const int n = std::min(len, Size() - offset);
+
+      if (pSrc)
+      {
+        memcpy(mBufs[ch].data() + offset, pSrc, n * sizeof(WDL_FFT_REAL));
+        memcpy(mBufs[ch].data(), pSrc + n, (len - n) * sizeof(WDL_FFT_REAL));
+      }
+      else
+      {
+        memset(mBufs[ch].data() + offset, 0, n * sizeof(WDL_FFT_REAL));
+        memset(mBufs[ch].data(), 0, (len - n) * sizeof(WDL_FFT_REAL));
+      }
+    }
+
+    void Accumulate(int ch, int64_t pos, WDL_FFT_REAL* pDest, int len) const
+    {
+      const WDL_FFT_REAL* pBuf = mBufs[ch].data();
+
+      for (auto i = 0; i < len; i++)
+        pDest[i] += pBuf[(pos + i) & mMask];
+    }
+
+    std::vector<WDL_FFT_REAL> mBufs[WDL_CONVO_MAX_PROC_NCH];
+    std::atomic<int64_t> mWritePos {0};
+    int mMask = 0;
+  };
+
+  /** One tail stage: a uniform partitioned engine for part of the impulse response, with its input and output buffered between the threads */
+  struct TailStage
+  {
+    void Reset()
+    {
+      mEngine.Reset();
+      mInput.Resize(8 * mBlockSize);
+      mInput.Clear(0);
+      mReadPos.store(0);
+      // output sample n of the engine is due at output position n + mStart. The head's latency delays when its output becomes available, not its positions
+      mOutputOffset = mStart;
+      mOutput.Resize(mOutputOffset + mInput.Size() + mBlockSize);
+      mOutput.Clear(mOutputOffset);
+      mBlock.Resize(mBlockSize * WDL_CONVO_MAX_PROC_NCH);
+    }
+
+    /** Audio thread: buffer input
+     * @return \c true if a block became ready */
+    bool Write(WDL_FFT_REAL** bufs, int len, int nch)
+    {
+      const int64_t writePos = mInput.mWritePos.load(std::memory_order_relaxed);
+      int offset = 0;
+
+      // if the worker fell a whole ring behind, the oldest input is overwritten. Process() notices and skips it
+      while (offset < len)
+      {
+        const int n = std::min(len - offset, mInput.Size());
+
+        for (auto ch = 0; ch < nch; ch++)
+          mInput.Store(ch, writePos + offset, bufs ? bufs[ch] + offset : nullptr, n);
+
+        offset += n;
+      }
+
+      mInput.mWritePos.store(writePos + len, std::memory_order_release);
+
+      return (writePos + len) / mBlockSize > writePos / mBlockSize;
+    }
+
+    /** Worker thread: the output position at which the next block is due, or -1 if it can't be processed yet */
+    int64_t Deadline(int64_t outputReadPos) const
+    {
+      const int64_t readPos = mReadPos.load(std::memory_order_relaxed);
+      const int64_t outputWritePos = readPos + mOutputOffset;
+
+      if (mInput.mWritePos.load(std::memory_order_acquire) - readPos < mBlockSize)
+        return -1;
+
+      if (outputWritePos + mBlockSize - outputReadPos > mOutput.Size())
+        return -1;
+
+      return outputWritePos;
+    }
+
+    /** Worker thread: convolve the next block */
+    void Process(int nch)
+    {
+      int64_t readPos = mReadPos.load(std::memory_order_relaxed);
+      const int64_t inputWritePos = mInput.mWritePos.load(std::memory_order_acquire);
+
+      // overrun: skip whole blocks. The output stays aligned with the input, since its position follows from readPos
+      if (inputWritePos - readPos > mInput.Size() - mBlockSize)
+        readPos += ((inputWritePos - readPos - mInput.Size()) / mBlockSize + 2) * mBlockSize;
+
+      const int64_t outputWritePos = readPos + mOutputOffset;
+
+      WDL_FFT_REAL* ptrs[WDL_CONVO_MAX_PROC_NCH];
+
+      for (auto ch = 0; ch < nch; ch++)
+      {
+        ptrs[ch] = mBlock.Get() + ch * mBlockSize;
+        mInput.Copy(ch, readPos, ptrs[ch], mBlockSize);
+      }
+
+      mReadPos.store(readPos + mBlockSize, std::memory_order_relaxed);
+
+      mEngine.Add(ptrs, mBlockSize, nch);
+      const int avail = mEngine.Avail(mBlockSize);
+      WDL_FFT_REAL** pOutputs = mEngine.Get();
+
+      for (auto ch = 0; ch < nch; ch++)
+        mOutput.Store(ch, outputWritePos, avail ? pOutputs[ch] : nullptr, mBlockSize);
+
+      mEngine.Advance(avail);
+
+      mOutput.mWritePos.store(outputWritePos + mBlockSize, std::memory_order_release);
+    }
+
+    /** Audio thread: add the tail output for [pos, pos + len) to the output buffers, from offset on
+     * @return \c false if any of it was late, and so left out */
+    bool MixInto(WDL_FFT_REAL** pOutputs, int offset, int64_t pos, int len, int nch) const
+    {
+      const int64_t writePos = mOutput.mWritePos.load(std::memory_order_acquire);
+      const int ready = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(len, writePos - pos)));
+
+      for (auto ch = 0; ch < nch; ch++)
+        mOutput.Accumulate(ch, pos, pOutputs[ch] + offset, ready);
+
+      return ready == len;
+    }
+
+    WDL_ConvolutionEngine mEngine;
+    Ring mInput;
+    Ring mOutput;
+    std::atomic<int64_t> mReadPos {0};
+    WDL_TypedBuf<WDL_FFT_REAL> mBlock;
+    int mBlockSize = 0;
+    int mStart = 0;
+    int mOutputOffset = 0;
+  };
+
+  void StartWorker()
+  {
+    if (mStages.empty())
+      return;
+
+    mStopping.store(false);
+    mWorker = std::thread([this]() { WorkerLoop(); });
+  }
+
+  void StopWorker()
+  {
+    if (!mWorker.joinable())
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      mStopping.store(true);
+    }
+
+    mWake.notify_one();
+    mWorker.join();
+  }
+
+  void WorkerLoop()
+  {
+    while (!mStopping.load())
+    {
+      const int64_t outputReadPos = mReadPos.load(std::memory_order_acquire);
+      TailStage* pEarliest = nullptr;
+      int64_t earliest = 0;
+
+      // earliest deadline first
+      for (auto& pStage : mStages)
+      {
+        const int64_t deadline = pStage->Deadline(outputReadPos);
+
+        if (deadline >= 0 && (!pEarliest || deadline < earliest))
+        {
+          pEarliest = pStage.get();
+          earliest = deadline;
+        }
+      }
+
+      if (pEarliest)
+      {
+        pEarliest->Process(mProcNch.load(std::memory_order_relaxed));
+      }
+      else
+      {
+        // the audio thread notifies without locking, so a wake-up can be missed: the timeout bounds the delay, well within the slack
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWake.wait_for(lock, std::chrono::milliseconds(2));
+      }
+    }
+  }
+
+  WDL_ConvolutionEngine_Div mHead;
+  std::vector<std::unique_ptr<TailStage>> mStages;
+  int mNumMixed = 0; // samples available from the head that already have the tail mixed in
+  std::atomic<int64_t> mReadPos {0}; // output position of the first sample available from the head
+  std::atomic<int> mProcNch {1};
+  std::atomic<int> mNumDeadlineMisses {0};
+
+  std::thread mWorker;
+  std::mutex mWakeMutex;
+  std::condition_variable mWake;
+  std::atomic<bool> mStopping {false};
+} WDL_FIXALIGN;
+
+END_IPLUG_NAMESPACE
@@ -42,6 +42,7 @@ IPlugAPIBase::IPlugAPIBase(Config c, EAPI plugAPI)
   Trace(TRACELOC, "%s:%s", c.pluginName, CurrentTime());
   
   mParamDisplayStr.Set("", MAX_PARAM_DISPLAY_LEN);
+  mParamChangeFromProcessor.Resize(c.nParams);
 }
 
 IPlugAPIBase::~IPlugAPIBase()
@@ -134,11 +135,26 @@ void IPlugAPIBase::SendParameterValueFromAPI(int paramIdx, double value, bool no
   if (normalized)
     value = GetParam(paramIdx)->FromNormalized(value);
   
-  mParamChangeFromProcessor.Push(ParamTuple { paramIdx, value } );
+  mParamChangeFromProcessor.Push(paramIdx, value);
 }
 
 void IPlugAPIBase::OnTimer(Timer& t)
 {
+  if (GetLockFreeStateRestore())
+  {
+    // the host has deactivated processing, so adopt a restored state here rather than waiting for the audio thread
+    if (mParamStateExchange.HasPending())
+      AdoptPendingParamStateIfInactive();
+    
+    if (mParamStateAdopted.exchange(false, std::memory_order_acquire))
+    {
+      for (int i = 0; i < NParams(); ++i)
+        OnParamChangeUI(i, kPresetRecall);
+      
+      OnRestoreState();
+    }
+  }
+  
   if(HasUI())
   {
 // VST3 ********************************************************************************
@@ -166,12 +182,9 @@ void IPlugAPIBase::OnTimer(Timer& t)
     }
 // !VST3 ******************************************************************************
 #else
-    while(mParamChangeFromProcessor.ElementsAvailable())
-    {
-      ParamTuple p;
-      mParamChangeFromProcessor.Pop(p);
-      SendParameterValueFromDelegate(p.idx, p.value, false);
-    }
+    mParamChangeFromProcessor.Drain([this](int paramIdx, double value) {
+      SendParameterValueFromDelegate(paramIdx, value, false);
+    });
     
     while (mMidiMsgsFromProcessor.ElementsAvailable())
     {
@@ -22,6 +22,7 @@
 #include "IPlugConstants.h"
 #include "IPlugStructs.h"
 #include "IPlugUtilities.h"
+#include "IPlugParamChangeCoalescer.h"
 #include "IPlugParameter.h"
 #include "IPlugQueue.h"
 #include "IPlugTimer.h"
@@ -227,7 +228,7 @@ private:
   WDL_String mParamDisplayStr;
   std::unique_ptr<Timer> mTimer;
   
-  IPlugQueue<ParamTuple> mParamChangeFromProcessor {PARAM_TRANSFER_SIZE};
+  IParamChangeCoalescer mParamChangeFromProcessor; // latest value of each parameter changed by the processor, to send to the editor
   IPlugQueue<IMidiMsg> mMidiMsgsFromEditor {MIDI_TRANSFER_SIZE}; // a queue of midi messages generated in the editor by clicking keyboard UI etc
   IPlugQueue<IMidiMsg> mMidiMsgsFromProcessor {MIDI_TRANSFER_SIZE}; // a queue of MIDI messages received (potentially on the high priority thread), by the processor to send to the editor
   IPlugQueue<SysExData> mSysExDataFromEditor {SYSEX_TRANSFER_SIZE}; // a queue of SYSEX data to send to the processor
@@ -119,6 +119,7 @@ static const int MAX_PARAM_DISPLAY_PRECISION = 6;
 #define PARAM_TRANSFER_SIZE 512
 #define MIDI_TRANSFER_SIZE 32
 #define SYSEX_TRANSFER_SIZE 4
+#define DEFAULT_MAX_PARAM_CHANGES 1024 // per block, when sample accurate automation is enabled
 
 // All version ints are stored as 0xVVVVRRMM: V = version, R = revision, M = minor revision.
 #define IPLUG_VERSION 0x010000
@@ -184,7 +185,8 @@ enum EAPI
   kAPIAAX = 4,
   kAPIAPP = 5,
   kAPIWAM = 6,
-  kAPIWEB = 7
+  kAPIWEB = 7,
+  kAPICLI = 8
 };
 
 /** @enum EHost
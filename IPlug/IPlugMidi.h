@@ -122,6 +122,7 @@ struct IMidiMsg
     kUndefined117 = 117,
     kUndefined118 = 118,
     kUndefined119 = 119,
+    kAllSoundOff = 120,
     kAllNotesOff = 123
   };
   
@@ -622,6 +623,11 @@ IMidiQueue is a fast, lean & mean MIDI queue for IPlug instruments or
 effects. Here are a few code snippets showing how to implement IMidiQueue in
 an IPlug project:
 
+(Altered for iPlug 2: the queue can also have a fixed capacity, so that Add()
+never allocates on the audio thread, with an overflow policy that decides
+which messages are dropped when it is full. AddSorted() merges an already
+sorted list of messages, such as a host's event list, in one pass.)
+
 
 MyPlug.h:
 
@@ -677,8 +683,24 @@ void MyPlug::ProcessBlock(double** inputs, double** outputs, int nFrames)
 class IMidiQueue
 {
 public:
-  IMidiQueue(int size = DEFAULT_BLOCK_SIZE)
-  : mBuf(NULL), mSize(0), mGrow(Granulize(size)), mFront(0), mBack(0)
+  // What Add() and AddSorted() do when the queue is full. Grow reallocates
+  // the queue, which is not real-time safe. The other policies keep the
+  // capacity set by the constructor or Resize(), and drop either the
+  // messages with the earliest offsets, or the ones with the latest offsets
+  // (which, for a single message, is usually the one being added).
+  // Dropping a note off or an all notes/sound off leaves notes hanging, so
+  // both drop policies skip those messages (see ReleasesNotes()) and only
+  // drop them when the queue holds nothing else, i.e. when it is too small
+  // for the number of notes that can be released at once.
+  enum class EOverflowPolicy
+  {
+    Grow,
+    DropOldest,
+    DropNewest
+  };
+
+  IMidiQueue(int size = DEFAULT_BLOCK_SIZE, EOverflowPolicy policy = EOverflowPolicy::Grow)
+  : mBuf(NULL), mSize(0), mGrow(Granulize(size)), mFront(0), mBack(0), mPolicy(policy)
   {
     Expand();
   }
@@ -689,30 +711,86 @@ public:
   }
 
   // Adds a MIDI message at the back of the queue. If the queue is full,
-  // it will automatically expand itself.
+  // it will automatically expand itself, or drop a message if the overflow
+  // policy is not Grow.
   void Add(const IMidiMsg& msg)
   {
     if (mBack >= mSize)
     {
       if (mFront > 0)
         Compact();
-      else if (!Expand()) return;
+      else if (mPolicy != EOverflowPolicy::Grow)
+      {
+        AddWhenFull(msg);
+        return;
+      }
+      else if (!Expand())
+      {
+        ++mNumDropped;
+        return;
+      }
+      else
+        ++mNumGrown;
     }
 
-#ifndef DONT_SORT_IMIDIQUEUE
     // Insert the MIDI message at the right offset.
-    if (mBack > mFront && msg.mOffset < mBuf[mBack - 1].mOffset)
+    const int i = InsertPosition(msg.mOffset);
+    if (i < mBack) memmove(&mBuf[i + 1], &mBuf[i], (mBack - i) * sizeof(IMidiMsg));
+    mBuf[i] = msg;
+    ++mBack;
+  }
+
+  // Adds nMsgs MIDI messages that are already sorted by offset, merging
+  // them with the queue in a single pass from the back. If they don't all
+  // fit, the overflow policy decides which messages are dropped.
+  void AddSorted(const IMidiMsg* pMsgs, int nMsgs)
+  {
+#ifdef DONT_SORT_IMIDIQUEUE
+    for (int k = 0; k < nMsgs; ++k) Add(pMsgs[k]);
+#else
+    if (nMsgs <= 0) return;
+    if (mFront > 0) Compact();
+
+    if (mBack + nMsgs > mSize && mPolicy == EOverflowPolicy::Grow)
     {
-      int i = mBack - 2;
-      while (i >= mFront && msg.mOffset < mBuf[i].mOffset) --i;
-      i++;
-      memmove(&mBuf[i + 1], &mBuf[i], (mBack - i) * sizeof(IMidiMsg));
-      mBuf[i] = msg;
+      while (mBack + nMsgs > mSize && Expand()) ++mNumGrown;
+    }
+
+    const int excess = mBack + nMsgs - mSize;
+    const int back = excess > 0 ? mSize : mBack + nMsgs;
+
+    // The messages of the two lists that are dropped lie before (DropOldest)
+    // or after (DropNewest, or a failed Grow, as in Add()) a cut, which is
+    // further in for messages that release notes.
+    int iCut = 0, jCut = 0, iReleaseCut = 0, jReleaseCut = 0;
+
+    if (excess > 0)
+    {
+      mNumDropped += excess;
+
+      const int nDropped = FindDropCut(pMsgs, nMsgs, excess, false, iCut, jCut);
+      FindDropCut(pMsgs, nMsgs, excess - nDropped, true, iReleaseCut, jReleaseCut);
+
+      // Remove the dropped queued messages
+      int w = 0;
+      for (int i = 0; i < mBack; ++i)
+      {
+        if (!IsDropped(mBuf[i], i, iCut, iReleaseCut)) mBuf[w++] = mBuf[i];
+      }
+      mBack = w;
+    }
+
+    // Merge from the back, so that queued messages are moved at most once.
+    // Messages with equal offsets stay in the order they were added.
+    int i = mBack - 1, j = nMsgs - 1, w = back - 1;
+    mBack = back;
+    while (j >= 0)
+    {
+      if (excess > 0 && IsDropped(pMsgs[j], j, jCut, jReleaseCut)) --j;
+      else if (i >= 0 && mBuf[i].mOffset > pMsgs[j].mOffset) mBuf[w--] = mBuf[i--];
+      else mBuf[w--] = pMsgs[j--];
     }
-    else
 #endif
-      mBuf[mBack] = msg;
-    ++mBack;
   }
 
   // Removes a MIDI message from the front of the queue (but does *not*
@@ -748,6 +826,39 @@ public:
   // Clears the queue.
   inline void Clear() { mFront = mBack = 0; }
 
+  // Sets what happens when a message is added to a full queue.
+  inline void SetOverflowPolicy(EOverflowPolicy policy) { mPolicy = policy; }
+
+  inline EOverflowPolicy GetOverflowPolicy() const { return mPolicy; }
+
+  // Returns the number of messages dropped because the queue was full.
+  inline int GetNumDropped() const { return mNumDropped; }
+
+  // Returns the number of times the queue grew because it was full, which
+  // allocates memory.
+  inline int GetNumGrown() const { return mNumGrown; }
+
+  // Resets the counters returned by GetNumDropped() and GetNumGrown().
+  inline void ClearCounters() { mNumDropped = mNumGrown = 0; }
+
+  // Returns true for the messages that the drop policies keep while they
+  // can: note offs (including note ons with zero velocity), and all notes
+  // off and all sound off.
+  static bool ReleasesNotes(const IMidiMsg& msg)
+  {
+    switch (msg.StatusMsg())
+    {
+      case IMidiMsg::kNoteOff:
+        return true;
+      case IMidiMsg::kNoteOn:
+        return msg.Velocity() == 0;
+      case IMidiMsg::kControlChange:
+        return msg.ControlChangeIdx() == IMidiMsg::kAllNotesOff || msg.ControlChangeIdx() == IMidiMsg::kAllSoundOff;
+      default:
+        return false;
+    }
+  }
+
   // Resizes (grows or shrinks) the queue, returns the new size.
   int Resize(int size)
   {
@@ -780,6 +891,80 @@ protected:
     return true;
   }
 
+  // Returns the index at which a message with this offset is inserted: after
+  // any queued messages with the same offset.
+  inline int InsertPosition(int offset) const
+  {
+    int i = mBack;
+#ifndef DONT_SORT_IMIDIQUEUE
+    while (i > mFront && offset < mBuf[i - 1].mOffset) --i;
+#endif
+    return i;
+  }
+
+  // Adds a message to a full queue without allocating, dropping a message
+  // according to the overflow policy.
+  void AddWhenFull(const IMidiMsg& msg)
+  {
+    ++mNumDropped;
+
+    if (mSize == 0) return;
+
+    // Positions k in the queue with msg inserted at i, from the front for
+    // DropOldest, or from the back. Drop the first message that doesn't
+    // release notes, or the first message if they all do.
+    const int i = InsertPosition(msg.mOffset);
+    const bool fromFront = mPolicy == EOverflowPolicy::DropOldest;
+    const int first = fromFront ? mFront : mBack, end = fromFront ? mBack + 1 : mFront - 1, step = fromFront ? 1 : -1;
+    int k = first;
+    while (k != end && ReleasesNotes(k == i ? msg : mBuf[k < i ? k : k - 1])) k += step;
+    if (k == end) k = first;
+
+    if (k < i)
+    {
+      memmove(&mBuf[k], &mBuf[k + 1], (i - 1 - k) * sizeof(IMidiMsg));
+      mBuf[i - 1] = msg;
+    }
+    else if (k > i)
+    {
+      memmove(&mBuf[i + 1], &mBuf[i], (k - 1 - i) * sizeof(IMidiMsg));
+      mBuf[i] = msg;
+    }
+  }
+
+  // Walks the queued messages (from index 0) merged with pMsgs, from the
+  // front for DropOldest, or from the back, until it has passed n messages
+  // that release notes (release == true) or that don't. Sets iCut and jCut
+  // to where it stopped in each list, and returns the number passed, which
+  // is less than n if there aren't enough.
+  int FindDropCut(const IMidiMsg* pMsgs, int nMsgs, int n, bool release, int& iCut, int& jCut) const
+  {
+    const bool fromFront = mPolicy == EOverflowPolicy::DropOldest;
+    int i = fromFront ? 0 : mBack, j = fromFront ? 0 : nMsgs, passed = 0;
+
+    while (passed < n && (fromFront ? i < mBack || j < nMsgs : i > 0 || j > 0))
+    {
+      const IMidiMsg* pMsg;
+      if (fromFront)
+        pMsg = (j >= nMsgs || (i < mBack && mBuf[i].mOffset <= pMsgs[j].mOffset)) ? &mBuf[i++] : &pMsgs[j++];
+      else
+        pMsg = (j <= 0 || (i > 0 && mBuf[i - 1].mOffset > pMsgs[j - 1].mOffset)) ? &mBuf[--i] : &pMsgs[--j];
+      if (ReleasesNotes(*pMsg) == release) ++passed;
+    }
+
+    iCut = i;
+    jCut = j;
+    return passed;
+  }
+
+  // Returns true if the message at index idx of its list lies past the cut
+  // found by FindDropCut() for its kind.
+  inline bool IsDropped(const IMidiMsg& msg, int idx, int cut, int releaseCut) const
+  {
+    const int c = ReleasesNotes(msg) ? releaseCut : cut;
+    return mPolicy == EOverflowPolicy::DropOldest ? idx < c : idx >= c;
+  }
+
   // Moves everything all the way to the front.
   inline void Compact()
   {
@@ -801,6 +986,9 @@ protected:
 
   int mSize, mGrow;
   int mFront, mBack;
+  EOverflowPolicy mPolicy;
+  int mNumDropped = 0;
+  int mNumGrown = 0;
 };
 
 END_IPLUG_NAMESPACE
@@ -0,0 +1,143 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IParamChangeCoalescer
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** Transfers parameter changes from the processor (possibly several API threads) to the main thread, coalescing repeated changes to the same parameter.
+ * Producers store the latest value and set a dirty bit, which is wait-free and can never overflow.
+ * The consumer visits only the dirty parameters, via a two-level bitset, so draining costs O(changed) rather than O(messages) or O(parameters).
+ * Each parameter is delivered at most once per drain, with its latest value */
+class IParamChangeCoalescer
+{
+public:
+  IParamChangeCoalescer(int nParams = 0)
+  {
+    Resize(nParams);
+  }
+
+  IParamChangeCoalescer(const IParamChangeCoalescer&) = delete;
+  IParamChangeCoalescer& operator=(const IParamChangeCoalescer&) = delete;
+
+  /** Allocate storage for nParams parameters and clear any pending changes. Not thread safe */
+  void Resize(int nParams)
+  {
+    mNParams = nParams;
+    mNWords = (nParams + 63) / 64;
+    mNSummaryWords = (mNWords + 63) / 64;
+    mValues.reset(nParams ? new std::atomic<double>[nParams] : nullptr);
+    mDirtyBits.reset(mNWords ? new std::atomic<uint64_t>[mNWords] : nullptr);
+    mSummaryBits.reset(mNSummaryWords ? new std::atomic<uint64_t>[mNSummaryWords] : nullptr);
+
+    for (auto i = 0; i < nParams; i++)
+      mValues[i].store(0.);
+
+    for (auto i = 0; i < mNWords; i++)
+      mDirtyBits[i].store(0);
+
+    for (auto i = 0; i < mNSummaryWords; i++)
+      mSummaryBits[i].store(0);
+  }
+
+  /** @return The number of parameters */
+  int NParams() const { return mNParams; }
+
+  /** Record the latest value of a parameter. Wait-free, may be called on the audio thread and by several producers at once
+   * @param paramIdx The parameter index
+   * @param value The new (non-normalized) value */
+  void Push(int paramIdx, double value)
+  {
+    if (paramIdx < 0 || paramIdx >= mNParams)
+      return;
+
+    const int wordIdx = paramIdx >> 6;
+    mValues[paramIdx].store(value, std::memory_order_relaxed);
+    mDirtyBits[wordIdx].fetch_or(uint64_t(1) << (paramIdx & 63), std::memory_order_release);
+    mSummaryBits[wordIdx >> 6].fetch_or(uint64_t(1) << (wordIdx & 63), std::memory_order_release);
+  }
+
+  /** @return \c true if no changes were pending. Only a hint, since producers may be pushing concurrently */
+  bool WasEmpty() const
+  {
+    for (auto i = 0; i < mNSummaryWords; i++)
+    {
+      if (mSummaryBits[i].load(std::memory_order_relaxed))
+        return false;
+    }
+
+    return true;
+  }
+
+  /** Deliver every parameter that changed since the last call, once each, with its latest value. Call on a single consumer thread
+   * @param func Called with (int paramIdx, double value) for each changed parameter, in ascending parameter order
+   * @return The number of parameters delivered */
+  template <typename F>
+  int Drain(F func)
+  {
+    int nDelivered = 0;
+
+    for (auto s = 0; s < mNSummaryWords; s++)
+    {
+      uint64_t summary = mSummaryBits[s].exchange(0, std::memory_order_acquire);
+
+      while (summary)
+      {
+        const int wordIdx = (s << 6) + CountTrailingZeros(summary);
+        summary &= summary - 1;
+
+        uint64_t bits = mDirtyBits[wordIdx].exchange(0, std::memory_order_acquire);
+
+        while (bits)
+        {
+          const int paramIdx = (wordIdx << 6) + CountTrailingZeros(bits);
+          bits &= bits - 1;
+
+          func(paramIdx, mValues[paramIdx].load(std::memory_order_relaxed));
+          nDelivered++;
+        }
+      }
+    }
+
+    return nDelivered;
+  }
+
+private:
+  static inline int CountTrailingZeros(uint64_t x)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    while (!(x & 1)) { x >>= 1; n++; }
+    return n;
+#endif
+  }
+
+  std::unique_ptr<std::atomic<double>[]> mValues;
+  std::unique_ptr<std::atomic<uint64_t>[]> mDirtyBits;
+  std::unique_ptr<std::atomic<uint64_t>[]> mSummaryBits;
+  int mNParams = 0;
+  int mNWords = 0;
+  int mNSummaryWords = 0;
+};
+
+END_IPLUG_NAMESPACE
@@ -0,0 +1,159 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IParamSnapshot
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "IPlugPlatform.h"
+#include "IPlugConstants.h"
+#include "IPlugEditorDelegate.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A per-block snapshot of all parameter values, for use on the audio thread.
+ * Call Update() once at the start of ProcessBlock(), then read the values from plain contiguous memory rather than doing an atomic load
+ * via IParam::Value() for every parameter access. The snapshot records which parameters changed since the previous block,
+ * so that DSP code only needs to visit those, and can provide a linear ramp from the previous value to de-zipper changes.
+ * Update() reads each parameter once, so it should only be called from the audio thread */
+class IParamSnapshot
+{
+public:
+  IParamSnapshot() = default;
+
+  IParamSnapshot(const IParamSnapshot&) = delete;
+  IParamSnapshot& operator=(const IParamSnapshot&) = delete;
+
+  /** Allocate storage for the parameters of a plug-in and take an initial snapshot, with no parameters marked as changed.
+   * Call this from the plug-in constructor, after the parameters have been initialized
+   * @param delegate The plug-in (or other delegate) owning the parameters */
+  void Init(const IEditorDelegate& delegate)
+  {
+    const int nParams = delegate.NParams();
+    mValues.resize(nParams);
+    mPrevValues.resize(nParams);
+    mChangedBits.assign((nParams + 63) / 64, 0);
+    mChangedIndices.resize(nParams);
+    mNChanged = 0;
+
+    for (auto i = 0; i < nParams; i++)
+    {
+      mValues[i] = mPrevValues[i] = delegate.GetParam(i)->ValueRelaxed();
+    }
+  }
+
+  /** Take a snapshot of the current parameter values. Call this once at the start of ProcessBlock()
+   * @param delegate The plug-in (or other delegate) owning the parameters */
+  void Update(const IEditorDelegate& delegate)
+  {
+    const int nParams = NParams();
+
+    // clear the bits set last block, O(changed)
+    for (auto i = 0; i < mNChanged; i++)
+    {
+      mChangedBits[mChangedIndices[i] >> 6] = 0;
+    }
+
+    mNChanged = 0;
+
+    for (auto i = 0; i < nParams; i++)
+    {
+      const double value = delegate.GetParam(i)->ValueRelaxed();
+      const double prev = mValues[i];
+      mPrevValues[i] = prev;
+
+      if (value != prev)
+      {
+        mValues[i] = value;
+        mChangedBits[i >> 6] |= (uint64_t(1) << (i & 63));
+        mChangedIndices[mNChanged++] = i;
+      }
+    }
+  }
+
+  /** @return The number of parameters in the snapshot */
+  int NParams() const { return static_cast<int>(mValues.size()); }
+
+  /** @return The value of a parameter at the time of the last Update() */
+  double Value(int paramIdx) const { return mValues[paramIdx]; }
+
+  /** @return The value of a parameter at the time of the Update() before the last one */
+  double PrevValue(int paramIdx) const { return mPrevValues[paramIdx]; }
+
+  /** @return Pointer to the contiguous array of NParams() values */
+  const double* Values() const { return mValues.data(); }
+
+  /** @return \c true if the parameter changed in the last Update() */
+  bool Changed(int paramIdx) const { return (mChangedBits[paramIdx >> 6] >> (paramIdx & 63)) & 1; }
+
+  /** @return The number of parameters that changed in the last Update() */
+  int NChanged() const { return mNChanged; }
+
+  /** Use with NChanged() to visit only the parameters that changed in the last Update()
+   * @param changeIdx Index in the range [0, NChanged())
+   * @return The index of a changed parameter */
+  int GetChangedParamIdx(int changeIdx) const { return mChangedIndices[changeIdx]; }
+
+  /** Get a value of the linear ramp from the previous to the current value of a parameter, which reaches the current value at the last frame of the block
+   * @param paramIdx The parameter index
+   * @param frame The sample frame within the block
+   * @param nFrames The number of sample frames in the block
+   * @return The ramped value */
+  double RampValue(int paramIdx, int frame, int nFrames) const
+  {
+    const double prev = mPrevValues[paramIdx];
+    return prev + (mValues[paramIdx] - prev) * (double(frame + 1) / double(nFrames));
+  }
+
+  /** Fill a buffer with a linear ramp from the previous to the current value of a parameter. If the parameter didn't change the buffer is filled with the current value
+   * @param paramIdx The parameter index
+   * @param pDest Buffer of at least nFrames samples
+   * @param nFrames The number of sample frames in the block */
+  template <typename T>
+  void FillRamp(int paramIdx, T* pDest, int nFrames) const
+  {
+    const double value = mValues[paramIdx];
+
+    if (!Changed(paramIdx) || nFrames < 1)
+    {
+      for (auto s = 0; s < nFrames; s++)
+        pDest[s] = static_cast<T>(value);
+
+      return;
+    }
+
+    const double prev = mPrevValues[paramIdx];
+    const double inc = (value - prev) / double(nFrames);
+    double v = prev;
+
+    for (auto s = 0; s < nFrames; s++)
+    {
+      v += inc;
+      pDest[s] = static_cast<T>(v);
+    }
+
+    pDest[nFrames - 1] = static_cast<T>(value);
+  }
+
+private:
+  std::vector<double> mValues;
+  std::vector<double> mPrevValues;
+  std::vector<uint64_t> mChangedBits;
+  std::vector<int> mChangedIndices;
+  int mNChanged = 0;
+};
+
+END_IPLUG_NAMESPACE
@@ -0,0 +1,139 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc IParamStateExchange
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "mutex.h"
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A wait-free triple buffer used to hand a complete set of parameter values from a non-realtime thread (e.g. a host restoring a preset) to the audio thread.
+ * Writers prepare a full value set and publish it, the audio thread adopts the most recently published set at the start of a block.
+ * The audio thread never blocks: writers are serialized with a mutex that only non-realtime threads take, and adoption is guarded by a try-lock,
+ * so that the main thread can adopt the values itself while no audio is being processed */
+class IParamStateExchange
+{
+public:
+  IParamStateExchange() = default;
+
+  IParamStateExchange(const IParamStateExchange&) = delete;
+  IParamStateExchange& operator=(const IParamStateExchange&) = delete;
+
+  /** Allocate the buffers. Not thread safe, call this before any other method e.g. in the plug-in constructor
+   * @param nParams The number of parameter values in a set */
+  void Resize(int nParams)
+  {
+    for (auto& buf : mBuffers)
+      buf.assign(nParams, 0.);
+
+    mStaged.assign(nParams, 0.);
+    mWriteIdx = 0;
+    mMiddle.store(1);
+    mReadIdx = 2;
+    mPublishedGen.store(0);
+    mAdoptedGen.store(0);
+  }
+
+  /** @return The number of values in a set */
+  int NValues() const { return static_cast<int>(mStaged.size()); }
+
+  /** Begin preparing a new value set, must be balanced with EndWrite(). Not realtime safe
+   * @return Pointer to NValues() values to fill */
+  double* BeginWrite()
+  {
+    mWriteMutex.Enter();
+    return mBuffers[mWriteIdx].data();
+  }
+
+  /** Publish the value set prepared since BeginWrite(), replacing any set that has not yet been adopted */
+  void EndWrite()
+  {
+    mStaged = mBuffers[mWriteIdx];
+    const uint32_t gen = mPublishedGen.load(std::memory_order_relaxed) + 1;
+    mBufferGen[mWriteIdx] = gen;
+    mPublishedGen.store(gen, std::memory_order_release);
+    mWriteIdx = mMiddle.exchange(mWriteIdx | kNewDataBit, std::memory_order_acq_rel) & kIndexMask;
+    mWriteMutex.Leave();
+  }
+
+  /** @return \c true if a published value set has not been adopted yet */
+  bool HasPending() const { return mAdoptedGen.load(std::memory_order_acquire) != mPublishedGen.load(std::memory_order_acquire); }
+
+  /** Copy the most recently published value set, if it has not been adopted yet. Not realtime safe.
+   * Used to serialize the correct state if the host saves before the audio thread has adopted a restored state
+   * @param pDest Destination for NValues() values
+   * @return \c true if there was a pending set to copy */
+  bool GetPending(double* pDest)
+  {
+    WDL_MutexLock lock(&mWriteMutex);
+
+    if (!HasPending())
+      return false;
+
+    std::copy(mStaged.begin(), mStaged.end(), pDest);
+    return true;
+  }
+
+  /** Try to take the most recently published value set. Never blocks. If a set is returned, EndAdopt() must be called once the values have been applied
+   * @return Pointer to NValues() values, or nullptr if there is no new set or another thread is adopting */
+  const double* BeginAdopt()
+  {
+    if (!(mMiddle.load(std::memory_order_relaxed) & kNewDataBit))
+      return nullptr;
+
+    if (mAdopting.test_and_set(std::memory_order_acquire))
+      return nullptr;
+
+    if (!(mMiddle.load(std::memory_order_relaxed) & kNewDataBit))
+    {
+      mAdopting.clear(std::memory_order_release);
+      return nullptr;
+    }
+
+    mReadIdx = mMiddle.exchange(mReadIdx, std::memory_order_acq_rel) & kIndexMask;
+    return mBuffers[mReadIdx].data();
+  }
+
+  /** Release the adoption started with a successful call to BeginAdopt() */
+  void EndAdopt()
+  {
+    mAdoptedGen.store(mBufferGen[mReadIdx], std::memory_order_release);
+    mAdopting.clear(std::memory_order_release);
+  }
+
+private:
+  static constexpr int kIndexMask = 0x3;
+  static constexpr int kNewDataBit = 0x4;
+
+  std::vector<double> mBuffers[3];
+  std::vector<double> mStaged; // copy of the last published set, guarded by mWriteMutex
+  WDL_Mutex mWriteMutex;
+  int mWriteIdx = 0; // owned by the writer
+  int mReadIdx = 2; // owned by the adopting thread
+  std::atomic<int> mMiddle{1};
+  uint32_t mBufferGen[3] = {}; // the generation of the set in each buffer, travels with the buffer index
+  std::atomic<uint32_t> mPublishedGen{0};
+  std::atomic<uint32_t> mAdoptedGen{0};
+  std::atomic_flag mAdopting = ATOMIC_FLAG_INIT;
+};
+
+END_IPLUG_NAMESPACE
@@ -336,6 +336,10 @@ public:
    * @return double Current value of the parameter */
   double Value() const { return mValue.load(); }
 
+  /** Gets a readable value of the parameter with a relaxed atomic load. Use this for bulk reads from a single thread, such as IParamSnapshot::Update()
+   * @return Current value of the parameter */
+  double ValueRelaxed() const { return mValue.load(std::memory_order_relaxed); }
+
   /** Returns the parameter's value as a boolean
    * @return \c true if value >= 0.5, else otherwise */
   bool Bool() const { return (mValue.load() >= 0.5); }
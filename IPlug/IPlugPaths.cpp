@@ -23,6 +23,9 @@
 #include <windows.h>
 #include <Shlobj.h>
 #include <Shlwapi.h>
+#elif defined OS_LINUX
+#include <unistd.h>
+#include <sys/stat.h>
 #endif
 
 BEGIN_IPLUG_NAMESPACE
@@ -277,6 +280,61 @@ EResourceLocation LocateResource(const char* name, const char* type, WDL_String&
   return EResourceLocation::kNotFound;
 }
 
+#elif defined OS_LINUX
+#pragma mark - OS_LINUX
+
+static bool FileExists(const char* path)
+{
+  struct stat st;
+  return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static void ExecutableDirectory(WDL_String& path)
+{
+  char buf[4096];
+  const ssize_t len = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+  buf[len > 0 ? len : 0] = '\0';
+  path.Set(buf);
+  path.remove_filepart();
+}
+
+EResourceLocation LocateResource(const char* name, const char* type, WDL_String& result, const char*, void*, const char*)
+{
+  if (CStringHasContents(name))
+  {
+    // a path to the file, absolute or relative to the working directory
+    if (FileExists(name))
+    {
+      result.Set(name);
+      return EResourceLocation::kAbsolutePath;
+    }
+
+    // otherwise the resources folder next to the executable, the same layout as the web and mac bundles
+    WDL_String path(name);
+    const char* file = path.get_filepart();
+    const char* subFolder = (strcmp(type, "ttf") == 0) ? "fonts" : "img";
+
+    WDL_String exeDir;
+    ExecutableDirectory(exeDir);
+
+    for (auto folder : {"resources", "../resources"})
+    {
+      result.SetFormatted(4096, "%s/%s/%s/%s", exeDir.Get(), folder, subFolder, file);
+
+      if (FileExists(result.Get()))
+        return EResourceLocation::kAbsolutePath;
+
+      result.SetFormatted(4096, "%s/%s/%s", exeDir.Get(), folder, file);
+
+      if (FileExists(result.Get()))
+        return EResourceLocation::kAbsolutePath;
+    }
+  }
+
+  result.Set("");
+  return EResourceLocation::kNotFound;
+}
+
 #endif
 
 END_IPLUG_NAMESPACE
@@ -13,6 +13,8 @@
  * @brief IPluginBase implementation
  */
 
+#include <thread>
+
 #include "IPlugPluginBase.h"
 #include "wdlendian.h"
 #include "wdl_base64.h"
@@ -75,6 +77,7 @@ const char* IPluginBase::GetAPIStr() const
     case kAPIAPP: return "APP";
     case kAPIWAM: return "WAM";
     case kAPIWEB: return "WEB";
+    case kAPICLI: return "CLI";
     default: return "";
   }
 }
@@ -106,6 +109,23 @@ bool IPluginBase::SerializeParams(IByteChunk& chunk) const
   TRACE
   bool savedOK = true;
   int i, n = mParams.GetSize();
+
+  // if a restored state has not been adopted by the audio thread yet, save that rather than the current values
+  if (mLockFreeStateRestore && mParamStateExchange.HasPending())
+  {
+    std::vector<double> pendingValues(n);
+
+    if (mParamStateExchange.GetPending(pendingValues.data()))
+    {
+      for (i = 0; i < n && savedOK; ++i)
+      {
+        double v = pendingValues[i];
+        savedOK &= (chunk.Put(&v) > 0);
+      }
+      return savedOK;
+    }
+  }
+
   for (i = 0; i < n && savedOK; ++i)
   {
     IParam* pParam = mParams.Get(i);
@@ -120,6 +140,32 @@ int IPluginBase::UnserializeParams(const IByteChunk& chunk, int startPos)
 {
   TRACE
   int i, n = mParams.GetSize(), pos = startPos;
+
+  if (mLockFreeStateRestore)
+  {
+    // stage a complete set of values, the audio thread adopts it at the next block boundary
+    double* pValues = mParamStateExchange.BeginWrite();
+
+    for (i = 0; i < n; ++i)
+    {
+      IParam* pParam = mParams.Get(i);
+      double v = pParam->Value();
+
+      if (pos >= 0)
+        pos = chunk.Get(&v, pos);
+
+      pValues[i] = pParam->Constrain(v);
+      Trace(TRACELOC, "%d %s %f", i, pParam->GetName(), pValues[i]);
+    }
+
+    mParamStateExchange.EndWrite();
+
+    // if the host has deactivated processing, adopt the values now rather than leaving them for the idle timer
+    AdoptPendingParamStateIfInactive();
+
+    return pos;
+  }
+
   ENTER_PARAMS_MUTEX
   for (i = 0; i < n && pos >= 0; ++i)
   {
@@ -136,6 +182,88 @@ int IPluginBase::UnserializeParams(const IByteChunk& chunk, int startPos)
   return pos;
 }
 
+void IPluginBase::SetLockFreeStateRestore(bool enable)
+{
+  mLockFreeStateRestore = enable;
+
+  if (enable)
+    mParamStateExchange.Resize(NParams());
+}
+
+bool IPluginBase::GetPendingParamState(double* pValues) const
+{
+  return mLockFreeStateRestore && mParamStateExchange.GetPending(pValues);
+}
+
+void IPluginBase::CallOnRestoreState()
+{
+  // with lock-free state restore, the idle timer calls OnRestoreState() once the restored values have been adopted
+  if (!mLockFreeStateRestore)
+    OnRestoreState();
+}
+
+bool IPluginBase::ProcessPendingParamState()
+{
+  if (!mLockFreeStateRestore)
+    return false;
+
+  return AdoptPendingParamState();
+}
+
+void IPluginBase::SetProcessingActive(bool active)
+{
+  const int newState = active ? kProcessingActive : kProcessingInactive;
+  int state = mProcessingState.load(std::memory_order_acquire);
+
+  while (!(state != kProcessingInactiveAdopting && mProcessingState.compare_exchange_weak(state, newState, std::memory_order_acq_rel)))
+  {
+    // the main thread is adopting a restored state, the host must not process until it has finished
+    if (state == kProcessingInactiveAdopting)
+    {
+      std::this_thread::yield();
+      state = mProcessingState.load(std::memory_order_acquire);
+    }
+  }
+}
+
+bool IPluginBase::AdoptPendingParamStateIfInactive()
+{
+  int state = kProcessingInactive;
+
+  if (!mProcessingState.compare_exchange_strong(state, kProcessingInactiveAdopting, std::memory_order_acq_rel))
+    return false;
+
+  const bool adopted = AdoptPendingParamState();
+  mProcessingState.store(kProcessingInactive, std::memory_order_release);
+
+  return adopted;
+}
+
+bool IPluginBase::AdoptPendingParamState()
+{
+  const double* pValues = mParamStateExchange.BeginAdopt();
+
+  if (!pValues)
+    return false;
+
+  int i, n = mParams.GetSize();
+
+  for (i = 0; i < n; ++i)
+  {
+    mParams.Get(i)->Set(pValues[i]);
+  }
+
+  for (i = 0; i < n; ++i)
+  {
+    OnParamChange(i, kPresetRecall);
+  }
+
+  mParamStateExchange.EndAdopt();
+  mParamStateAdopted.store(true, std::memory_order_release);
+
+  return true;
+}
+
 void IPluginBase::InitParamRange(int startIdx, int endIdx, int countStart, const char* nameFmtStr, double defaultVal, double minVal, double maxVal, double step, const char *label, int flags, const char *group, const IParam::Shape& shape, IParam::EParamUnit unit, IParam::DisplayFunc displayFunc)
 {
   WDL_String nameStr;
@@ -431,7 +559,7 @@ bool IPluginBase::RestorePreset(int idx)
     {
       mCurrentPresetIdx = idx;
       OnPresetsModified();
-      OnRestoreState();
+      CallOnRestoreState();
     }
   }
   return restoredOK;
@@ -19,6 +19,7 @@
 #include "IPlugParameter.h"
 #include "IPlugStructs.h"
 #include "IPlugLogger.h"
+#include "IPlugParamStateExchange.h"
 
 BEGIN_IPLUG_NAMESPACE
 
@@ -144,6 +145,36 @@ public:
    * @param startPos The position in the chunk where the data starts
    * @return The new chunk position (endPos)*/
   virtual int UnserializeState(const IByteChunk& chunk, int startPos) { TRACE return UnserializeParams(chunk, startPos); }
+
+  /** Call this in your plug-in constructor, after the parameters have been initialized, so that restoring state never blocks the audio thread.
+   * UnserializeParams() then prepares a complete set of parameter values which the audio thread adopts at the start of the next block,
+   * calling OnParamChange() with kPresetRecall for every parameter. The user interface is updated, and OnRestoreState() called, on the next idle timer tick.
+   * While the host has deactivated processing (see SetProcessingActive()), the values are adopted straight away by UnserializeParams(), or by the idle timer.
+   * This replaces ENTER_PARAMS_MUTEX for state restore, so PARAMS_MUTEX should not be defined when using it.
+   * @param enable \c true to defer state restore to the audio thread */
+  void SetLockFreeStateRestore(bool enable);
+
+  /** @return \c true if lock-free state restore has been enabled, see SetLockFreeStateRestore() */
+  bool GetLockFreeStateRestore() const { return mLockFreeStateRestore; }
+
+  /** With lock-free state restore, gets the parameter values staged by UnserializeParams() that have not been adopted yet, so that the API class can report them to the host. Not realtime safe
+   * @param pValues Destination for NParams() non-normalized values
+   * @return \c true if there was a staged state to copy, otherwise the parameters already hold the restored values */
+  bool GetPendingParamState(double* pValues) const;
+
+  /** Called by the API class after the host has restored state with UnserializeState(), instead of calling OnRestoreState() directly.
+   * With lock-free state restore the parameters may not hold the restored values yet, so OnRestoreState() is called by the idle timer once they have been adopted */
+  void CallOnRestoreState();
+
+  /** Called by the API class on the audio thread at the start of every block, before host parameter changes are handled, in order to adopt parameter values staged by UnserializeParams(). Never blocks.
+   * @return \c true if a new set of parameter values was adopted */
+  bool ProcessPendingParamState();
+
+  /** Called by the API class, on a non-realtime thread, when the host activates or deactivates processing.
+   * While processing is inactive a restored state is adopted on the main thread, so this waits for such an adoption to finish before reporting that processing is active.
+   * APIs that never call this are treated as always processing, so that restored state is only ever adopted on the audio thread
+   * @param active \c false if the host has promised not to call the audio callback until processing is activated again */
+  void SetProcessingActive(bool active);
   
   /** VST3 ONLY! - THIS IS ONLY INCLUDED FOR COMPATIBILITY - NOONE ELSE SHOULD NEED IT!
    * @param chunk The output bytechunk where data can be serialized.
@@ -390,6 +421,14 @@ public:
   friend class IPlugAPIBase;
   
 private:
+  /** Apply a staged parameter state, on whichever thread wins the adoption try-lock */
+  bool AdoptPendingParamState();
+
+  /** Called on a non-realtime thread. Adopts a staged parameter state only if processing is inactive, claiming mProcessingState so that processing can't be activated in the meantime */
+  bool AdoptPendingParamStateIfInactive();
+
+  enum EProcessingState { kProcessingActive, kProcessingInactive, kProcessingInactiveAdopting };
+
   int mCurrentPresetIdx = 0;
   /** \c true if the plug-in does opaque state chunks. If false the host will provide a default interface */
   bool mStateChunks = false;
@@ -421,6 +460,14 @@ private:
   WDL_PtrList<const char> mParamGroups;
   /** "Baked in" Factory presets */
   WDL_PtrList<IPreset> mPresets;
+  /** \c true if parameter state restore is handed to the audio thread rather than using ENTER_PARAMS_MUTEX */
+  bool mLockFreeStateRestore = false;
+  /** Parameter values prepared by UnserializeParams() for adoption on the audio thread */
+  mutable IParamStateExchange mParamStateExchange;
+  /** One of EProcessingState, set by SetProcessingActive() and claimed by AdoptPendingParamStateIfInactive() */
+  std::atomic<int> mProcessingState{kProcessingActive};
+  /** Set when a parameter state has been adopted and the user interface needs updating */
+  std::atomic<bool> mParamStateAdopted{false};
 
 #ifdef PARAMS_MUTEX
   friend class IPlugVST3ProcessorBase;
@@ -269,6 +269,12 @@ void IPlugProcessor::SetChannelLabel(ERoute direction, int idx, const char* form
     mChannelData[direction].Get(idx)->mLabel.SetFormatted(MAX_CHAN_NAME_LEN, formatStr, idx+(!zeroBased));
 }
 
+void IPlugProcessor::SetSampleAccurateAutomation(bool enable, int maxChangesPerBlock)
+{
+  mSampleAccurateAutomation = enable;
+  mParamChanges.Resize(enable ? maxChangesPerBlock : 0);
+}
+
 void IPlugProcessor::SetLatency(int samples)
 {
   mLatency = samples;
@@ -115,6 +115,19 @@ public:
   /** @return \c true if the plugin is currently rendering off-line */
   bool GetRenderingOffline() const { return mRenderingOffline; };
 
+  /** Call this (e.g. in your plug-in constructor) in order to receive every host automation point in a block, rather than only the last one.
+   * The points are available in time order via GetParamChanges() during ProcessBlock(), so that you can run large buffers and still follow dense automation precisely.
+   * Parameter values are still set to the last point in the block before ProcessBlock() is called. Currently only supported by VST3 and the command-line render host.
+   * @param enable \c true to enable sample accurate automation
+   * @param maxChangesPerBlock The maximum number of automation points per block, any further points will be dropped from the list */
+  void SetSampleAccurateAutomation(bool enable, int maxChangesPerBlock = DEFAULT_MAX_PARAM_CHANGES);
+
+  /** @return \c true if sample accurate automation has been enabled with SetSampleAccurateAutomation() */
+  bool GetSampleAccurateAutomation() const { return mSampleAccurateAutomation; }
+
+  /** @return A time ordered list of the host automation points for the current block. Only valid during ProcessBlock(), and only populated if sample accurate automation is enabled */
+  const IParamChangeList& GetParamChanges() const { return mParamChanges; }
+
 #pragma mark -
   /** @return The number of samples elapsed since start of project timeline. */
   double GetSamplePos() const { return mTimeInfo.mSamplePos; }
@@ -306,6 +319,10 @@ protected: // these members are protected because they need to be access by the
   std::unique_ptr<NChanDelayLine<sample>> mLatencyDelay = nullptr;
   /** Contains detailed information about the transport state */
   ITimeInfo mTimeInfo;
+  /** \c true if every host automation point should be added to mParamChanges */
+  bool mSampleAccurateAutomation = false;
+  /** Time ordered host automation points for the current block, when sample accurate automation is enabled */
+  IParamChangeList mParamChanges;
 };
 
 END_IPLUG_NAMESPACE
@@ -15,6 +15,7 @@
  * @copydoc IPlugQueue
  */
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 
@@ -26,13 +27,18 @@ BEGIN_IPLUG_NAMESPACE
 
 /** A lock-free SPSC queue used to transfer data between threads
  * based on MLQueue.h by Randy Jones
- * based on https://kjellkod.wordpress.com/2012/11/28/c-debt-paid-in-full-wait-free-lock-free-queue/ */
+ * based on https://kjellkod.wordpress.com/2012/11/28/c-debt-paid-in-full-wait-free-lock-free-queue/
+ * The capacity is rounded up to a power of two so that indices can be masked rather than wrapped with a modulo.
+ * The read and write indices live on separate cache lines, and each side keeps a cached copy of the other side's index,
+ * so that the shared index is only reloaded when the queue looks full (producer) or empty (consumer).
+ * As well as copying single elements, elements can be pushed and popped in bulk,
+ * or written and read in place via WriteSlot()/CommitWrite() and ReadSlot()/CommitRead() to avoid copying large elements */
 template<typename T>
 class IPlugQueue final
 {
 public:
-  /** IPlugQueue constructor 
-   * @param size \todo */
+  /** IPlugQueue constructor
+   * @param size The minimum number of elements the queue can hold */
   IPlugQueue(int size)
   {
     Resize(size);
@@ -42,93 +48,202 @@ public:
 
   IPlugQueue(const IPlugQueue&) = delete;
   IPlugQueue& operator=(const IPlugQueue&) = delete;
-    
-  /** \todo 
-   * @param size \todo */
+
+  /** Set the capacity of the queue and empty it. Not thread safe
+   * @param size The minimum number of elements the queue can hold, rounded up to a power of two */
   void Resize(int size)
   {
-    mData.Resize(size + 1);
+    size_t capacity = 1;
+    while (capacity < static_cast<size_t>(size > 0 ? size : 1))
+      capacity <<= 1;
+
+    mData.Resize(static_cast<int>(capacity));
+    mMask = capacity - 1;
+    mWriteIndex.store(0);
+    mReadIndex.store(0);
+    mCachedReadIndex = 0;
+    mCachedWriteIndex = 0;
+  }
+
+  /** @return The number of elements the queue can hold */
+  size_t Capacity() const
+  {
+    return mMask + 1;
   }
 
-  /** \todo 
-   * @param item \todo
-   * @return true \todo
-   * @return false \todo */
+  /** Push an element onto the queue. Producer thread only
+   * @param item The element to copy into the queue
+   * @return true if the element was pushed
+   * @return false if the queue was full */
   bool Push(const T& item)
   {
-    const auto currentWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
-    const auto nextWriteIndex = Increment(currentWriteIndex);
-    if(nextWriteIndex != mReadIndex.load(std::memory_order_acquire))
-    {
-      mData.Get()[currentWriteIndex] = item;
-      mWriteIndex.store(nextWriteIndex, std::memory_order_release);
-      return true;
-    }
-    return false;
+    T* pSlot = WriteSlot();
+
+    if (!pSlot)
+      return false;
+
+    *pSlot = item;
+    CommitWrite();
+    return true;
   }
 
-  /** \todo 
-   * @param item \todo
-   * @return true \todo
-   * @return false \todo */
+  /** Pop an element off the queue. Consumer thread only
+   * @param item Destination for the element
+   * @return true if an element was popped
+   * @return false if the queue was empty */
   bool Pop(T& item)
   {
-    const auto currentReadIndex = mReadIndex.load(std::memory_order_relaxed);
-    if(currentReadIndex == mWriteIndex.load(std::memory_order_acquire))
-    {
-      return false; // empty the queue
-    }
-    item = mData.Get()[currentReadIndex];
-    mReadIndex.store(Increment(currentReadIndex), std::memory_order_release);
+    const T* pSlot = ReadSlot();
+
+    if (!pSlot)
+      return false;
+
+    item = *pSlot;
+    CommitRead();
     return true;
   }
 
-  /** \todo 
-   * @return size_t \todo */
+  /** Push several elements onto the queue, publishing them all at once. Producer thread only
+   * @param pItems Pointer to the elements to push
+   * @param nItems The number of elements in pItems
+   * @return The number of elements pushed, which is less than nItems if the queue became full */
+  int PushN(const T* pItems, int nItems)
+  {
+    const auto writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+    const size_t nFree = NFreeForWrite(writeIndex, static_cast<size_t>(nItems));
+    const size_t n = std::min(nFree, static_cast<size_t>(nItems));
+    T* pData = mData.Get();
+
+    for (size_t i = 0; i < n; i++)
+      pData[(writeIndex + i) & mMask] = pItems[i];
+
+    mWriteIndex.store(writeIndex + n, std::memory_order_release);
+    return static_cast<int>(n);
+  }
+
+  /** Pop several elements off the queue, releasing their slots all at once. Consumer thread only
+   * @param pItems Destination for up to maxItems elements
+   * @param maxItems The maximum number of elements to pop
+   * @return The number of elements popped */
+  int PopN(T* pItems, int maxItems)
+  {
+    const auto readIndex = mReadIndex.load(std::memory_order_relaxed);
+    const size_t nAvailable = NAvailableForRead(readIndex, static_cast<size_t>(maxItems));
+    const size_t n = std::min(nAvailable, static_cast<size_t>(maxItems));
+    const T* pData = mData.Get();
+
+    for (size_t i = 0; i < n; i++)
+      pItems[i] = pData[(readIndex + i) & mMask];
+
+    mReadIndex.store(readIndex + n, std::memory_order_release);
+    return static_cast<int>(n);
+  }
+
+  /** Reserve the next slot for writing in place, avoiding a copy of the element. Producer thread only.
+   * The slot is not visible to the consumer until CommitWrite() is called, and holds whatever element last used it
+   * @return Pointer to the slot, or nullptr if the queue is full */
+  T* WriteSlot()
+  {
+    const auto writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+
+    if (!NFreeForWrite(writeIndex, 1))
+      return nullptr;
+
+    return &mData.Get()[writeIndex & mMask];
+  }
+
+  /** Publish the slot obtained with a successful call to WriteSlot(). Producer thread only */
+  void CommitWrite()
+  {
+    mWriteIndex.store(mWriteIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /** Get the next element for reading in place, avoiding a copy of the element. Consumer thread only.
+   * The slot is not reused by the producer until CommitRead() is called
+   * @return Pointer to the element, or nullptr if the queue is empty */
+  const T* ReadSlot()
+  {
+    const auto readIndex = mReadIndex.load(std::memory_order_relaxed);
+
+    if (!NAvailableForRead(readIndex, 1))
+      return nullptr;
+
+    return &mData.Get()[readIndex & mMask];
+  }
+
+  /** Release the element obtained with a successful call to ReadSlot(). Consumer thread only */
+  void CommitRead()
+  {
+    mReadIndex.store(mReadIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /** @return The number of elements that can be popped. Consumer thread only */
   size_t ElementsAvailable() const
   {
-    return (mWriteIndex.load(std::memory_order_acquire) - mReadIndex.load(std::memory_order_relaxed))%mData.GetSize();
+    return mWriteIndex.load(std::memory_order_acquire) - mReadIndex.load(std::memory_order_relaxed);
   }
 
-  /** \todo
+  /** Get the next element without popping it. Consumer thread only, and only valid if ElementsAvailable() is non-zero
    * useful for reading elements while a criterion is met. Can be used like
    * while IPlugQueue.ElementsAvailable() && q.peek().mTime < 100 { elem = q.pop() ... }
-   * @return const T& \todo */
+   * @return const T& The next element */
   const T& Peek()
   {
     const auto currentReadIndex = mReadIndex.load(std::memory_order_relaxed);
-    return mData.Get()[currentReadIndex];
+    return mData.Get()[currentReadIndex & mMask];
   }
 
-  /** \todo 
-   * @return true \todo
-   * @return false \todo */
+  /** @return true if the queue was empty at the time of the call */
   bool WasEmpty() const
   {
     return (mWriteIndex.load() == mReadIndex.load());
   }
 
-  /** \todo 
-   * @return true \todo
-   * @return false \todo */
+  /** @return true if the queue was full at the time of the call */
   bool WasFull() const
   {
-    const auto nextWriteIndex = Increment(mWriteIndex.load());
-    return (nextWriteIndex == mReadIndex.load());
+    return (mWriteIndex.load() - mReadIndex.load()) > mMask;
   }
 
 private:
-  /** \todo 
-   * @param idx \todo
-   * @return size_t \todo */
-  size_t Increment(size_t idx) const
+  static constexpr size_t kCacheLineSize = 64;
+
+  /** @return The number of free slots, reloading the consumer's index only if fewer than nWanted slots appear free */
+  size_t NFreeForWrite(size_t writeIndex, size_t nWanted)
   {
-    return (idx + 1) % (mData.GetSize());
+    size_t nFree = Capacity() - (writeIndex - mCachedReadIndex);
+
+    if (nFree < nWanted)
+    {
+      mCachedReadIndex = mReadIndex.load(std::memory_order_acquire);
+      nFree = Capacity() - (writeIndex - mCachedReadIndex);
+    }
+
+    return nFree;
+  }
+
+  /** @return The number of readable elements, reloading the producer's index only if fewer than nWanted elements appear available */
+  size_t NAvailableForRead(size_t readIndex, size_t nWanted)
+  {
+    size_t nAvailable = mCachedWriteIndex - readIndex;
+
+    if (nAvailable < nWanted)
+    {
+      mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+      nAvailable = mCachedWriteIndex - readIndex;
+    }
+
+    return nAvailable;
   }
 
   WDL_TypedBuf<T> mData;
-  std::atomic<size_t> mWriteIndex{0};
-  std::atomic<size_t> mReadIndex{0};
+  size_t mMask = 0;
+
+  // indices increase monotonically and are masked on access, each side's data is on its own cache line
+  alignas(kCacheLineSize) std::atomic<size_t> mWriteIndex{0};
+  size_t mCachedReadIndex = 0; // owned by the producer
+  alignas(kCacheLineSize) std::atomic<size_t> mReadIndex{0};
+  size_t mCachedWriteIndex = 0; // owned by the consumer
 };
 
 END_IPLUG_NAMESPACE
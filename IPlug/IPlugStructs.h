@@ -40,6 +40,79 @@ struct ParamTuple
   {}
 };
 
+/** A single host automation point for a parameter, used when sample accurate automation is enabled. See IPlugProcessor::SetSampleAccurateAutomation() */
+struct IParamChange
+{
+  int mParamIdx;
+  int mOffset;
+  double mNormalizedValue;
+  double mValue;
+
+  IParamChange(int paramIdx = kNoParameter, int offset = 0, double normalizedValue = 0., double value = 0.)
+  : mParamIdx(paramIdx)
+  , mOffset(offset)
+  , mNormalizedValue(normalizedValue)
+  , mValue(value)
+  {}
+};
+
+/** A fixed capacity list of IParamChange events for one processing block, kept in time order.
+ * Memory is only allocated in Resize(), so Add() is safe to call on the audio thread. If the list is full, changes are dropped and counted */
+class IParamChangeList
+{
+public:
+  /** Set the maximum number of changes per block. Allocates, so don't call this on the audio thread */
+  void Resize(int capacity)
+  {
+    mBuf.Resize(capacity);
+    mSize = 0;
+  }
+
+  /** Add a change, keeping the list sorted by offset. Changes with equal offsets stay in the order they were added
+   * @return \c false if the list was full and the change was dropped */
+  bool Add(const IParamChange& change)
+  {
+    if (mSize >= mBuf.GetSize())
+    {
+      mNDropped++;
+      return false;
+    }
+
+    IParamChange* pBuf = mBuf.Get();
+    int i = mSize;
+
+    if (i > 0 && change.mOffset < pBuf[i - 1].mOffset)
+    {
+      i -= 2;
+      while (i >= 0 && change.mOffset < pBuf[i].mOffset) --i;
+      i++;
+      memmove(&pBuf[i + 1], &pBuf[i], (mSize - i) * sizeof(IParamChange));
+    }
+
+    pBuf[i] = change;
+    mSize++;
+    return true;
+  }
+
+  void Clear() { mSize = 0; }
+
+  /** @return The number of changes in this block */
+  int NChanges() const { return mSize; }
+
+  /** @return The maximum number of changes per block */
+  int GetCapacity() const { return mBuf.GetSize(); }
+
+  /** @return The total number of changes that have been dropped because the list was full */
+  int NDropped() const { return mNDropped; }
+
+  const IParamChange& Get(int idx) const { return mBuf.Get()[idx]; }
+
+private:
+  WDL_TypedBuf<IParamChange> mBuf;
+  int mSize = 0;
+  int mNDropped = 0;
+};
+
 /** This structure is used when queueing Sysex messages. You may need to set MAX_SYSEX_SIZE to reflect the max sysex payload in bytes */
 struct SysExData
 {
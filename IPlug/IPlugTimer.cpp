@@ -143,4 +143,9 @@ void Timer_impl::TimerProc(void* userData)
   Timer_impl* itimer = (Timer_impl*) userData;
   itimer->mTimerFunc(*itimer);
 }
+#elif defined OS_LINUX && defined CLI_API
+Timer* Timer::Create(ITimerFunction func, uint32_t intervalMs)
+{
+  return nullptr;
+}
 #endif
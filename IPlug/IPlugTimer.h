@@ -95,6 +95,10 @@ private:
   long ID = 0;
   ITimerFunction mTimerFunc;
 };
+#elif defined OS_LINUX && defined CLI_API
+// The command-line render host has no run loop to attach a timer to, and doesn't need one, so Timer::Create() returns nullptr
+#elif defined OS_LINUX
+  #error Timer is only implemented on Linux for the command-line render host (CLI_API)
 #else
   #error NOT IMPLEMENTED
 #endif
@@ -0,0 +1,185 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc WorkerPool
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "IPlugPlatform.h"
+
+BEGIN_IPLUG_NAMESPACE
+
+/** A pool of worker threads that run queued tasks in first-in, first-out order, for work that should not block the UI thread, such as decoding resources.
+ * Tasks can be enqueued from any thread except the audio thread, since enqueuing locks and allocates.
+ * The destructor runs any tasks that are still queued, then joins the threads. */
+class WorkerPool final
+{
+public:
+  using Task = std::function<void()>;
+
+  /** Constructs a WorkerPool and starts its threads
+   * @param nThreads The number of worker threads, or 0 for one fewer than the number of hardware threads (but at least one, and at most 8) */
+  WorkerPool(int nThreads = 0)
+  {
+    if (nThreads <= 0)
+      nThreads = std::max(1, std::min(8, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+
+    for (auto i = 0; i < nThreads; i++)
+      mThreads.emplace_back([this]() { WorkerLoop(); });
+  }
+
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopping = true;
+    }
+
+    mCondition.notify_all();
+
+    for (auto& thread : mThreads)
+      thread.join();
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  /** Queue a task to run on one of the worker threads
+   * @param task The task */
+  void Enqueue(Task task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mTasks.push_back(std::move(task));
+    }
+
+    mCondition.notify_one();
+  }
+
+  /** @return The number of worker threads */
+  int NThreads() const { return static_cast<int>(mThreads.size()); }
+
+  /** Call a function for each index in [0, n), spread over the worker threads and the calling thread, and return when all the calls have finished.
+   * The calling thread takes indices too, so this completes even if the workers are busy with other tasks
+   * @param n The number of indices
+   * @param func Called with each index, on any of the threads */
+  void ParallelFor(int n, const std::function<void(int idx)>& func)
+  {
+    struct State
+    {
+      std::atomic<int> next { 0 };
+      int done = 0;
+      std::mutex mutex;
+      std::condition_variable finished;
+    };
+
+    auto pState = std::make_shared<State>();
+    const std::function<void(int idx)>* pFunc = &func;
+
+    // N.B. a helper that starts after all the indices are taken returns without touching func, which may be gone by then
+    auto run = [pState, pFunc, n]() {
+      int nDone = 0;
+
+      for (int idx = pState->next++; idx < n; idx = pState->next++, nDone++)
+        (*pFunc)(idx);
+
+      if (nDone)
+      {
+        std::lock_guard<std::mutex> lock(pState->mutex);
+
+        if ((pState->done += nDone) == n)
+          pState->finished.notify_all();
+      }
+    };
+
+    for (auto i = 0; i < std::min(NThreads(), n - 1); i++)
+      Enqueue(run);
+
+    run();
+
+    std::unique_lock<std::mutex> lock(pState->mutex);
+    pState->finished.wait(lock, [&]() { return pState->done == n; });
+  }
+
+  /** Get the pool shared by the whole module, starting it if it isn't running. Each call must be balanced by a call to ReleaseShared().
+   * N.B. the threads are joined by the last ReleaseShared(), rather than at static destruction, where joining can deadlock while a DLL unloads
+   * @return The shared pool */
+  static WorkerPool* RetainShared()
+  {
+    std::lock_guard<std::mutex> lock(SharedMutex());
+
+    if (SharedCount()++ == 0)
+      SharedPool() = std::make_unique<WorkerPool>();
+
+    return SharedPool().get();
+  }
+
+  /** Release the shared pool, stopping it if this was the last user. Tasks that are still queued are run first */
+  static void ReleaseShared()
+  {
+    std::unique_ptr<WorkerPool> pPool;
+
+    {
+      std::lock_guard<std::mutex> lock(SharedMutex());
+
+      if (--SharedCount() == 0)
+        pPool = std::move(SharedPool());
+    }
+
+    // joins outside the lock, so that queued tasks can retain the pool
+  }
+
+private:
+  void WorkerLoop()
+  {
+    while (true)
+    {
+      Task task;
+
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+
+        if (mTasks.empty())
+          return;
+
+        task = std::move(mTasks.front());
+        mTasks.pop_front();
+      }
+
+      task();
+    }
+  }
+
+  static std::mutex& SharedMutex() { static std::mutex sMutex; return sMutex; }
+  static int& SharedCount() { static int sCount = 0; return sCount; }
+  static std::unique_ptr<WorkerPool>& SharedPool() { static std::unique_ptr<WorkerPool> sPool; return sPool; }
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::deque<Task> mTasks;
+  std::vector<std::thread> mThreads;
+  bool mStopping = false;
+};
+
+END_IPLUG_NAMESPACE
@@ -69,6 +69,10 @@
 #elif defined WEB_API
   #include "IPlugWeb.h"
   #define PLUGIN_API_BASE IPlugWeb
+#elif defined CLI_API
+  #include "IPlugCLI.h"
+  #define PLUGIN_API_BASE IPlugCLI
+  #define API_EXT "cli"
 #elif defined VST3_API
   #define IPLUG_VST3
   #include "IPlugVST3.h"
@@ -104,7 +108,8 @@ END_IPLUG_NAMESPACE
   #define BUNDLE_ID BUNDLE_DOMAIN "." BUNDLE_MFR "." BUNDLE_NAME API_EXT2
   #define EXPORT __attribute__ ((visibility("default")))
 #elif defined OS_LINUX
-  //TODO:
+  #define BUNDLE_ID ""
+  #define EXPORT __attribute__ ((visibility("default")))
 #elif defined OS_WEB
   #define BUNDLE_ID ""
 #else
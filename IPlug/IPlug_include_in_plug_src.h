@@ -269,7 +269,7 @@
     
     return 0;
   }
-#elif defined AUv3_API || defined AAX_API || defined APP_API
+#elif defined AUv3_API || defined AAX_API || defined APP_API || defined CLI_API
 // Nothing to do here
 #else
   #error "No API defined!"
@@ -280,9 +280,9 @@
 BEGIN_IPLUG_NAMESPACE
 
 #pragma mark -
-#pragma mark VST2, VST3, AAX, AUv3, APP, WAM, WEB
+#pragma mark VST2, VST3, AAX, AUv3, APP, WAM, WEB, CLI
 
-#if defined VST2_API || defined VST3_API || defined AAX_API || defined AUv3_API || defined APP_API  || defined WAM_API || defined WEB_API
+#if defined VST2_API || defined VST3_API || defined AAX_API || defined AUv3_API || defined APP_API  || defined WAM_API || defined WEB_API || defined CLI_API
 
 Plugin* MakePlug(const InstanceInfo& info)
 {
@@ -18,7 +18,10 @@
 
 #include "IPlugPlatform.h"
 #include "IPlugQueue.h"
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <vector>
 
 BEGIN_IPLUG_NAMESPACE
 
@@ -68,11 +71,12 @@ public:
    *  This must be called on the main thread - typically in MyPlugin::OnIdle() */
   void TransmitData(IEditorDelegate& dlg)
   {
-    while(mQueue.ElementsAvailable())
+    const ISenderData<MAXNC, T>* pData;
+
+    while((pData = mQueue.ReadSlot()))
     {
-      ISenderData<MAXNC, T> d;
-      mQueue.Pop(d);
-      dlg.SendControlMsgFromDelegate(d.ctrlTag, kUpdateMessage, sizeof(ISenderData<MAXNC, T>), (void*) &d);
+      dlg.SendControlMsgFromDelegate(pData->ctrlTag, kUpdateMessage, sizeof(ISenderData<MAXNC, T>), (void*) pData);
+      mQueue.CommitRead();
     }
   }
 
@@ -163,4 +167,171 @@ protected:
   float mPreviousSum = 1.f;
 };
 
+/** ISenderRingData is sent to controls by IRingBufferSender. Rather than containing the samples, it describes a window onto the sender's ring buffer,
+ * which the control reads in place. The audio thread may overwrite the ring while it is being read, so check IsIntact() after reading.
+ * It is only valid for the duration of IControl::OnMsgFromDelegate(), and only when the editor runs in the same process as the processor */
+struct ISenderRingData
+{
+  int nChans = 0;
+  int chanOffset = 0;
+  int ringSize = 0; // a power of two
+  const float* const* pChannels = nullptr; // the ring for each of the nChans channels
+  const std::atomic<uint64_t>* pReservedPos = nullptr; // the frame position the audio thread may be writing up to
+  uint64_t endPos = 0; // the total number of frames written when the message was sent, doubles as a sequence number
+
+  /** Get the most recent frames of a channel in place. The window is split in two segments where the ring wraps
+   * @param chan The channel, in the range [0, nChans)
+   * @param nFrames The number of frames wanted, clipped to the ring size and the number of frames ever written
+   * @param pSeg1 The oldest frames of the window
+   * @param nSeg1 The number of frames in pSeg1
+   * @param pSeg2 The newest frames of the window, if it wraps
+   * @param nSeg2 The number of frames in pSeg2
+   * @return The number of frames in the window */
+  int GetWindow(int chan, int nFrames, const float*& pSeg1, int& nSeg1, const float*& pSeg2, int& nSeg2) const
+  {
+    const uint64_t n = std::min<uint64_t>(std::min(nFrames, ringSize), endPos);
+    const int start = static_cast<int>((endPos - n) & static_cast<uint64_t>(ringSize - 1));
+    nSeg1 = std::min(static_cast<int>(n), ringSize - start);
+    nSeg2 = static_cast<int>(n) - nSeg1;
+    pSeg1 = pChannels[chan] + start;
+    pSeg2 = pChannels[chan];
+    return static_cast<int>(n);
+  }
+
+  /** Copy the most recent frames of a channel. If fewer than nFrames have ever been written, the start of pDest is zeroed
+   * @param chan The channel, in the range [0, nChans)
+   * @param pDest Destination for nFrames frames
+   * @param nFrames The number of frames to copy, which should not exceed ringSize */
+  void CopyLatest(int chan, float* pDest, int nFrames) const
+  {
+    const float* pSeg1;
+    const float* pSeg2;
+    int nSeg1, nSeg2;
+    const int n = GetWindow(chan, nFrames, pSeg1, nSeg1, pSeg2, nSeg2);
+    const int nZeros = nFrames - n;
+
+    std::fill(pDest, pDest + nZeros, 0.f);
+    std::copy(pSeg1, pSeg1 + nSeg1, pDest + nZeros);
+    std::copy(pSeg2, pSeg2 + nSeg2, pDest + nZeros + nSeg1);
+  }
+
+  /** Check that a window read with GetWindow() or CopyLatest() was not overwritten by the audio thread while it was being read
+   * @param nFrames The number of frames that were read
+   * @return \c true if the data read is consistent */
+  bool IsIntact(int nFrames) const
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t windowStart = endPos - std::min<uint64_t>(nFrames, endPos);
+    return pReservedPos->load(std::memory_order_relaxed) <= windowStart + static_cast<uint64_t>(ringSize);
+  }
+};
+
+/** IRingBufferSender is a utility class which can be used to make buffer data available to the GUI without copying it through a queue.
+ * The audio thread writes samples directly into a ring buffer per channel, and the controls read the most recent window in place, see ISenderRingData.
+ * Only suitable when the editor runs in the same process as the processor
+ * @tparam MAXNC The maximum number of channels
+ * @tparam RINGSIZE The number of frames in the ring for each channel, which must be a power of two */
+template <int MAXNC = 1, int RINGSIZE = 8192>
+class IRingBufferSender
+{
+public:
+  static_assert(RINGSIZE > 0 && (RINGSIZE & (RINGSIZE - 1)) == 0, "RINGSIZE must be a power of two");
+
+  static constexpr int kUpdateMessage = 1;
+
+  IRingBufferSender()
+  : mRing(static_cast<size_t>(MAXNC) * RINGSIZE, 0.f)
+  {
+    for (auto c = 0; c < MAXNC; c++)
+      mChannelPtrs[c] = mRing.data() + (static_cast<size_t>(c) * RINGSIZE);
+  }
+
+  IRingBufferSender(const IRingBufferSender&) = delete;
+  IRingBufferSender& operator=(const IRingBufferSender&) = delete;
+
+  /** Write sample buffers into the ring, skipping blocks that are silent, like IBufferSender. This can be called on the realtime audio thread. */
+  void ProcessBlock(sample** inputs, int nFrames, int ctrlTag, int nChans = MAXNC, int chanOffset = 0)
+  {
+    nChans = std::min(nChans, MAXNC);
+    float sum = 0.f;
+
+    for (auto c = 0; c < nChans; c++)
+    {
+      for (auto s = 0; s < nFrames; s++)
+        sum += std::fabs((float) inputs[chanOffset + c][s]);
+    }
+
+    sum /= (float) std::max(nFrames, 1);
+
+    const bool send = sum > SENDER_THRESHOLD || mPreviousSum > SENDER_THRESHOLD;
+    mPreviousSum = sum;
+
+    if (!send || nFrames < 1)
+      return;
+
+    // only the most recent RINGSIZE frames of a long block can be kept
+    const int nToWrite = std::min(nFrames, RINGSIZE);
+    const int srcOffset = nFrames - nToWrite;
+    const uint64_t writePos = mWritePos.load(std::memory_order_relaxed);
+
+    mCtrlTag.store(ctrlTag, std::memory_order_relaxed);
+    mNChans.store(nChans, std::memory_order_relaxed);
+    mChanOffset.store(chanOffset, std::memory_order_relaxed);
+
+    // announce which frames are about to be overwritten before writing them, so readers can detect an overrun
+    mReservedPos.store(writePos + nToWrite, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const int start = static_cast<int>(writePos & (RINGSIZE - 1));
+    const int nSeg1 = std::min(nToWrite, RINGSIZE - start);
+
+    for (auto c = 0; c < nChans; c++)
+    {
+      const sample* pIn = inputs[chanOffset + c] + srcOffset;
+      float* pRing = mChannelPtrs[c];
+
+      for (auto s = 0; s < nSeg1; s++)
+        pRing[start + s] = (float) pIn[s];
+
+      for (auto s = nSeg1; s < nToWrite; s++)
+        pRing[s - nSeg1] = (float) pIn[s];
+    }
+
+    mWritePos.store(writePos + nToWrite, std::memory_order_release);
+  }
+
+  /** Sends a message describing the latest window to the control, if new frames were written since the last call.
+   *  This must be called on the main thread - typically in MyPlugin::OnIdle() */
+  void TransmitData(IEditorDelegate& dlg)
+  {
+    const uint64_t writePos = mWritePos.load(std::memory_order_acquire);
+
+    if (writePos == mLastTransmittedPos)
+      return;
+
+    mLastTransmittedPos = writePos;
+
+    ISenderRingData d;
+    d.nChans = mNChans.load(std::memory_order_relaxed);
+    d.chanOffset = mChanOffset.load(std::memory_order_relaxed);
+    d.ringSize = RINGSIZE;
+    d.pChannels = mChannelPtrs.data();
+    d.pReservedPos = &mReservedPos;
+    d.endPos = writePos;
+
+    dlg.SendControlMsgFromDelegate(mCtrlTag.load(std::memory_order_relaxed), kUpdateMessage, sizeof(ISenderRingData), (void*) &d);
+  }
+
+private:
+  std::vector<float> mRing;
+  std::array<float*, MAXNC> mChannelPtrs {};
+  std::atomic<uint64_t> mWritePos {0};
+  std::atomic<uint64_t> mReservedPos {0};
+  std::atomic<int> mCtrlTag {kNoTag};
+  std::atomic<int> mNChans {MAXNC};
+  std::atomic<int> mChanOffset {0};
+  float mPreviousSum = 1.f;
+  uint64_t mLastTransmittedPos = 0;
+};
+
 END_IPLUG_NAMESPACE
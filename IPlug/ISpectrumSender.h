@@ -0,0 +1,340 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+#pragma once
+
+/**
+ * @file
+ * @copydoc ISpectrumSender
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "fft.h"
+
+#include "IPlugPlatform.h"
+#include "IPlugQueue.h"
+#include "ISender.h"
+
+#if defined OS_WIN
+#include <windows.h>
+#elif defined OS_MAC || defined OS_IOS
+#include <pthread.h>
+#endif
+
+BEGIN_IPLUG_NAMESPACE
+
+/** ISpectrumSender is a utility class which can be used to send magnitude spectra to the GUI, for analyser controls such as IVSpectrumControl.
+ * The audio thread only copies samples into a lock-free queue. A low-priority worker thread windows overlapping frames, transforms them with WDL_real_fft()
+ * and reduces the bins to NPOINTS log-frequency display points (in dB), so only NPOINTS values per channel are sent to the control.
+ * Where the worker can't keep up with the audio thread, samples are dropped rather than blocking. On the web, where there is no worker thread,
+ * the analysis happens in TransmitData().
+ * NOTE: WDL/fft.c must be compiled into the project.
+ * @tparam MAXNC The maximum number of channels
+ * @tparam NPOINTS The number of display points per channel */
+template <int MAXNC = 1, int NPOINTS = 128>
+class ISpectrumSender : public ISender<MAXNC, 4, std::array<float, NPOINTS>>
+{
+public:
+  /** The window function applied to each frame before the FFT */
+  enum class EWindowType
+  {
+    Rectangular,
+    Hann,
+    BlackmanHarris
+  };
+
+  /** The level sent for display points with no energy */
+  static constexpr float kMinDB = -150.f;
+
+  /** Constructs an ISpectrumSender and starts its worker thread
+   * @param fftSize The FFT size, a power of two between 64 and 32768
+   * @param overlap The number of frames overlapping each sample, the hop size is fftSize / overlap
+   * @param windowType The window function
+   * @param minFreq The frequency of the first display point in Hz
+   * @param maxFreq The frequency of the last display point in Hz */
+  ISpectrumSender(int fftSize = 2048, int overlap = 4, EWindowType windowType = EWindowType::Hann, float minFreq = 20.f, float maxFreq = 20000.f)
+  : mFFTSize(fftSize)
+  , mHopSize(std::max(1, fftSize / std::max(1, overlap)))
+  , mMinFreq(minFreq)
+  , mMaxFreq(maxFreq)
+  , mInputQueue(fftSize * 4)
+  {
+    assert(fftSize >= 64 && fftSize <= 32768 && (fftSize & (fftSize - 1)) == 0);
+
+    WDL_fft_init();
+
+    for (auto& history : mHistory)
+      history.assign(fftSize, 0.f);
+
+    mFFTBuffer.resize(fftSize);
+    mMagnitudes.resize(fftSize / 2 + 1);
+    CalculateWindow(windowType);
+
+#ifndef OS_WEB
+    mRunning.store(true);
+    mThread = std::thread([this]() { WorkerLoop(); });
+#endif
+  }
+
+  ~ISpectrumSender()
+  {
+#ifndef OS_WEB
+    mRunning.store(false);
+
+    if (mThread.joinable())
+      mThread.join();
+#endif
+  }
+
+  ISpectrumSender(const ISpectrumSender&) = delete;
+  ISpectrumSender& operator=(const ISpectrumSender&) = delete;
+
+  /** Set the sample rate used to map FFT bins to display frequencies, e.g. in OnReset()
+   * @param sampleRate The sample rate in Hz */
+  void SetSampleRate(double sampleRate)
+  {
+    mSampleRate.store(sampleRate);
+  }
+
+  /** Queue samples for analysis. This can be called on the realtime audio thread. */
+  void ProcessBlock(sample** inputs, int nFrames, int ctrlTag, int nChans = MAXNC, int chanOffset = 0)
+  {
+    nChans = std::min(nChans, MAXNC);
+    mCtrlTag.store(ctrlTag, std::memory_order_relaxed);
+    mNChans.store(nChans, std::memory_order_relaxed);
+
+    Frame chunk[kChunkSize];
+
+    for (auto s = 0; s < nFrames; s += kChunkSize)
+    {
+      const int n = std::min(kChunkSize, nFrames - s);
+
+      for (auto i = 0; i < n; i++)
+      {
+        for (auto c = 0; c < nChans; c++)
+          chunk[i][c] = (float) inputs[chanOffset + c][s + i];
+      }
+
+      if (mInputQueue.PushN(chunk, n) < n)
+        return; // the worker is behind, drop the rest of the block
+    }
+  }
+
+  /** Sends the latest spectra to the control.
+   *  This must be called on the main thread - typically in MyPlugin::OnIdle() */
+  void TransmitData(IEditorDelegate& dlg)
+  {
+#ifdef OS_WEB
+    ProcessPending();
+#endif
+    ISender<MAXNC, 4, std::array<float, NPOINTS>>::TransmitData(dlg);
+  }
+
+private:
+  using Frame = std::array<float, MAXNC>;
+  static constexpr int kChunkSize = 64;
+
+  void WorkerLoop()
+  {
+#if defined OS_WIN
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined OS_MAC || defined OS_IOS
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+
+    while (mRunning.load(std::memory_order_relaxed))
+    {
+      if (!ProcessPending())
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+
+  /** Consume the queued samples, analysing a frame every mHopSize samples
+   * @return \c true if any samples were consumed */
+  bool ProcessPending()
+  {
+    Frame chunk[kChunkSize];
+    bool consumed = false;
+    int n;
+
+    while ((n = mInputQueue.PopN(chunk, kChunkSize)) > 0)
+    {
+      consumed = true;
+
+      for (auto i = 0; i < n; i++)
+      {
+        for (auto c = 0; c < MAXNC; c++)
+          mHistory[c][mHistoryPos] = chunk[i][c];
+
+        mHistoryPos = (mHistoryPos + 1) & (mFFTSize - 1);
+
+        if (++mHopCount == mHopSize)
+        {
+          mHopCount = 0;
+          Analyse();
+        }
+      }
+    }
+
+    return consumed;
+  }
+
+  void Analyse()
+  {
+    const double sampleRate = mSampleRate.load();
+
+    if (sampleRate != mMappedSampleRate)
+      CalculatePointMapping(sampleRate);
+
+    const int nChans = mNChans.load(std::memory_order_relaxed);
+    const int half = mFFTSize / 2;
+    const int* pPermute = WDL_fft_permute_tab(half);
+    mOutput.ctrlTag = mCtrlTag.load(std::memory_order_relaxed);
+    mOutput.nChans = nChans;
+    mOutput.chanOffset = 0;
+
+    for (auto c = 0; c < nChans; c++)
+    {
+      // oldest sample first
+      for (auto i = 0; i < mFFTSize; i++)
+        mFFTBuffer[i] = mHistory[c][(mHistoryPos + i) & (mFFTSize - 1)] * mWindow[i];
+
+      WDL_real_fft(mFFTBuffer.data(), mFFTSize, 0);
+
+      const WDL_FFT_COMPLEX* pBins = reinterpret_cast<const WDL_FFT_COMPLEX*>(mFFTBuffer.data());
+      mMagnitudes[0] = std::fabs(pBins[0].re) * mWindowScale * 0.5f;
+      mMagnitudes[half] = std::fabs(pBins[0].im) * mWindowScale * 0.5f;
+
+      for (auto k = 1; k < half; k++)
+      {
+        const WDL_FFT_COMPLEX& bin = pBins[pPermute[k]];
+        mMagnitudes[k] = std::sqrt(bin.re * bin.re + bin.im * bin.im) * mWindowScale;
+      }
+
+      for (auto p = 0; p < NPOINTS; p++)
+      {
+        const PointMapping& m = mPointMapping[p];
+        float mag;
+
+        if (m.firstBin > m.lastBin)
+        {
+          // fewer bins than display points at low frequencies, interpolate
+          const int bin = std::min(static_cast<int>(m.centreBin), half - 1);
+          const float frac = m.centreBin - (float) bin;
+          mag = mMagnitudes[bin] + (mMagnitudes[bin + 1] - mMagnitudes[bin]) * frac;
+        }
+        else
+        {
+          // keep the peaks when several bins map to one point
+          mag = *std::max_element(mMagnitudes.begin() + m.firstBin, mMagnitudes.begin() + m.lastBin + 1);
+        }
+
+        mOutput.vals[c][p] = std::max(kMinDB, 20.f * std::log10(std::max(mag, 1e-10f)));
+      }
+    }
+
+    ISender<MAXNC, 4, std::array<float, NPOINTS>>::PushData(mOutput);
+  }
+
+  void CalculateWindow(EWindowType windowType)
+  {
+    mWindow.resize(mFFTSize);
+    double sum = 0.;
+
+    for (auto i = 0; i < mFFTSize; i++)
+    {
+      const double x = 2. * PI * (double) i / (double) mFFTSize;
+      double w = 1.;
+
+      switch (windowType)
+      {
+        case EWindowType::Hann: w = 0.5 - 0.5 * std::cos(x); break;
+        case EWindowType::BlackmanHarris: w = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2. * x) - 0.01168 * std::cos(3. * x); break;
+        default: break;
+      }
+
+      mWindow[i] = (float) w;
+      sum += w;
+    }
+
+    // a full scale sine at a bin centre reads 0dB, WDL_real_fft() bins are twice the magnitude of a plain DFT
+    mWindowScale = (float) (1. / sum);
+  }
+
+  void CalculatePointMapping(double sampleRate)
+  {
+    mMappedSampleRate = sampleRate;
+
+    const int half = mFFTSize / 2;
+    const double binsPerHz = (double) mFFTSize / sampleRate;
+    const double maxFreq = std::min((double) mMaxFreq, sampleRate * 0.5);
+    const double minFreq = std::min((double) mMinFreq, maxFreq);
+    const double ratio = maxFreq / minFreq;
+
+    auto pointFreq = [&](double p) {
+      return minFreq * std::pow(ratio, p / (double) std::max(NPOINTS - 1, 1));
+    };
+
+    for (auto p = 0; p < NPOINTS; p++)
+    {
+      // each point covers the bins between the geometric midpoints to its neighbours
+      const double lo = pointFreq(p - 0.5) * binsPerHz;
+      const double hi = pointFreq(p + 0.5) * binsPerHz;
+      PointMapping& m = mPointMapping[p];
+      m.centreBin = (float) Clip(pointFreq(p) * binsPerHz, 0., (double) half);
+      m.firstBin = Clip(static_cast<int>(std::ceil(lo)), 0, half);
+      m.lastBin = Clip(static_cast<int>(std::floor(hi)), 0, half);
+    }
+  }
+
+  struct PointMapping
+  {
+    float centreBin = 0.f;
+    int firstBin = 1;
+    int lastBin = 0;
+  };
+
+  const int mFFTSize;
+  const int mHopSize;
+  const float mMinFreq;
+  const float mMaxFreq;
+
+  // shared between the audio thread and the worker
+  IPlugQueue<Frame> mInputQueue;
+  std::atomic<double> mSampleRate {DEFAULT_SAMPLE_RATE};
+  std::atomic<int> mCtrlTag {kNoTag};
+  std::atomic<int> mNChans {MAXNC};
+
+  // owned by the worker
+  std::array<std::vector<float>, MAXNC> mHistory;
+  int mHistoryPos = 0;
+  int mHopCount = 0;
+  std::vector<WDL_FFT_REAL> mFFTBuffer;
+  std::vector<float> mWindow;
+  std::vector<float> mMagnitudes;
+  float mWindowScale = 1.f;
+  std::array<PointMapping, NPOINTS> mPointMapping;
+  double mMappedSampleRate = 0.;
+  ISenderData<MAXNC, std::array<float, NPOINTS>> mOutput;
+
+#ifndef OS_WEB
+  std::atomic<bool> mRunning {false};
+  std::thread mThread;
+#endif
+};
+
+END_IPLUG_NAMESPACE
@@ -126,6 +126,8 @@ IPlugVST2::IPlugVST2(const InstanceInfo& info, const Config& config)
 {
   Trace(TRACELOC, "%s", config.pluginName);
 
+  SetProcessingActive(false);
+
   mHasVSTExtensions = VSTEXT_NONE;
 
   int nInputs = MaxNChannels(ERoute::kInput), nOutputs = MaxNChannels(ERoute::kOutput);
@@ -442,9 +444,11 @@ VstIntPtr VSTCALLBACK IPlugVST2::VSTDispatcher(AEffect *pEffect, VstInt32 opCode
       {
         _this->OnActivate(false);
         _this->OnReset();
+        _this->SetProcessingActive(false);
       }
       else
       {
+        _this->SetProcessingActive(true);
         _this->OnActivate(true);
       }
       return 0;
@@ -541,7 +545,7 @@ VstIntPtr VSTCALLBACK IPlugVST2::VSTDispatcher(AEffect *pEffect, VstInt32 opCode
 
         if (pos >= 0)
         {
-          _this->OnRestoreState();
+          _this->CallOnRestoreState();
           return 1;
         }
       }
@@ -929,6 +933,8 @@ VstIntPtr VSTCALLBACK IPlugVST2::VSTDispatcher(AEffect *pEffect, VstInt32 opCode
 template <class SAMPLETYPE>
 void IPlugVST2::VSTPreProcess(SAMPLETYPE** inputs, SAMPLETYPE** outputs, VstInt32 nFrames)
 {
+  ProcessPendingParamState();
+
   if (DoesMIDIIn())
     mHostCallback(&mAEffect, __audioMasterWantMidiDeprecated, 0, 0, 0, 0.0f);
 
@@ -32,6 +32,7 @@ IPlugVST3::IPlugVST3(const InstanceInfo& info, const Config& config)
 , IPlugVST3ControllerBase(parameters)
 , mView(nullptr)
 {
+  SetProcessingActive(false);
   CreateTimer();
 }
 
@@ -76,7 +77,14 @@ tresult PLUGIN_API IPlugVST3::setActive(TBool state)
 {
   TRACE
 
+  if (state)
+    SetProcessingActive(true);
+
   OnActivate((bool) state);
+
+  if (!state)
+    SetProcessingActive(false);
+
   return SingleComponentEffect::setActive(state);
 }
 
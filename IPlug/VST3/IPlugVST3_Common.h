@@ -80,7 +80,7 @@ struct IPlugVST3State
     if (pController)
       pController->UpdateParams(pPlug, savedBypass);
     
-    pPlug->OnRestoreState();
+    pPlug->CallOnRestoreState();
     
     return true;
   }
@@ -28,6 +28,8 @@ IPlugVST3Controller::IPlugVST3Controller(const InstanceInfo& info, const Config&
 , mProcessorGUID(info.mOtherGUID)
 , IPlugVST3ControllerBase(parameters)
 {
+  // the controller never processes audio, so a restored state is adopted as soon as it has been unserialized
+  SetProcessingActive(false);
   CreateTimer();
 }
 
@@ -335,9 +335,13 @@ public:
   
   void UpdateParams(IPlugAPIBase* pPlug, int savedBypass)
   {
+    // with lock-free state restore, the restored values may only be staged for the audio thread
+    std::vector<double> pendingValues(pPlug->NParams());
+    const bool pending = pPlug->GetPendingParamState(pendingValues.data());
+    
     for (int i = 0; i < pPlug->NParams(); i++)
     {
-      double normalized = pPlug->GetParam(i)->GetNormalized();
+      double normalized = pending ? pPlug->GetParam(i)->ToNormalized(pendingValues[i]) : pPlug->GetParam(i)->GetNormalized();
       mParameters.getParameter(i)->setNormalized(normalized);
     }
     
@@ -21,6 +21,7 @@ IPlugVST3Processor::IPlugVST3Processor(const InstanceInfo& info, const Config& c
 , IPlugVST3ProcessorBase(config, *this)
 {
   setControllerClass(info.mOtherGUID);
+  SetProcessingActive(false);
   CreateTimer();
 }
 
@@ -61,7 +62,14 @@ tresult PLUGIN_API IPlugVST3Processor::setActive(TBool state)
 {
   TRACE
   
+  if (state)
+    SetProcessingActive(true);
+
   OnActivate((bool) state);
+
+  if (!state)
+    SetProcessingActive(false);
+
   return AudioEffect::setActive(state);
 }
 
@@ -82,7 +82,7 @@ private:
   Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) override;
   
 //  Steinberg::Vst::ParameterChanges mOutputParamChanges;
-  IMidiQueue mMidiOutputQueue;
+  IMidiQueue mMidiOutputQueue {DEFAULT_BLOCK_SIZE, IMidiQueue::EOverflowPolicy::DropOldest};
 };
 
 Steinberg::FUnknown* MakeProcessor();
@@ -277,6 +277,8 @@ void IPlugVST3ProcessorBase::ProcessParameterChanges(ProcessData& data, IPlugQue
 {
   IParameterChanges* paramChanges = data.inputParameterChanges;
   
+  mParamChanges.Clear();
+
   if (paramChanges)
   {
     int32 numParamsChanged = paramChanges->getParameterCount();
@@ -312,7 +314,21 @@ void IPlugVST3ProcessorBase::ProcessParameterChanges(ProcessData& data, IPlugQue
 #ifdef PARAMS_MUTEX
                 mPlug.mParams_mutex.Enter();
 #endif
-                mPlug.GetParam(idx)->SetNormalized(value);
+                IParam* pParam = mPlug.GetParam(idx);
+
+                if (mSampleAccurateAutomation)
+                {
+                  for (int32 pointIdx = 0; pointIdx < numPoints; pointIdx++)
+                  {
+                    int32 pointOffset;
+                    double pointValue;
+                    
+                    if (paramQueue->getPoint(pointIdx, pointOffset, pointValue) == kResultTrue)
+                      mParamChanges.Add(IParamChange(idx, pointOffset, pointValue, pParam->FromNormalized(pointValue)));
+                  }
+                }
+
+                pParam->SetNormalized(value);
               
                 // In VST3 non distributed the same parameter value is also set via IPlugVST3Controller::setParamNormalized(ParamID tag, ParamValue value)
                 mPlug.OnParamChange(idx, kHost, offsetSamples);
@@ -326,17 +342,24 @@ void IPlugVST3ProcessorBase::ProcessParameterChanges(ProcessData& data, IPlugQue
                 int channel = index / kCountCtrlNumber;
                 int ctrlr = index % kCountCtrlNumber;
 
-                IMidiMsg msg;
+                // with sample accurate automation every point becomes a MIDI message, otherwise only the last one
+                for (int32 pointIdx = mSampleAccurateAutomation ? 0 : numPoints - 1; pointIdx < numPoints; pointIdx++)
+                {
+                  if (paramQueue->getPoint(pointIdx, offsetSamples, value) != kResultTrue)
+                    continue;
+
+                  IMidiMsg msg;
 
-                if (ctrlr == kAfterTouch)
-                  msg.MakeChannelATMsg((int) (value * 127.), offsetSamples, channel);
-                else if (ctrlr == kPitchBend)
-                  msg.MakePitchWheelMsg((value * 2.)-1., channel, offsetSamples);
-                else
-                  msg.MakeControlChangeMsg((IMidiMsg::EControlChangeMsg) ctrlr, value, channel, offsetSamples);
+                  if (ctrlr == kAfterTouch)
+                    msg.MakeChannelATMsg((int) (value * 127.), offsetSamples, channel);
+                  else if (ctrlr == kPitchBend)
+                    msg.MakePitchWheelMsg((value * 2.)-1., channel, offsetSamples);
+                  else
+                    msg.MakeControlChangeMsg((IMidiMsg::EControlChangeMsg) ctrlr, value, channel, offsetSamples);
 
-                fromProcessor.Push(msg);
-                ProcessMidiMsg(msg);
+                  fromProcessor.Push(msg);
+                  ProcessMidiMsg(msg);
+                }
               }
             }
               break;
@@ -424,6 +447,7 @@ void IPlugVST3ProcessorBase::ProcessAudio(ProcessData& data, ProcessSetup& setup
 void IPlugVST3ProcessorBase::Process(ProcessData& data, ProcessSetup& setup, const BusList& ins, const BusList& outs, IPlugQueue<IMidiMsg>& fromEditor, IPlugQueue<IMidiMsg>& fromProcessor, IPlugQueue<SysExData>& sysExFromEditor, SysExData& sysExBuf)
 {
   PrepareProcessContext(data, setup);
+  mPlug.ProcessPendingParamState();
   ProcessParameterChanges(data, fromProcessor);
   
   if (DoesMIDIIn())
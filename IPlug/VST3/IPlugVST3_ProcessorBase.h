@@ -189,7 +189,7 @@ private:
   int mMaxNChansForMainInputBus = 0;
   IPlugAPIBase& mPlug;
   Steinberg::Vst::ProcessContext mProcessContext;
-  IMidiQueue mMidiOutputQueue;
+  IMidiQueue mMidiOutputQueue {DEFAULT_BLOCK_SIZE, IMidiQueue::EOverflowPolicy::DropOldest};
   bool mSidechainActive = false;
 };
 
@@ -66,6 +66,8 @@ void IPlugWAM::onProcess(WAM::AudioBus* pAudio, void* pData)
   AttachBuffers(ERoute::kInput, 0, NChannelsConnected(ERoute::kInput), pAudio->inputs, blockSize);
   AttachBuffers(ERoute::kOutput, 0, NChannelsConnected(ERoute::kOutput), pAudio->outputs, blockSize);
   
+  ProcessPendingParamState();
+
   ENTER_PARAMS_MUTEX
   ProcessBuffers((float) 0.0f, blockSize);
   LEAVE_PARAMS_MUTEX
@@ -73,12 +75,9 @@ void IPlugWAM::onProcess(WAM::AudioBus* pAudio, void* pData)
 
 void IPlugWAM::OnEditorIdleTick()
 {
-  while(mParamChangeFromProcessor.ElementsAvailable())
-  {
-    ParamTuple p;
-    mParamChangeFromProcessor.Pop(p);
-    SendParameterValueFromDelegate(p.idx, p.value, false);
-  }
+  mParamChangeFromProcessor.Drain([this](int paramIdx, double value) {
+    SendParameterValueFromDelegate(paramIdx, value, false);
+  });
 
   while (mMidiMsgsFromProcessor.ElementsAvailable())
   {
@@ -0,0 +1,252 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Checks that bitmaps and SVGs loaded on worker threads are handed over to IGraphics through the shared caches, with the headless LICE user interface
+ * Usage: AsyncLoadTest
+ * Resources are preloaded before any IGraphics exists, as a plug-in constructor does with IGEditorDelegate::PreloadEditorResources(), and must be cached without one.
+ * The decoder used by the checks waits for the main thread to let it finish, so that the checks can tell whether IGraphics waited for a preload, or loaded the resource again.
+ * LoadBitmap() must return the preloaded bitmap, and LoadBitmapAsync() must complete, on the display tick, with the preloaded bitmap or one it decoded on a worker thread.
+ * Returns 0 if every check passes
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "IGraphics_include_in_plug_hdr.h"
+#include "IGraphics_include_in_plug_src.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+static const char* kBitmap = TEST_RESOURCES "/smiley.png";
+static const char* kSVG = TEST_RESOURCES "/23.svg";
+static const char* kMissingSVG = TEST_RESOURCES "/missing.svg";
+
+/** An editor delegate without a plug-in, as the checks only load resources */
+class TestDelegate : public IGEditorDelegate
+{
+public:
+  TestDelegate()
+  : IGEditorDelegate(0)
+  {
+  }
+
+  void BeginInformHostOfParamChangeFromUI(int paramIdx) override {}
+  void EndInformHostOfParamChangeFromUI(int paramIdx) override {}
+};
+
+/** A thread safe bitmap decoder that only decodes once it is let go, and records what it decoded and on which thread */
+class GatedDecoder
+{
+public:
+  IBitmapDecodeFunc GetFunc()
+  {
+    return [this](const void* pData, int dataSize, int scale) -> APIBitmap* {
+      while (!mOpen.load())
+        std::this_thread::yield();
+
+      APIBitmap* pBitmap = IGRAPHICS_DRAW_CLASS::ThreadSafeBitmapDecoder()(pData, dataSize, scale);
+      mOnMainThread = std::this_thread::get_id() == mMainThread;
+      mDecoded.store(pBitmap);
+      mNCalls++;
+      return pBitmap;
+    };
+  }
+
+  /** Let the decoder finish, now or after a delay, from another thread */
+  void Open(int delayMs = 0)
+  {
+    if (!delayMs)
+    {
+      mOpen.store(true);
+      return;
+    }
+
+    mOpener = std::thread([this, delayMs]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+      mOpen.store(true);
+    });
+  }
+
+  ~GatedDecoder()
+  {
+    if (mOpener.joinable())
+      mOpener.join();
+  }
+
+  std::atomic<bool> mOpen{false};
+  std::atomic<APIBitmap*> mDecoded{nullptr};
+  std::atomic<int> mNCalls{0};
+  std::atomic<bool> mOnMainThread{false};
+
+private:
+  std::thread::id mMainThread = std::this_thread::get_id();
+  std::thread mOpener;
+};
+
+/** Calls IGraphics::IsDirty(), as the display timer does, until done() returns true or the timeout has passed
+ * @return \c true if done() returned true */
+template <typename Done>
+static bool TickUntil(IGraphics& graphics, Done done, int timeoutMs = 5000)
+{
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  IRECTList rects;
+
+  while (!done())
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+
+    graphics.IsDirty(rects);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return true;
+}
+
+static bool Check(bool ok, const char* what)
+{
+  if (!ok)
+    printf("FAILED: %s\n", what);
+
+  return ok;
+}
+
+/** A plug-in's delegate preloads resources before its editor is opened, they must be cached without an IGraphics, and kept until the delegate is deleted */
+static bool CheckPreloadBeforeEditor()
+{
+  bool pass = true;
+
+  {
+    TestDelegate dlg;
+    dlg.PreloadEditorResources({kBitmap}, {kSVG});
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+    while ((IGraphics::GetBitmapCacheStats().mItems < 1 || IGraphics::GetSVGCacheStats().mItems < 1) && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    pass &= Check(IGraphics::GetBitmapCacheStats().mItems == 1 && IGraphics::GetSVGCacheStats().mItems == 1, "resources preloaded by the delegate are cached before an IGraphics exists");
+
+    IGraphicsLinux graphics(dlg, 100, 100, 60, 1.f);
+    const uint64_t hits = IGraphics::GetBitmapCacheStats().mHits;
+    const IBitmap bitmap = graphics.LoadBitmap(kBitmap);
+    const ISVG svg = graphics.LoadSVG(kSVG);
+
+    pass &= Check(bitmap.IsValid() && svg.IsValid(), "the editor loads preloaded resources");
+    pass &= Check(IGraphics::GetBitmapCacheStats().mHits > hits && IGraphics::GetBitmapCacheStats().mItems == 1, "the editor finds a preloaded bitmap in the cache");
+  }
+
+  pass &= Check(IGraphics::GetBitmapCacheStats().mItems == 0 && IGraphics::GetSVGCacheStats().mItems == 0, "preloaded resources are deleted with the last user of the caches");
+  return pass;
+}
+
+/** LoadBitmap() of a bitmap that is still being preloaded must wait for it, and return it, rather than load it again */
+static bool CheckLoadWaitsForPreload()
+{
+  bool pass = true;
+  GatedDecoder decoder;
+  TestDelegate dlg;
+
+  IGraphics::StartSharedPreloads({kBitmap}, {}, 1, decoder.GetFunc(), "", nullptr, nullptr);
+
+  {
+    IGraphicsLinux graphics(dlg, 100, 100, 60, 1.f);
+    decoder.Open(100);
+
+    const IBitmap bitmap = graphics.LoadBitmap(kBitmap);
+
+    pass &= Check(bitmap.IsValid() && bitmap.GetAPIBitmap() == decoder.mDecoded.load(), "LoadBitmap() returns the bitmap being preloaded");
+    pass &= Check(decoder.mNCalls == 1 && !decoder.mOnMainThread, "a bitmap being preloaded is decoded once, on a worker thread");
+  }
+
+  IGraphics::ReleaseSharedPreloads();
+  return pass;
+}
+
+/** LoadBitmapAsync() of a bitmap that is still being preloaded must complete, on a display tick, once the preload has finished, with the preloaded bitmap */
+static bool CheckAsyncLoadWaitsForPreload()
+{
+  bool pass = true;
+  GatedDecoder decoder;
+  TestDelegate dlg;
+
+  IGraphics::StartSharedPreloads({kBitmap}, {}, 1, decoder.GetFunc(), "", nullptr, nullptr);
+
+  {
+    IGraphicsLinux graphics(dlg, 100, 100, 60, 1.f);
+    IBitmap loaded;
+    bool completed = false;
+    const uint64_t misses = IGraphics::GetBitmapCacheStats().mMisses;
+
+    graphics.LoadBitmapAsync(kBitmap, [&](const IBitmap& bitmap) {
+      loaded = bitmap;
+      completed = true;
+    });
+
+    // a load of its own would look for the bitmap in the cache first
+    pass &= Check(IGraphics::GetBitmapCacheStats().mMisses == misses, "LoadBitmapAsync() doesn't load a bitmap that is being preloaded again");
+
+    TickUntil(graphics, [&]() { return completed; }, 100);
+    pass &= Check(!completed, "LoadBitmapAsync() doesn't complete while the bitmap is being preloaded");
+
+    decoder.Open();
+    pass &= Check(TickUntil(graphics, [&]() { return completed; }), "LoadBitmapAsync() completes once the preload has finished");
+    pass &= Check(loaded.IsValid() && loaded.GetAPIBitmap() == decoder.mDecoded.load() && decoder.mNCalls == 1, "LoadBitmapAsync() is handed the preloaded bitmap");
+  }
+
+  IGraphics::ReleaseSharedPreloads();
+  return pass;
+}
+
+/** LoadBitmapAsync() and LoadSVGAsync() without a preload must complete on a display tick, and leave the result in the cache */
+static bool CheckAsyncLoad()
+{
+  bool pass = true;
+  TestDelegate dlg;
+  IGraphicsLinux graphics(dlg, 100, 100, 60, 1.f);
+
+  IBitmap bitmap;
+  ISVG svg(nullptr), missingSVG(nullptr);
+  int nCompleted = 0;
+
+  graphics.LoadBitmapAsync(kBitmap, [&](const IBitmap& loaded) { bitmap = loaded; nCompleted++; }, 1, false, 2);
+  graphics.LoadSVGAsync(kSVG, [&](const ISVG& loaded) { svg = loaded; nCompleted++; });
+  graphics.LoadSVGAsync(kMissingSVG, [&](const ISVG& loaded) { missingSVG = loaded; nCompleted++; });
+
+  pass &= Check(TickUntil(graphics, [&]() { return nCompleted == 3; }), "asynchronous loads complete on a display tick");
+  pass &= Check(bitmap.IsValid() && bitmap.GetScale() == 2, "LoadBitmapAsync() loads the bitmap for the scale it asked for");
+  pass &= Check(svg.IsValid() && !missingSVG.IsValid(), "LoadSVGAsync() loads an SVG, or hands over an invalid one if it is missing");
+
+  const uint64_t misses = IGraphics::GetBitmapCacheStats().mMisses;
+  const IBitmap cached = graphics.LoadBitmap(kBitmap, 1, false, 2);
+  pass &= Check(cached.GetAPIBitmap() == bitmap.GetAPIBitmap() && IGraphics::GetBitmapCacheStats().mMisses == misses, "a bitmap loaded asynchronously is cached");
+
+  return pass;
+}
+
+int main(int argc, char* argv[])
+{
+  bool pass = true;
+
+  pass &= CheckPreloadBeforeEditor();
+  pass &= CheckLoadWaitsForPreload();
+  pass &= CheckAsyncLoadWaitsForPreload();
+  pass &= CheckAsyncLoad();
+
+  printf("Asynchronous loading %s\n", pass ? "ok" : "FAILED");
+
+  return pass ? 0 : 1;
+}
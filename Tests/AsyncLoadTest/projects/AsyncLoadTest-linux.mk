@@ -0,0 +1,25 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/AsyncLoadTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+TARGET = ../build-linux/AsyncLoadTest
+
+# the headless LICE user interface, without a plug-in, loading the IGraphicsStressTest resources, e.g. make -f AsyncLoadTest-linux.mk test EXTRA_CFLAGS=-fsanitize=thread
+TEST_SRC = $(IPLUG_SRC) \
+	$(IGRAPHICS_SRC) \
+	$(LICE_SRC) \
+	$(PROJECT_ROOT)/AsyncLoadTest.cpp
+
+CFLAGS += $(HEADLESS_CFLAGS) $(LICE_CFLAGS) -DTEST_RESOURCES=\"$(abspath $(PROJECT_ROOT)/../IGraphicsStressTest/resources/img)\" $(EXTRA_CFLAGS)
+
+$(TARGET): $(TEST_SRC)
+	mkdir -p $(dir $@)
+	$(CXX) $(CFLAGS) -o $@ $(TEST_SRC) $(LDFLAGS)
+
+# builds and runs the check, which fails unless preloaded and asynchronously loaded resources are handed over through the caches
+test: $(TARGET)
+	$(TARGET)
+
+.PHONY: test
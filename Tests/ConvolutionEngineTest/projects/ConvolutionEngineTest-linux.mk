@@ -0,0 +1,28 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/ConvolutionEngineTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+TARGET = ../build-linux/ConvolutionEngineTest
+
+# only WDL's convolution engine is needed, not the plug-in sources in SRC
+TEST_SRC = $(WDL_PATH)/convoengine.cpp \
+	$(PROJECT_ROOT)/ConvolutionEngineTest.cpp
+
+FFT_OBJ = ../build-linux/fft.o
+
+CFLAGS += -DWDL_FFT_REALSIZE=8 $(EXTRA_CFLAGS)
+
+$(FFT_OBJ): $(WDL_PATH)/fft.c
+	mkdir -p $(dir $@)
+	$(CC) -O3 -DWDL_FFT_REALSIZE=8 -c -o $@ $<
+
+$(TARGET): $(TEST_SRC) $(FFT_OBJ)
+	$(CXX) $(CFLAGS) -o $@ $(TEST_SRC) $(FFT_OBJ) $(LDFLAGS)
+
+# builds and runs the check, which fails if the output doesn't match direct convolution
+test: $(TARGET)
+	$(TARGET)
+
+.PHONY: test
@@ -0,0 +1,186 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Checks WDL's FFT, which uses SSE2 or AVX, against a scalar build of the same code (WDL_FFT_NO_SIMD), and times both
+ * The makefile links fft.c twice, with the scalar build's functions renamed with a _scalar suffix.
+ * Usage: FFTTest [bench]
+ * Without arguments, compares complex and real FFTs, forward and inverse, at every size from 2 to 32768, and the complex multiplies.
+ * Returns 0 if the FFTs match to within the tolerance, and the complex multiplies are bit-exact. With "bench", prints a size sweep
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fft.h"
+
+extern "C" {
+void WDL_fft_init_scalar();
+void WDL_fft_complexmul_scalar(WDL_FFT_COMPLEX* dest, WDL_FFT_COMPLEX* src, int len);
+void WDL_fft_complexmul2_scalar(WDL_FFT_COMPLEX* dest, WDL_FFT_COMPLEX* src, WDL_FFT_COMPLEX* src2, int len);
+void WDL_fft_complexmul3_scalar(WDL_FFT_COMPLEX* destAdd, WDL_FFT_COMPLEX* src, WDL_FFT_COMPLEX* src2, int len);
+void WDL_fft_scalar(WDL_FFT_COMPLEX*, int len, int isInverse);
+void WDL_real_fft_scalar(WDL_FFT_REAL*, int len, int isInverse);
+}
+
+static constexpr int kMaxSize = 32768;
+
+// a few ulps of the largest output, since the vectorised passes round the first and middle elements differently
+static constexpr double kTolerance = sizeof(WDL_FFT_REAL) == sizeof(float) ? 1e-6 : 1e-14;
+
+static const char* TypeName() { return sizeof(WDL_FFT_REAL) == sizeof(float) ? "float" : "double"; }
+
+static void FillNoise(WDL_FFT_REAL* pData, int n, std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> noise(-1., 1.);
+
+  for (auto i = 0; i < n; i++)
+    pData[i] = static_cast<WDL_FFT_REAL>(noise(rng));
+}
+
+/** @return The largest difference between the two arrays, relative to the largest value of the reference */
+static double RelativeError(const WDL_FFT_REAL* pData, const WDL_FFT_REAL* pReference, int n)
+{
+  double error = 0., magnitude = 0.;
+
+  for (auto i = 0; i < n; i++)
+  {
+    error = std::max(error, std::fabs(static_cast<double>(pData[i]) - pReference[i]));
+    magnitude = std::max(magnitude, std::fabs(static_cast<double>(pReference[i])));
+  }
+
+  return magnitude > 0. ? error / magnitude : error;
+}
+
+static bool Check()
+{
+  std::mt19937 rng(1);
+  std::vector<WDL_FFT_COMPLEX> a(kMaxSize), b(kMaxSize), c(kMaxSize), d(kMaxSize);
+  double worst = 0.;
+  int worstSize = 0;
+  bool multipliesExact = true;
+
+  for (auto n = 2; n <= kMaxSize; n *= 2)
+  {
+    for (auto isInverse = 0; isInverse < 2; isInverse++)
+    {
+      FillNoise(&a[0].re, 2 * n, rng);
+      b = a;
+      WDL_fft(a.data(), n, isInverse);
+      WDL_fft_scalar(b.data(), n, isInverse);
+
+      double error = RelativeError(&a[0].re, &b[0].re, 2 * n);
+
+      FillNoise(&a[0].re, n, rng);
+      b = a;
+      WDL_real_fft(&a[0].re, n, isInverse);
+      WDL_real_fft_scalar(&b[0].re, n, isInverse);
+
+      error = std::max(error, RelativeError(&a[0].re, &b[0].re, n));
+
+      if (error > worst)
+      {
+        worst = error;
+        worstSize = n;
+      }
+    }
+
+    FillNoise(&a[0].re, 2 * n, rng);
+    FillNoise(&b[0].re, 2 * n, rng);
+    FillNoise(&c[0].re, 2 * n, rng);
+    d = c;
+    WDL_fft_complexmul(c.data(), a.data(), n);
+    WDL_fft_complexmul_scalar(d.data(), a.data(), n);
+    multipliesExact &= memcmp(c.data(), d.data(), n * sizeof(WDL_FFT_COMPLEX)) == 0;
+
+    WDL_fft_complexmul2(c.data(), a.data(), b.data(), n);
+    WDL_fft_complexmul2_scalar(d.data(), a.data(), b.data(), n);
+    multipliesExact &= memcmp(c.data(), d.data(), n * sizeof(WDL_FFT_COMPLEX)) == 0;
+
+    WDL_fft_complexmul3(c.data(), a.data(), b.data(), n);
+    WDL_fft_complexmul3_scalar(d.data(), a.data(), b.data(), n);
+    multipliesExact &= memcmp(c.data(), d.data(), n * sizeof(WDL_FFT_COMPLEX)) == 0;
+  }
+
+  const bool pass = worst <= kTolerance && multipliesExact;
+
+  printf("%s: largest relative difference from the scalar FFT %.3g at size %d (tolerance %g), complex multiplies %s: %s\n",
+         TypeName(), worst, worstSize, kTolerance, multipliesExact ? "bit-exact" : "DIFFERENT", pass ? "ok" : "FAILED");
+
+  return pass;
+}
+
+/** @return The mean time per call of the fastest of a few runs, in nanoseconds */
+template <typename Func>
+static double NanosecondsPerCall(int nCalls, Func&& func)
+{
+  double best = 0.;
+
+  for (auto run = 0; run < 4; run++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+
+    for (auto i = 0; i < nCalls; i++)
+      func();
+
+    const double time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / nCalls;
+
+    if (run == 0 || time < best)
+      best = time;
+  }
+
+  return best;
+}
+
+static void Bench()
+{
+  std::mt19937 rng(1);
+  std::vector<WDL_FFT_COMPLEX> a(kMaxSize);
+  FillNoise(&a[0].re, 2 * kMaxSize, rng);
+
+  printf("%s, nanoseconds per forward + inverse pair\n", TypeName());
+  printf("    size    complex scalar / simd          real scalar / simd\n");
+
+  for (auto n = 16; n <= kMaxSize; n *= 2)
+  {
+    const int nCalls = std::max(20, (1 << 22) / n);
+
+    // the FFTs are unnormalised, so the data grows by n with each pair. That doesn't change the timing
+    const double complexScalar = NanosecondsPerCall(nCalls, [&]() { WDL_fft_scalar(a.data(), n, 0); WDL_fft_scalar(a.data(), n, 1); });
+    const double complexSIMD = NanosecondsPerCall(nCalls, [&]() { WDL_fft(a.data(), n, 0); WDL_fft(a.data(), n, 1); });
+    FillNoise(&a[0].re, 2 * n, rng);
+    const double realScalar = NanosecondsPerCall(nCalls, [&]() { WDL_real_fft_scalar(&a[0].re, n, 0); WDL_real_fft_scalar(&a[0].re, n, 1); });
+    const double realSIMD = NanosecondsPerCall(nCalls, [&]() { WDL_real_fft(&a[0].re, n, 0); WDL_real_fft(&a[0].re, n, 1); });
+    FillNoise(&a[0].re, 2 * n, rng);
+
+    printf("%8d  %10.0f / %8.0f (x%.2f)  %10.0f / %8.0f (x%.2f)\n", n,
+           complexScalar, complexSIMD, complexScalar / complexSIMD, realScalar, realSIMD, realScalar / realSIMD);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  WDL_fft_init();
+  WDL_fft_init_scalar();
+
+  if (argc > 1 && !strcmp(argv[1], "bench"))
+  {
+    Bench();
+    return 0;
+  }
+
+  return Check() ? 0 : 1;
+}
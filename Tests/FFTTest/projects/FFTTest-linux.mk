@@ -0,0 +1,50 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/FFTTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+# extra flags for fft.c, e.g. make -f FFTTest-linux.mk test FFT_CFLAGS=-DWDL_FFT_NO_AVX to test SSE2 on a CPU with AVX
+FFT_CFLAGS ?=
+
+BUILD_DIR = ../build-linux
+
+# the scalar build of fft.c, with its functions renamed so that both builds can be linked together
+SCALAR_CFLAGS = -DWDL_FFT_NO_SIMD \
+-DWDL_fft_init=WDL_fft_init_scalar \
+-DWDL_fft_complexmul=WDL_fft_complexmul_scalar \
+-DWDL_fft_complexmul2=WDL_fft_complexmul2_scalar \
+-DWDL_fft_complexmul3=WDL_fft_complexmul3_scalar \
+-DWDL_fft=WDL_fft_scalar \
+-DWDL_real_fft=WDL_real_fft_scalar \
+-DWDL_fft_permute=WDL_fft_permute_scalar \
+-DWDL_fft_permute_tab=WDL_fft_permute_tab_scalar
+
+# one executable per WDL_FFT_REALSIZE: 4 (float) and 8 (double)
+TARGETS = $(BUILD_DIR)/FFTTest-4 $(BUILD_DIR)/FFTTest-8
+
+CFLAGS += $(EXTRA_CFLAGS)
+
+$(BUILD_DIR)/fft-%.o: $(WDL_PATH)/fft.c
+	mkdir -p $(dir $@)
+	$(CC) -O3 -DWDL_FFT_REALSIZE=$* $(FFT_CFLAGS) -c -o $@ $<
+
+$(BUILD_DIR)/fft-scalar-%.o: $(WDL_PATH)/fft.c
+	mkdir -p $(dir $@)
+	$(CC) -O3 -DWDL_FFT_REALSIZE=$* $(SCALAR_CFLAGS) -c -o $@ $<
+
+$(BUILD_DIR)/FFTTest-%: $(PROJECT_ROOT)/FFTTest.cpp $(BUILD_DIR)/fft-%.o $(BUILD_DIR)/fft-scalar-%.o
+	$(CXX) $(CFLAGS) -DWDL_FFT_REALSIZE=$* -o $@ $^ $(LDFLAGS)
+
+# builds and runs the check, which fails if the FFT differs from the scalar code by more than the tolerance
+test: $(TARGETS)
+	$(foreach t,$(TARGETS),$(t) &&) true
+
+# builds and runs the size sweep
+bench: $(TARGETS)
+	$(foreach t,$(TARGETS),$(t) bench &&) true
+
+# keep the fft.c objects between runs
+.SECONDARY:
+
+.PHONY: test bench
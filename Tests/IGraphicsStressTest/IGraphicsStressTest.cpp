@@ -3,6 +3,9 @@
 
 #include "IControls.h"
 
+#include <algorithm>
+#include <vector>
+
 IGraphicsStressTest::IGraphicsStressTest(const InstanceInfo& info)
 : Plugin(info, MakeConfig(kNumParams, 1))
 {
@@ -62,13 +65,18 @@ void IGraphicsStressTest::LayoutUI(IGraphics* pGraphics)
     GetUI()->SetAllControlsDirty();
   };
   
-  pGraphics->SetKeyHandlerFunc([DoFunc](const IKeyPress& key, bool isUp)
+  pGraphics->SetKeyHandlerFunc([this, DoFunc](const IKeyPress& key, bool isUp)
   {
     if(!isUp) {
       switch (key.VK) {
         case kVK_UP: DoFunc(EFunc::More); return true;
         case kVK_DOWN: DoFunc(EFunc::Less); return true;
         case kVK_TAB: key.S ? DoFunc(EFunc::Prev) : DoFunc(EFunc::Next); return true;
+        case kVK_H: RunHitTestBenchmark(); return true;
+        case kVK_C: ToggleLayerCache(); return true;
+#if defined OS_LINUX
+        case kVK_B: RunFrameTimeBenchmark(); return true;
+#endif
         default: return false;
       }
     }
@@ -88,6 +96,11 @@ void IGraphicsStressTest::LayoutUI(IGraphics* pGraphics)
     {
       g.DrawText(IText(30), "Press tab to go to next test", r);
       g.DrawText(IText(30), "up/down to change the # of things", r.GetVShifted(40.f));
+      g.DrawText(IText(30), "H to benchmark mouse hit testing", r.GetVShifted(80.f));
+      g.DrawText(IText(30), "C to toggle caching the test in a layer", r.GetVShifted(120.f));
+#if defined OS_LINUX
+      g.DrawText(IText(30), "B to benchmark frame times", r.GetVShifted(160.f));
+#endif
     }
     else
     //      if (!g.CheckLayer(pCaller->mLayer))
@@ -130,7 +143,7 @@ void IGraphicsStressTest::LayoutUI(IGraphics* pGraphics)
     
     //      g.DrawLayer(pCaller->mLayer);
     
-  }, 10000, false, false));
+  }, 10000, false, false))->SetOpaque();
   
   pGraphics->AttachControl(new ITextControl(labelsArea.GetGridCell(0, 1, 2), "", IText(20)), kCtrlTagNumThings);
   pGraphics->AttachControl(new ITextControl(labelsArea.GetGridCell(1, 1, 2), "", IText(20)), kCtrlTagTestNum);
@@ -167,4 +180,136 @@ void IGraphicsStressTest::LayoutUI(IGraphics* pGraphics)
   });
 
 }
+
+void IGraphicsStressTest::RunHitTestBenchmark()
+{
+  IGraphics* pGraphics = GetUI();
+  const int firstIdx = pGraphics->NControls();
+  const IRECT area = pGraphics->GetBounds().GetReducedFromBottom(100.f);
+  const int nRows = 50;
+  const int nCols = 40;
+  const int nQueries = 20000;
+
+  // a grid of small controls, like a large step sequencer, in front of the test controls
+  for (int row = 0; row < nRows; row++)
+  {
+    for (int col = 0; col < nCols; col++)
+    {
+      pGraphics->AttachControl(new ILambdaControl(area.GetGridCell(row, col, nRows, nCols), [](ILambdaControl* pCaller, IGraphics& g, IRECT& r) {}));
+    }
+  }
+
+  const bool gridWasEnabled = pGraphics->HitTestGridEnabled();
+  const bool mouseOverWasEnabled = pGraphics->CanEnableMouseOver();
+  pGraphics->EnableMouseOver(true);
+
+  auto timeQueries = [&](bool useGrid) {
+    pGraphics->EnableHitTestGrid(useGrid);
+    pGraphics->OnMouseOver(0.f, 0.f, IMouseMod()); // the grid is built on first use
+    srand(1);
+    const double start = GetTimestamp();
+
+    for (int i = 0; i < nQueries; i++)
+    {
+      pGraphics->OnMouseOver(area.L + (rand() % 1000) * area.W() / 1000.f, area.T + (rand() % 1000) * area.H() / 1000.f, IMouseMod());
+    }
+
+    return (GetTimestamp() - start) * 1e6 / nQueries;
+  };
+
+  const double linearTime = timeQueries(false);
+  const double gridTime = timeQueries(true);
+
+  pGraphics->OnMouseOut();
+  pGraphics->RemoveControls(firstIdx);
+  pGraphics->EnableHitTestGrid(gridWasEnabled);
+  pGraphics->EnableMouseOver(mouseOverWasEnabled);
+
+  pGraphics->GetControlWithTag(kCtrlTagTestNum)->As<ITextControl>()->SetStrFmt(64, "Hit test %i ctrls: %.2fus linear, %.2fus grid", nRows * nCols, linearTime, gridTime);
+  DBGMSG("Hit test with %i controls: %.3f us per mouse move linear, %.3f us with grid\n", nRows * nCols, linearTime, gridTime);
+}
+
+void IGraphicsStressTest::ToggleLayerCache()
+{
+  mUseLayerCache = !mUseLayerCache;
+  GetUI()->GetControl(1)->SetUseLayerCache(mUseLayerCache);
+  GetUI()->GetControlWithTag(kCtrlTagTestNum)->As<ITextControl>()->SetStrFmt(64, "Layer cache %s", mUseLayerCache ? "on" : "off");
+}
+
+#if defined OS_LINUX
+void IGraphicsStressTest::RunFrameTimeBenchmark(int nFrames)
+{
+  IGraphicsLinux* pGraphics = static_cast<IGraphicsLinux*>(GetUI());
+
+  if (!pGraphics || nFrames < 1)
+    return;
+
+  IControl* pVisuals = pGraphics->GetControl(1);
+  const int kindWas = mKindOfThing;
+  const int nTests = 12;
+  std::vector<double> frameTimes(nFrames);
+
+  printf("IGraphicsStressTest %s/%s, %i things, %i frames per test\n", pGraphics->GetDrawingAPIStr(), pGraphics->GetPlatformAPIStr(), mNumberOfThings, nFrames);
+  printf("test    mean ms  median ms   worst ms\n");
+
+  for (int kind = 1; kind <= nTests; kind++)
+  {
+    mKindOfThing = kind;
+    srand(1);
+    pGraphics->RenderFullFrame(); // not timed, loads the bitmap and SVG
+
+    for (int frame = 0; frame < nFrames; frame++)
+    {
+      pVisuals->SetDirty(false);
+      const double start = GetTimestamp();
+      pGraphics->RenderFrame();
+      frameTimes[frame] = (GetTimestamp() - start) * 1000.;
+    }
+
+    double total = 0.;
+
+    for (auto t : frameTimes)
+      total += t;
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    printf("%4i %10.3f %10.3f %10.3f\n", kind, total / nFrames, frameTimes[nFrames / 2], frameTimes[nFrames - 1]);
+  }
+
+  // the FPS display is dirty at every frame, so the part of the test behind it is redrawn, unless it is cached
+  const bool fpsWasShown = pGraphics->ShowingFPSDisplay();
+  pGraphics->ShowFPSDisplay(true);
+
+  printf("with the FPS display redrawing over the test\n");
+  printf("test  uncached ms  draws/frame  cached ms  draws/frame\n");
+
+  for (int kind = 1; kind <= nTests; kind++)
+  {
+    mKindOfThing = kind;
+    printf("%4i", kind);
+
+    for (auto cached : {false, true})
+    {
+      srand(1);
+      pVisuals->SetUseLayerCache(cached);
+      pGraphics->RenderFullFrame();
+      pGraphics->ResetDrawStats();
+
+      const double start = GetTimestamp();
+
+      for (int frame = 0; frame < nFrames; frame++)
+        pGraphics->RenderFrame();
+
+      const double meanTime = (GetTimestamp() - start) * 1000. / nFrames;
+      printf(" %11.3f %12.2f", meanTime, static_cast<double>(pGraphics->GetDrawStats().mControlDraws) / nFrames);
+    }
+
+    printf("\n");
+  }
+
+  pGraphics->ShowFPSDisplay(fpsWasShown);
+  pVisuals->SetUseLayerCache(mUseLayerCache);
+  mKindOfThing = kindWas;
+  pGraphics->SetAllControlsDirty();
+}
+#endif
 #endif
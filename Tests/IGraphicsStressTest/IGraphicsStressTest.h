@@ -30,8 +30,17 @@ public:
 #if IPLUG_EDITOR
   void LayoutUI(IGraphics* pGraphics) override;
   void OnParentWindowResize(int width, int height) override;
+  void RunHitTestBenchmark();
+  void ToggleLayerCache();
+#if defined OS_LINUX
+  /** Time drawing each test with the headless linux target, printing the frame times to stdout.
+   * Then time the frames where only the FPS display redraws over the test, with and without the test cached in a layer
+   * @param nFrames The number of frames to time for each test */
+  void RunFrameTimeBenchmark(int nFrames = 100);
+#endif
 public:
   int mNumberOfThings = 16;
   int mKindOfThing = 0;
+  bool mUseLayerCache = false;
 #endif
 };
@@ -0,0 +1,39 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Headless linux driver for the IGraphicsStressTest frame time benchmark, see README.md
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "IGraphicsStressTest.h"
+
+int main(int argc, char* argv[])
+{
+  const int nFrames = argc > 1 ? atoi(argv[1]) : 100;
+
+  if (nFrames < 1)
+  {
+    fprintf(stderr, "usage: %s [frames per test]\n", argv[0]);
+    return 1;
+  }
+
+  std::unique_ptr<IGraphicsStressTest> pPlug(static_cast<IGraphicsStressTest*>(MakePlug(InstanceInfo())));
+
+  pPlug->OpenWindow(nullptr);
+  pPlug->RunFrameTimeBenchmark(nFrames);
+  pPlug->CloseWindow();
+
+  return 0;
+}
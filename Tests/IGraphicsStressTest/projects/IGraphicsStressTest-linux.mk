@@ -0,0 +1,31 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/IGraphicsStressTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+# LICE or SKIA, e.g. make -f IGraphicsStressTest-linux.mk GRAPHICS=SKIA
+GRAPHICS ?= LICE
+
+# the number of frames timed for each test
+BENCH_FRAMES ?= 100
+
+TARGET = ../build-linux/IGraphicsStressTest
+
+SRC += $(IGRAPHICS_SRC) \
+	$($(GRAPHICS)_SRC) \
+	$(PROJECT_ROOT)/IGraphicsStressTest.cpp \
+	$(PROJECT_ROOT)/IGraphicsStressTest_linux.cpp
+
+CFLAGS += $(HEADLESS_CFLAGS) $($(GRAPHICS)_CFLAGS) $(EXTRA_CFLAGS)
+LDFLAGS += $($(GRAPHICS)_LDFLAGS)
+
+$(TARGET): $(SRC)
+	mkdir -p $(dir $@)
+	$(CXX) $(CFLAGS) -o $@ $(SRC) $(LDFLAGS)
+
+# builds and runs the frame time benchmark, resources are found in ../resources relative to the executable
+bench: $(TARGET)
+	$(TARGET) $(BENCH_FRAMES)
+
+.PHONY: bench
@@ -0,0 +1,238 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Checks that IMidiQueue keeps its messages sorted by offset, and keeps the messages that release notes when it drops messages because it is full
+ * Usage: IMidiQueueTest [iterations [seed]]
+ * Each iteration fills a queue with random messages, one at a time with Add() and in sorted batches with AddSorted(), and removes some from the front, for a number of steps.
+ * After each step, the queue must hold the same messages, in the same order, as a reference model that inserts every message after those with the same offset, then drops messages one at a time while it holds more than the capacity.
+ * The DropOldest policy drops the first message that doesn't release notes, DropNewest the last one, and both only drop a note off or an all notes/sound off when the queue holds nothing else. Grow must never drop a message.
+ * Each iteration (300 by default) checks the three policies, and one in three only adds note offs. The seed (1 by default) is printed if a check fails, so that it can be repeated
+ * Returns 0 if every check passes
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "IPlugPlatform.h"
+#include "IPlugMidi.h"
+
+using namespace iplug;
+
+using EOverflowPolicy = IMidiQueue::EOverflowPolicy;
+
+static constexpr int kNSteps = 60;
+static constexpr int kMaxOffset = 50;
+
+static const char* PolicyName(EOverflowPolicy policy)
+{
+  switch (policy)
+  {
+    case EOverflowPolicy::Grow: return "Grow";
+    case EOverflowPolicy::DropOldest: return "DropOldest";
+    default: return "DropNewest";
+  }
+}
+
+static bool SameMsg(const IMidiMsg& a, const IMidiMsg& b)
+{
+  return a.mOffset == b.mOffset && a.mStatus == b.mStatus && a.mData1 == b.mData1 && a.mData2 == b.mData2;
+}
+
+static bool ByOffset(const IMidiMsg& a, const IMidiMsg& b)
+{
+  return a.mOffset < b.mOffset;
+}
+
+/** What IMidiQueue should hold: a sorted list that is trimmed to the capacity one message at a time, as the overflow policy says */
+class ReferenceQueue
+{
+public:
+  ReferenceQueue(int capacity, EOverflowPolicy policy)
+  : mCapacity(capacity)
+  , mPolicy(policy)
+  {
+  }
+
+  /** Adds a message after any with the same offset, the capacity can be exceeded until Trim() */
+  void Add(const IMidiMsg& msg)
+  {
+    mMsgs.insert(std::upper_bound(mMsgs.begin(), mMsgs.end(), msg, ByOffset), msg);
+  }
+
+  /** Drops messages one at a time, as the overflow policy says, until the capacity is reached */
+  void Trim()
+  {
+    if (mPolicy == EOverflowPolicy::Grow)
+      return;
+
+    while (static_cast<int>(mMsgs.size()) > mCapacity)
+    {
+      const int n = static_cast<int>(mMsgs.size());
+      const bool fromFront = mPolicy == EOverflowPolicy::DropOldest;
+      int k = fromFront ? 0 : n - 1;
+
+      for (int i = 0; i < n; i++)
+      {
+        const int idx = fromFront ? i : n - 1 - i;
+
+        if (!IMidiQueue::ReleasesNotes(mMsgs[idx]))
+        {
+          k = idx;
+          break;
+        }
+      }
+
+      mMsgs.erase(mMsgs.begin() + k);
+      mNDropped++;
+    }
+  }
+
+  void Remove() { mMsgs.erase(mMsgs.begin()); }
+
+  const std::vector<IMidiMsg>& GetMsgs() const { return mMsgs; }
+  int GetNumDropped() const { return mNDropped; }
+
+private:
+  std::vector<IMidiMsg> mMsgs;
+  int mCapacity;
+  EOverflowPolicy mPolicy;
+  int mNDropped = 0;
+};
+
+/** Makes random messages, each with its own note or controller number, so that the order of messages with the same offset can be checked */
+class MsgMaker
+{
+public:
+  MsgMaker(std::mt19937& rng, bool noteOffsOnly)
+  : mRng(rng)
+  , mNoteOffsOnly(noteOffsOnly)
+  {
+  }
+
+  IMidiMsg Make()
+  {
+    const int offset = static_cast<int>(mRng() % kMaxOffset);
+    const int type = mNoteOffsOnly ? 0 : static_cast<int>(mRng() % 4);
+    IMidiMsg msg;
+
+    if (type == 0)
+      msg.MakeNoteOffMsg(0, offset);
+    else if (type == 1)
+      msg.MakeControlChangeMsg(mRng() % 2 ? IMidiMsg::kAllNotesOff : IMidiMsg::kModWheel, 0.5, 0, offset);
+    else // a note on with zero velocity is a note off
+      msg.MakeNoteOnMsg(0, mRng() % 3 ? 100 : 0, offset);
+
+    msg.mData1 = static_cast<uint8_t>(mID++ % 128);
+    return msg;
+  }
+
+private:
+  std::mt19937& mRng;
+  bool mNoteOffsOnly;
+  int mID = 0;
+};
+
+/** Runs kNSteps random steps on a queue with the smallest capacity, and compares it with the reference after each step */
+static bool Check(std::mt19937& rng, EOverflowPolicy policy, bool noteOffsOnly, unsigned int seed, int iteration)
+{
+  IMidiQueue queue(1, policy);
+  const int capacity = queue.GetSize();
+  ReferenceQueue ref(capacity, policy);
+  MsgMaker maker(rng, noteOffsOnly);
+  std::vector<IMidiMsg> batch;
+
+  for (int step = 0; step < kNSteps; step++)
+  {
+    if (rng() % 2)
+    {
+      const IMidiMsg msg = maker.Make();
+      queue.Add(msg);
+      ref.Add(msg);
+    }
+    else
+    {
+      // up to a little more than the capacity, so that a batch can overflow an empty queue
+      batch.resize(rng() % (capacity + 20));
+
+      for (auto& msg : batch)
+        msg = maker.Make();
+
+      std::stable_sort(batch.begin(), batch.end(), ByOffset);
+      queue.AddSorted(batch.data(), static_cast<int>(batch.size()));
+
+      for (const auto& msg : batch)
+        ref.Add(msg);
+    }
+
+    ref.Trim();
+
+    if (rng() % 10 == 0)
+    {
+      const int nRemoved = static_cast<int>(rng() % (queue.ToDo() + 1));
+
+      for (int k = 0; k < nRemoved; k++)
+      {
+        queue.Remove();
+        ref.Remove();
+      }
+    }
+
+    const std::vector<IMidiMsg>& expected = ref.GetMsgs();
+    const IMidiMsg* pMsgs = queue.Empty() ? nullptr : &queue.Peek();
+    const char* error = nullptr;
+
+    if (queue.ToDo() != static_cast<int>(expected.size()))
+      error = "holds the wrong number of messages";
+    else if (queue.GetNumDropped() != ref.GetNumDropped())
+      error = "counted the wrong number of dropped messages";
+    else if (!std::is_sorted(pMsgs, pMsgs + queue.ToDo(), ByOffset))
+      error = "is not sorted by offset";
+    else if (!std::equal(expected.begin(), expected.end(), pMsgs, SameMsg))
+      error = "dropped the wrong messages, or reordered messages with the same offset";
+
+    if (error)
+    {
+      printf("FAILED: seed %u, iteration %d, %s%s, step %d: the queue %s (%d held, %d expected)\n", seed, iteration, PolicyName(policy),
+             noteOffsOnly ? " with note offs only" : "", step, error, queue.ToDo(), static_cast<int>(expected.size()));
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  const int nIterations = argc > 1 ? std::max(1, atoi(argv[1])) : 300;
+  const unsigned int seed = argc > 2 ? static_cast<unsigned int>(strtoul(argv[2], nullptr, 10)) : 1;
+  std::mt19937 rng(seed);
+  bool pass = true;
+  int nCases = 0;
+
+  for (int iteration = 0; iteration < nIterations; iteration++)
+  {
+    const bool noteOffsOnly = iteration % 3 == 0;
+
+    for (EOverflowPolicy policy : {EOverflowPolicy::DropOldest, EOverflowPolicy::DropNewest, EOverflowPolicy::Grow})
+    {
+      pass &= Check(rng, policy, noteOffsOnly, seed, iteration);
+      nCases++;
+    }
+  }
+
+  printf("IMidiQueue: %d cases %s\n", nCases, pass ? "ok" : "FAILED");
+
+  return pass ? 0 : 1;
+}
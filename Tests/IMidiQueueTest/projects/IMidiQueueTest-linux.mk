@@ -0,0 +1,22 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/IMidiQueueTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+TARGET = ../build-linux/IMidiQueueTest
+
+# IMidiQueue is header only, none of the plug-in sources in SRC are needed, e.g. make -f IMidiQueueTest-linux.mk test EXTRA_CFLAGS=-fsanitize=address,undefined
+TEST_SRC = $(PROJECT_ROOT)/IMidiQueueTest.cpp
+
+CFLAGS += $(EXTRA_CFLAGS)
+
+$(TARGET): $(TEST_SRC) $(IPLUG_PATH)/IPlugMidi.h
+	mkdir -p $(dir $@)
+	$(CXX) $(CFLAGS) -o $@ $(TEST_SRC) $(LDFLAGS)
+
+# builds and runs the check, which fails unless the queue matches a reference model after every step of random additions and removals
+test: $(TARGET)
+	$(TARGET)
+
+.PHONY: test
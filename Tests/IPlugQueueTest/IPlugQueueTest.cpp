@@ -0,0 +1,474 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Checks IPlugQueue across two threads, and benchmarks it against the previous queue, which wrapped its indices with a modulo
+ * Usage: IPlugQueueTest [bench [elements]]
+ * Without arguments, a producer thread pushes a sequence of numbers with Push(), PushN() and WriteSlot()/CommitWrite() in turn,
+ * while a consumer thread pops them with Pop(), PopN() and ReadSlot()/CommitRead() in turn. Every number must arrive once, in order. Returns 0 if they do.
+ * With "bench", prints the time per element to move a number of elements (1M by default) through each queue, on one thread and between two threads,
+ * for Push()/Pop(), PushN()/PopN() and WriteSlot()/CommitWrite(). The previous queue has no bulk or in-place access, so Push()/Pop() of each element is its baseline
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "IPlugQueue.h"
+
+using namespace iplug;
+
+static constexpr int kQueueSize = 1024;
+static constexpr int kBatchSize = 32;
+
+/** The IPlugQueue before its indices were padded and masked, kept as the benchmark's baseline.
+ * It holds size + 1 elements, so each index is wrapped with a division, and both indices share a cache line */
+template<typename T>
+class ModuloQueue final
+{
+public:
+  ModuloQueue(int size)
+  {
+    mData.Resize(size + 1);
+  }
+
+  bool Push(const T& item)
+  {
+    const auto currentWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
+    const auto nextWriteIndex = Increment(currentWriteIndex);
+    if(nextWriteIndex != mReadIndex.load(std::memory_order_acquire))
+    {
+      mData.Get()[currentWriteIndex] = item;
+      mWriteIndex.store(nextWriteIndex, std::memory_order_release);
+      return true;
+    }
+    return false;
+  }
+
+  bool Pop(T& item)
+  {
+    const auto currentReadIndex = mReadIndex.load(std::memory_order_relaxed);
+    if(currentReadIndex == mWriteIndex.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    item = mData.Get()[currentReadIndex];
+    mReadIndex.store(Increment(currentReadIndex), std::memory_order_release);
+    return true;
+  }
+
+private:
+  size_t Increment(size_t idx) const
+  {
+    return (idx + 1) % (mData.GetSize());
+  }
+
+  WDL_TypedBuf<T> mData;
+  std::atomic<size_t> mWriteIndex{0};
+  std::atomic<size_t> mReadIndex{0};
+};
+
+/** An element the size of a small message, such as IMidiMsg */
+struct SmallElement
+{
+  int64_t mValue = 0;
+  int64_t mPad = 0;
+};
+
+/** An element the size of a block of parameter values, which WriteSlot() and ReadSlot() avoid copying */
+struct LargeElement
+{
+  int64_t mValue = 0;
+  double mData[31] = {};
+};
+
+/** Pushes nElements numbers on a producer thread while the main thread pops them, switching method every few elements on each side
+ * @return \c true if every number arrived once, in order */
+static bool CheckTwoThreads(int queueSize, int64_t nElements)
+{
+  IPlugQueue<SmallElement> queue(queueSize);
+
+  std::thread producer([&]() {
+    int64_t next = 0;
+    int method = 0;
+    SmallElement batch[kBatchSize];
+
+    while (next < nElements)
+    {
+      switch (method++ % 3)
+      {
+        case 0:
+        {
+          SmallElement element;
+          element.mValue = next;
+
+          if (queue.Push(element))
+            next++;
+
+          break;
+        }
+        case 1:
+        {
+          const int nBatch = static_cast<int>(std::min<int64_t>(1 + next % kBatchSize, nElements - next));
+
+          for (int i = 0; i < nBatch; i++)
+            batch[i].mValue = next + i;
+
+          next += queue.PushN(batch, nBatch);
+          break;
+        }
+        case 2:
+        {
+          if (SmallElement* pSlot = queue.WriteSlot())
+          {
+            pSlot->mValue = next++;
+            queue.CommitWrite();
+          }
+
+          break;
+        }
+      }
+
+      if (queue.WasFull())
+        std::this_thread::yield();
+    }
+  });
+
+  int64_t expected = 0;
+  int method = 0;
+  bool pass = true;
+  SmallElement batch[kBatchSize];
+
+  auto receive = [&](int64_t value) {
+    if (value != expected && pass)
+    {
+      printf("FAILED: queue of %d, received %lld, expected %lld\n", queueSize, static_cast<long long>(value), static_cast<long long>(expected));
+      pass = false;
+    }
+
+    expected = value + 1;
+  };
+
+  while (expected < nElements && pass)
+  {
+    switch (method++ % 3)
+    {
+      case 0:
+      {
+        SmallElement element;
+
+        if (queue.Pop(element))
+          receive(element.mValue);
+
+        break;
+      }
+      case 1:
+      {
+        const int nPopped = queue.PopN(batch, 1 + static_cast<int>(expected % kBatchSize));
+
+        for (int i = 0; i < nPopped; i++)
+          receive(batch[i].mValue);
+
+        break;
+      }
+      case 2:
+      {
+        if (const SmallElement* pSlot = queue.ReadSlot())
+        {
+          receive(pSlot->mValue);
+          queue.CommitRead();
+        }
+
+        break;
+      }
+    }
+
+    if (queue.WasEmpty())
+      std::this_thread::yield();
+  }
+
+  if (!pass)
+    std::_Exit(1); // the producer may be waiting for elements that will never be popped
+
+  producer.join();
+
+  if (!queue.WasEmpty())
+  {
+    printf("FAILED: queue of %d, elements left after the last one\n", queueSize);
+    pass = false;
+  }
+
+  return pass;
+}
+
+/** Checks the capacity, and that the queue reports itself full and empty, on one thread */
+static bool CheckCapacity(int queueSize)
+{
+  IPlugQueue<SmallElement> queue(queueSize);
+  int nPushed = 0;
+  SmallElement element;
+
+  while (queue.Push(element))
+    nPushed++;
+
+  const bool pass = nPushed == static_cast<int>(queue.Capacity()) && nPushed >= queueSize && nPushed < 2 * std::max(queueSize, 1)
+                    && queue.WasFull() && !queue.WriteSlot() && queue.PushN(&element, 1) == 0 && queue.ElementsAvailable() == static_cast<size_t>(nPushed);
+
+  int nPopped = 0;
+
+  while (queue.Pop(element))
+    nPopped++;
+
+  if (!pass || nPopped != nPushed || !queue.WasEmpty() || queue.ReadSlot() || queue.PopN(&element, 1) != 0)
+  {
+    printf("FAILED: queue of %d, capacity %d, pushed %d, popped %d\n", queueSize, static_cast<int>(queue.Capacity()), nPushed, nPopped);
+    return false;
+  }
+
+  return true;
+}
+
+using Clock = std::chrono::steady_clock;
+
+/** @return The time per element in nanoseconds */
+static double NanosecondsPerElement(Clock::time_point start, int64_t nElements)
+{
+  const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+  return elapsed.count() / nElements;
+}
+
+/** Moves nElements through the queue on one thread, kBatchSize at a time, with Push()/Pop() of each element */
+template <typename T, typename Queue>
+static double TimeOneThread(Queue& queue, int64_t nElements)
+{
+  T element;
+  int64_t sum = 0;
+  const auto start = Clock::now();
+
+  for (int64_t i = 0; i < nElements; i += kBatchSize)
+  {
+    for (int b = 0; b < kBatchSize; b++)
+    {
+      element.mValue = i + b;
+      queue.Push(element);
+    }
+
+    for (int b = 0; b < kBatchSize; b++)
+    {
+      queue.Pop(element);
+      sum += element.mValue;
+    }
+  }
+
+  const double time = NanosecondsPerElement(start, nElements);
+  return sum >= 0 ? time : 0.; // uses sum, so the loop isn't optimized away
+}
+
+/** As TimeOneThread(), with PushN()/PopN() */
+template <typename T>
+static double TimeOneThreadBulk(IPlugQueue<T>& queue, int64_t nElements)
+{
+  T batch[kBatchSize];
+  int64_t sum = 0;
+  const auto start = Clock::now();
+
+  for (int64_t i = 0; i < nElements; i += kBatchSize)
+  {
+    for (int b = 0; b < kBatchSize; b++)
+      batch[b].mValue = i + b;
+
+    queue.PushN(batch, kBatchSize);
+    const int nPopped = queue.PopN(batch, kBatchSize);
+
+    for (int b = 0; b < nPopped; b++)
+      sum += batch[b].mValue;
+  }
+
+  const double time = NanosecondsPerElement(start, nElements);
+  return sum >= 0 ? time : 0.;
+}
+
+/** As TimeOneThread(), writing and reading each element in place */
+template <typename T>
+static double TimeOneThreadInPlace(IPlugQueue<T>& queue, int64_t nElements)
+{
+  int64_t sum = 0;
+  const auto start = Clock::now();
+
+  for (int64_t i = 0; i < nElements; i += kBatchSize)
+  {
+    for (int b = 0; b < kBatchSize; b++)
+    {
+      queue.WriteSlot()->mValue = i + b;
+      queue.CommitWrite();
+    }
+
+    for (int b = 0; b < kBatchSize; b++)
+    {
+      sum += queue.ReadSlot()->mValue;
+      queue.CommitRead();
+    }
+  }
+
+  const double time = NanosecondsPerElement(start, nElements);
+  return sum >= 0 ? time : 0.;
+}
+
+/** Moves nElements from a producer thread to the main thread, which pops them with consume(), waiting by yielding when the queue is full or empty */
+template <typename Produce, typename Consume>
+static double TimeTwoThreads(int64_t nElements, Produce produce, Consume consume)
+{
+  const auto start = Clock::now();
+
+  std::thread producer([&]() {
+    for (int64_t next = 0; next < nElements;)
+    {
+      const int64_t nPushed = produce(next);
+
+      if (!nPushed)
+        std::this_thread::yield();
+
+      next += nPushed;
+    }
+  });
+
+  for (int64_t received = 0; received < nElements;)
+  {
+    const int64_t nPopped = consume();
+
+    if (!nPopped)
+      std::this_thread::yield();
+
+    received += nPopped;
+  }
+
+  producer.join();
+  return NanosecondsPerElement(start, nElements);
+}
+
+template <typename T>
+static void BenchElement(const char* name, int64_t nElements)
+{
+  double oldTimes[2], newTimes[2], bulkTimes[2], inPlaceTimes[2];
+
+  {
+    ModuloQueue<T> oldQueue(kQueueSize);
+    IPlugQueue<T> queue(kQueueSize);
+    oldTimes[0] = TimeOneThread<T>(oldQueue, nElements);
+    newTimes[0] = TimeOneThread<T>(queue, nElements);
+    bulkTimes[0] = TimeOneThreadBulk(queue, nElements);
+    inPlaceTimes[0] = TimeOneThreadInPlace(queue, nElements);
+  }
+
+  {
+    ModuloQueue<T> queue(kQueueSize);
+    oldTimes[1] = TimeTwoThreads(nElements,
+      [&](int64_t next) { T element; element.mValue = next; return static_cast<int64_t>(queue.Push(element)); },
+      [&]() { T element; return static_cast<int64_t>(queue.Pop(element)); });
+  }
+
+  {
+    IPlugQueue<T> queue(kQueueSize);
+    newTimes[1] = TimeTwoThreads(nElements,
+      [&](int64_t next) { T element; element.mValue = next; return static_cast<int64_t>(queue.Push(element)); },
+      [&]() { T element; return static_cast<int64_t>(queue.Pop(element)); });
+  }
+
+  {
+    IPlugQueue<T> queue(kQueueSize);
+    T pushBatch[kBatchSize], popBatch[kBatchSize];
+    bulkTimes[1] = TimeTwoThreads(nElements,
+      [&](int64_t next) {
+        const int nBatch = static_cast<int>(std::min<int64_t>(kBatchSize, nElements - next));
+
+        for (int b = 0; b < nBatch; b++)
+          pushBatch[b].mValue = next + b;
+
+        return static_cast<int64_t>(queue.PushN(pushBatch, nBatch));
+      },
+      [&]() { return static_cast<int64_t>(queue.PopN(popBatch, kBatchSize)); });
+  }
+
+  {
+    IPlugQueue<T> queue(kQueueSize);
+    int64_t sum = 0;
+    inPlaceTimes[1] = TimeTwoThreads(nElements,
+      [&](int64_t next) {
+        T* pSlot = queue.WriteSlot();
+
+        if (!pSlot)
+          return static_cast<int64_t>(0);
+
+        pSlot->mValue = next;
+        queue.CommitWrite();
+        return static_cast<int64_t>(1);
+      },
+      [&]() {
+        const T* pSlot = queue.ReadSlot();
+
+        if (!pSlot)
+          return static_cast<int64_t>(0);
+
+        sum += pSlot->mValue;
+        queue.CommitRead();
+        return static_cast<int64_t>(1);
+      });
+  }
+
+  const char* threads[2] = {"1 thread", "2 threads"};
+
+  for (int t = 0; t < 2; t++)
+  {
+    printf("%-8s %-10s %12.2f %12.2f (x%4.2f) %12.2f (x%4.2f) %12.2f (x%4.2f)\n", name, threads[t], oldTimes[t],
+           newTimes[t], oldTimes[t] / newTimes[t], bulkTimes[t], oldTimes[t] / bulkTimes[t], inPlaceTimes[t], oldTimes[t] / inPlaceTimes[t]);
+  }
+}
+
+static void Bench(int64_t nElements)
+{
+  printf("ns per element moved through a queue of %d, %lld elements, batches of %d, %u cores\n", kQueueSize, static_cast<long long>(nElements), kBatchSize, std::thread::hardware_concurrency());
+  printf("%-8s %-10s %12s %21s %21s %21s\n", "element", "", "modulo (ns)", "Push/Pop (ns)", "PushN/PopN (ns)", "WriteSlot (ns)");
+
+  BenchElement<SmallElement>("16 B", nElements);
+  BenchElement<LargeElement>("256 B", nElements);
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1 && !strcmp(argv[1], "bench"))
+  {
+    Bench(argc > 2 ? std::max<int64_t>(kBatchSize, atoll(argv[2])) : 1000000);
+    return 0;
+  }
+
+  bool pass = true;
+  int nCases = 0;
+
+  for (int queueSize : {0, 1, 5, 32, 1000})
+  {
+    pass &= CheckCapacity(queueSize);
+    nCases++;
+  }
+
+  for (int queueSize : {1, 5, 32, 1000})
+  {
+    pass &= CheckTwoThreads(queueSize, 200000);
+    nCases++;
+  }
+
+  printf("IPlugQueue: %d cases %s\n", nCases, pass ? "ok" : "FAILED");
+
+  return pass ? 0 : 1;
+}
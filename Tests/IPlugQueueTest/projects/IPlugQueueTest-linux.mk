@@ -0,0 +1,29 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/IPlugQueueTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+# the number of elements moved through each queue in the benchmark
+BENCH_ELEMENTS ?= 1000000
+
+TARGET = ../build-linux/IPlugQueueTest
+
+# IPlugQueue is header only, none of the plug-in sources in SRC are needed, e.g. make -f IPlugQueueTest-linux.mk test EXTRA_CFLAGS=-fsanitize=thread
+TEST_SRC = $(PROJECT_ROOT)/IPlugQueueTest.cpp
+
+CFLAGS += $(EXTRA_CFLAGS)
+
+$(TARGET): $(TEST_SRC) $(IPLUG_PATH)/IPlugQueue.h
+	mkdir -p $(dir $@)
+	$(CXX) $(CFLAGS) -o $@ $(TEST_SRC) $(LDFLAGS)
+
+# builds and runs the check, which fails unless every element pushed on one thread is popped once, in order, on another
+test: $(TARGET)
+	$(TARGET)
+
+# builds and runs the benchmark against the previous, modulo indexed, queue
+bench: $(TARGET)
+	$(TARGET) bench $(BENCH_ELEMENTS)
+
+.PHONY: test bench
@@ -0,0 +1,191 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Checks IRECTList::Optimize() against the rects it replaces, and against IRECTList::OptimizePairwise(), the previous implementation
+ * For known layouts and random ones, Optimize() must return rects that don't overlap and cover the same area as the input,
+ * and with a maximum overdraw, rects that don't overlap and cover at least that area, with at most that fraction of each rect uncovered.
+ * They must also cover all of the area that OptimizePairwise() covers, which can be less than the input where several rects overlap one rect.
+ * Returns 0 if every check passes
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "IGraphicsStructs.h"
+
+using namespace iplug;
+using namespace igraphics;
+
+static constexpr float kGridStep = 0.5f; // rect edges are on a grid of whole units, so coverage is sampled at the centre of each half unit
+
+static bool Overlaps(const IRECT& a, const IRECT& b)
+{
+  return a.L < b.R && b.L < a.R && a.T < b.B && b.T < a.B;
+}
+
+template <typename Rects>
+static bool Covers(const Rects& rects, float x, float y)
+{
+  for (const auto& r : rects)
+  {
+    if (r.Contains(x, y))
+      return true;
+  }
+
+  return false;
+}
+
+static std::vector<IRECT> ToVector(const IRECTList& rects)
+{
+  std::vector<IRECT> v;
+
+  for (auto i = 0; i < rects.Size(); i++)
+    v.push_back(rects.Get(i));
+
+  return v;
+}
+
+/** @return \c true if no two rects in the list overlap */
+static bool NoOverlaps(const IRECTList& rects)
+{
+  for (auto i = 0; i < rects.Size(); i++)
+  {
+    for (auto j = i + 1; j < rects.Size(); j++)
+    {
+      if (Overlaps(rects.Get(i), rects.Get(j)))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+static int sNumPairwiseMissing = 0; // cases where OptimizePairwise() doesn't cover all of the input
+
+/** Optimizes a copy of the rects with OptimizePairwise() and with Optimize(maxOverdraw), and compares the results with each other and the input
+ * @return \c true if Optimize() is correct */
+static bool Check(const char* name, const std::vector<IRECT>& input, float maxOverdraw)
+{
+  IRECTList reference, optimized;
+
+  for (const auto& r : input)
+  {
+    reference.Add(r);
+    optimized.Add(r);
+  }
+
+  const IRECT bounds = reference.Bounds();
+  reference.OptimizePairwise();
+  optimized.Optimize(maxOverdraw);
+
+  const std::vector<IRECT> pairwiseRects = ToVector(reference), optimizedRects = ToVector(optimized);
+  bool pass = NoOverlaps(optimized);
+  bool pairwiseMissing = false;
+
+  // the same area as the input without overdraw, or at least that area with it, and at least the area OptimizePairwise() covers
+  for (auto y = bounds.T + kGridStep / 2.f; y < bounds.B && pass; y += kGridStep)
+  {
+    for (auto x = bounds.L + kGridStep / 2.f; x < bounds.R && pass; x += kGridStep)
+    {
+      const bool inInput = Covers(input, x, y);
+      const bool inOptimized = Covers(optimizedRects, x, y);
+      const bool inPairwise = Covers(pairwiseRects, x, y);
+      pass = (maxOverdraw > 0.f ? (inOptimized || !inInput) : inOptimized == inInput) && (inOptimized || !inPairwise);
+      pairwiseMissing |= inInput && !inPairwise;
+    }
+  }
+
+  sNumPairwiseMissing += pairwiseMissing;
+
+  // no rect is uncovered by more than maxOverdraw of its area
+  for (auto i = 0; i < optimized.Size() && pass; i++)
+  {
+    const IRECT& r = optimized.Get(i);
+    int nSamples = 0, nCovered = 0;
+
+    for (auto y = r.T + kGridStep / 2.f; y < r.B; y += kGridStep)
+    {
+      for (auto x = r.L + kGridStep / 2.f; x < r.R; x += kGridStep)
+      {
+        nSamples++;
+        nCovered += Covers(input, x, y);
+      }
+    }
+
+    pass = nCovered >= (1.f - maxOverdraw) * nSamples - 0.5f;
+  }
+
+  if (!pass)
+  {
+    printf("FAILED: %s, maximum overdraw %g\n", name, maxOverdraw);
+
+    for (const auto& r : input)
+      printf("  in  (%g, %g, %g, %g)\n", r.L, r.T, r.R, r.B);
+
+    for (auto i = 0; i < optimized.Size(); i++)
+      printf("  out (%g, %g, %g, %g)\n", optimized.Get(i).L, optimized.Get(i).T, optimized.Get(i).R, optimized.Get(i).B);
+  }
+
+  return pass;
+}
+
+int main()
+{
+  bool pass = true;
+
+  // a rect in the gap between two neighbours in a row: merging the row must not overlap it
+  const std::vector<IRECT> inGap = {IRECT(0, 0, 10, 10), IRECT(20, 0, 30, 10), IRECT(12, 2, 18, 8)};
+
+  for (auto maxOverdraw : {0.f, 0.25f, 0.5f, 0.9f})
+    pass &= Check("rect in the gap", inGap, maxOverdraw);
+
+  // a row of controls, with a gap that a merge can absorb
+  const std::vector<IRECT> row = {IRECT(0, 0, 10, 10), IRECT(12, 0, 22, 10), IRECT(24, 0, 34, 10), IRECT(10, 0, 12, 10)};
+
+  for (auto maxOverdraw : {0.f, 0.5f})
+    pass &= Check("row", row, maxOverdraw);
+
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> pos(0, 40), size(1, 12), count(2, 12);
+  int nRandom = 0;
+
+  for (auto iteration = 0; iteration < 2000; iteration++)
+  {
+    std::vector<IRECT> input;
+    const int n = count(rng);
+
+    for (auto i = 0; i < n; i++)
+    {
+      const float l = static_cast<float>(pos(rng)), t = static_cast<float>(pos(rng));
+
+      // some rects share a row or column with the previous one, as controls in a layout do
+      if (i && (rng() % 3) == 0)
+        input.push_back(IRECT(l, input.back().T, l + size(rng), input.back().B));
+      else if (i && (rng() % 3) == 0)
+        input.push_back(IRECT(input.back().L, t, input.back().R, t + size(rng)));
+      else
+        input.push_back(IRECT(l, t, l + size(rng), t + size(rng)));
+    }
+
+    for (auto maxOverdraw : {0.f, 0.2f, 0.5f})
+    {
+      pass &= Check("random", input, maxOverdraw);
+      nRandom++;
+    }
+  }
+
+  printf("IRECTList::Optimize(): %d random cases and the known layouts %s. OptimizePairwise() left out part of the input in %d cases\n",
+         nRandom, pass ? "ok" : "FAILED", sNumPairwiseMissing);
+
+  return pass ? 0 : 1;
+}
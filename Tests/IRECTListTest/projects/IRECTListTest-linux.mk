@@ -0,0 +1,22 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/IRECTListTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+TARGET = ../build-linux/IRECTListTest
+
+# IRECTList is header-only, so none of the plug-in sources in SRC are needed
+TEST_SRC = $(PROJECT_ROOT)/IRECTListTest.cpp
+
+CFLAGS += $(LICE_CFLAGS) $(EXTRA_CFLAGS)
+
+$(TARGET): $(TEST_SRC)
+	mkdir -p $(dir $@)
+	$(CXX) $(CFLAGS) -o $@ $(TEST_SRC) $(LDFLAGS)
+
+# builds and runs the check, which fails if Optimize() returns overlapping rects, or covers the wrong area
+test: $(TARGET)
+	$(TARGET)
+
+.PHONY: test
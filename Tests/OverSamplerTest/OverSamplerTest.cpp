@@ -0,0 +1,357 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Checks that the multi-channel HIIR resamplers, which process channels in SIMD lanes, are bit-exact with the FPU ones, and times them
+ * Usage: OverSamplerTest [bench]
+ * Without arguments, compares Upsampler2xMulti and Downsampler2xMulti with one Upsampler2xFPU / Downsampler2xFPU per channel, for every
+ * coefficient count OverSampler uses, 1 to 13 channels, float and double, and compares OverSampler at every factor with a chain of FPU resamplers.
+ * Returns 0 if everything is bit-exact. With "bench", prints the time per block of the FPU and multi-channel resamplers, and of OverSampler
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "IPlugConstants.h"
+#include "Oversampler.h"
+#include "HIIR/FPUUpsampler2x.h"
+#include "HIIR/FPUDownsampler2x.h"
+
+using namespace iplug;
+
+static constexpr double kCoeffs12[12] = { 0.036681502163648017, 0.13654762463195794, 0.27463175937945444, 0.42313861743656711, 0.56109869787919531, 0.67754004997416184, 0.76974183386322703, 0.83988962484963892, 0.89226081800387902, 0.9315419599631839, 0.96209454837808417, 0.98781637073289585 };
+static constexpr double kCoeffs4[4] = {0.041893991997656171, 0.16890348243995201, 0.39056077292116603, 0.74389574826847926 };
+static constexpr double kCoeffs3[3] = {0.055748680811302048, 0.24305119574153072, 0.64669913119268196 };
+static constexpr double kCoeffs2[2] = {0.10717745346023573, 0.53091435354504557 };
+
+static constexpr int kMaxChannels = 13;
+
+static const char* SIMDName()
+{
+#if defined HIIR_USE_AVX
+  return "AVX";
+#elif defined HIIR_USE_SSE2
+  return "SSE2";
+#elif defined HIIR_USE_NEON
+  return "NEON";
+#else
+  return "FPU";
+#endif
+}
+
+template <typename T>
+static const char* TypeName() { return sizeof(T) == sizeof(float) ? "float" : "double"; }
+
+template <typename T>
+static void FillNoise(std::vector<std::vector<T>>& bufs, std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> noise(-1., 1.);
+
+  for (auto& buf : bufs)
+  {
+    for (auto& s : buf)
+      s = static_cast<T>(noise(rng));
+  }
+}
+
+/** Runs a few blocks through nChans channels of the multi-channel and FPU resamplers, processing only some of the channels in every other block
+ * @return \c true if the outputs are bit-exact */
+template <int NC, typename T>
+static bool CheckResamplers(const double* pCoeffs, int nChans, int nFrames)
+{
+  Upsampler2xMulti<NC, T> multiUp(nChans);
+  Downsampler2xMulti<NC, T> multiDown(nChans);
+  std::vector<Upsampler2xFPU<NC, T>> fpuUp(nChans);
+  std::vector<Downsampler2xFPU<NC, T>> fpuDown(nChans);
+
+  multiUp.set_coefs(pCoeffs);
+  multiDown.set_coefs(pCoeffs);
+
+  for (auto c = 0; c < nChans; c++)
+  {
+    fpuUp[c].set_coefs(pCoeffs);
+    fpuDown[c].set_coefs(pCoeffs);
+  }
+
+  std::mt19937 rng(NC * 100 + nChans);
+  std::vector<std::vector<T>> inputs(nChans, std::vector<T>(nFrames));
+  std::vector<std::vector<T>> multiUpOut(nChans, std::vector<T>(2 * nFrames)), fpuUpOut(multiUpOut);
+  std::vector<std::vector<T>> multiDownOut(nChans, std::vector<T>(nFrames)), fpuDownOut(multiDownOut);
+  std::vector<const T*> inPtrs(nChans), upOutConstPtrs(nChans);
+  std::vector<T*> upOutPtrs(nChans), downOutPtrs(nChans);
+
+  for (auto c = 0; c < nChans; c++)
+  {
+    inPtrs[c] = inputs[c].data();
+    upOutPtrs[c] = multiUpOut[c].data();
+    upOutConstPtrs[c] = multiUpOut[c].data();
+    downOutPtrs[c] = multiDownOut[c].data();
+  }
+
+  bool exact = true;
+
+  for (auto block = 0; block < 6; block++)
+  {
+    const int nProcessed = (block % 2) ? (nChans + 1) / 2 : nChans;
+
+    FillNoise(inputs, rng);
+
+    multiUp.process_block(upOutPtrs.data(), inPtrs.data(), nProcessed, nFrames);
+    multiDown.process_block(downOutPtrs.data(), upOutConstPtrs.data(), nProcessed, nFrames);
+
+    for (auto c = 0; c < nProcessed; c++)
+    {
+      fpuUp[c].process_block(fpuUpOut[c].data(), inputs[c].data(), nFrames);
+      fpuDown[c].process_block(fpuDownOut[c].data(), fpuUpOut[c].data(), nFrames);
+
+      exact &= memcmp(multiUpOut[c].data(), fpuUpOut[c].data(), 2 * nFrames * sizeof(T)) == 0;
+      exact &= memcmp(multiDownOut[c].data(), fpuDownOut[c].data(), nFrames * sizeof(T)) == 0;
+    }
+  }
+
+  // the per-sample path that OverSampler::Process() uses, on channel 0
+  T multiPair[2], fpuPair[2];
+  multiUp.process_sample(0, multiPair[0], multiPair[1], static_cast<T>(0.3));
+  fpuUp[0].process_sample(fpuPair[0], fpuPair[1], static_cast<T>(0.3));
+  exact &= multiPair[0] == fpuPair[0] && multiPair[1] == fpuPair[1];
+  exact &= multiDown.process_sample(0, multiPair) == fpuDown[0].process_sample(fpuPair);
+
+  if (!exact)
+    printf("MISMATCH: %d coefficients, %s, %d channels, %d frames\n", NC, TypeName<T>(), nChans, nFrames);
+
+  return exact;
+}
+
+/** Runs OverSampler with a pass-through function, and compares it with up and down sampling each channel through a chain of FPU resamplers
+ * @return \c true if the outputs are bit-exact */
+template <typename T>
+static bool CheckOverSampler(EFactor factor, int nChans, int nFrames)
+{
+  OverSampler<T> overSampler(factor, true, nChans, nChans);
+  overSampler.Reset(nFrames);
+
+  const int nStages = static_cast<int>(factor);
+  std::vector<Upsampler2xFPU<12, T>> up2(nChans);
+  std::vector<Upsampler2xFPU<4, T>> up4(nChans);
+  std::vector<Upsampler2xFPU<3, T>> up8(nChans);
+  std::vector<Upsampler2xFPU<2, T>> up16(nChans);
+  std::vector<Downsampler2xFPU<12, T>> down2(nChans);
+  std::vector<Downsampler2xFPU<4, T>> down4(nChans);
+  std::vector<Downsampler2xFPU<3, T>> down8(nChans);
+  std::vector<Downsampler2xFPU<2, T>> down16(nChans);
+
+  for (auto c = 0; c < nChans; c++)
+  {
+    up2[c].set_coefs(kCoeffs12);
+    up4[c].set_coefs(kCoeffs4);
+    up8[c].set_coefs(kCoeffs3);
+    up16[c].set_coefs(kCoeffs2);
+    down2[c].set_coefs(kCoeffs12);
+    down4[c].set_coefs(kCoeffs4);
+    down8[c].set_coefs(kCoeffs3);
+    down16[c].set_coefs(kCoeffs2);
+  }
+
+  std::mt19937 rng(nStages * 100 + nChans);
+  std::vector<std::vector<T>> inputs(nChans, std::vector<T>(nFrames)), outputs(inputs), expected(inputs);
+  std::vector<T> a(16 * nFrames), b(16 * nFrames);
+  std::vector<T*> inPtrs(nChans), outPtrs(nChans);
+
+  for (auto c = 0; c < nChans; c++)
+  {
+    inPtrs[c] = inputs[c].data();
+    outPtrs[c] = outputs[c].data();
+  }
+
+  bool exact = true;
+
+  for (auto block = 0; block < 4; block++)
+  {
+    FillNoise(inputs, rng);
+
+    overSampler.ProcessBlock(inPtrs.data(), outPtrs.data(), nFrames, nChans, nChans, [nChans](T** in, T** out, int n) {
+      for (auto c = 0; c < nChans; c++)
+        memcpy(out[c], in[c], n * sizeof(T));
+    });
+
+    for (auto c = 0; c < nChans; c++)
+    {
+      memcpy(a.data(), inputs[c].data(), nFrames * sizeof(T));
+
+      if (nStages >= 1) { up2[c].process_block(b.data(), a.data(), nFrames); std::swap(a, b); }
+      if (nStages >= 2) { up4[c].process_block(b.data(), a.data(), nFrames * 2); std::swap(a, b); }
+      if (nStages >= 3) { up8[c].process_block(b.data(), a.data(), nFrames * 4); std::swap(a, b); }
+      if (nStages >= 4) { up16[c].process_block(b.data(), a.data(), nFrames * 8); std::swap(a, b); }
+      if (nStages >= 4) { down16[c].process_block(b.data(), a.data(), nFrames * 8); std::swap(a, b); }
+      if (nStages >= 3) { down8[c].process_block(b.data(), a.data(), nFrames * 4); std::swap(a, b); }
+      if (nStages >= 2) { down4[c].process_block(b.data(), a.data(), nFrames * 2); std::swap(a, b); }
+      if (nStages >= 1) { down2[c].process_block(b.data(), a.data(), nFrames); std::swap(a, b); }
+
+      exact &= memcmp(outputs[c].data(), a.data(), nFrames * sizeof(T)) == 0;
+    }
+  }
+
+  if (!exact)
+    printf("MISMATCH: OverSampler<%s> at %dx, %d channels, %d frames\n", TypeName<T>(), 1 << nStages, nChans, nFrames);
+
+  return exact;
+}
+
+template <typename T>
+static bool CheckAll()
+{
+  bool exact = true;
+
+  for (auto nChans = 1; nChans <= kMaxChannels; nChans++)
+  {
+    for (auto nFrames : {1, 64, 257})
+    {
+      exact &= CheckResamplers<12, T>(kCoeffs12, nChans, nFrames);
+      exact &= CheckResamplers<4, T>(kCoeffs4, nChans, nFrames);
+      exact &= CheckResamplers<3, T>(kCoeffs3, nChans, nFrames);
+      exact &= CheckResamplers<2, T>(kCoeffs2, nChans, nFrames);
+    }
+
+    for (auto factor : {k2x, k4x, k8x, k16x})
+      exact &= CheckOverSampler<T>(factor, nChans, 100);
+  }
+
+  printf("%s, %s: %s\n", SIMDName(), TypeName<T>(), exact ? "bit-exact" : "MISMATCH");
+
+  return exact;
+}
+
+/** @return The mean time per call of the fastest of a few runs of nCalls calls, after a warm-up run */
+template <typename Func>
+static double MicrosecondsPerCall(int nCalls, Func&& func)
+{
+  double best = 0.;
+
+  for (auto run = 0; run < 4; run++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+
+    for (auto i = 0; i < nCalls; i++)
+      func();
+
+    const double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / nCalls;
+
+    if (run == 1 || (run > 1 && time < best))
+      best = time;
+  }
+
+  return best;
+}
+
+template <typename T>
+static void Bench()
+{
+  static constexpr int kBlockSize = 512;
+  static constexpr int kNumCalls = 2000;
+
+  std::mt19937 rng(1);
+  std::vector<std::vector<T>> inputs(16, std::vector<T>(kBlockSize)), upOutputs(16, std::vector<T>(2 * kBlockSize)), outputs(inputs);
+  std::vector<T*> inPtrs(16), upOutPtrs(16), outPtrs(16);
+  std::vector<const T*> inConstPtrs(16), upOutConstPtrs(16);
+
+  FillNoise(inputs, rng);
+
+  for (auto c = 0; c < 16; c++)
+  {
+    inPtrs[c] = inputs[c].data();
+    inConstPtrs[c] = inputs[c].data();
+    upOutPtrs[c] = upOutputs[c].data();
+    upOutConstPtrs[c] = upOutputs[c].data();
+    outPtrs[c] = outputs[c].data();
+  }
+
+  printf("\n%s, %s, %d frames, microseconds per block\n", SIMDName(), TypeName<T>(), kBlockSize);
+  printf("channels  12 coefficient up FPU / multi      down FPU / multi\n");
+
+  for (auto nChans : {1, 2, 4, 8, 16})
+  {
+    std::vector<Upsampler2xFPU<12, T>> fpuUp(nChans);
+    std::vector<Downsampler2xFPU<12, T>> fpuDown(nChans);
+    Upsampler2xMulti<12, T> multiUp(nChans);
+    Downsampler2xMulti<12, T> multiDown(nChans);
+
+    for (auto c = 0; c < nChans; c++)
+    {
+      fpuUp[c].set_coefs(kCoeffs12);
+      fpuDown[c].set_coefs(kCoeffs12);
+    }
+
+    multiUp.set_coefs(kCoeffs12);
+    multiDown.set_coefs(kCoeffs12);
+
+    const double fpuUpTime = MicrosecondsPerCall(kNumCalls, [&]() {
+      for (auto c = 0; c < nChans; c++)
+        fpuUp[c].process_block(upOutPtrs[c], inPtrs[c], kBlockSize);
+    });
+
+    const double multiUpTime = MicrosecondsPerCall(kNumCalls, [&]() {
+      multiUp.process_block(upOutPtrs.data(), inConstPtrs.data(), nChans, kBlockSize);
+    });
+
+    const double fpuDownTime = MicrosecondsPerCall(kNumCalls, [&]() {
+      for (auto c = 0; c < nChans; c++)
+        fpuDown[c].process_block(outPtrs[c], upOutPtrs[c], kBlockSize);
+    });
+
+    const double multiDownTime = MicrosecondsPerCall(kNumCalls, [&]() {
+      multiDown.process_block(outPtrs.data(), upOutConstPtrs.data(), nChans, kBlockSize);
+    });
+
+    printf("%8d  %9.1f / %6.1f (x%.2f)  %9.1f / %6.1f (x%.2f)\n", nChans,
+           fpuUpTime, multiUpTime, fpuUpTime / multiUpTime, fpuDownTime, multiDownTime, fpuDownTime / multiDownTime);
+  }
+
+  printf("channels  OverSampler 2x / 4x / 8x / 16x, pass-through\n");
+
+  for (auto nChans : {1, 2, 8})
+  {
+    printf("%8d ", nChans);
+
+    for (auto factor : {k2x, k4x, k8x, k16x})
+    {
+      OverSampler<T> overSampler(factor, true, nChans, nChans);
+      overSampler.Reset(kBlockSize);
+
+      const double time = MicrosecondsPerCall(kNumCalls / 4, [&]() {
+        overSampler.ProcessBlock(inPtrs.data(), outPtrs.data(), kBlockSize, nChans, nChans, [nChans](T** in, T** out, int n) {
+          for (auto c = 0; c < nChans; c++)
+            memcpy(out[c], in[c], n * sizeof(T));
+        });
+      });
+
+      printf(" %8.1f", time);
+    }
+
+    printf("\n");
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1 && !strcmp(argv[1], "bench"))
+  {
+    Bench<float>();
+    Bench<double>();
+    return 0;
+  }
+
+  const bool exact = CheckAll<float>() & CheckAll<double>();
+
+  return exact ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/OverSamplerTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+# the instruction set, e.g. make -f OverSamplerTest-linux.mk test SIMD_CFLAGS="-mavx2 -mfma". SSE2 by default on x86-64
+SIMD_CFLAGS ?=
+
+TARGET = ../build-linux/OverSamplerTest
+
+# only header-only code is tested, so none of the plug-in sources in SRC are needed
+TEST_SRC = $(PROJECT_ROOT)/OverSamplerTest.cpp
+
+CFLAGS += $(SIMD_CFLAGS) $(EXTRA_CFLAGS)
+
+$(TARGET): $(TEST_SRC)
+	mkdir -p $(dir $@)
+	$(CXX) $(CFLAGS) -o $@ $(TEST_SRC) $(LDFLAGS)
+
+# builds and runs the check, which fails unless the multi-channel resamplers are bit-exact with the FPU ones
+test: $(TARGET)
+	$(TARGET)
+
+# builds and runs the benchmark
+bench: $(TARGET)
+	$(TARGET) bench
+
+.PHONY: test bench
@@ -0,0 +1,350 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Checks that lock-free parameter state restore (IPluginBase::SetLockFreeStateRestore()) never blocks the audio thread, and never hands it a torn state
+ * Usage: ParamStateTest [seconds]
+ * First, a thread stalls in the middle of writing, or of adopting, a state in IParamStateExchange. The audio thread must still return, if it waits for the stalled thread the test times out.
+ * Then the restore handshake of a plug-in is checked: a state is adopted by UnserializeParams() while processing is inactive, and is staged, and reported by GetPendingParamState(), while it is active.
+ * Last, for a number of seconds (2 by default), a host thread activates processing, processes blocks and deactivates it again, while the main thread restores and saves states.
+ * Every state holds the same value in every parameter, so a torn state is detected. The worst time taken by ProcessPendingParamState() is printed.
+ * Returns 0 if every check passes
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "IPlugAPIBase.h"
+#include "IPlugParamStateExchange.h"
+
+using namespace iplug;
+
+static constexpr int kNParams = 16;
+static constexpr int kBlocksPerActivation = 64;
+
+/** Runs func on a new thread, as the audio thread, and exits the test if it hasn't returned after a second, which means it waited for another thread
+ * @param name Printed if func blocks */
+template <typename Func>
+static bool RunWithoutBlocking(const char* name, Func func)
+{
+  std::atomic<bool> done{false};
+  bool result = false;
+
+  std::thread audioThread([&]() {
+    result = func();
+    done.store(true, std::memory_order_release);
+  });
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+  while (!done.load(std::memory_order_acquire))
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+    {
+      printf("FAILED: %s, the audio thread blocked\n", name);
+      std::_Exit(1);
+    }
+
+    std::this_thread::yield();
+  }
+
+  audioThread.join();
+  return result;
+}
+
+/** Fills a state with value, in place of a host chunk, and publishes it */
+static void Publish(IParamStateExchange& exchange, double value)
+{
+  double* pValues = exchange.BeginWrite();
+  std::fill(pValues, pValues + exchange.NValues(), value);
+  exchange.EndWrite();
+}
+
+/** A writer that stalls between IParamStateExchange::BeginWrite() and EndWrite() must not block adoption of the previous state */
+static bool CheckStalledWriter()
+{
+  IParamStateExchange exchange;
+  exchange.Resize(kNParams);
+  Publish(exchange, 1.);
+
+  std::atomic<bool> writing{false}, adopted{false};
+
+  std::thread writer([&]() {
+    double* pValues = exchange.BeginWrite();
+    writing.store(true, std::memory_order_release);
+
+    while (!adopted.load(std::memory_order_acquire))
+      std::this_thread::yield();
+
+    std::fill(pValues, pValues + exchange.NValues(), 2.);
+    exchange.EndWrite();
+  });
+
+  while (!writing.load(std::memory_order_acquire))
+    std::this_thread::yield();
+
+  const bool pass = RunWithoutBlocking("stalled writer", [&]() {
+    const double* pValues = exchange.BeginAdopt();
+    const bool ok = pValues && pValues[0] == 1. && pValues[kNParams - 1] == 1.;
+
+    if (pValues)
+      exchange.EndAdopt();
+
+    return ok;
+  });
+
+  adopted.store(true, std::memory_order_release);
+  writer.join();
+
+  // the stalled state is adopted at the next block
+  const double* pValues = exchange.BeginAdopt();
+  const bool adoptedLater = pValues && pValues[0] == 2.;
+
+  if (pValues)
+    exchange.EndAdopt();
+
+  if (!pass || !adoptedLater)
+    printf("FAILED: stalled writer, %s\n", pass ? "the stalled state was not adopted afterwards" : "the published state was not adopted");
+
+  return pass && adoptedLater;
+}
+
+/** The audio thread must not wait for a non-realtime thread that stalls while adopting a state, and a writer must be able to publish meanwhile */
+static bool CheckStalledAdopter()
+{
+  IParamStateExchange exchange;
+  exchange.Resize(kNParams);
+  Publish(exchange, 1.);
+
+  const double* pStalled = exchange.BeginAdopt();
+
+  const bool skipped = RunWithoutBlocking("stalled adopter", [&]() {
+    Publish(exchange, 2.);
+    return exchange.BeginAdopt() == nullptr;
+  });
+
+  exchange.EndAdopt();
+
+  const double* pValues = exchange.BeginAdopt();
+  const bool adoptedLater = pStalled && pValues && pValues[0] == 2.;
+
+  if (pValues)
+    exchange.EndAdopt();
+
+  if (!skipped || !adoptedLater)
+    printf("FAILED: stalled adopter, %s\n", skipped ? "the state published meanwhile was not adopted afterwards" : "the audio thread adopted a state while another thread was adopting");
+
+  return skipped && adoptedLater;
+}
+
+/** A plug-in with kNParams parameters that restores state lock-free, and counts the calls to OnRestoreState() */
+class ParamStatePlug : public IPlugAPIBase
+{
+public:
+  ParamStatePlug(bool lockFree)
+  : IPlugAPIBase(Config(kNParams, 0, "0-2", "ParamStateTest", "ParamStateTest", "iPlug2", 0x10000, 'Ipst', 'Acme', 0, false, false, false, false, 0, false, 0, 0, false, 0, 0, 0, 0, ""), kAPICLI)
+  {
+    for (int i = 0; i < kNParams; i++)
+      GetParam(i)->InitDouble("Value", 0., 0., 1e9, 1.);
+
+    SetLockFreeStateRestore(lockFree);
+  }
+
+  void InformHostOfPresetChange() override {}
+
+  void OnRestoreState() override { mNRestoreStateCalls++; }
+
+  /** @return The value of every parameter, or -1 if they are not all the same */
+  double GetStateValue() const
+  {
+    const double value = GetParam(0)->Value();
+
+    for (int i = 1; i < kNParams; i++)
+    {
+      if (GetParam(i)->Value() != value)
+        return -1.;
+    }
+
+    return value;
+  }
+
+  int mNRestoreStateCalls = 0;
+};
+
+/** @return A host chunk holding value for every parameter */
+static IByteChunk MakeState(double value)
+{
+  IByteChunk chunk;
+
+  for (int i = 0; i < kNParams; i++)
+    chunk.Put(&value);
+
+  return chunk;
+}
+
+/** @return The value of every parameter in a saved state, or -1 if they are not all the same */
+static double GetSavedStateValue(const ParamStatePlug& plug)
+{
+  IByteChunk chunk;
+  plug.SerializeParams(chunk);
+
+  double value = 0., first = 0.;
+  int pos = chunk.Get(&first, 0);
+
+  for (int i = 1; i < kNParams && pos >= 0; i++)
+  {
+    pos = chunk.Get(&value, pos);
+
+    if (value != first)
+      return -1.;
+  }
+
+  return pos >= 0 ? first : -1.;
+}
+
+/** Checks when a restored state is adopted, what the API class reports to the host and the user interface meanwhile, and that OnRestoreState() is left to the idle timer */
+static bool CheckHandshake()
+{
+  bool pass = true;
+  auto check = [&pass](bool ok, const char* what) {
+    if (!ok)
+      printf("FAILED: %s\n", what);
+
+    pass &= ok;
+  };
+
+  ParamStatePlug lockingPlug(false);
+  lockingPlug.UnserializeParams(MakeState(3.), 0);
+  lockingPlug.CallOnRestoreState();
+  check(lockingPlug.GetStateValue() == 3. && lockingPlug.mNRestoreStateCalls == 1, "without lock-free restore, the state is set and OnRestoreState() is called straight away");
+
+  ParamStatePlug plug(true);
+  std::vector<double> pending(kNParams);
+
+  // the host has not activated processing, or has deactivated it
+  plug.SetProcessingActive(false);
+  plug.UnserializeParams(MakeState(5.), 0);
+  plug.CallOnRestoreState();
+  check(plug.GetStateValue() == 5., "a state restored while processing is inactive is adopted straight away");
+  check(!plug.GetPendingParamState(pending.data()), "once adopted, a state is not reported as pending");
+  check(plug.mNRestoreStateCalls == 0, "OnRestoreState() is left to the idle timer");
+
+  // the host is processing, so the state waits for the next block
+  plug.SetProcessingActive(true);
+  plug.UnserializeParams(MakeState(6.), 0);
+  check(plug.GetStateValue() == 5., "a state restored while processing is active is not adopted until the next block");
+  check(plug.GetPendingParamState(pending.data()) && pending[0] == 6. && pending[kNParams - 1] == 6., "a staged state is reported to the API class, for the host's controller");
+  check(GetSavedStateValue(plug) == 6., "a staged state is saved if the host saves before the next block");
+  check(plug.ProcessPendingParamState() && plug.GetStateValue() == 6., "the audio thread adopts a staged state");
+  check(!plug.ProcessPendingParamState(), "a state is only adopted once");
+
+  return pass;
+}
+
+/** For a number of seconds, the host activates processing, processes blocks on its own thread and deactivates processing, while the main thread restores and saves states.
+ * The audio thread must only ever see complete states, in the order they were restored */
+static bool StressTest(double seconds)
+{
+  ParamStatePlug plug(true);
+  std::atomic<bool> stop{false};
+  std::atomic<bool> hostPass{true};
+  long nBlocks = 0, nAdopted = 0;
+  double worstMicroseconds = 0.;
+
+  std::thread host([&]() {
+    double lastValue = 0.;
+
+    while (!stop.load(std::memory_order_acquire))
+    {
+      plug.SetProcessingActive(true);
+
+      for (int block = 0; block < kBlocksPerActivation; block++)
+      {
+        const auto start = std::chrono::steady_clock::now();
+        const bool adopted = plug.ProcessPendingParamState();
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        worstMicroseconds = std::max(worstMicroseconds, elapsed.count());
+        nBlocks++;
+        nAdopted += adopted;
+
+        const double value = plug.GetStateValue();
+
+        if (value < lastValue)
+        {
+          printf("FAILED: stress test, the audio thread saw %s state (%g after %g)\n", value < 0. ? "a torn" : "an older", value, lastValue);
+          hostPass.store(false);
+        }
+
+        lastValue = value;
+      }
+
+      plug.SetProcessingActive(false);
+      std::this_thread::yield();
+    }
+  });
+
+  bool pass = true;
+  double value = 0.;
+  const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+
+  while (std::chrono::steady_clock::now() < end && pass && hostPass.load())
+  {
+    plug.UnserializeParams(MakeState(++value), 0);
+
+    // whether it has been adopted or not, the state just restored is the one saved
+    const double saved = GetSavedStateValue(plug);
+
+    if (saved != value)
+    {
+      printf("FAILED: stress test, saved %g after restoring %g\n", saved, value);
+      pass = false;
+    }
+  }
+
+  stop.store(true, std::memory_order_release);
+  host.join();
+
+  // the last state is adopted at the next block, if it hasn't been already
+  plug.SetProcessingActive(true);
+  plug.ProcessPendingParamState();
+
+  if (pass && hostPass.load() && plug.GetStateValue() != value)
+  {
+    printf("FAILED: stress test, ended with %g after restoring %g\n", plug.GetStateValue(), value);
+    pass = false;
+  }
+
+  printf("Stress test: %.0f states restored, %ld blocks, %ld states adopted by the audio thread, worst ProcessPendingParamState() %.1f us\n",
+         value, nBlocks, nAdopted, worstMicroseconds);
+
+  return pass && hostPass.load();
+}
+
+int main(int argc, char* argv[])
+{
+  const double seconds = argc > 1 ? atof(argv[1]) : 2.;
+  bool pass = true;
+
+  pass &= CheckStalledWriter();
+  pass &= CheckStalledAdopter();
+  pass &= CheckHandshake();
+  pass &= StressTest(seconds);
+
+  printf("Lock-free parameter state restore %s\n", pass ? "ok" : "FAILED");
+
+  return pass ? 0 : 1;
+}
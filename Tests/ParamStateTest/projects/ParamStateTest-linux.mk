@@ -0,0 +1,26 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/ParamStateTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+# the duration of the stress test in seconds
+STRESS_SECONDS ?= 2
+
+TARGET = ../build-linux/ParamStateTest
+
+# the test plug-in is built on IPlugAPIBase alone, without a user interface, e.g. make -f ParamStateTest-linux.mk test EXTRA_CFLAGS=-fsanitize=thread
+TEST_SRC = $(IPLUG_SRC) \
+	$(PROJECT_ROOT)/ParamStateTest.cpp
+
+CFLAGS += $(CLI_CFLAGS) $(EXTRA_CFLAGS)
+
+$(TARGET): $(TEST_SRC)
+	mkdir -p $(dir $@)
+	$(CXX) $(CFLAGS) -o $@ $(TEST_SRC) $(LDFLAGS)
+
+# builds and runs the check, which fails if the audio thread blocks on a stalled thread, or sees a torn or out of order state
+test: $(TARGET)
+	$(TARGET) $(STRESS_SECONDS)
+
+.PHONY: test
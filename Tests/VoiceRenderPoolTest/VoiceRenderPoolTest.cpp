@@ -0,0 +1,242 @@
+/*
+ ==============================================================================
+
+ This file is part of the iPlug 2 library. Copyright (C) the iPlug 2 developers.
+
+ See LICENSE.txt for  more info.
+
+ ==============================================================================
+*/
+
+/**
+ * @file
+ * @brief Checks that VoiceAllocator renders the same output with a VoiceRenderPool as without one, and times serial against parallel rendering
+ * Usage: VoiceRenderPoolTest [bench [partials]]
+ * Without arguments, renders blocks of voices serially and with 1 to 3 workers, in whole blocks and in sub-blocks as MidiSynth does between MIDI events.
+ * The pool sums the voices in a different order, so the outputs must match to within rounding. Returns 0 if they do.
+ * With "bench", prints the time per block of serial rendering and of the pool with each number of workers, for several voice counts and block sizes.
+ * Each voice is an additive oscillator with a number of partials (32 by default), which sets the cost of a voice
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "VoiceAllocator.h"
+
+using namespace iplug;
+
+static constexpr int kNChannels = 2;
+static constexpr int kMaxBlockSize = 512;
+static constexpr double kSampleRate = 48000.;
+
+/** An additive oscillator that is always busy, with its own state only, as voices rendered in parallel must be */
+class BenchVoice : public SynthVoice
+{
+public:
+  BenchVoice(int voiceIdx, int nPartials)
+  : mPhases(nPartials, 0.)
+  , mIncrements(nPartials)
+  {
+    const double freq = 55. * std::pow(2., (voiceIdx % 48) / 12.);
+
+    for (int p = 0; p < nPartials; p++)
+      mIncrements[p] = 2. * PI * freq * (p + 1) / kSampleRate;
+
+    mPan = (voiceIdx % 7) / 6.;
+  }
+
+  bool GetBusy() const override { return true; }
+
+  void ProcessSamplesAccumulating(sample** inputs, sample** outputs, int nInputs, int nOutputs, int startIdx, int nFrames) override
+  {
+    const int nPartials = static_cast<int>(mPhases.size());
+
+    for (int s = startIdx; s < startIdx + nFrames; s++)
+    {
+      double out = 0.;
+
+      for (int p = 0; p < nPartials; p++)
+      {
+        out += std::sin(mPhases[p]) / (p + 1);
+        mPhases[p] += mIncrements[p];
+
+        if (mPhases[p] > 2. * PI)
+          mPhases[p] -= 2. * PI;
+      }
+
+      out *= 0.01;
+      outputs[0][s] += static_cast<sample>(out * (1. - mPan));
+
+      if (nOutputs > 1)
+        outputs[1][s] += static_cast<sample>(out * mPan);
+    }
+  }
+
+private:
+  std::vector<double> mPhases;
+  std::vector<double> mIncrements;
+  double mPan = 0.5;
+};
+
+/** A VoiceAllocator with nVoices busy voices, rendering serially or with nWorkers workers, into its own output buffers */
+class Renderer
+{
+public:
+  Renderer(int nVoices, int nPartials, int nWorkers)
+  : mBuffers(kNChannels, std::vector<sample>(kMaxBlockSize))
+  {
+    for (int v = 0; v < nVoices; v++)
+    {
+      mVoices.emplace_back(new BenchVoice(v, nPartials));
+      mAllocator.AddVoice(mVoices.back().get(), 0);
+    }
+
+    for (auto& buffer : mBuffers)
+      mOutputs.push_back(buffer.data());
+
+    if (nWorkers > 0)
+    {
+      mPool.Start(nWorkers, kNChannels, kMaxBlockSize);
+      mAllocator.SetRenderPool(&mPool);
+    }
+  }
+
+  /** Renders a block of nFrames, in sub-blocks of at most subBlockSize as MidiSynth does between MIDI events */
+  void ProcessBlock(int nFrames, int subBlockSize)
+  {
+    for (auto& buffer : mBuffers)
+      std::fill(buffer.begin(), buffer.begin() + nFrames, 0.);
+
+    for (int start = 0; start < nFrames; start += subBlockSize)
+      mAllocator.ProcessVoices(nullptr, mOutputs.data(), 0, kNChannels, start, std::min(subBlockSize, nFrames - start));
+  }
+
+  const std::vector<std::vector<sample>>& GetBuffers() const { return mBuffers; }
+
+private:
+  VoiceAllocator mAllocator;
+  VoiceRenderPool mPool;
+  std::vector<std::unique_ptr<BenchVoice>> mVoices;
+  std::vector<std::vector<sample>> mBuffers;
+  std::vector<sample*> mOutputs;
+};
+
+/** Renders nBlocks serially and with nWorkers workers
+ * @return \c true if the outputs match to within rounding */
+static bool Check(int nVoices, int nWorkers, int blockSize, int subBlockSize)
+{
+  static constexpr int kNBlocks = 50;
+  Renderer serial(nVoices, 4, 0);
+  Renderer parallel(nVoices, 4, nWorkers);
+  double maxError = 0.;
+
+  for (int block = 0; block < kNBlocks; block++)
+  {
+    serial.ProcessBlock(blockSize, subBlockSize);
+    parallel.ProcessBlock(blockSize, subBlockSize);
+
+    for (int c = 0; c < kNChannels; c++)
+    {
+      for (int s = 0; s < blockSize; s++)
+        maxError = std::max(maxError, std::fabs(static_cast<double>(serial.GetBuffers()[c][s] - parallel.GetBuffers()[c][s])));
+    }
+  }
+
+  const bool pass = maxError < 1e-12 * nVoices;
+
+  if (!pass)
+    printf("FAILED: %d voices, %d workers, %d frames in blocks of %d: error %g\n", nVoices, nWorkers, blockSize, subBlockSize, maxError);
+
+  return pass;
+}
+
+/** @return The mean time in microseconds to render a block of blockSize frames */
+static double TimeBlocks(Renderer& renderer, int blockSize)
+{
+  static constexpr int kNWarmupBlocks = 20;
+  static constexpr double kSecondsPerCase = 0.25;
+
+  for (int block = 0; block < kNWarmupBlocks; block++)
+    renderer.ProcessBlock(blockSize, blockSize);
+
+  const auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed {0.};
+  int nBlocks = 0;
+
+  while (elapsed.count() < kSecondsPerCase)
+  {
+    renderer.ProcessBlock(blockSize, blockSize);
+    nBlocks++;
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+
+  return 1e6 * elapsed.count() / nBlocks;
+}
+
+static void Bench(int nPartials)
+{
+  const int maxWorkers = std::max(1, std::min(7, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+
+  printf("VoiceAllocator::ProcessVoices(), %d partials per voice, %d channels, %g Hz, up to %d workers\n", nPartials, kNChannels, kSampleRate, maxWorkers);
+  printf("%8s %8s %14s", "voices", "frames", "serial (us)");
+
+  for (int nWorkers = 1; nWorkers <= maxWorkers; nWorkers++)
+    printf("   %d worker%s (us)", nWorkers, nWorkers > 1 ? "s" : " ");
+
+  printf("   block (us)\n");
+
+  for (int nVoices : {4, 16, 64})
+  {
+    for (int blockSize : {64, 512})
+    {
+      Renderer serial(nVoices, nPartials, 0);
+      const double serialTime = TimeBlocks(serial, blockSize);
+      printf("%8d %8d %14.1f", nVoices, blockSize, serialTime);
+
+      for (int nWorkers = 1; nWorkers <= maxWorkers; nWorkers++)
+      {
+        Renderer parallel(nVoices, nPartials, nWorkers);
+        const double parallelTime = TimeBlocks(parallel, blockSize);
+        printf(" %8.1f (x%4.2f)", parallelTime, serialTime / parallelTime);
+      }
+
+      // the time available to render the block in real time
+      printf(" %12.1f\n", 1e6 * blockSize / kSampleRate);
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1 && !strcmp(argv[1], "bench"))
+  {
+    Bench(argc > 2 ? std::max(1, atoi(argv[2])) : 32);
+    return 0;
+  }
+
+  bool pass = true;
+  int nCases = 0;
+
+  for (int nVoices : {2, 7, 32})
+  {
+    for (int nWorkers : {1, 2, 3})
+    {
+      for (int subBlockSize : {kMaxBlockSize, 100, 16})
+      {
+        pass &= Check(nVoices, nWorkers, kMaxBlockSize, subBlockSize);
+        nCases++;
+      }
+    }
+  }
+
+  printf("VoiceRenderPool: %d cases %s\n", nCases, pass ? "ok" : "FAILED");
+
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+# IPLUG2_ROOT should point to the top level IPLUG2 folder from the project folder
+# By default, that is three directories up from /Tests/VoiceRenderPoolTest/projects
+IPLUG2_ROOT = ../../..
+
+include ../../../common-cli.mk
+
+# the number of partials in each voice of the benchmark, which sets the cost of a voice
+BENCH_PARTIALS ?= 32
+
+TARGET = ../build-linux/VoiceRenderPoolTest
+
+# only the voice allocator is needed, none of the plug-in sources in SRC
+TEST_SRC = $(IPLUG_SYNTH_PATH)/VoiceAllocator.cpp \
+	$(PROJECT_ROOT)/VoiceRenderPoolTest.cpp
+
+CFLAGS += $(EXTRA_CFLAGS)
+
+$(TARGET): $(TEST_SRC)
+	mkdir -p $(dir $@)
+	$(CXX) $(CFLAGS) -o $@ $(TEST_SRC) $(LDFLAGS)
+
+# builds and runs the check, which fails unless rendering with the pool matches serial rendering to within rounding
+test: $(TARGET)
+	$(TARGET)
+
+# builds and runs the serial against parallel benchmark
+bench: $(TARGET)
+	$(TARGET) bench $(BENCH_PARTIALS)
+
+.PHONY: test bench
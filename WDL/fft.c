@@ -26,6 +26,11 @@
 
   The DJB FFT web page is:  http://cr.yp.to/djbfft.html
 
+
+  Altered for iPlug 2: the radix-4 passes and the complex multiplies use SSE2,
+  or AVX when the CPU supports it (see fft_simd.h). Define WDL_FFT_NO_AVX to
+  use SSE2 only, or WDL_FFT_NO_SIMD to use the scalar code only.
+
 */
 
 
@@ -59,6 +64,168 @@ static WDL_FFT_COMPLEX d32768[4095];
 
 #define sqrthalf (d16[1].re)
 
+#if !defined(WDL_FFT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define WDL_FFT_SIMD
+
+#include <emmintrin.h>
+
+// define WDL_FFT_NO_AVX to use SSE2 even when the CPU supports AVX
+#if defined(WDL_FFT_NO_AVX)
+#elif defined(_MSC_VER)
+  #include <intrin.h>
+  #include <immintrin.h>
+  #define WDL_FFT_AVX_TARGET
+  #define WDL_FFT_AVX
+#elif (defined(__GNUC__) || defined(__clang__)) && !defined(__EMSCRIPTEN__)
+  #include <immintrin.h>
+  #define WDL_FFT_AVX_TARGET __attribute__((target("avx")))
+  #define WDL_FFT_AVX
+#endif
+
+// pass twiddle factors for the vectorised passes: for the size 8n pass, tw[k] for k=0..2n-1 at fft_simd_tw[2n-8]
+static WDL_FFT_COMPLEX fft_simd_tw[32768/2 - 8];
+
+static void (*fft_simd_cpass)(WDL_FFT_COMPLEX *a, const WDL_FFT_COMPLEX *tw, unsigned int n);
+static void (*fft_simd_upass)(WDL_FFT_COMPLEX *a, const WDL_FFT_COMPLEX *tw, unsigned int n);
+static void (*fft_simd_complexmul)(WDL_FFT_COMPLEX *dest, const WDL_FFT_COMPLEX *a, const WDL_FFT_COMPLEX *b, int n, int accumulate);
+
+#define WDL_FFT_SIMD_NAME(x) x##_sse2
+#define WDL_FFT_SIMD_FUNC static
+#if WDL_FFT_REALSIZE == 4
+  #define WDL_FFT_SIMD_K 2
+  #define V __m128
+  #define VLOAD(p) _mm_loadu_ps((const float *)(p))
+  #define VSTORE(p, v) _mm_storeu_ps((float *)(p), v)
+  #define VADD _mm_add_ps
+  #define VSUB _mm_sub_ps
+  #define VMUL _mm_mul_ps
+  #define VXOR _mm_xor_ps
+  #define VSWAP(x) _mm_shuffle_ps(x, x, _MM_SHUFFLE(2,3,0,1))
+  #define VDUPRE(x) _mm_shuffle_ps(x, x, _MM_SHUFFLE(2,2,0,0))
+  #define VDUPIM(x) _mm_shuffle_ps(x, x, _MM_SHUFFLE(3,3,1,1))
+  #define VSIGNRE _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f)
+  #define VSIGNIM _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f)
+#else
+  #define WDL_FFT_SIMD_K 1
+  #define V __m128d
+  #define VLOAD(p) _mm_loadu_pd((const double *)(p))
+  #define VSTORE(p, v) _mm_storeu_pd((double *)(p), v)
+  #define VADD _mm_add_pd
+  #define VSUB _mm_sub_pd
+  #define VMUL _mm_mul_pd
+  #define VXOR _mm_xor_pd
+  #define VSWAP(x) _mm_shuffle_pd(x, x, 1)
+  #define VDUPRE(x) _mm_unpacklo_pd(x, x)
+  #define VDUPIM(x) _mm_unpackhi_pd(x, x)
+  #define VSIGNRE _mm_set_pd(0.0, -0.0)
+  #define VSIGNIM _mm_set_pd(-0.0, 0.0)
+#endif
+#include "fft_simd.h"
+#undef WDL_FFT_SIMD_NAME
+#undef WDL_FFT_SIMD_FUNC
+#undef WDL_FFT_SIMD_K
+#undef V
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VXOR
+#undef VSWAP
+#undef VDUPRE
+#undef VDUPIM
+#undef VSIGNRE
+#undef VSIGNIM
+
+#ifdef WDL_FFT_AVX
+#define WDL_FFT_SIMD_NAME(x) x##_avx
+#define WDL_FFT_SIMD_FUNC static WDL_FFT_AVX_TARGET
+#if WDL_FFT_REALSIZE == 4
+  #define WDL_FFT_SIMD_K 4
+  #define V __m256
+  #define VLOAD(p) _mm256_loadu_ps((const float *)(p))
+  #define VSTORE(p, v) _mm256_storeu_ps((float *)(p), v)
+  #define VADD _mm256_add_ps
+  #define VSUB _mm256_sub_ps
+  #define VMUL _mm256_mul_ps
+  #define VXOR _mm256_xor_ps
+  #define VSWAP(x) _mm256_permute_ps(x, 0xB1)
+  #define VDUPRE(x) _mm256_moveldup_ps(x)
+  #define VDUPIM(x) _mm256_movehdup_ps(x)
+  #define VSIGNRE _mm256_set_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f)
+  #define VSIGNIM _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f)
+#else
+  #define WDL_FFT_SIMD_K 2
+  #define V __m256d
+  #define VLOAD(p) _mm256_loadu_pd((const double *)(p))
+  #define VSTORE(p, v) _mm256_storeu_pd((double *)(p), v)
+  #define VADD _mm256_add_pd
+  #define VSUB _mm256_sub_pd
+  #define VMUL _mm256_mul_pd
+  #define VXOR _mm256_xor_pd
+  #define VSWAP(x) _mm256_permute_pd(x, 0x5)
+  #define VDUPRE(x) _mm256_movedup_pd(x)
+  #define VDUPIM(x) _mm256_permute_pd(x, 0xF)
+  #define VSIGNRE _mm256_set_pd(0.0, -0.0, 0.0, -0.0)
+  #define VSIGNIM _mm256_set_pd(-0.0, 0.0, -0.0, 0.0)
+#endif
+#include "fft_simd.h"
+#undef WDL_FFT_SIMD_NAME
+#undef WDL_FFT_SIMD_FUNC
+#undef WDL_FFT_SIMD_K
+#undef V
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VXOR
+#undef VSWAP
+#undef VDUPRE
+#undef VDUPIM
+#undef VSIGNRE
+#undef VSIGNIM
+
+static int fft_simd_has_avx()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  // AVX, and OSXSAVE with the OS saving the YMM registers
+  if (!(info[2] & (1 << 28)) || !(info[2] & (1 << 27))) return 0;
+  return (_xgetbv(0) & 6) == 6;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx");
+#endif
+}
+#endif // WDL_FFT_AVX
+
+// expands the pass twiddle factors of fft.c into tw[0...2n-1], for the size 8n pass
+static void fft_simd_gen(WDL_FFT_COMPLEX *tw, const WDL_FFT_COMPLEX *w, unsigned int n, int isbig)
+{
+  unsigned int k;
+  tw[0].re = 1.0;
+  tw[0].im = 0.0;
+  for (k = 1; k < 2 * n; k ++)
+  {
+    if (!isbig || k < n)
+    {
+      tw[k] = w[k - 1];
+    }
+    else if (k == n)
+    {
+      tw[k].re = tw[k].im = sqrthalf;
+    }
+    else
+    {
+      tw[k].re = w[2 * n - 1 - k].im;
+      tw[k].im = w[2 * n - 1 - k].re;
+    }
+  }
+}
+#endif // WDL_FFT_SIMD
+
 #define VOL *(volatile WDL_FFT_REAL *)&
 
 #define TRANSFORM(a0,a1,a2,a3,wre,wim) { \
@@ -416,6 +583,10 @@ static void cpass(register WDL_FFT_COMPLEX *a,register const WDL_FFT_COMPLEX *w,
   register WDL_FFT_COMPLEX *a2;
   register WDL_FFT_COMPLEX *a3;
 
+#ifdef WDL_FFT_SIMD
+  if (fft_simd_cpass) { fft_simd_cpass(a, fft_simd_tw + 2 * n - 8, n); return; }
+#endif
+
   a2 = a + 4 * n;
   a1 = a + 2 * n;
   a3 = a2 + 2 * n;
@@ -485,6 +656,10 @@ static void cpassbig(register WDL_FFT_COMPLEX *a,register const WDL_FFT_COMPLEX
   register WDL_FFT_COMPLEX *a3;
   register unsigned int k;
 
+#ifdef WDL_FFT_SIMD
+  if (fft_simd_cpass) { fft_simd_cpass(a, fft_simd_tw + 2 * n - 8, n); return; }
+#endif
+
   a2 = a + 4 * n;
   a1 = a + 2 * n;
   a3 = a2 + 2 * n;
@@ -582,6 +757,10 @@ void WDL_fft_complexmul(WDL_FFT_COMPLEX *a,WDL_FFT_COMPLEX *b,int n)
   register WDL_FFT_REAL t1, t2, t3, t4, t5, t6, t7, t8;
   if (n<2 || (n&1)) return;
 
+#ifdef WDL_FFT_SIMD
+  if (fft_simd_complexmul) { fft_simd_complexmul(a, a, b, n, 0); return; }
+#endif
+
   do {
     t1 = a[0].re * b[0].re;
     t2 = a[0].im * b[0].im;
@@ -609,6 +788,10 @@ void WDL_fft_complexmul2(WDL_FFT_COMPLEX *c, WDL_FFT_COMPLEX *a, WDL_FFT_COMPLEX
   register WDL_FFT_REAL t1, t2, t3, t4, t5, t6, t7, t8;
   if (n<2 || (n&1)) return;
 
+#ifdef WDL_FFT_SIMD
+  if (fft_simd_complexmul) { fft_simd_complexmul(c, a, b, n, 0); return; }
+#endif
+
   do {
     t1 = a[0].re * b[0].re;
     t2 = a[0].im * b[0].im;
@@ -636,6 +819,10 @@ void WDL_fft_complexmul3(WDL_FFT_COMPLEX *c, WDL_FFT_COMPLEX *a, WDL_FFT_COMPLEX
   register WDL_FFT_REAL t1, t2, t3, t4, t5, t6, t7, t8;
   if (n<2 || (n&1)) return;
 
+#ifdef WDL_FFT_SIMD
+  if (fft_simd_complexmul) { fft_simd_complexmul(c, a, b, n, 1); return; }
+#endif
+
   do {
     t1 = a[0].re * b[0].re;
     t2 = a[0].im * b[0].im;
@@ -800,6 +987,10 @@ static void upass(register WDL_FFT_COMPLEX *a,register const WDL_FFT_COMPLEX *w,
   register WDL_FFT_COMPLEX *a2;
   register WDL_FFT_COMPLEX *a3;
 
+#ifdef WDL_FFT_SIMD
+  if (fft_simd_upass) { fft_simd_upass(a, fft_simd_tw + 2 * n - 8, n); return; }
+#endif
+
   a2 = a + 4 * n;
   a1 = a + 2 * n;
   a3 = a2 + 2 * n;
@@ -870,6 +1061,10 @@ static void upassbig(register WDL_FFT_COMPLEX *a,register const WDL_FFT_COMPLEX
   register WDL_FFT_COMPLEX *a3;
   register unsigned int k;
 
+#ifdef WDL_FFT_SIMD
+  if (fft_simd_upass) { fft_simd_upass(a, fft_simd_tw + 2 * n - 8, n); return; }
+#endif
+
   a2 = a + 4 * n;
   a1 = a + 2 * n;
   a3 = a2 + 2 * n;
@@ -1050,6 +1245,27 @@ void WDL_fft_init()
     fft_gen(d32768,d16384,0);
 #undef fft_gen
 
+#ifdef WDL_FFT_SIMD
+    {
+      static const WDL_FFT_COMPLEX *passtabs[] = { d32, d64, d128, d256, d512, d1024, d2048, d4096, d8192, d16384, d32768 };
+      unsigned int n;
+      for (i = 0, n = 4; n <= 32768/8; i ++, n *= 2)
+        fft_simd_gen(fft_simd_tw + 2 * n - 8, passtabs[i], n, n >= 1024/8);
+    }
+
+    fft_simd_cpass = cpass_sse2;
+    fft_simd_upass = upass_sse2;
+    fft_simd_complexmul = complexmul_sse2;
+#ifdef WDL_FFT_AVX
+    if (fft_simd_has_avx())
+    {
+      fft_simd_cpass = cpass_avx;
+      fft_simd_upass = upass_avx;
+      fft_simd_complexmul = complexmul_avx;
+    }
+#endif
+#endif
+
 #ifndef WDL_FFT_NO_PERMUTE
 	  offs = 0;
 	  for (i = 2; i <= 32768; i *= 2) 
@@ -0,0 +1,131 @@
+/*
+  WDL - fft_simd.h
+  Copyright (C) 2006 and later Cockos Incorporated
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+
+
+
+  Added for iPlug 2: vectorised versions of the radix-4 passes and the complex
+  multiplies of fft.c. Each vector holds WDL_FFT_SIMD_K consecutive complex
+  values, interleaved as in memory, so the passes keep the djbfft recursion and
+  output order. The arithmetic in each lane is the same as in the scalar macros,
+  except that the first and middle elements of a pass are rotated by a twiddle
+  factor of 1 and sqrt(0.5)*(1+i) rather than by the special cased macros.
+
+  This file is included by fft.c once per instruction set, after defining:
+    WDL_FFT_SIMD_NAME(x)  the function name for x
+    WDL_FFT_SIMD_FUNC     the function specifiers
+    WDL_FFT_SIMD_K        the number of complex values per vector
+    V, VLOAD(p), VSTORE(p,v), VADD, VSUB, VMUL, VXOR, VSWAP (swaps re and im),
+    VDUPRE, VDUPIM (broadcast the real or imaginary parts), VSIGNRE, VSIGNIM
+    (masks of the sign bits of the real or imaginary parts)
+
+*/
+
+/* i * x */
+#define VMULI(x) VXOR(VSWAP(x), VSIGNRE)
+/* x * w */
+#define VCMUL(x, wre, wim) VADD(VMUL(x, wre), VXOR(VMUL(VSWAP(x), wim), VSIGNRE))
+/* x * conj(w) */
+#define VCMULCONJ(x, wre, wim) VADD(VMUL(x, wre), VXOR(VMUL(VSWAP(x), wim), VSIGNIM))
+
+/* a[0...8n-1], tw[0...2n-1] */
+WDL_FFT_SIMD_FUNC void WDL_FFT_SIMD_NAME(cpass)(WDL_FFT_COMPLEX *a, const WDL_FFT_COMPLEX *tw, unsigned int n)
+{
+  WDL_FFT_COMPLEX *a1 = a + 2 * n;
+  WDL_FFT_COMPLEX *a2 = a + 4 * n;
+  WDL_FFT_COMPLEX *a3 = a + 6 * n;
+  unsigned int k;
+
+  for (k = 0; k < 2 * n; k += WDL_FFT_SIMD_K)
+  {
+    const V x0 = VLOAD(a + k), x1 = VLOAD(a1 + k), x2 = VLOAD(a2 + k), x3 = VLOAD(a3 + k);
+    const V w = VLOAD(tw + k), wre = VDUPRE(w), wim = VDUPIM(w);
+    const V d02 = VSUB(x0, x2);
+    const V id13 = VMULI(VSUB(x1, x3));
+
+    VSTORE(a + k, VADD(x0, x2));
+    VSTORE(a1 + k, VADD(x1, x3));
+    VSTORE(a2 + k, VCMUL(VADD(d02, id13), wre, wim));
+    VSTORE(a3 + k, VCMULCONJ(VSUB(d02, id13), wre, wim));
+  }
+}
+
+/* a[0...8n-1], tw[0...2n-1] */
+WDL_FFT_SIMD_FUNC void WDL_FFT_SIMD_NAME(upass)(WDL_FFT_COMPLEX *a, const WDL_FFT_COMPLEX *tw, unsigned int n)
+{
+  WDL_FFT_COMPLEX *a1 = a + 2 * n;
+  WDL_FFT_COMPLEX *a2 = a + 4 * n;
+  WDL_FFT_COMPLEX *a3 = a + 6 * n;
+  unsigned int k;
+
+  for (k = 0; k < 2 * n; k += WDL_FFT_SIMD_K)
+  {
+    const V x0 = VLOAD(a + k), x1 = VLOAD(a1 + k), x2 = VLOAD(a2 + k), x3 = VLOAD(a3 + k);
+    const V w = VLOAD(tw + k), wre = VDUPRE(w), wim = VDUPIM(w);
+    const V p = VCMULCONJ(x2, wre, wim);
+    const V q = VCMUL(x3, wre, wim);
+    const V s = VADD(p, q);
+    const V id = VMULI(VSUB(p, q));
+
+    VSTORE(a + k, VADD(x0, s));
+    VSTORE(a2 + k, VSUB(x0, s));
+    VSTORE(a1 + k, VSUB(x1, id));
+    VSTORE(a3 + k, VADD(x1, id));
+  }
+}
+
+/* dest[i] = a[i] * b[i], or dest[i] += a[i] * b[i] if accumulate. dest may be a */
+WDL_FFT_SIMD_FUNC void WDL_FFT_SIMD_NAME(complexmul)(WDL_FFT_COMPLEX *dest, const WDL_FFT_COMPLEX *a, const WDL_FFT_COMPLEX *b, int n, int accumulate)
+{
+  int i = 0;
+
+  if (accumulate)
+  {
+    for (; i <= n - WDL_FFT_SIMD_K; i += WDL_FFT_SIMD_K)
+    {
+      const V w = VLOAD(b + i);
+      VSTORE(dest + i, VADD(VLOAD(dest + i), VCMUL(VLOAD(a + i), VDUPRE(w), VDUPIM(w))));
+    }
+  }
+  else
+  {
+    for (; i <= n - WDL_FFT_SIMD_K; i += WDL_FFT_SIMD_K)
+    {
+      const V w = VLOAD(b + i);
+      VSTORE(dest + i, VCMUL(VLOAD(a + i), VDUPRE(w), VDUPIM(w)));
+    }
+  }
+
+  for (; i < n; i ++)
+  {
+    WDL_FFT_REAL re = a[i].re * b[i].re - a[i].im * b[i].im;
+    WDL_FFT_REAL im = a[i].im * b[i].re + a[i].re * b[i].im;
+    if (accumulate)
+    {
+      re += dest[i].re;
+      im += dest[i].im;
+    }
+    dest[i].re = re;
+    dest[i].im = im;
+  }
+}
+
+#undef VMULI
+#undef VCMUL
+#undef VCMULCONJ
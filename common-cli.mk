@@ -0,0 +1,96 @@
+PROJECT_ROOT = $(PWD)/..
+DEPS_PATH = $(IPLUG2_ROOT)/Dependencies
+WDL_PATH = $(IPLUG2_ROOT)/WDL
+IPLUG_PATH = $(IPLUG2_ROOT)/IPlug
+IGRAPHICS_PATH = $(IPLUG2_ROOT)/IGraphics
+CONTROLS_PATH = $(IGRAPHICS_PATH)/Controls
+PLATFORMS_PATH = $(IGRAPHICS_PATH)/Platforms
+DRAWING_PATH = $(IGRAPHICS_PATH)/Drawing
+IGRAPHICS_EXTRAS_PATH = $(IGRAPHICS_PATH)/Extras
+IPLUG_EXTRAS_PATH = $(IPLUG_PATH)/Extras
+IPLUG_SYNTH_PATH = $(IPLUG_EXTRAS_PATH)/Synth
+IPLUG_CLI_PATH = $(IPLUG_PATH)/CLI
+NANOVG_PATH = $(DEPS_PATH)/IGraphics/NanoVG/src
+NANOSVG_PATH = $(DEPS_PATH)/IGraphics/NanoSVG/src
+STB_PATH = $(DEPS_PATH)/IGraphics/STB
+SKIA_PATH = $(DEPS_PATH)/Build/src/skia
+
+IPLUG_SRC = $(IPLUG_PATH)/IPlugAPIBase.cpp \
+	$(IPLUG_PATH)/IPlugParameter.cpp \
+	$(IPLUG_PATH)/IPlugPluginBase.cpp \
+	$(IPLUG_PATH)/IPlugProcessor.cpp \
+	$(IPLUG_PATH)/IPlugPaths.cpp \
+	$(IPLUG_PATH)/IPlugTimer.cpp
+
+# the headless linux IGraphics target, used to test and benchmark user interfaces without a display
+IGRAPHICS_SRC = $(IGRAPHICS_PATH)/IGraphics.cpp \
+	$(IGRAPHICS_PATH)/IControl.cpp \
+	$(IGRAPHICS_PATH)/IGraphicsEditorDelegate.cpp \
+	$(CONTROLS_PATH)/*.cpp \
+	$(PLATFORMS_PATH)/IGraphicsLinux.cpp
+
+INCLUDE_PATHS = -I$(PROJECT_ROOT) \
+-I$(WDL_PATH) \
+-I$(IPLUG_PATH) \
+-I$(IPLUG_EXTRAS_PATH) \
+-I$(IPLUG_SYNTH_PATH) \
+-I$(IPLUG_CLI_PATH) \
+-I$(IGRAPHICS_PATH) \
+-I$(DRAWING_PATH) \
+-I$(CONTROLS_PATH) \
+-I$(PLATFORMS_PATH) \
+-I$(IGRAPHICS_EXTRAS_PATH) \
+-I$(NANOVG_PATH) \
+-I$(NANOSVG_PATH) \
+-I$(STB_PATH)
+
+#every cpp file that is needed for both the render host and the headless user interface
+SRC = $(IPLUG_SRC) \
+	$(IPLUG_CLI_PATH)/IPlugCLI.cpp
+
+#every cpp file that is needed for the command-line render host
+CLI_SRC = $(IPLUG_CLI_PATH)/IPlugCLI_host.cpp \
+	$(IPLUG_CLI_PATH)/IPlugCLI_main.cpp
+
+CFLAGS = $(INCLUDE_PATHS) \
+-std=c++17 \
+-O3 \
+-DCLI_API \
+-DWDL_NO_DEFINE_MINMAX \
+-DNDEBUG=1
+
+# the command-line render host has no user interface, so only the DSP side of the plug-in is built
+CLI_CFLAGS = -DIPLUG_DSP=1 \
+-DIPLUG_EDITOR=0 \
+-DNO_IGRAPHICS
+
+# the headless user interface draws with LICE, which needs no other dependencies, or with Skia's CPU raster backend
+HEADLESS_CFLAGS = -DIPLUG_DSP=1 \
+-DIPLUG_EDITOR=1
+
+LICE_CFLAGS = -DIGRAPHICS_LICE \
+-D_LICE_NO_SYSBITMAPS_
+
+LICE_SRC = $(WDL_PATH)/lice/lice.cpp
+
+# Skia must be built for linux with the scripts in Dependencies, as for the other platforms
+SKIA_CFLAGS = -DIGRAPHICS_SKIA \
+-DIGRAPHICS_CPU \
+-I$(SKIA_PATH) \
+-I$(SKIA_PATH)/include/core \
+-I$(SKIA_PATH)/include/effects \
+-I$(SKIA_PATH)/include/config \
+-I$(SKIA_PATH)/include/utils \
+-I$(SKIA_PATH)/include/gpu \
+-I$(SKIA_PATH)/modules/svg/include \
+-I$(DEPS_PATH)/Build/linux/include/freetype2
+
+SKIA_LDFLAGS = -L$(DEPS_PATH)/Build/linux/lib \
+-lsvg \
+-lskshaper \
+-lskunicode \
+-lskia \
+-lfreetype \
+-lfontconfig
+
+LDFLAGS = -lpthread